@@ -24,6 +24,8 @@
 #include <benchmark/benchmark.h>
 
 #include "simdjson_peval.h"
+#include "simdjson_peval_ndjson.h"
+#include "simdjson_peval_io.h"
 
 #include <iostream>
 
@@ -47,6 +49,9 @@ static const bool ERRORS_WITH_PATH = false;
 static simdjson::ondemand::parser parser;
 static simdjson::padded_string json_data;
 
+// error container reused by all "global" tests.
+static simdjson_peval::error serrors(ERRORS_WITH_PATH);
+
 #if defined(__clang__) || defined(__GNUC__)
 //   Optimize: always include lambda functions.
 #    define ALWAYS_INLINE __attribute__((always_inline))
@@ -197,11 +202,11 @@ loadTwitter_peval_global() {
     stweets.clear();
     stweets.reserve(1<<10);
 
-    auto errors = error(ERRORS_WITH_PATH);
-    eval_tweet(data_document, &errors);
+    serrors.reset();
+    eval_tweet(data_document, &serrors);
 
-    if (errors) {
-        std::cerr << "ERROR:\n" << errors.to_string() << '\n';
+    if (serrors) {
+        std::cerr << "ERROR:\n" << serrors.to_string() << '\n';
         exit(1);
     }
 
@@ -624,13 +629,14 @@ loadCellphones_peval_global() {
 
     size_t idx = 0;
 
-    auto errors = error(ERRORS_WITH_PATH);
+    serrors.reset();
 
     for (auto doc_ref : data_docs.value()) {
-        error::path_scope doc_scope(&errors, idx);
+        error::path_scope doc_scope(&serrors, idx);
         if (idx != 0) {
-            eval_cellphone(doc_ref, &errors);
-            if (!errors) {
+            serrors.clear();
+            eval_cellphone(doc_ref, &serrors);
+            if (!serrors) {
                 result.push_back(std::move(stmp_cellphone));
             }
         }
@@ -641,6 +647,81 @@ loadCellphones_peval_global() {
 }
 
 
+static std::vector<Cellphone>
+loadCellphones_peval_many() {
+    using namespace simdjson_peval;
+
+    std::vector<Cellphone> result;
+    result.reserve(1<<10);
+
+    eval_many_options options;
+    options.skip_documents = 1;
+
+    serrors.reset();
+    eval_many(
+        &parser, json_data, &stmp_cellphone, eval_cellphone,
+        [&result](record_batch<Cellphone> *batch, error *err) {
+            std::move(batch->begin(), batch->end(), back_inserter(result));
+        },
+        &serrors, options);
+
+    return result;
+}
+
+
+static std::vector<Cellphone>
+loadCellphones_peval_input(simdjson::padded_string_view json) {
+    using namespace simdjson_peval;
+
+    std::vector<Cellphone> result;
+    result.reserve(1<<10);
+
+    eval_many_options options;
+    options.skip_documents = 1;
+
+    serrors.reset();
+    eval_many(
+        &parser, json, &stmp_cellphone, eval_cellphone,
+        [&result](record_batch<Cellphone> *batch, error *err) {
+            std::move(batch->begin(), batch->end(), back_inserter(result));
+        },
+        &serrors, options);
+
+    return result;
+}
+
+
+static std::vector<Cellphone>
+loadCellphones_peval_feeder(size_t fragment_size) {
+    using namespace simdjson_peval;
+
+    std::vector<Cellphone> result;
+    result.reserve(1<<10);
+
+    eval_many_options options;
+    options.skip_documents = 1;
+
+    serrors.reset();
+    feeder feed(
+        &parser, &stmp_cellphone, eval_cellphone,
+        [&result](record_batch<Cellphone> *batch, error *err) {
+            std::move(batch->begin(), batch->end(), back_inserter(result));
+        },
+        &serrors, options);
+
+    // simulate data received in fragments.
+    std::string_view data(json_data);
+    while (!data.empty()) {
+        const auto size = std::min(fragment_size, data.size());
+        feed.push(data.substr(0, size));
+        data.remove_prefix(size);
+    }
+    feed.finish();
+
+    return result;
+}
+
+
 static std::vector<Cellphone>
 loadCellphones_raw() {
     using namespace simdjson_peval;
@@ -767,6 +848,51 @@ cellphone_file_peval_global(benchmark::State& state) {
     }
 }
 
+static void
+cellphone_file_peval_many(benchmark::State& state) {
+    for (auto _ : state) {
+        auto phones = loadCellphones_peval_many();
+        benchmark::DoNotOptimize(phones.data());
+    }
+}
+
+// Argument: size of fragments pushed into the feeder.
+static void
+cellphone_file_peval_feeder(benchmark::State& state) {
+    for (auto _ : state) {
+        auto phones = loadCellphones_peval_feeder(size_t(state.range(0)));
+        benchmark::DoNotOptimize(phones.data());
+    }
+}
+
+// Includes loading the file into a padded string.
+static void
+cellphone_file_peval_load(benchmark::State& state) {
+    for (auto _ : state) {
+        simdjson::padded_string json;
+        if (simdjson::padded_string::load(AMAZON_EXAMPLE).get(json)) {
+            state.SkipWithError("cannot load file");
+            break;
+        }
+        auto phones = loadCellphones_peval_input(json);
+        benchmark::DoNotOptimize(phones.data());
+    }
+}
+
+// Includes mapping the file into memory.
+static void
+cellphone_file_peval_mmap(benchmark::State& state) {
+    for (auto _ : state) {
+        simdjson_peval::mapped_file file;
+        if (file.open(AMAZON_EXAMPLE)) {
+            state.SkipWithError("cannot map file");
+            break;
+        }
+        auto phones = loadCellphones_peval_input(file.view());
+        benchmark::DoNotOptimize(phones.data());
+    }
+}
+
 static void
 cellphone_file_raw(benchmark::State& state) {
     for (auto _ : state) {
@@ -781,6 +907,18 @@ BENCHMARK(cellphone_file_peval_local)
 BENCHMARK(cellphone_file_peval_global)
 ->Setup(setupCellphoneLoadJSON);
 
+BENCHMARK(cellphone_file_peval_many)
+->Setup(setupCellphoneLoadJSON);
+
+BENCHMARK(cellphone_file_peval_feeder)
+->Setup(setupCellphoneLoadJSON)
+->Arg(1500)
+->Arg(1<<16);
+
+BENCHMARK(cellphone_file_peval_load);
+
+BENCHMARK(cellphone_file_peval_mmap);
+
 BENCHMARK(cellphone_file_raw)
 ->Setup(setupCellphoneLoadJSON);
 
@@ -860,11 +998,11 @@ loadMapData_peval_global(size_t reserve) {
 
     obj_map_data.clear();
 
-    auto errors = error(ERRORS_WITH_PATH);
-    eval_map_data(data_document, &errors);
+    serrors.reset();
+    eval_map_data(data_document, &serrors);
 
-    if (errors) {
-        std::cerr << "PEVAL_ERROR:\n" << errors.to_string() << '\n';
+    if (serrors) {
+        std::cerr << "PEVAL_ERROR:\n" << serrors.to_string() << '\n';
         exit(1);
     }
 
@@ -955,6 +1093,91 @@ BENCHMARK(map_data_raw)
 ->Range(2, 1 << 16);
 
 
+// Array Slices
+// /////////////////////////////////////////////////////////////////////////
+
+using SliceItem = std::pair<int64_t, std::string_view>;
+
+static std::vector<SliceItem> slice_items;
+static SliceItem stmp_slice_item;
+
+static auto eval_slice_item =
+    simdjson_peval::object(
+        simdjson_peval::member(
+            "id", simdjson_peval::number_value(&stmp_slice_item.first)),
+        simdjson_peval::member(
+            "name", simdjson_peval::string_value(&stmp_slice_item.second)));
+
+static void
+setupSliceLoadJSON(const benchmark::State& state) {
+    slice_items.reserve(1<<20);
+
+    std::string raw_json = "[";
+    for (size_t i = 0; i < (1<<20); ++i) {
+        if (i != 0) {
+            raw_json += ',';
+        }
+
+        raw_json +=
+            "{\"id\":" + std::to_string(i)
+            + ",\"name\":\"item " + std::to_string(i) + "\"}";
+    }
+    raw_json += ']';
+
+    json_data = simdjson::padded_string(raw_json);
+}
+
+// All elements of an array with 1M objects.
+static void
+array_slice_all(benchmark::State& state) {
+    using namespace simdjson_peval;
+
+    auto eval_fn =
+        array_to_out_iter<simdjson::ondemand::document>(
+            std::back_inserter(slice_items), &stmp_slice_item,
+            eval_slice_item);
+
+    for (auto _ : state) {
+        slice_items.clear();
+        auto data_document = parser.iterate(json_data);
+        serrors.reset();
+        eval_fn(data_document, &serrors);
+        benchmark::DoNotOptimize(slice_items.data());
+    }
+}
+
+// Argument: index of the first of 100 elements.
+static void
+array_slice_page(benchmark::State& state) {
+    using namespace simdjson_peval;
+
+    const auto begin = size_t(state.range(0));
+    auto eval_fn =
+        slice<simdjson::ondemand::document>(
+            begin, begin + 100,
+            array_to_out_iter<simdjson::ondemand::document>(
+                std::back_inserter(slice_items), &stmp_slice_item,
+                eval_slice_item));
+
+    for (auto _ : state) {
+        slice_items.clear();
+        auto data_document = parser.iterate(json_data);
+        serrors.reset();
+        eval_fn(data_document, &serrors);
+        benchmark::DoNotOptimize(slice_items.data());
+    }
+}
+
+BENCHMARK(array_slice_all)
+->Setup(setupSliceLoadJSON);
+
+BENCHMARK(array_slice_page)
+->Setup(setupSliceLoadJSON)
+->Arg(0)
+->Arg(1000)
+->Arg(1<<19);
+
+
 // Main
 // /////////////////////////////////////////////////////////////////////////
 
@@ -0,0 +1,222 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <benchmark/benchmark.h>
+
+#include "simdjson_peval.h"
+#include "simdjson_peval_io.h"
+#include "simdjson_peval_parallel.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+
+// Evaluate a directory of NDJSON files
+// /////////////////////////////////////////////////////////////////////////
+
+// Number and size of the generated files.
+static const size_t IO_NUM_FILES = 32;
+static const size_t IO_FILE_SIZE = size_t(8) << 20;
+
+// Structure to hold data of a log record.
+struct IoRecord {
+    uint64_t id;
+    std::string level;
+    std::string message;
+    double duration;
+};
+
+static std::vector<std::string> io_paths;
+
+// Directory of the files: `SIMDJSON_PEVAL_BENCH_DIR` or generated files.
+static void
+setupIoFiles(const benchmark::State& state) {
+    if (!io_paths.empty()) {
+        return;
+    }
+
+    namespace fs = std::filesystem;
+
+    const char *env_dir = std::getenv("SIMDJSON_PEVAL_BENCH_DIR");
+    if (env_dir) {
+        for (const auto &entry : fs::directory_iterator(env_dir)) {
+            if (entry.is_regular_file()) {
+                io_paths.push_back(entry.path().string());
+            }
+        }
+        std::sort(io_paths.begin(), io_paths.end());
+        return;
+    }
+
+    const auto dir = fs::temp_directory_path() / "simdjson_peval_io_bench";
+    fs::create_directories(dir);
+    for (size_t file_idx = 0; file_idx < IO_NUM_FILES; ++file_idx) {
+        const auto path =
+            (dir / ("part" + std::to_string(file_idx) + ".ndjson")).string();
+        io_paths.push_back(path);
+        if (fs::exists(path) && fs::file_size(path) >= IO_FILE_SIZE) {
+            continue;
+        }
+
+        std::string data;
+        for (uint64_t id = 0; data.size() < IO_FILE_SIZE; ++id) {
+            data += "{\"id\":" + std::to_string(id)
+                + ",\"level\":\"" + ((id % 10 == 0) ? "warn" : "info")
+                + "\",\"message\":\"request " + std::to_string(id * 7919)
+                + " of file " + std::to_string(file_idx)
+                + " handled\",\"duration\":" + std::to_string(id % 1000)
+                + ".25}\n";
+        }
+        std::ofstream(path, std::ios::binary) << data;
+    }
+}
+
+static size_t
+ioTotalSize() {
+    size_t total_size = 0;
+    for (const auto &path : io_paths) {
+        total_size += std::filesystem::file_size(path);
+    }
+    return total_size;
+}
+
+// Drop the files from the page cache, so that each iteration reads
+// them from the disk.
+static void
+dropIoFileCache() {
+    for (const auto &path : io_paths) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            continue;
+        }
+
+        // only clean pages are dropped.
+        ::fsync(fd);
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+}
+
+static auto
+ioRecordProto(IoRecord *tmp_record) {
+    using namespace simdjson_peval;
+
+    return
+        object<simdjson::ondemand::document_reference>(
+            member("id", number_value(&tmp_record->id)),
+            member("level", string_value(&tmp_record->level)),
+            member("message", string_value(&tmp_record->message)),
+            member("duration", number_value(&tmp_record->duration)));
+}
+
+// Baseline: load each file before it is evaluated.
+static void
+io_files_load(benchmark::State& state) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    IoRecord tmp_record;
+    auto proto = ioRecordProto(&tmp_record);
+
+    size_t num_records = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        dropIoFileCache();
+        state.ResumeTiming();
+
+        num_records = 0;
+        for (const auto &path : io_paths) {
+            auto json_data = simdjson::padded_string::load(path);
+            if (json_data.error()) {
+                state.SkipWithError("can't load file");
+                return;
+            }
+
+            error errors;
+            eval_many(
+                &parser, json_data.value_unsafe(), &tmp_record, proto,
+                [&num_records](record_batch<IoRecord> *batch, error *err) {
+                    num_records += batch->size();
+                },
+                &errors);
+        }
+    }
+
+    state.SetBytesProcessed(
+        int64_t(state.iterations()) * int64_t(ioTotalSize()));
+    state.counters["records"] = double(num_records);
+}
+BENCHMARK(io_files_load)
+    ->Setup(setupIoFiles)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Arguments: use io_uring (0: pread), block size in KiB.
+static void
+io_files_async(benchmark::State& state) {
+    using namespace simdjson_peval;
+
+    async_file_options file_options;
+    file_options.use_uring = (state.range(0) != 0);
+    file_options.block_size = size_t(state.range(1)) << 10;
+
+    simdjson::ondemand::parser parser;
+    IoRecord tmp_record;
+    auto proto = ioRecordProto(&tmp_record);
+
+    size_t num_records = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        dropIoFileCache();
+        state.ResumeTiming();
+
+        num_records = 0;
+
+        error errors;
+        async_file_source source(io_paths, file_options);
+        eval_files_async(
+            &parser, &source, &tmp_record, proto,
+            [&num_records](record_batch<IoRecord> *batch, error *err) {
+                num_records += batch->size();
+            },
+            &errors);
+    }
+
+    state.SetBytesProcessed(
+        int64_t(state.iterations()) * int64_t(ioTotalSize()));
+    state.counters["records"] = double(num_records);
+}
+BENCHMARK(io_files_async)
+    ->Setup(setupIoFiles)
+    ->ArgNames({"uring", "block_kib"})
+    ->ArgsProduct({{0, 1}, {256, 1024}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
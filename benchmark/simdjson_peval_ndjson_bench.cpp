@@ -0,0 +1,348 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <benchmark/benchmark.h>
+
+#include "simdjson_peval.h"
+#include "simdjson_peval_ndjson.h"
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+
+// Batch size sweep over synthetic document size distributions
+// /////////////////////////////////////////////////////////////////////////
+
+// Minimum size of the synthetic input.
+static const size_t SWEEP_INPUT_SIZE = size_t(64) << 20;
+
+// Document size distributions.
+enum SweepDistribution {
+    SWEEP_TINY = 0,     // log lines of about 100 bytes
+    SWEEP_MEDIUM = 1,   // records of about 2 KB
+    SWEEP_LARGE = 2,    // product records of about 100 KB
+    SWEEP_MIXED = 3     // mostly tiny with some large documents
+};
+
+// Structure to hold data of a synthetic document.
+struct SweepRecord {
+    uint64_t id;
+    std::string kind;
+    double score;
+    std::vector<std::string> tags;
+};
+
+static std::vector<simdjson::padded_string> sweep_json_data(4);
+
+// Size of the payload of the next document.
+static size_t
+sweepPayloadSize(SweepDistribution distribution, std::mt19937_64 *rng) {
+    std::uniform_int_distribution<size_t> percent(0, 99);
+    switch (distribution) {
+    case SWEEP_TINY:
+        return std::uniform_int_distribution<size_t>(10, 90)(*rng);
+    case SWEEP_MEDIUM:
+        return std::uniform_int_distribution<size_t>(1000, 3000)(*rng);
+    case SWEEP_LARGE:
+        return std::uniform_int_distribution<size_t>(50000, 150000)(*rng);
+    case SWEEP_MIXED:
+    default:
+        return ((percent(*rng) == 0)
+                ? std::uniform_int_distribution<size_t>(50000, 150000)(*rng)
+                : std::uniform_int_distribution<size_t>(10, 90)(*rng));
+    }
+}
+
+static void
+createSweepJSON(SweepDistribution distribution) {
+    auto &json_data = sweep_json_data[distribution];
+    if (json_data.size() != 0) {
+        return;
+    }
+
+    std::mt19937_64 rng(42);
+    std::string data;
+    data.reserve(SWEEP_INPUT_SIZE + (size_t(1) << 20));
+    for (uint64_t id = 0; data.size() < SWEEP_INPUT_SIZE; ++id) {
+        // payload is split into tags of 20 characters.
+        const auto payload_size = sweepPayloadSize(distribution, &rng);
+        data += "{\"id\":" + std::to_string(id)
+            + ",\"kind\":\"synthetic\",\"score\":" + std::to_string(id % 97)
+            + ".5,\"tags\":[";
+        for (size_t pos = 0; pos < payload_size; pos += 20) {
+            if (pos != 0) {
+                data += ',';
+            }
+            data += "\"" + std::string(std::min(payload_size - pos, size_t(20)),
+                                       char('a' + id % 26)) + "\"";
+        }
+        data += "]}\n";
+    }
+
+    json_data = simdjson::padded_string(data);
+}
+
+static void
+setupSweepJSON(const benchmark::State& state) {
+    createSweepJSON(SweepDistribution(state.range(0)));
+}
+
+// Arguments: distribution, batch size in KiB (0: automatic).
+static void
+ndjson_batch_size_sweep(benchmark::State& state) {
+    using namespace simdjson_peval;
+
+    const auto distribution = SweepDistribution(state.range(0));
+    const auto &json_data = sweep_json_data[distribution];
+
+    eval_many_options options;
+    if (state.range(1) == 0) {
+        options.auto_batch_size = true;
+    }
+    else {
+        options.batch_size = size_t(state.range(1)) << 10;
+    }
+
+    simdjson::ondemand::parser parser;
+    SweepRecord tmp_record;
+    std::string tmp_tag;
+    auto proto =
+        object<simdjson::ondemand::document_reference>(
+            member("id", number_value(&tmp_record.id)),
+            member("kind", string_value(&tmp_record.kind)),
+            member("score", number_value(&tmp_record.score)),
+            member("tags",
+                   array_to_out_iter(
+                       back_inserter(tmp_record.tags), &tmp_tag,
+                       string_value(&tmp_tag))));
+
+    eval_many_stats stats;
+    for (auto _ : state) {
+        error errors;
+        stats =
+            eval_many(
+                &parser, json_data, &tmp_record,
+                [&tmp_record, proto]
+                (simdjson::simdjson_result<
+                     simdjson::ondemand::document_reference> &sj_doc,
+                 error *err) mutable {
+                    tmp_record.tags.clear();
+                    proto(sj_doc, err);
+                },
+                [](record_batch<SweepRecord> *batch, error *err) {
+                    benchmark::DoNotOptimize(batch->begin());
+                },
+                &errors, options);
+    }
+
+    state.SetBytesProcessed(
+        int64_t(state.iterations()) * int64_t(json_data.size()));
+    state.counters["batch_kib"] = double(stats.batch_size >> 10);
+    state.counters["changes"] = double(stats.batch_size_changes);
+}
+BENCHMARK(ndjson_batch_size_sweep)
+    ->Setup(setupSweepJSON)
+    ->ArgNames({"distribution", "batch_kib"})
+    ->ArgsProduct({
+            {SWEEP_TINY, SWEEP_MEDIUM, SWEEP_LARGE, SWEEP_MIXED},
+            {0, 64, 256, 1024, 4096, 16384}})
+    ->Unit(benchmark::kMillisecond);
+
+
+
+// Input buffers with and without transparent huge pages
+// /////////////////////////////////////////////////////////////////////////
+
+static std::vector<simdjson_peval::padded_buffer> huge_pages_json_data;
+
+// Copy the mixed synthetic input into both kinds of buffers.
+static void
+setupHugePagesJSON(const benchmark::State& state) {
+    if (!huge_pages_json_data.empty()) {
+        return;
+    }
+
+    createSweepJSON(SWEEP_MIXED);
+
+    const auto &json_data = sweep_json_data[SWEEP_MIXED];
+    for (const auto huge_pages : {false, true}) {
+        auto &buffer =
+            huge_pages_json_data.emplace_back(json_data.size(), huge_pages);
+        buffer.resize(json_data.size());
+        std::memcpy(buffer.data(), json_data.data(), json_data.size());
+    }
+}
+
+// Argument: use transparent huge pages (0/1).
+static void
+ndjson_huge_pages(benchmark::State& state) {
+    using namespace simdjson_peval;
+
+    const auto &json_data = huge_pages_json_data[state.range(0) != 0];
+
+    simdjson::ondemand::parser parser;
+    SweepRecord tmp_record;
+    std::string tmp_tag;
+    auto proto =
+        object<simdjson::ondemand::document_reference>(
+            member("id", number_value(&tmp_record.id)),
+            member("kind", string_value(&tmp_record.kind)),
+            member("score", number_value(&tmp_record.score)),
+            member("tags",
+                   array_to_out_iter(
+                       back_inserter(tmp_record.tags), &tmp_tag,
+                       string_value(&tmp_tag))));
+
+    eval_many_options options;
+    options.batch_size = size_t(16) << 20;
+
+    for (auto _ : state) {
+        error errors;
+        eval_many(
+            &parser, json_data.view(), &tmp_record,
+            [&tmp_record, proto]
+            (simdjson::simdjson_result<
+                 simdjson::ondemand::document_reference> &sj_doc,
+             error *err) mutable {
+                tmp_record.tags.clear();
+                proto(sj_doc, err);
+            },
+            [](record_batch<SweepRecord> *batch, error *err) {
+                benchmark::DoNotOptimize(batch->begin());
+            },
+            &errors, options);
+    }
+
+    state.SetBytesProcessed(
+        int64_t(state.iterations()) * int64_t(json_data.size()));
+}
+BENCHMARK(ndjson_huge_pages)
+    ->Setup(setupHugePagesJSON)
+    ->ArgName("huge_pages")
+    ->Arg(0)->Arg(1)
+    ->Unit(benchmark::kMillisecond);
+
+
+
+// Selective scan of log lines with and without prefilter
+// /////////////////////////////////////////////////////////////////////////
+
+static simdjson::padded_string log_json_data;
+
+// Structure to hold data of a log line.
+struct LogRecord {
+    std::string level;
+    uint64_t id;
+    std::string msg;
+};
+
+// Create log lines, 1% of them with level "error".
+static void
+setupLogJSON(const benchmark::State& state) {
+    if (log_json_data.size() != 0) {
+        return;
+    }
+
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<size_t> percent(0, 99);
+    std::string data;
+    data.reserve(SWEEP_INPUT_SIZE + (size_t(1) << 20));
+    for (uint64_t id = 0; data.size() < SWEEP_INPUT_SIZE; ++id) {
+        data += std::string("{\"level\":\"")
+            + (percent(rng) == 0 ? "error" : "info")
+            + "\",\"id\":" + std::to_string(id)
+            + ",\"msg\":\"request " + std::to_string(id % 1000)
+            + " handled by worker " + std::to_string(id % 16) + "\"}\n";
+    }
+
+    log_json_data = simdjson::padded_string(data);
+}
+
+// Argument: use prefilter (0/1).
+static void
+ndjson_prefilter(benchmark::State& state) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    LogRecord tmp_record;
+    auto proto =
+        object<simdjson::ondemand::document_reference>(
+            where(
+                member("level", string_value(&tmp_record.level)),
+                [&tmp_record]() { return tmp_record.level == "error"; }),
+            member("id", number_value(&tmp_record.id)),
+            member("msg", string_value(&tmp_record.msg)));
+
+    eval_many_options options;
+    if (state.range(0) != 0) {
+        options.required_literals = {"\"level\":\"error\""};
+    }
+
+    eval_many_stats stats;
+    for (auto _ : state) {
+        error errors;
+        stats =
+            eval_many(
+                &parser, log_json_data, &tmp_record, proto,
+                [](record_batch<LogRecord> *batch, error *err) {
+                    benchmark::DoNotOptimize(batch->begin());
+                },
+                &errors, options);
+    }
+
+    state.SetBytesProcessed(
+        int64_t(state.iterations()) * int64_t(log_json_data.size()));
+    state.counters["records"] = double(stats.records);
+}
+BENCHMARK(ndjson_prefilter)
+    ->Setup(setupLogJSON)
+    ->ArgName("prefilter")
+    ->Arg(0)->Arg(1)
+    ->Unit(benchmark::kMillisecond);
+
+// Reference: count the lines by memchr().
+static void
+ndjson_memchr_lines(benchmark::State& state) {
+    size_t lines = 0;
+    for (auto _ : state) {
+        lines = 0;
+        const char *pos = log_json_data.data();
+        const char *end = pos + log_json_data.size();
+        while ((pos = static_cast<const char *>(
+                    std::memchr(pos, '\n', size_t(end - pos)))) != nullptr)
+        {
+            ++lines;
+            ++pos;
+        }
+        benchmark::DoNotOptimize(lines);
+    }
+
+    state.SetBytesProcessed(
+        int64_t(state.iterations()) * int64_t(log_json_data.size()));
+}
+BENCHMARK(ndjson_memchr_lines)
+    ->Setup(setupLogJSON)
+    ->Unit(benchmark::kMillisecond);
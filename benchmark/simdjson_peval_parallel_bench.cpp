@@ -0,0 +1,451 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <benchmark/benchmark.h>
+
+#include "simdjson_peval.h"
+#include "simdjson_peval_parallel.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+// Multi-threaded evaluation of the Amazon cellphone example
+// /////////////////////////////////////////////////////////////////////////
+
+// Minimum size of the replicated input.
+static const size_t PARALLEL_INPUT_SIZE = size_t(64) << 20;
+
+// Structure to hold data of a cellphone.
+struct ParallelCellphone {
+    std::string asin;
+    std::string brand;
+    std::string title;
+    std::string url;
+    std::string image;
+    double rating;
+    std::string reviewUrl;
+    uint64_t totalReviews;
+    std::string prices;
+};
+
+static simdjson::padded_string parallel_json_data;
+
+// Replicate all cellphones (without header line) up to
+// PARALLEL_INPUT_SIZE bytes.
+static void
+setupParallelLoadJSON(const benchmark::State& state) {
+    if (parallel_json_data.size() != 0) {
+        return;
+    }
+
+    simdjson::padded_string example =
+        simdjson::padded_string::load(AMAZON_EXAMPLE);
+    const auto example_view = std::string_view(example.data(), example.size());
+    const auto body = example_view.substr(example_view.find('\n') + 1);
+
+    std::string data;
+    data.reserve(PARALLEL_INPUT_SIZE + body.size());
+    while (data.size() < PARALLEL_INPUT_SIZE) {
+        data.append(body);
+    }
+
+    parallel_json_data = simdjson::padded_string(data);
+}
+
+static auto
+makeCellphoneProto(ParallelCellphone *tmp_cellphone) {
+    using namespace simdjson_peval;
+
+    return
+        array<simdjson::ondemand::document_reference>(
+            string_value(&tmp_cellphone->asin),
+            string_value(&tmp_cellphone->brand),
+            string_value(&tmp_cellphone->title),
+            string_value(&tmp_cellphone->url),
+            string_value(&tmp_cellphone->image),
+            number_value(&tmp_cellphone->rating),
+            string_value(&tmp_cellphone->reviewUrl),
+            number_value(&tmp_cellphone->totalReviews),
+            string_value(&tmp_cellphone->prices));
+}
+
+// Arguments: number of threads, ordered output (0/1).
+static void
+cellphone_parallel(benchmark::State& state) {
+    using namespace simdjson_peval;
+
+    eval_parallel_options options;
+    options.threads = size_t(state.range(0));
+    options.ordered = (state.range(1) != 0);
+
+    size_t records = 0;
+    for (auto _ : state) {
+        error errors;
+        records = 0;
+
+        eval_many_parallel<ParallelCellphone>(
+            parallel_json_data, makeCellphoneProto,
+            [&records](record_batch<ParallelCellphone> *batch, error *err) {
+                records += batch->size();
+                benchmark::DoNotOptimize(batch->begin());
+            },
+            &errors, options);
+    }
+
+    state.SetBytesProcessed(
+        int64_t(state.iterations()) * int64_t(parallel_json_data.size()));
+    state.counters["records"] = double(records);
+}
+BENCHMARK(cellphone_parallel)
+    ->Setup(setupParallelLoadJSON)
+    ->ArgNames({"threads", "ordered"})
+    ->ArgsProduct({{1, 2, 4, 8, 16}, {0, 1}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+
+// Sequential reference for the pipeline.
+static void
+cellphone_sequential(benchmark::State& state) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    ParallelCellphone tmp_cellphone;
+    auto proto = makeCellphoneProto(&tmp_cellphone);
+
+    for (auto _ : state) {
+        error errors;
+        eval_many(
+            &parser, parallel_json_data, &tmp_cellphone, proto,
+            [](record_batch<ParallelCellphone> *batch, error *err) {
+                benchmark::DoNotOptimize(batch->begin());
+            },
+            &errors);
+    }
+
+    state.SetBytesProcessed(
+        int64_t(state.iterations()) * int64_t(parallel_json_data.size()));
+}
+BENCHMARK(cellphone_sequential)
+    ->Setup(setupParallelLoadJSON)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+
+// Argument: block size of the pipeline in KiB.
+static void
+cellphone_pipeline(benchmark::State& state) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    ParallelCellphone tmp_cellphone;
+    auto proto = makeCellphoneProto(&tmp_cellphone);
+
+    eval_pipeline_options options;
+    options.block_size = size_t(state.range(0)) << 10;
+
+    for (auto _ : state) {
+        error errors;
+        std::string_view input(parallel_json_data);
+
+        eval_many_pipeline(
+            &parser,
+            [&input](char *buffer, size_t capacity)
+            -> simdjson::simdjson_result<size_t> {
+                auto size = std::min(capacity, input.size());
+                std::memcpy(buffer, input.data(), size);
+                input.remove_prefix(size);
+                return size;
+            },
+            &tmp_cellphone, proto,
+            [](record_batch<ParallelCellphone> *batch, error *err) {
+                benchmark::DoNotOptimize(batch->begin());
+            },
+            &errors, options);
+    }
+
+    state.SetBytesProcessed(
+        int64_t(state.iterations()) * int64_t(parallel_json_data.size()));
+}
+BENCHMARK(cellphone_pipeline)
+    ->Setup(setupParallelLoadJSON)
+    ->ArgName("block_kib")
+    ->RangeMultiplier(4)->Range(64, 4096)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+
+// Huge array: all cellphones as elements of a single top-level array.
+static simdjson::padded_string array_json_data;
+
+static void
+setupArrayLoadJSON(const benchmark::State& state) {
+    setupParallelLoadJSON(state);
+    if (array_json_data.size() != 0) {
+        return;
+    }
+
+    std::string data;
+    data.reserve(parallel_json_data.size() + 2);
+    data.push_back('[');
+    for (auto c : std::string_view(parallel_json_data)) {
+        data.push_back(c == '\n' ? ',' : c);
+    }
+    data.back() = ']';
+
+    array_json_data = simdjson::padded_string(data);
+}
+
+static auto
+makeCellphoneElementProto(ParallelCellphone *tmp_cellphone) {
+    using namespace simdjson_peval;
+
+    return
+        array(
+            string_value(&tmp_cellphone->asin),
+            string_value(&tmp_cellphone->brand),
+            string_value(&tmp_cellphone->title),
+            string_value(&tmp_cellphone->url),
+            string_value(&tmp_cellphone->image),
+            number_value(&tmp_cellphone->rating),
+            string_value(&tmp_cellphone->reviewUrl),
+            number_value(&tmp_cellphone->totalReviews),
+            string_value(&tmp_cellphone->prices));
+}
+
+// Sequential reference for the huge array.
+static void
+cellphone_array_sequential(benchmark::State& state) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    ParallelCellphone tmp_cellphone;
+
+    for (auto _ : state) {
+        std::vector<ParallelCellphone> cellphones;
+        error errors;
+
+        auto proto =
+            array_to_out_iter<simdjson::ondemand::document>(
+                back_inserter(cellphones), &tmp_cellphone,
+                makeCellphoneElementProto(&tmp_cellphone));
+
+        auto doc = parser.iterate(array_json_data);
+        proto(doc, &errors);
+        benchmark::DoNotOptimize(cellphones.data());
+    }
+
+    state.SetBytesProcessed(
+        int64_t(state.iterations()) * int64_t(array_json_data.size()));
+}
+BENCHMARK(cellphone_array_sequential)
+    ->Setup(setupArrayLoadJSON)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Argument: number of threads.
+static void
+cellphone_array_parallel(benchmark::State& state) {
+    using namespace simdjson_peval;
+
+    eval_array_parallel_options options;
+    options.threads = size_t(state.range(0));
+
+    size_t steals = 0;
+    for (auto _ : state) {
+        std::vector<ParallelCellphone> cellphones;
+        error errors;
+
+        auto stats =
+            eval_array_parallel<ParallelCellphone>(
+                array_json_data, back_inserter(cellphones),
+                makeCellphoneElementProto, &errors, options);
+        steals = stats.steals;
+        benchmark::DoNotOptimize(cellphones.data());
+    }
+
+    state.SetBytesProcessed(
+        int64_t(state.iterations()) * int64_t(array_json_data.size()));
+    state.counters["steals"] = double(steals);
+}
+BENCHMARK(cellphone_array_parallel)
+    ->Setup(setupArrayLoadJSON)
+    ->ArgName("threads")
+    ->RangeMultiplier(2)->Range(1, 16)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+
+// Requests with one document each: parser per request or from a pool
+// /////////////////////////////////////////////////////////////////////////
+
+// Number of requests evaluated per iteration.
+static const size_t NUM_REQUESTS = 1000;
+
+// Argument: use parser pool (0/1).
+static void
+cellphone_requests(benchmark::State& state) {
+    using namespace simdjson_peval;
+
+    const auto use_pool = (state.range(0) != 0);
+    parser_pool pool;
+
+    // one line of the input per request.
+    std::vector<simdjson::padded_string> requests;
+    std::string_view data(parallel_json_data.data(), parallel_json_data.size());
+    while (requests.size() < NUM_REQUESTS && !data.empty()) {
+        const auto line = data.substr(0, data.find('\n') + 1);
+        requests.emplace_back(line);
+        data.remove_prefix(line.size());
+    }
+
+    ParallelCellphone tmp_cellphone;
+    auto proto = makeCellphoneProto(&tmp_cellphone);
+
+    for (auto _ : state) {
+        for (auto &request : requests) {
+            parser_pool::handle pooled_parser;
+            std::unique_ptr<simdjson::ondemand::parser> own_parser;
+            simdjson::ondemand::parser *parser;
+            if (use_pool) {
+                pooled_parser = pool.acquire();
+                parser = pooled_parser.get();
+            }
+            else {
+                own_parser = std::make_unique<simdjson::ondemand::parser>();
+                parser = own_parser.get();
+            }
+
+            error errors;
+            eval_many(
+                parser, request, &tmp_cellphone, proto,
+                [](record_batch<ParallelCellphone> *batch, error *err) {
+                    benchmark::DoNotOptimize(batch->begin());
+                },
+                &errors);
+        }
+    }
+
+    state.SetItemsProcessed(
+        int64_t(state.iterations()) * int64_t(requests.size()));
+    state.counters["parsers"] = double(pool.get_stats().created);
+}
+BENCHMARK(cellphone_requests)
+    ->Setup(setupParallelLoadJSON)
+    ->ArgName("pool")
+    ->Arg(0)->Arg(1)
+    ->Unit(benchmark::kMillisecond);
+
+
+
+// Directory of files of very different sizes
+// /////////////////////////////////////////////////////////////////////////
+
+// Number of small files besides the huge one.
+static const size_t NUM_SMALL_FILES = 256;
+
+static std::vector<std::string> files_paths;
+
+// One huge file with half of the replicated input and small files
+// sharing the other half.
+static void
+setupParallelFiles(const benchmark::State& state) {
+    if (!files_paths.empty()) {
+        return;
+    }
+
+    setupParallelLoadJSON(state);
+
+    namespace fs = std::filesystem;
+    const auto dir = fs::temp_directory_path() / "simdjson_peval_files_bench";
+    fs::create_directories(dir);
+
+    std::string_view data(parallel_json_data.data(), parallel_json_data.size());
+    auto take_lines =
+        [&data](size_t size) {
+            auto pos = data.find('\n', std::min(size, data.size()) - 1);
+            const auto lines =
+                data.substr(0, (pos == std::string_view::npos) ? pos : pos + 1);
+            data.remove_prefix(lines.size());
+            return lines;
+        };
+
+    const auto huge_size = data.size() / 2;
+    const auto small_size = (data.size() - huge_size) / NUM_SMALL_FILES;
+    for (size_t idx = 0; idx <= NUM_SMALL_FILES && !data.empty(); ++idx) {
+        const auto path =
+            (dir / ("part" + std::to_string(idx) + ".ndjson")).string();
+        std::ofstream(path, std::ios::binary)
+            << take_lines((idx == 0) ? huge_size : small_size);
+        files_paths.push_back(path);
+    }
+}
+
+// Arguments: number of threads, split huge files (0/1).
+static void
+cellphone_files(benchmark::State& state) {
+    using namespace simdjson_peval;
+
+    eval_files_options options;
+    options.threads = size_t(state.range(0));
+    options.split_files = (state.range(1) != 0);
+
+    eval_files_stats stats;
+    for (auto _ : state) {
+        error errors;
+        stats =
+            eval_files_parallel<ParallelCellphone>(
+                files_paths, makeCellphoneProto,
+                [](record_batch<ParallelCellphone> *batch, error *err) {
+                    benchmark::DoNotOptimize(batch->begin());
+                },
+                &errors, options);
+    }
+
+    double min_utilization = 1;
+    double sum_utilization = 0;
+    for (const auto &worker : stats.workers) {
+        min_utilization = std::min(min_utilization, worker.utilization);
+        sum_utilization += worker.utilization;
+    }
+
+    state.SetBytesProcessed(
+        int64_t(state.iterations()) * int64_t(parallel_json_data.size()));
+    state.counters["records"] = double(stats.records);
+    state.counters["units"] = double(stats.units);
+    state.counters["steals"] = double(stats.steals);
+    state.counters["min_util"] = min_utilization;
+    state.counters["avg_util"] =
+        sum_utilization / double(std::max(stats.workers.size(), size_t(1)));
+}
+BENCHMARK(cellphone_files)
+    ->Setup(setupParallelFiles)
+    ->ArgNames({"threads", "split"})
+    ->ArgsProduct({{1, 2, 4, 8, 16}, {0, 1}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
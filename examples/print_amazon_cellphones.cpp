@@ -25,6 +25,7 @@
 //
 
 #include <simdjson_peval.h>
+#include <simdjson_peval_ndjson.h>
 
 #include <iostream>
 #include <vector>
@@ -68,25 +69,24 @@ main(int argc, char *argv[]) {
             number_value(&tmp_phone.totalReviews),
             string_value(&tmp_phone.prices));
 
-    // create stream of documents
-    auto docStream = parser.iterate_many(padded_json.value());
+    // save batches of phones without errors.
+    auto save_phones =
+        [&cellphones](record_batch<Cellphone> *batch, error *err) {
+            for (auto &phone : *batch) {
+                cellphones.push_back(std::move(phone));
+            }
+        };
 
-    size_t idx = 0;
+    eval_many_options options;
+    options.skip_documents = 1; // ignore fist document.
 
     auto errors = error(true); // report alle errors in a single container.
-    for (auto json_document_ref : docStream.value()) {
-        // set scope with document number:
-        error::path_scope doc_scope(&errors, idx);
 
-        if (idx != 0) { // ignore fist document.
-            eval_amazon_data(json_document_ref, &errors); // evaluate document.
-            if (!errors) {
-                // save data
-                cellphones.push_back(std::move(tmp_phone));
-            }
-        }
-        ++idx; // count documents.
-    }
+    // evaluate all documents of the stream.
+    auto stats =
+        eval_many(
+            &parser, padded_json.value(), &tmp_phone, eval_amazon_data,
+            save_phones, &errors, options);
 
     if (errors) {
         // show errors
@@ -111,5 +111,5 @@ main(int argc, char *argv[]) {
     }
 
     std::cout << "====================\n"
-              << "total: " << (idx-1) << " phones\n";
+              << "total: " << stats.records << " phones\n";
 }
@@ -33,6 +33,24 @@
 #include <functional>
 #include <string_view>
 #include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <cmath>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 
 /**
@@ -117,12 +135,12 @@ struct _trace_element {
 /// Type of trace element buffer.
 using _trace_buffer_type = std::vector<_trace_element>;
 
-/// Buffer to store trace elements.
-extern _trace_buffer_type _trace_buffer;
+/// Buffer to store trace elements (one per thread).
+extern thread_local _trace_buffer_type _trace_buffer;
 
 /// Declare gloval trace buffer.
 #define _SIMDJSON_PEVAL_DEF_GLOBAL_TRACE_BUFFER \
-     simdjson_peval::_trace_buffer_type simdjson_peval::_trace_buffer
+     thread_local simdjson_peval::_trace_buffer_type simdjson_peval::_trace_buffer
 
 /// write vector of log elements.
 inline std::ostream&
@@ -180,6 +198,325 @@ operator<<(std::ostream& os, const _trace_buffer_type &trace) {
 #endif // _VECTOR_SET_DEBUG
 
 
+///
+/// @name Error codes.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
+
+/**
+ * Evaluation was cancelled by a `cancellation_token`.
+ *
+ * The error codes of simdjson_peval follow the codes of simdjson, so
+ * they are stored in error containers like all other codes.
+ */
+inline constexpr simdjson::error_code CANCELLED =
+    simdjson::error_code(int(simdjson::NUM_ERROR_CODES));
+
+/**
+ * Evaluation was stopped at the deadline of an `eval_guard`.
+ */
+inline constexpr simdjson::error_code DEADLINE_EXCEEDED =
+    simdjson::error_code(int(simdjson::NUM_ERROR_CODES) + 1);
+
+/**
+ * Nesting depth exceeds `eval_limits::max_depth`.
+ */
+inline constexpr simdjson::error_code DEPTH_LIMIT_EXCEEDED =
+    simdjson::error_code(int(simdjson::NUM_ERROR_CODES) + 2);
+
+/**
+ * Number of elements of an array exceeds
+ * `eval_limits::max_array_elements`.
+ */
+inline constexpr simdjson::error_code ARRAY_LIMIT_EXCEEDED =
+    simdjson::error_code(int(simdjson::NUM_ERROR_CODES) + 3);
+
+/**
+ * Total number of elements exceeds `eval_limits::max_elements`.
+ */
+inline constexpr simdjson::error_code ELEMENT_LIMIT_EXCEEDED =
+    simdjson::error_code(int(simdjson::NUM_ERROR_CODES) + 4);
+
+/**
+ * Total size of output strings exceeds `eval_limits::max_string_bytes`.
+ */
+inline constexpr simdjson::error_code STRING_LIMIT_EXCEEDED =
+    simdjson::error_code(int(simdjson::NUM_ERROR_CODES) + 5);
+
+// @name Internal implementations
+// @private
+namespace internal {
+
+/**
+ * Get text of an error code of simdjson or simdjson_peval.
+ *
+ * @private
+ */
+inline const char *
+error_text(simdjson::error_code code) {
+    switch (int(code)) {
+    case int(CANCELLED):
+        return "The evaluation was cancelled.";
+    case int(DEADLINE_EXCEEDED):
+        return "The deadline of the evaluation was exceeded.";
+    case int(DEPTH_LIMIT_EXCEEDED):
+        return "The nesting depth exceeds the limit.";
+    case int(ARRAY_LIMIT_EXCEEDED):
+        return "The number of array elements exceeds the limit.";
+    case int(ELEMENT_LIMIT_EXCEEDED):
+        return "The total number of elements exceeds the limit.";
+    case int(STRING_LIMIT_EXCEEDED):
+        return "The total size of output strings exceeds the limit.";
+    default:
+        if (code < simdjson::SUCCESS || code >= simdjson::NUM_ERROR_CODES) {
+            return simdjson::error_message(simdjson::UNEXPECTED_ERROR);
+        }
+        return simdjson::error_message(code);
+    }
+}
+
+} // namespace internal
+
+/// @}
+
+///
+/// @name Cancellation of evaluations.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
+
+/**
+ * Token to cancel evaluations from another thread.
+ *
+ * All methods are thread safe.
+ */
+class cancellation_token {
+public:
+
+    cancellation_token() = default;
+
+    cancellation_token(const cancellation_token &) = delete;
+    cancellation_token &operator=(const cancellation_token &) = delete;
+
+    /**
+     * Request to cancel all evaluations using this token.
+     */
+    void
+    cancel() {
+        cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    /**
+     * Checks if the cancellation was requested.
+     */
+    bool
+    is_cancelled() const {
+        return cancelled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Withdraw the cancellation, so the token can be reused.
+     */
+    void
+    reset() {
+        cancelled.store(false, std::memory_order_relaxed);
+    }
+
+private:
+
+    /// Flag: cancellation requested.
+    std::atomic<bool> cancelled{false};
+
+}; // class cancellation_token
+
+/**
+ * Guard to stop a long-running evaluation.
+ *
+ * A guard is attached to an error container by `error::set_guard()`.
+ * The evaluation functions check it at array element, object member
+ * and document boundaries. The evaluation stops, if the token is
+ * cancelled or the deadline is reached. Each error container seeing
+ * this adds `CANCELLED` or `DEADLINE_EXCEEDED` once, so the record in
+ * evaluation fails; the evaluation functions then skip all remaining
+ * elements.
+ *
+ * The token is checked at each boundary, the clock only every
+ * `check_interval` boundaries of an error container. A guard may be
+ * shared by the error containers of multiple threads.
+ */
+class eval_guard {
+public:
+
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * Constructor.
+     *
+     * @param token Pointer to cancellation token or `nullptr`.
+     */
+    explicit eval_guard(const cancellation_token *token = nullptr)
+        : token(token)
+    { /* empty */ }
+
+    eval_guard(const eval_guard &) = delete;
+    eval_guard &operator=(const eval_guard &) = delete;
+
+    /**
+     * Set the deadline of the evaluation.
+     *
+     * @param new_deadline Point in time to stop the evaluation.
+     */
+    void
+    set_deadline(clock::time_point new_deadline) {
+        deadline = new_deadline;
+    }
+
+    /**
+     * Set the deadline relative to now.
+     *
+     * @param timeout Time until the evaluation is stopped.
+     */
+    void
+    set_timeout(clock::duration timeout) {
+        deadline = clock::now() + timeout;
+    }
+
+    /**
+     * Set the number of boundaries between two checks of the clock.
+     *
+     * @param interval Number of boundaries (at least 1).
+     */
+    void
+    set_check_interval(size_t interval) {
+        check_interval = std::max(interval, size_t(1));
+    }
+
+    /**
+     * Get the number of boundaries between two checks of the clock.
+     */
+    size_t
+    get_check_interval() const {
+        return check_interval;
+    }
+
+    /**
+     * Get the reason why the evaluation was stopped.
+     *
+     * @return `CANCELLED`, `DEADLINE_EXCEEDED` or `simdjson::SUCCESS`,
+     *         if the evaluation wasn't stopped.
+     */
+    simdjson::error_code
+    get_stop_code() const {
+        return stop_code.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Rearm the guard for the next evaluation (the deadline is kept).
+     */
+    void
+    reset() {
+        stop_code.store(simdjson::SUCCESS, std::memory_order_relaxed);
+    }
+
+    /**
+     * Check the token and optionally the clock.
+     *
+     * @param check_clock Flag: compare the clock with the deadline.
+     *
+     * @return Code to stop with or `simdjson::SUCCESS`.
+     */
+    simdjson::error_code
+    check(bool check_clock) const {
+        if (token && token->is_cancelled()) {
+            return CANCELLED;
+        }
+        if (check_clock
+            && deadline != clock::time_point::max()
+            && clock::now() >= deadline)
+        {
+            return DEADLINE_EXCEEDED;
+        }
+
+        return simdjson::SUCCESS;
+    }
+
+    /**
+     * Mark the evaluation as stopped.
+     *
+     * @param code Reason to stop.
+     *
+     * @return `true` if the evaluation wasn't stopped before.
+     */
+    bool
+    stop(simdjson::error_code code) {
+        auto expected = simdjson::SUCCESS;
+        return
+            stop_code.compare_exchange_strong(
+                expected, code, std::memory_order_relaxed);
+    }
+
+private:
+
+    /// Token to check or `nullptr`.
+    const cancellation_token *token;
+
+    /// Deadline of the evaluation.
+    clock::time_point deadline = clock::time_point::max();
+
+    /// Number of boundaries between two checks of the clock.
+    size_t check_interval = 1024;
+
+    /// Reason why the evaluation was stopped.
+    std::atomic<simdjson::error_code> stop_code{simdjson::SUCCESS};
+
+}; // class eval_guard
+
+/// @}
+
+///
+/// @name Resource limits of evaluations.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
+
+/**
+ * Limits of the resources used by an evaluation.
+ *
+ * Limits are attached to an error container by `error::set_limits()`.
+ * The evaluation functions check them at array element and object
+ * member boundaries before the element is evaluated, and before an
+ * output string is copied. The first exceeded limit adds its error
+ * code; the evaluation then stops like a cancelled evaluation.
+ *
+ * Functions evaluating document streams or the elements of huge arrays
+ * as records apply the limits to each record.
+ */
+struct eval_limits {
+    /// Maximum nesting depth of array elements and object members.
+    size_t max_depth = std::numeric_limits<size_t>::max();
+
+    /// Maximum number of elements of each array.
+    size_t max_array_elements = std::numeric_limits<size_t>::max();
+
+    /// Maximum total number of array elements and object members.
+    size_t max_elements = std::numeric_limits<size_t>::max();
+
+    /// Maximum total size of strings copied into `std::string`.
+    size_t max_string_bytes = std::numeric_limits<size_t>::max();
+};
+
+/**
+ * Resources used by an evaluation, counted while limits are attached.
+ */
+struct eval_usage {
+    /// Total number of array elements and object members.
+    size_t elements = 0;
+
+    /// Total size of strings copied into `std::string`.
+    size_t string_bytes = 0;
+};
+
+/// @}
+
+
 /**
  * Single error message.
  */
@@ -212,7 +549,7 @@ public:
      */
     const char *
     get_text() const {
-        return simdjson::error_message(code);
+        return internal::error_text(code);
     }
 
     /**
@@ -241,106 +578,683 @@ private:
 
 
 /**
- * Error container for collecting all errors that occurred during the
- * evaluation.
+ * Aggregated error statistics.
+ *
+ * Instead of storing a message for every single error, this class
+ * counts errors by the path template of the element (array indexes
+ * are collapsed to `[*]`, e.g. `<root>.statuses[*].user.name`) and
+ * the error code. For each combination the path of the first error
+ * and a bounded list of sample paths is kept.
+ *
+ * The memory used is limited by the constructor arguments no matter
+ * how many errors are added. Errors for combinations exceeding
+ * `max_entries` are only counted as dropped.
  */
-class error {
+class error_histogram {
 public:
-    using message_container = std::vector<error_message>;
 
     /**
-     * Scope class to create path information.
-     *
-     * Create an instance of this class to create another path level
-     * inside an error container.
+     * Statistics of a single path template and error code.
      */
-    class path_scope {
+    class entry {
+        friend class error_histogram;
     public:
 
         /**
-         * Constructor for array elements.
-         *
-         * @param err Pointer to error container to create a new
-         *            path level for new errors added.
-         * @param idx Index of array which is processing.
+         * get error code.
          */
-        path_scope(error *err, size_t idx);
+        simdjson::error_code
+        get_code() const {
+            return code;
+        }
 
         /**
-         * Constructor for object member elements.
-         *
-         * @param err Pointer to error container to create a new
-         *            path level for new errors added.
-         * @param member Name of the member.
+         * get error message.
          */
-        path_scope(error *err, std::string_view member);
+        const char *
+        get_text() const {
+            return internal::error_text(code);
+        }
 
         /**
-         * Destructor.
+         * get path template with collapsed array indexes.
          */
-        ~path_scope();
+        const std::string &
+        get_path() const {
+            return path;
+        }
+
+        /**
+         * get number of errors counted.
+         */
+        size_t
+        get_count() const {
+            return count;
+        }
+
+        /**
+         * get path of the first error counted.
+         */
+        const std::string &
+        get_first_path() const {
+            return first_path;
+        }
+
+        /**
+         * get sample paths of the most recent errors (unordered).
+         */
+        const std::vector<std::string> &
+        get_samples() const {
+            return samples;
+        }
+
+        /**
+         * Converts all information into a one-line message.
+         */
+        std::string
+        to_string() const;
 
     private:
 
-        /// Pointer to error container.
-        error *error_ptr;
+        /// hash of `path` and `code`.
+        size_t hash;
 
-    }; // class path_scope
+        /// error code
+        simdjson::error_code code;
+
+        /// path template.
+        std::string path;
+
+        /// number of errors.
+        size_t count;
+
+        /// path of first error.
+        std::string first_path;
 
+        /// paths of the most recent errors.
+        std::vector<std::string> samples;
+
+        /// next sample to overwrite, if `samples` is full.
+        size_t next_sample;
+
+    }; // class error_histogram::entry
+
+    using entry_container = std::vector<entry>;
 
     /**
      * Constructor.
      *
-     * @param pflag Flag indicating whether the container should collect
-     *              element paths for errors.
+     * @param max_entries Maximum number of path/code combinations.
+     * @param max_samples Maximum number of sample paths per combination.
+     * @param max_path_length Paths are truncated to this length.
      */
-    error(bool pflag = false) : path_flag(pflag) { /* empty */ }
-
+    error_histogram(
+        size_t max_entries = 256,
+        size_t max_samples = 4,
+        size_t max_path_length = 256)
+        : max_entries(max_entries)
+        , max_samples(max_samples)
+        , max_path_length(max_path_length)
+    {
+        entries.reserve(max_entries);
+    }
 
     /**
-     * Convert error container into boolean.
+     * Get statistics of all path/code combinations.
      *
-     * @return `true` if errors where collected.
+     * @return Entries in order of their first occurrence.
      */
-    operator bool() const {
-        return (!messages.empty());
+    const entry_container &
+    get_entries() const {
+        return entries;
     }
 
     /**
-     * Get all collected messages.
-     *
-     * @return Const reference to vector with collected error elements.
+     * Get number of all errors added.
      */
-    const message_container &
-    get_messages() const {
-        return messages;
+    size_t
+    get_total() const {
+        return total;
     }
 
     /**
-     * Add a new error if not success.
-     *
-     * Collect any error code which is not `simdjson::SUCCESS`.
+     * Get number of errors not counted, because `max_entries` was
+     * reached.
+     */
+    size_t
+    get_dropped() const {
+        return dropped;
+    }
+
+    /**
+     * Count an error.
      *
-     * @param code Errorcode.
+     * @param code Error code.
+     * @param path_template Path with collapsed array indexes.
+     * @param path Path to the element where the error occurred.
      */
     void
-    add(simdjson::error_code code);
+    add(simdjson::error_code code,
+        std::string_view path_template,
+        std::string_view path);
 
     /**
-     * Checks if path information collection is enabled.
+     * Add all statistics of another histogram.
      *
-     * @return `true` if collection of path information is enabled.
+     * @param other Histogram to merge.
+     * @param index_offset Value added to the leading array index of
+     *                     all paths of `other` (see `error::append()`).
      */
-    bool
-    is_path_enabled() const {
-        return path_flag;
+    void
+    merge(const error_histogram &other, size_t index_offset = 0);
+
+    /**
+     * Remove all statistics.
+     */
+    void
+    clear() {
+        entries.clear();
+        total = 0;
+        dropped = 0;
     }
 
     /**
-     * Convert all collected errors into one string.
+     * Convert all entries into one string.
      *
-     * @return All collected errors in one string. Errors are separated
-     *         by line breaks.
+     * @return All entries in one string separated by line breaks.
+     */
+    std::string
+    to_string() const;
+
+private:
+
+    /// statistics.
+    entry_container entries;
+
+    /// Maximum number of entries.
+    size_t max_entries;
+
+    /// Maximum number of samples per entry.
+    size_t max_samples;
+
+    /// Maximum length of stored paths.
+    size_t max_path_length;
+
+    /// number of all errors.
+    size_t total = 0;
+
+    /// number of errors not counted by an entry.
+    size_t dropped = 0;
+
+    /**
+     * Find or create entry.
+     *
+     * @return Pointer to entry or `nullptr`, if `max_entries` is reached.
+     */
+    entry *
+    get_entry(simdjson::error_code code, std::string_view path_template);
+
+    /**
+     * Add a sample path to an entry.
+     */
+    void
+    add_sample(entry *entry_ptr, std::string_view path);
+
+}; // class error_histogram
+
+
+/**
+ * Error container for collecting all errors that occurred during the
+ * evaluation.
+ */
+class error {
+public:
+    using message_container = std::vector<error_message>;
+
+    /**
+     * Scope class to create path information.
+     *
+     * Create an instance of this class to create another path level
+     * inside an error container.
+     */
+    class path_scope {
+    public:
+
+        /**
+         * Constructor for array elements.
+         *
+         * @param err Pointer to error container to create a new
+         *            path level for new errors added.
+         * @param idx Index of array which is processing.
+         */
+        path_scope(error *err, size_t idx);
+
+        /**
+         * Constructor for object member elements.
+         *
+         * @param err Pointer to error container to create a new
+         *            path level for new errors added.
+         * @param member Name of the member.
+         */
+        path_scope(error *err, std::string_view member);
+
+        /**
+         * Destructor.
+         */
+        ~path_scope();
+
+    private:
+
+        /// Pointer to error container.
+        error *error_ptr;
+
+    }; // class path_scope
+
+    /**
+     * Scope class of a record staging the values of reducers.
+     *
+     * Functions storing records (e.g. `eval_many()` or
+     * `array_to_out_iter()`) create an instance for each record. Values
+     * passed to `reduce()` inside the scope are staged, until the
+     * record is accepted by `commit()`. The outermost record adds them
+     * to the accumulators, nested records leave them to the enclosing
+     * one. Values of records not committed (with errors or rejected by
+     * `where()`) are discarded.
+     */
+    class record_scope {
+    public:
+
+        /**
+         * Constructor.
+         *
+         * @param err Pointer to error container to stage the values.
+         */
+        explicit record_scope(error *err);
+
+        record_scope(const record_scope &) = delete;
+        record_scope &operator=(const record_scope &) = delete;
+
+        /**
+         * Destructor: discards the values, if not committed.
+         */
+        ~record_scope();
+
+        /**
+         * Accept the values staged by the record.
+         */
+        void
+        commit();
+
+    private:
+
+        /// Pointer to error container.
+        error *error_ptr;
+
+        /// Number of staged values before the record.
+        size_t begin;
+
+        /// Flag: values are accepted.
+        bool committed = false;
+
+    }; // class record_scope
+
+
+    /**
+     * Constructor.
+     *
+     * @param pflag Flag indicating whether the container should collect
+     *              element paths for errors.
+     */
+    error(bool pflag = false) : path_flag(pflag) { /* empty */ }
+
+    /**
+     * Constructor for aggregated errors.
+     *
+     * Errors are not stored as messages but counted by the histogram.
+     * The collection of element paths is always enabled.
+     *
+     * @param hist Pointer to histogram to count errors.
+     */
+    error(error_histogram *hist) : histogram(hist), path_flag(true) {
+        _SIMDJSON_PEVAL_ASSERT(hist != nullptr);
+    }
+
+
+    /**
+     * Convert error container into boolean.
+     *
+     * @return `true` if errors where collected.
+     */
+    operator bool() const {
+        return (count != 0);
+    }
+
+    /**
+     * Get number of all errors added.
+     *
+     * Unlike the number of messages, this includes errors counted by
+     * a histogram.
+     *
+     * @return Number of errors.
+     */
+    size_t
+    get_count() const {
+        return count;
+    }
+
+    /**
+     * Get histogram used to count errors.
+     *
+     * @return Pointer to histogram or `nullptr`, if errors are
+     *         collected as messages.
+     */
+    error_histogram *
+    get_histogram() const {
+        return histogram;
+    }
+
+    /**
+     * Get all collected messages.
+     *
+     * @return Const reference to vector with collected error elements.
+     */
+    const message_container &
+    get_messages() const {
+        return messages;
+    }
+
+    /**
+     * Add a new error if not success.
+     *
+     * Collect any error code which is not `simdjson::SUCCESS`.
+     *
+     * @param code Errorcode.
+     */
+    void
+    add(simdjson::error_code code);
+
+    /**
+     * Add all errors of another container.
+     *
+     * This is used to combine errors of documents evaluated with
+     * separate containers, e.g. by different threads. The array index
+     * of the first path level (`<root>[n]`) of all errors added is
+     * increased by `index_offset`.
+     *
+     * If this container uses a histogram, messages of `other` are
+     * counted by the histogram. Errors counted by a histogram of
+     * `other` can only be merged into a histogram, otherwise they are
+     * only included in `get_count()`.
+     *
+     * @param other Error container to add.
+     * @param index_offset Value added to the leading array index.
+     */
+    void
+    append(const error &other, size_t index_offset = 0);
+
+    /**
+     * Remove all collected errors and the state of the current record.
+     *
+     * The state of the record is the rejection by `where()`, a pending
+     * `slice()`, the used resources and an exceeded limit, so the
+     * container can be reused for the next document. The capacity of
+     * the message container is kept, so that the container can be
+     * reused without new allocations. The current path is not changed,
+     * so this method can be called inside a path scope. A histogram
+     * used to count errors is not cleared.
+     */
+    void
+    clear() {
+        messages.clear();
+        count = 0;
+        reset_usage();
+        guard_stop_seen = false;
+        rejected = false;
+        slice_begin = 0;
+        slice_end = std::numeric_limits<size_t>::max();
+    }
+
+    /**
+     * Remove all collected errors and the current path.
+     *
+     * Like `clear()`, but also removes all path levels. This method
+     * must not be called while a `path_scope` of this container
+     * exists.
+     */
+    void
+    reset() {
+        path_vector.clear();
+        depth = 0;
+        pending_values.clear();
+        clear();
+    }
+
+    /**
+     * Checks if path information collection is enabled.
+     *
+     * @return `true` if collection of path information is enabled.
+     */
+    bool
+    is_path_enabled() const {
+        return path_flag;
+    }
+
+    /**
+     * Attach a guard to stop long-running evaluations.
+     *
+     * @param guard_ptr Pointer to the guard or `nullptr`.
+     */
+    void
+    set_guard(eval_guard *guard_ptr) {
+        guard = guard_ptr;
+        guard_checks = 0;
+        guard_stop_seen = false;
+    }
+
+    /**
+     * Get the attached guard.
+     *
+     * @return Pointer to the guard or `nullptr`.
+     */
+    eval_guard *
+    get_guard() const {
+        return guard;
+    }
+
+    /**
+     * Mark the current record as rejected or accepted.
+     *
+     * Set by `where()` if its predicate fails. Functions storing
+     * records skip rejected records and accept the next one.
+     *
+     * @param flag `true` to reject the record.
+     */
+    void
+    set_rejected(bool flag) {
+        rejected = flag;
+    }
+
+    /**
+     * Checks if the current record is rejected by `where()`.
+     *
+     * The remaining members of a rejected record are not evaluated.
+     */
+    bool
+    is_rejected() const {
+        return rejected;
+    }
+
+    /**
+     * Select the elements of the next evaluated array.
+     *
+     * Set by `slice()` and `take()`. The next array function skips the
+     * elements before `begin` without evaluation and stops the
+     * iteration at `end`.
+     *
+     * @param begin Index of the first element.
+     * @param end Index behind the last element.
+     */
+    void
+    set_slice(size_t begin, size_t end) {
+        slice_begin = begin;
+        slice_end = end;
+    }
+
+    /**
+     * Get and clear the selected elements of the next evaluated array.
+     *
+     * @return Index of the first element and index behind the last
+     *         element.
+     */
+    std::pair<size_t, size_t>
+    take_slice() {
+        const auto result = std::make_pair(slice_begin, slice_end);
+        slice_begin = 0;
+        slice_end = std::numeric_limits<size_t>::max();
+        return result;
+    }
+
+    /**
+     * Attach resource limits.
+     *
+     * Must not be called while a `path_scope` of this container
+     * exists.
+     *
+     * @param limits_ptr Pointer to the limits or `nullptr`.
+     */
+    void
+    set_limits(const eval_limits *limits_ptr) {
+        limits = limits_ptr;
+        depth = 0;
+        reset_usage();
+    }
+
+    /**
+     * Get the attached resource limits.
+     *
+     * @return Pointer to the limits or `nullptr`.
+     */
+    const eval_limits *
+    get_limits() const {
+        return limits;
+    }
+
+    /**
+     * Get the resources used since the last reset.
+     */
+    const eval_usage &
+    get_usage() const {
+        return usage;
+    }
+
+    /**
+     * Reset the used resources to start the evaluation of a record.
+     *
+     * The current path level is the root of the record, so the nesting
+     * depth is counted from here.
+     */
+    void
+    reset_usage() {
+        usage = eval_usage();
+        base_depth = depth;
+        scope_idx = 0;
+        limit_code = simdjson::SUCCESS;
+    }
+
+    /**
+     * Checks the index of a top-level array element against
+     * `eval_limits::max_array_elements`.
+     *
+     * Used by functions evaluating each element of an array as a
+     * record. Must be called before `reset_usage()` of the record,
+     * which resets the index of the current path level. If the limit
+     * is exceeded, `ARRAY_LIMIT_EXCEEDED` is added.
+     *
+     * @param idx Index of the element.
+     *
+     * @return `true` if the evaluation has to stop.
+     */
+    bool
+    exceeds_array_limit(size_t idx) {
+        if (limits == nullptr || idx < limits->max_array_elements) {
+            return false;
+        }
+
+        stop_by_limit(ARRAY_LIMIT_EXCEEDED);
+        return true;
+    }
+
+    /**
+     * Account for a string copied into the output.
+     *
+     * Called by the evaluation functions before a string is copied. If
+     * the limit of string bytes is exceeded, `STRING_LIMIT_EXCEEDED`
+     * is added and the evaluation stops.
+     *
+     * @param size Size of the string.
+     *
+     * @return `true` if the string may be copied.
+     */
+    bool
+    use_string_bytes(size_t size) {
+        if (limits == nullptr) {
+            return true;
+        }
+        if (limit_code) {
+            return false;
+        }
+        if (size > limits->max_string_bytes - usage.string_bytes) {
+            stop_by_limit(STRING_LIMIT_EXCEEDED);
+            return false;
+        }
+
+        usage.string_bytes += size;
+        return true;
+    }
+
+    /**
+     * Pass a value to an accumulator of a reducer.
+     *
+     * Outside of a `record_scope` the value is added at once,
+     * otherwise it is staged until the outermost record is committed.
+     *
+     * @param add_fn Function adding the value to the accumulator.
+     * @param acc_ptr Pointer to the accumulator.
+     * @param value Value to add.
+     */
+    void
+    reduce(void (*add_fn)(void *, double), void *acc_ptr, double value) {
+        if (record_depth == 0) {
+            add_fn(acc_ptr, value);
+        }
+        else {
+            pending_values.push_back({add_fn, acc_ptr, value});
+        }
+    }
+
+    /**
+     * Checks if the evaluation has to stop.
+     *
+     * Called by the evaluation functions at array element, object
+     * member and document boundaries. If a guard is attached and it
+     * detects a cancellation or the deadline, or if a resource limit is
+     * exceeded, the reason is added as error once.
+     *
+     * @return `true` if the evaluation has to stop.
+     */
+    bool
+    is_stopped() {
+        return ((guard != nullptr || limits != nullptr) && check_stop());
+    }
+
+    /**
+     * Convert all collected errors into one string.
+     *
+     * If a histogram is used, the entries of the histogram are
+     * converted.
+     *
+     * @return All collected errors in one string. Errors are separated
+     *         by line breaks.
      */
     std::string
     to_string() const;
@@ -349,405 +1263,1443 @@ private:
     /// path element value.
     using path_value = std::variant<size_t, std::string_view>;
 
-    /// All collected messages.
-    message_container messages;
+    /// Value of a reducer staged until its record is committed.
+    struct pending_value {
+        /// Function adding the value to the accumulator.
+        void (*add_fn)(void *, double);
+
+        /// Pointer to the accumulator.
+        void *acc_ptr;
+
+        /// Value to add.
+        double value;
+    };
+
+    /// All collected messages.
+    message_container messages;
+
+    /// Current path to elements.
+    std::vector<path_value> path_vector;
+
+    /// Histogram to count errors instead of collecting messages.
+    error_histogram *histogram = nullptr;
+
+    /// Buffer for path templates passed to the histogram.
+    std::string template_buffer;
+
+    /// Buffer for paths passed to the histogram.
+    std::string path_buffer;
+
+    /// Number of errors added.
+    size_t count = 0;
+
+    /// Flag: track path for error messages.
+    bool path_flag;
+
+    /// Guard to stop the evaluation or `nullptr`.
+    eval_guard *guard = nullptr;
+
+    /// Number of boundaries checked with the guard.
+    size_t guard_checks = 0;
+
+    /// Flag: stop of the guard added to this container.
+    bool guard_stop_seen = false;
+
+    /// Resource limits or `nullptr`.
+    const eval_limits *limits = nullptr;
+
+    /// Resources used since the last reset.
+    eval_usage usage;
+
+    /// Number of path levels (counted while limits are attached).
+    size_t depth = 0;
+
+    /// Path level of the root of the current record.
+    size_t base_depth = 0;
+
+    /// Array index of the innermost path level.
+    size_t scope_idx = 0;
+
+    /// Exceeded limit or `simdjson::SUCCESS`.
+    simdjson::error_code limit_code = simdjson::SUCCESS;
+
+    /// Flag: current record rejected by `where()`.
+    bool rejected = false;
+
+    /// First element selected by `slice()`.
+    size_t slice_begin = 0;
+
+    /// Element behind the last one selected by `slice()`.
+    size_t slice_end = std::numeric_limits<size_t>::max();
+
+    /// Values of reducers staged by the open records.
+    std::vector<pending_value> pending_values;
+
+    /// Number of open records (`record_scope`).
+    size_t record_depth = 0;
+
+    /**
+     * Check the limits and the guard.
+     */
+    bool
+    check_stop();
+
+    /**
+     * Stop the evaluation because of an exceeded limit.
+     */
+    void
+    stop_by_limit(simdjson::error_code code);
+
+    /**
+     * Create string representation of element path.
+     */
+    std::string
+    create_path();
+
+    /**
+     * Write string representation of element path into a buffer.
+     *
+     * @param result Pointer to string to store the path.
+     * @param collapse_idx Write `[*]` instead of array indexes.
+     */
+    void
+    create_path(std::string *result, bool collapse_idx) const;
+
+}; // class error
+
+
+// helper methods
+// //////////////////////////////////////////////////////////////////////
+
+// @name Internal implementations
+// @private
+namespace internal {
+
+/**
+ * Check for JS `null` and set `is_null` reference.
+ *
+ * @private
+ *
+ * @param sj_result The `simdjson::simdjson_result<>` to be checked.
+ * @param is_null Pointer to location to store `null` status.
+ *
+ * @return `true` if `(is_null != nullptr)` and `sj_result` contains a
+ *         `null` value.
+ */
+template<typename SJValue>
+inline bool
+check_null(SJValue &sj_result, bool *is_null) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("check_null(SJValue,bool*)");
+    _SIMDJSON_PEVAL_TRACE("start");
+
+    if (!is_null) {
+        _SIMDJSON_PEVAL_TRACE("is_null:undef");
+        return false;
+    }
+
+    *is_null = sj_result.value().is_null();
+    _SIMDJSON_PEVAL_TRACE(*is_null ? "is_null:true" : "is_null:false");
+
+    return (*is_null);
+}
+
+/**
+ * Check for JS `null` and set optional value.
+ *
+ * @private
+ *
+ * @param sj_result The `simdjson::simdjson_result<>` to be checked.
+ * @param opt_value Pointer to optional value. The value is set to
+ *                  `std::nullopt`, if `sj_result` is `null`.
+ *
+ * @return `true` if `sj_result` contains a `null` value.
+ */
+template<typename SJValue, typename Optional>
+inline bool
+check_null(SJValue &sj_result, Optional *opt_value) {
+    _SIMDJSON_PEVAL_ASSERT(opt_value != nullptr);
+
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("check_null(SJValue,Optional)");
+    _SIMDJSON_PEVAL_TRACE("start");
+
+    if (!sj_result.value().is_null()) {
+        _SIMDJSON_PEVAL_TRACE("is_null:false");
+        return false;
+    }
+
+    _SIMDJSON_PEVAL_TRACE("is_null:true");
+
+    *opt_value = std::nullopt;
+    return true;
+}
+
+/**
+ * Create function to evaluate array element by array iterator.
+ *
+ * @private
+ *
+ * @param element_fn Evaluation function for an array element.
+ *
+ * @return Function that evaluates a single array element.
+ */
+template<typename ElementFn>
+inline auto
+array(ElementFn element_fn) {
+    using ArrayIter =
+        simdjson::simdjson_result<simdjson::ondemand::array_iterator>;
+
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("internal::array(ElementFn)");
+    _SIMDJSON_PEVAL_TRACE("start");
+
+    return
+        [element_fn]
+        (ArrayIter *sj_array_iter, ArrayIter *sj_array_end,
+         size_t sj_array_idx,
+         error *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
+        {
+            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+
+            error::path_scope array_idx_scope(err, sj_array_idx);
+            if (*sj_array_iter == *sj_array_end) {
+                const auto code = simdjson::INDEX_OUT_OF_BOUNDS;
+                _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                err->add(code);
+            }
+            else {
+                auto sj_result = **sj_array_iter;
+                element_fn(sj_result, err);
+            }
+
+            _SIMDJSON_PEVAL_TRACE_EVAL_END();
+        };
+}
+
+/**
+ * Create function to evaluate array elements by array iterator.
+ *
+ * @private
+ *
+ * @param element_fn First evaluation function for an array element.
+ * @param more_element_fn More evaluation function for next array elements.
+ *
+ * @return Function that evaluates all array elements.
+ */
+template<
+    typename ElementFn,
+    typename ...MoreElementFn>
+inline auto
+array(ElementFn element_fn, MoreElementFn ...more_element_fn) {
+    using ArrayIter =
+        simdjson::simdjson_result<simdjson::ondemand::array_iterator>;
+
+    _SIMDJSON_PEVAL_TRACE_SET_NAME(
+        "internal::array(ElementFn,MoreElementFn...)");
+    _SIMDJSON_PEVAL_TRACE("start");
+
+    auto eval_more_fn =
+        internal::array(
+            std::forward<MoreElementFn>(more_element_fn)...);
+
+
+    return
+        [element_fn, eval_more_fn]
+        (ArrayIter *sj_array_iter, ArrayIter *sj_array_end,
+         size_t sj_array_idx,
+         error *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
+        {
+            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+
+            {
+                error::path_scope array_idx_scope(err, sj_array_idx);
+
+                if (*sj_array_iter == *sj_array_end) {
+                    const auto code = simdjson::INDEX_OUT_OF_BOUNDS;
+                    _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                    err->add(code);
+                }
+                else {
+                    auto sj_result = **sj_array_iter;
+                    element_fn(sj_result, err);
+                    ++sj_array_iter->value();
+                }
+            }
+
+            eval_more_fn(sj_array_iter, sj_array_end, sj_array_idx+1, err);
+
+            _SIMDJSON_PEVAL_TRACE_EVAL_END();
+        };
+}
+
+/**
+ * Add an offset to the leading array index of an element path.
+ *
+ * @private
+ *
+ * @param path Element path like `<root>[3].id`.
+ * @param index_offset Value added to the array index.
+ * @param result Pointer to string to store the new path. Paths
+ *               without leading array index are copied unchanged.
+ */
+inline void
+rebase_path(std::string_view path, size_t index_offset, std::string *result) {
+    constexpr std::string_view prefix = "<root>[";
+
+    const auto end_pos = path.find(']');
+    if (index_offset == 0
+        || path.substr(0, prefix.size()) != prefix
+        || end_pos == std::string_view::npos)
+    {
+        result->assign(path);
+        return;
+    }
+
+    size_t idx = 0;
+    for (auto c : path.substr(prefix.size(), end_pos - prefix.size())) {
+        idx = idx * 10 + size_t(c - '0');
+    }
+
+    result->assign(prefix)
+        .append(std::to_string(idx + index_offset))
+        .append(path.substr(end_pos));
+}
+
+/**
+ * Replace all array indexes of an element path by `[*]`.
+ *
+ * @private
+ *
+ * @param path Element path like `<root>[3].id`.
+ * @param result Pointer to string to store the path template.
+ */
+inline void
+collapse_path(std::string_view path, std::string *result) {
+    result->clear();
+
+    for (size_t pos = 0; pos < path.size(); ++pos) {
+        result->push_back(path[pos]);
+        if (path[pos] == '[') {
+            const auto end_pos = path.find(']', pos);
+            if (end_pos == std::string_view::npos) {
+                break;
+            }
+            result->append("*]");
+            pos = end_pos;
+        }
+    }
+}
+
+/**
+ * Bitmasks of the characters of a block of 64 bytes.
+ *
+ * @private
+ *
+ * Bit `i` is set, if byte `i` of the block is the character. The
+ * masks are built by SSE2 compares, if available.
+ */
+struct block_masks {
+    /// quotes.
+    uint64_t quote = 0;
+
+    /// backslashes.
+    uint64_t backslash = 0;
+
+    /// opening brackets and braces.
+    uint64_t open = 0;
+
+    /// closing brackets and braces.
+    uint64_t close = 0;
+
+    /// commas.
+    uint64_t comma = 0;
+
+    /// whitespace.
+    uint64_t space = 0;
+
+    /**
+     * Constructor.
+     *
+     * @param block Pointer to 64 bytes.
+     */
+    explicit block_masks(const char *block) {
+#ifdef __SSE2__
+        for (int part = 0; part < 4; ++part) {
+            const auto chars =
+                _mm_loadu_si128(
+                    reinterpret_cast<const __m128i *>(block + 16 * part));
+            // '[' | 0x20 == '{' and ']' | 0x20 == '}'.
+            const auto lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+            const auto mask =
+                [&](__m128i values, char c) {
+                    const auto bits =
+                        _mm_movemask_epi8(
+                            _mm_cmpeq_epi8(values, _mm_set1_epi8(c)));
+                    return uint64_t(uint16_t(bits)) << (16 * part);
+                };
+
+            quote |= mask(chars, '"');
+            backslash |= mask(chars, '\\');
+            open |= mask(lower, '{');
+            close |= mask(lower, '}');
+            comma |= mask(chars, ',');
+            space |=
+                mask(chars, ' ') | mask(chars, '\t') | mask(chars, '\n')
+                | mask(chars, '\r');
+        }
+#else
+        for (size_t idx = 0; idx < 64; ++idx) {
+            const auto bit = uint64_t(1) << idx;
+            switch (block[idx]) {
+            case '"': quote |= bit; break;
+            case '\\': backslash |= bit; break;
+            case '[': case '{': open |= bit; break;
+            case ']': case '}': close |= bit; break;
+            case ',': comma |= bit; break;
+            case ' ': case '\t': case '\n': case '\r': space |= bit; break;
+            default: break;
+            }
+        }
+#endif
+    }
+};
+
+/**
+ * Get index of the lowest bit set.
+ *
+ * @private
+ */
+inline size_t
+lowest_bit(uint64_t bits) {
+    _SIMDJSON_PEVAL_ASSERT(bits != 0);
+#if defined(__clang__) || defined(__GNUC__)
+    return size_t(__builtin_ctzll(bits));
+#else
+    size_t idx = 0;
+    while ((bits & 1) == 0) {
+        bits >>= 1;
+        ++idx;
+    }
+    return idx;
+#endif
+}
+
+/**
+ * Resumable scanner for the element boundaries of a JSON array.
+ *
+ * @private
+ *
+ * The scanner only tracks strings and nesting depth, it doesn't
+ * validate the elements. It reports the position of the opening
+ * bracket, of all commas separating the elements and of the closing
+ * bracket of the array. Data can be passed in multiple parts.
+ *
+ * The data is scanned in blocks of 64 bytes like by stage 1 of
+ * simdjson: bitmasks of escaped characters and of the bytes inside of
+ * strings are computed for the whole block, and only brackets, braces
+ * and commas outside of strings are visited one by one.
+ */
+class array_scanner {
+public:
+
+    /**
+     * Scan the next part of the data.
+     *
+     * `boundary_fn` is called for the opening bracket, each separating
+     * comma and the closing bracket:
+     *
+     *     void
+     *     boundary_fn(size_t pos, bool after_element);
+     *
+     * `pos` is the position in `data` and `after_element` is `true`,
+     * if there is a (non whitespace) element since the last boundary.
+     * Scanning stops behind the closing bracket.
+     *
+     * @param data Next part of the data.
+     * @param boundary_fn Function called for each boundary.
+     *
+     * @return `simdjson::INCORRECT_TYPE` if the data doesn't start with
+     *         an array, otherwise `simdjson::SUCCESS`.
+     */
+    template<typename BoundaryFn>
+    simdjson::error_code
+    scan(std::string_view data, BoundaryFn boundary_fn);
+
+    /**
+     * Checks if the closing bracket of the array was found.
+     */
+    bool
+    is_finished() const {
+        return finished;
+    }
+
+private:
+
+    /// nesting depth (1: inside the array).
+    size_t depth = 0;
+
+    /// Flag: last part ended inside of a string.
+    bool in_string = false;
+
+    /// Flag: first byte of the next part is escaped.
+    bool in_escape = false;
+
+    /// Flag: non whitespace since the last boundary.
+    bool element = false;
+
+    /// Flag: closing bracket found.
+    bool finished = false;
+
+    /**
+     * Scan a block of 64 bytes, of which the first `size` bytes are
+     * data and the rest is whitespace.
+     */
+    template<typename BoundaryFn>
+    void
+    scan_block(
+        const char *block, size_t size, size_t offset,
+        BoundaryFn &boundary_fn);
+
+    /**
+     * Get mask of the characters escaped by backslashes.
+     *
+     * Backslash sequences of odd length escape the next character.
+     *
+     * @param backslash Mask of the backslashes.
+     * @param carry_ptr Set to `true`, if the block ends with an odd
+     *                  sequence.
+     */
+    uint64_t
+    find_escaped(uint64_t backslash, bool *carry_ptr) const {
+        const uint64_t even_bits = 0x5555555555555555ULL;
+        const uint64_t odd_bits = ~even_bits;
+        const uint64_t carry_in = (in_escape ? 1 : 0);
+
+        const uint64_t start_edges = backslash & ~(backslash << 1);
+        const uint64_t even_start_mask = even_bits ^ carry_in;
+        const uint64_t even_starts = start_edges & even_start_mask;
+        const uint64_t odd_starts = start_edges & ~even_start_mask;
+        const uint64_t even_carries = backslash + even_starts;
+        uint64_t odd_carries = backslash + odd_starts;
+        *carry_ptr = (odd_carries < backslash);
+        odd_carries |= carry_in;
+
+        const uint64_t even_carry_ends = even_carries & ~backslash;
+        const uint64_t odd_carry_ends = odd_carries & ~backslash;
+        return ((even_carry_ends & odd_bits) | (odd_carry_ends & even_bits));
+    }
+
+    /**
+     * Get mask of all bits behind an odd number of set bits, including
+     * these bits.
+     */
+    static uint64_t
+    prefix_xor(uint64_t bits) {
+        bits ^= bits << 1;
+        bits ^= bits << 2;
+        bits ^= bits << 4;
+        bits ^= bits << 8;
+        bits ^= bits << 16;
+        bits ^= bits << 32;
+        return bits;
+    }
+
+}; // class array_scanner
+
+template<typename BoundaryFn>
+inline simdjson::error_code
+array_scanner::scan(std::string_view data, BoundaryFn boundary_fn) {
+    const char *begin = data.data();
+    const char *end = begin + data.size();
+    const char *ptr = begin;
+
+    // opening bracket.
+    while (depth == 0 && !finished && ptr < end) {
+        switch (*ptr) {
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r':
+            break;
+
+        case '[':
+            boundary_fn(size_t(ptr - begin), false);
+            depth = 1;
+            break;
+
+        default:
+            return simdjson::INCORRECT_TYPE;
+        }
+
+        ++ptr;
+    }
+
+    // elements: the last block is filled up with whitespace.
+    char last_block[64];
+    while (ptr < end && !finished) {
+        const auto size = std::min(size_t(end - ptr), sizeof(last_block));
+        const char *block = ptr;
+        if (size < sizeof(last_block)) {
+            std::memset(last_block, ' ', sizeof(last_block));
+            std::memcpy(last_block, ptr, size);
+            block = last_block;
+        }
+
+        scan_block(block, size, size_t(ptr - begin), boundary_fn);
+        ptr += size;
+    }
+
+    return simdjson::SUCCESS;
+}
+
+template<typename BoundaryFn>
+inline void
+array_scanner::scan_block(
+    const char *block, size_t size, size_t offset, BoundaryFn &boundary_fn)
+{
+    const block_masks masks(block);
+
+    bool carry = false;
+    const uint64_t escaped = find_escaped(masks.backslash, &carry);
+    const uint64_t quote = masks.quote & ~escaped;
+    const uint64_t string =
+        prefix_xor(quote) ^ (in_string ? ~uint64_t(0) : uint64_t(0));
+
+    in_string = ((string >> (size - 1)) & 1) != 0;
+    in_escape = (size < 64 ? ((escaped >> size) & 1) != 0 : carry);
+
+    // non whitespace not yet assigned to an element.
+    uint64_t pending = ~masks.space;
+    for (uint64_t structural =
+             (masks.open | masks.close | masks.comma) & ~string;
+         structural != 0;
+         structural &= structural - 1)
+    {
+        const auto idx = lowest_bit(structural);
+        const uint64_t before = (uint64_t(1) << idx) - 1;
+        if ((pending & before) != 0) {
+            element = true;
+        }
+        pending &= ~(before | (uint64_t(1) << idx));
+
+        switch (block[idx]) {
+        case '[':
+        case '{':
+            element = true;
+            ++depth;
+            break;
+
+        case ']':
+        case '}':
+            if (--depth == 0) {
+                finished = true;
+                boundary_fn(offset + idx, element);
+                element = false;
+                return;
+            }
+            break;
+
+        default:
+            // comma.
+            if (depth == 1) {
+                boundary_fn(offset + idx, element);
+                element = false;
+            }
+            break;
+        }
+    }
+
+    if (pending != 0) {
+        element = true;
+    }
+}
+
+} // namespace internal
+
+// main implementation
+// //////////////////////////////////////////////////////////////////////
+
+/**
+ * Evaluate function.
+ *
+ * This function type is ceated by protortype functions like
+ * `string_value()` `object()` or `array()` to evaluate a JSON
+ * value.
+ *
+ * @param sj_result Parser result to evaluate.
+ * @param err Pointer to error container to store errors.
+ */
+template<typename SJValue = simdjson::ondemand::value>
+using eval_fn_type =
+    std::function<
+        void (simdjson::simdjson_result<SJValue> &sj_result, error *err)>;
+
+///
+/// @name Evaluate JSON scalar values.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
+
+/**
+ * Create evalutation function to store any scalar value by function.
+ *
+ * The get function get a `simdjson_result` and a pointer to store the
+ * value as parameters and a pointer to the error container to report
+ * errors.
+ *
+ *     void
+ *     get_fn(simdjson_result<type> *result, Value *val_ptr, error *err);
+ *
+ * @param val_ptr Pointer to location to store the value.
+ * @param get_fn Get-function to collect and store value.
+ *
+ * @return Function to evaluate JSON value.
+ */
+template<typename SJValue = simdjson::ondemand::value,
+         typename ValuePtr,
+         typename GetFn>
+inline auto
+value(ValuePtr *val_ptr, GetFn get_fn) {
+    using ResultType = simdjson::simdjson_result<SJValue>;
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("value(ValuePtr,GetFn)");
+    _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
+
+    return
+        [val_ptr, get_fn]
+        (ResultType &sj_result, error *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
+        {
+            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+
+            get_fn(&sj_result, val_ptr, err);
+
+            _SIMDJSON_PEVAL_TRACE_EVAL_END();
+        };
+}
+
+/**
+ * Create evalutation function to store any scalar value by function.
+ *
+ * The get function get a `simdjson_result` and a pointer to store the
+ * value as parameters and a pointer to the error container to store
+ * errors.
+ *
+ *     void
+ *     get_fn(simdjson_result<type> *result, Value *val_ptr, error *err);
+ *
+ * @param val_ptr Pointer to location to store the value.
+ * @param get_fn Get-function to collect and store value.
+ * @param is_null Pointer to location to store `null` status. If
+ *                `(is_null == nullptr)` a `null` is not allowed.
+ *
+ * @return Function to evaluate JSON value.
+ */
+template<typename SJValue = simdjson::ondemand::value,
+         typename ValuePtr,
+         typename GetFn>
+inline auto
+value(ValuePtr val_ptr, GetFn get_fn, bool *is_null) {
+    using ResultType = simdjson::simdjson_result<SJValue>;
+
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("value(ValuePtr,GetFn,bool*)");
+    _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
+
+    return
+        [val_ptr, is_null, get_fn]
+        (ResultType &sj_result, error *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
+        {
+            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+
+            if (internal::check_null(sj_result, is_null)) {
+                _SIMDJSON_PEVAL_TRACE("is_null");
+                _SIMDJSON_PEVAL_TRACE_EVAL_END();
+                return;
+            }
+
+            get_fn(&sj_result, val_ptr, err);
+
+            _SIMDJSON_PEVAL_TRACE_EVAL_END();
+        };
+}
+
+
+/**
+ * Create evalutation function to store any scalar value as
+ * `std::optional` by function.
+ *
+ * The get function get a `simdjson_result` and a pointer to store the
+ * value as parameters and a pointer to the error container to store
+ * errors.
+ *
+ *     void
+ *     get_fn(simdjson_result<type> *result, Value *opt_ptr, error *err);
+ *
+ * @param opt_ptr Pointer to `std::optional` to store the value.
+ * @param get_fn Get-function to collect and store value.
+ *
+ * @return Function to evaluate JSON value.
+ */
+template<typename SJValue = simdjson::ondemand::value,
+         typename Value,
+         typename GetFn>
+inline auto
+value(std::optional<Value> *opt_ptr, GetFn get_fn) {
+    using ResultType = simdjson::simdjson_result<SJValue>;
+
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("value(std::optional<Value>*,GetFn)");
+    _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(opt_ptr != nullptr);
+
+    return
+        [opt_ptr, get_fn]
+        (ResultType &sj_result, error *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
+        {
+            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+
+            if (internal::check_null(sj_result, opt_ptr)) {
+                _SIMDJSON_PEVAL_TRACE("is_null");
+                _SIMDJSON_PEVAL_TRACE_EVAL_END();
+                return;
+            }
+
+            opt_ptr->emplace();
+            get_fn(&sj_result, opt_ptr, err);
+
+            _SIMDJSON_PEVAL_TRACE_EVAL_END();
+        };
+}
+
+
+/**
+ * Create evalutation function to execute a generic function.
+ *
+ * The get function get a `simdjson_result` and a pointer to store the
+ * value as parameters and a pointer to the error container to store
+ * errors.
+ *
+ *     void
+ *     get_fn(simdjson_result<type> *result, error *err);
+ *
+ * @param get_fn Get-function to collect the value.
+ *
+ * @return Function to evaluate JSON value.
+ */
+template<typename SJValue = simdjson::ondemand::value,
+         typename GetFn>
+inline auto
+value(GetFn get_fn) {
+    using ResultType = simdjson::simdjson_result<SJValue>;
+
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("value(GetFn)");
+    _SIMDJSON_PEVAL_TRACE("start");
+
+    return
+        [get_fn]
+        (ResultType &sj_result, error *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
+        {
+            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+
+            get_fn(&sj_result, err);
+
+            _SIMDJSON_PEVAL_TRACE_EVAL_END();
+        };
+}
+
+
+/**
+ * Create evalutation function to store a value into a simdjson value.
+ *
+ * Only array and object values work with `simdjson::ondemand::document`.
+ *
+ * @param val_ptr Pointer to location to store the value.
+ *
+ * @return Function to evaluate JSON value.
+ */
+template<typename SJValue = simdjson::ondemand::value>
+inline auto
+value(simdjson::simdjson_result<simdjson::ondemand::value> *val_ptr)
+{
+    _SIMDJSON_PEVAL_TRACE_SET_NAME(
+        "value(simdjson::simdjson_result<simdjson::ondemand::value>*)");
+    _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
+
+    auto get_value =
+        [](auto *sj_result, auto *val_ptr, auto *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE
+        {
+            _SIMDJSON_PEVAL_TRACE("start:get_value");
+            if constexpr(
+                std::is_same_v<
+                    decltype(*sj_result),
+                    simdjson::simdjson_result<simdjson::ondemand::value>&>)
+            {
+                _SIMDJSON_PEVAL_TRACE("type:value");
+                *val_ptr = *sj_result;
+            }
+            else {
+                _SIMDJSON_PEVAL_TRACE("type:other");
+                *val_ptr = sj_result->value().get_value();
+            }
+        };
+
+    return value<SJValue>(val_ptr, get_value);
+}
 
-    /// Current path to elements.
-    std::vector<path_value> path_vector;
+/// @}
 
-    /// Flag: track path for error messages.
-    bool path_flag;
+///
+/// @name Evaluate JSON string values.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
 
-    /**
-     * Create string representation of element path.
-     */
-    std::string
-    create_path();
 
-}; // class error
+/**
+ * Create evalutation function to store a string into a
+ * `std::string_view`.
+ *
+ * @param val_ptr Pointer to location to store the value.
+ *
+ * @return Function to evaluate JSON value.
+ */
+template<typename SJValue = simdjson::ondemand::value>
+inline auto
+string_value(std::string_view *val_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(std::string_view*)");
+    _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
 
+    auto get_value =
+        [](auto *sj_result, auto *val_ptr, auto *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE
+        {
+            _SIMDJSON_PEVAL_TRACE("start:get_value");
+            const auto code = sj_result->value().get_string().get(*val_ptr);
+            if (code) {
+                _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                err->add(code);
+            }
+        };
 
-// helper methods
-// //////////////////////////////////////////////////////////////////////
+    return value<SJValue>(val_ptr, get_value);
+}
 
-// @name Internal implementations
-// @private
-namespace internal {
 
 /**
- * Check for JS `null` and set `is_null` reference.
+ * Create evalutation function to store a string into a
+ * `std::string_view`.
  *
- * @private
+ * @param val_ptr Pointer to location to store the value.
+ * @param is_null Pointer to location to store `null` status. If
+ *                `(is_null == nullptr)` a `null` is not allowed.
  *
- * @param sj_result The `simdjson::simdjson_result<>` to be checked.
- * @param is_null Pointer to location to store `null` status.
+ * @return Function to evaluate JSON value.
+ */
+template<typename SJValue = simdjson::ondemand::value>
+inline auto
+string_value(std::string_view *val_ptr, bool *is_null) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(std::string_view*,bool*)");
+    _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
+
+    auto get_value =
+        [](auto *sj_result, auto *val_ptr, auto *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE
+        {
+            _SIMDJSON_PEVAL_TRACE("start:get_value");
+            const auto code = sj_result->value().get_string().get(*val_ptr);
+            if (code) {
+                _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                err->add(code);
+            }
+        };
+
+    return value<SJValue>(val_ptr, get_value, is_null);
+}
+
+/**
+ * Create evalutation function to store a string into an
+ * `std::optional<std::string_view>`.
  *
- * @return `true` if `(is_null != nullptr)` and `sj_result` contains a
- *         `null` value.
+ * @param opt_ptr Pointer to `std::optional` to store the value.
+ *
+ * @return Function to evaluate JSON value.
  */
-template<typename SJValue>
-inline bool
-check_null(SJValue &sj_result, bool *is_null) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("check_null(SJValue,bool*)");
+template<typename SJValue = simdjson::ondemand::value>
+inline auto
+string_value(std::optional<std::string_view> *opt_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME(
+        "string_value(std::optional<std::string_view>*)");
     _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(opt_ptr != nullptr);
 
-    if (!is_null) {
-        _SIMDJSON_PEVAL_TRACE("is_null:undef");
-        return false;
-    }
+    auto get_value =
+        [](auto *sj_result, auto *opt_ptr, auto *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE
+        {
+            _SIMDJSON_PEVAL_TRACE("start:get_value");
+            const auto code = sj_result->value().get_string().get(**opt_ptr);
+            if (code) {
+                _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                err->add(code);
+            }
+        };
 
-    *is_null = sj_result.value().is_null();
-    _SIMDJSON_PEVAL_TRACE(*is_null ? "is_null:true" : "is_null:false");
+    return value<SJValue>(opt_ptr, get_value);
+}
+
+/**
+ * Create evalutation function to store a string into a
+ * `std::string`.
+ *
+ * @param val_ptr Pointer to location to store the value.
+ *
+ * @return Function to evaluate JSON value.
+ */
+template<typename SJValue = simdjson::ondemand::value>
+inline auto
+string_value(std::string *val_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(std::string*)");
+    _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
+
+    auto get_value =
+        [](auto *sj_result, auto *val_ptr, auto *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE
+        {
+            _SIMDJSON_PEVAL_TRACE("start:get_value");
+            std::string_view tmp_value;
+            const auto code = sj_result->value().get_string().get(tmp_value);
+            if (code) {
+                _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                err->add(code);
+            }
+            else if (err->use_string_bytes(tmp_value.size())) {
+                *val_ptr = tmp_value;
+            }
+        };
+
+    return value<SJValue>(val_ptr, get_value);
+}
+
+/**
+ * Create evalutation function to store a string into a
+ * `std::string`.
+ *
+ * @param val_ptr Pointer to location to store the value.
+ * @param is_null Pointer to location to store `null` status. If
+ *                `(is_null == nullptr)` a `null` is not allowed.
+ *
+ * @return Function to evaluate JSON value.
+ */
+template<typename SJValue = simdjson::ondemand::value>
+inline auto
+string_value(std::string *val_ptr, bool *is_null) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(std::string*,bool*)");
+    _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
+
+    auto get_value =
+        [](auto *sj_result, auto *val_ptr, auto *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE
+        {
+            _SIMDJSON_PEVAL_TRACE("start:get_value");
+            std::string_view tmp_value;
+            const auto code = sj_result->value().get_string().get(tmp_value);
+            if (code) {
+                _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                err->add(code);
+            }
+            else if (err->use_string_bytes(tmp_value.size())) {
+                *val_ptr = tmp_value;
+            }
+        };
+
+    return value<SJValue>(val_ptr, get_value, is_null);
+}
+
+/**
+ * Create evalutation function to store a string into an
+ * `std::optional<std::string>`.
+ *
+ * @param opt_ptr Pointer to `std::optional` to store the value.
+ *
+ * @return Function to evaluate JSON value.
+ */
+template<typename SJValue = simdjson::ondemand::value>
+inline auto
+string_value(std::optional<std::string> *opt_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(std::optional<std::string>*)");
+    _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(opt_ptr != nullptr);
+
+    auto get_value =
+        [](auto *sj_result, auto *opt_ptr, auto *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE
+        {
+            _SIMDJSON_PEVAL_TRACE("start:get_value");
+            std::string_view tmp_value;
+            const auto code = sj_result->value().get_string().get(tmp_value);
+            if (code) {
+                _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                err->add(code);
+            }
+            else if (err->use_string_bytes(tmp_value.size())) {
+                **opt_ptr = tmp_value;
+            }
+        };
+
+    return value<SJValue>(opt_ptr, get_value);
+}
+
+
+/**
+ * Create evalutation function to convert and store a string into a
+ * `int64_t`.
+ *
+ * @param val_ptr Pointer to location to store the value.
+ *
+ * @return Function to evaluate JSON value.
+ */
+template<typename SJValue = simdjson::ondemand::value>
+inline auto
+string_value(int64_t *val_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(int64_t*)");
+    _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
+
+    auto get_value =
+        [](auto *sj_result, auto *val_ptr, auto *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE
+        {
+            _SIMDJSON_PEVAL_TRACE("start:get_value");
+            const auto code =
+                sj_result->value().get_int64_in_string().get(*val_ptr);
+            if (code) {
+                _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                err->add(code);
+            }
+        };
 
-    return (*is_null);
+    return value<SJValue>(val_ptr, get_value);
 }
 
 /**
- * Check for JS `null` and set optional value.
- *
- * @private
+ * Create evalutation function to convert and store a string into a
+ * `int64_t`.
  *
- * @param sj_result The `simdjson::simdjson_result<>` to be checked.
- * @param opt_value Pointer to optional value. The value is set to
- *                  `std::nullopt`, if `sj_result` is `null`.
+ * @param val_ptr Pointer to location to store the value.
+ * @param is_null Pointer to location to store `null` status. If
+ *                `(is_null == nullptr)` a `null` is not allowed.
  *
- * @return `true` if `sj_result` contains a `null` value.
+ * @return Function to evaluate JSON value.
  */
-template<typename SJValue, typename Optional>
-inline bool
-check_null(SJValue &sj_result, Optional *opt_value) {
-    _SIMDJSON_PEVAL_ASSERT(opt_value != nullptr);
-
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("check_null(SJValue,Optional)");
+template<typename SJValue = simdjson::ondemand::value>
+inline auto
+string_value(int64_t *val_ptr, bool *is_null) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(int64_t*,bool*)");
     _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
 
-    if (!sj_result.value().is_null()) {
-        _SIMDJSON_PEVAL_TRACE("is_null:false");
-        return false;
-    }
-
-    _SIMDJSON_PEVAL_TRACE("is_null:true");
+    auto get_value =
+        [](auto *sj_result, auto *val_ptr, auto *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE
+        {
+            _SIMDJSON_PEVAL_TRACE("start:get_value");
+            const auto code =
+                sj_result->value().get_int64_in_string().get(*val_ptr);
+            if (code) {
+                _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                err->add(code);
+            }
+        };
 
-    *opt_value = std::nullopt;
-    return true;
+    return value<SJValue>(val_ptr, get_value, is_null);
 }
 
 /**
- * Create function to evaluate array element by array iterator.
- *
- * @private
+ * Create evalutation function to convert and store a string into an
+ * `std::optional<int64_t>`.
  *
- * @param element_fn Evaluation function for an array element.
+ * @param opt_ptr Pointer to `std::optional` to store the value.
  *
- * @return Function that evaluates a single array element.
+ * @return Function to evaluate JSON value.
  */
-template<typename ElementFn>
+template<typename SJValue = simdjson::ondemand::value>
 inline auto
-array(ElementFn element_fn) {
-    using ArrayIter =
-        simdjson::simdjson_result<simdjson::ondemand::array_iterator>;
-
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("internal::array(ElementFn)");
+string_value(std::optional<int64_t> *opt_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(std::optional<int64_t>*)");
     _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(opt_ptr != nullptr);
 
-    return
-        [element_fn]
-        (ArrayIter *sj_array_iter, ArrayIter *sj_array_end,
-         size_t sj_array_idx,
-         error *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
+    auto get_value =
+        [](auto *sj_result, auto *opt_ptr, auto *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE
         {
-            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
-            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
-
-            error::path_scope array_idx_scope(err, sj_array_idx);
-            if (*sj_array_iter == *sj_array_end) {
-                const auto code = simdjson::INDEX_OUT_OF_BOUNDS;
+            _SIMDJSON_PEVAL_TRACE("start:get_value");
+            const auto code =
+                sj_result->value().get_int64_in_string().get(**opt_ptr);
+            if (code) {
                 _SIMDJSON_PEVAL_TRACE_ERROR(code);
                 err->add(code);
             }
-            else {
-                auto sj_result = **sj_array_iter;
-                element_fn(sj_result, err);
-            }
-
-            _SIMDJSON_PEVAL_TRACE_EVAL_END();
         };
+
+    return value<SJValue>(opt_ptr, get_value);
 }
 
 /**
- * Create function to evaluate array elements by array iterator.
- *
- * @private
+ * Create evalutation function to convert and store a string into a
+ * `uint64_t`.
  *
- * @param element_fn First evaluation function for an array element.
- * @param more_element_fn More evaluation function for next array elements.
+ * @param val_ptr Pointer to location to store the value.
  *
- * @return Function that evaluates all array elements.
+ * @return Function to evaluate JSON value.
  */
-template<
-    typename ElementFn,
-    typename ...MoreElementFn>
+template<typename SJValue = simdjson::ondemand::value>
 inline auto
-array(ElementFn element_fn, MoreElementFn ...more_element_fn) {
-    using ArrayIter =
-        simdjson::simdjson_result<simdjson::ondemand::array_iterator>;
-
-    _SIMDJSON_PEVAL_TRACE_SET_NAME(
-        "internal::array(ElementFn,MoreElementFn...)");
+string_value(uint64_t *val_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(uint64_t*)");
     _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
 
-    auto eval_more_fn =
-        internal::array(
-            std::forward<MoreElementFn>(more_element_fn)...);
-
-
-    return
-        [element_fn, eval_more_fn]
-        (ArrayIter *sj_array_iter, ArrayIter *sj_array_end,
-         size_t sj_array_idx,
-         error *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
+    auto get_value =
+        [](auto *sj_result, auto *val_ptr, auto *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE
         {
-            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
-            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
-
-            {
-                error::path_scope array_idx_scope(err, sj_array_idx);
-
-                if (*sj_array_iter == *sj_array_end) {
-                    const auto code = simdjson::INDEX_OUT_OF_BOUNDS;
-                    _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                    err->add(code);
-                }
-                else {
-                    auto sj_result = **sj_array_iter;
-                    element_fn(sj_result, err);
-                    ++sj_array_iter->value();
-                }
+            _SIMDJSON_PEVAL_TRACE("start:get_value");
+            const auto code =
+                sj_result->value().get_uint64_in_string().get(*val_ptr);
+            if (code) {
+                _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                err->add(code);
             }
-
-            eval_more_fn(sj_array_iter, sj_array_end, sj_array_idx+1, err);
-
-            _SIMDJSON_PEVAL_TRACE_EVAL_END();
         };
-}
-
-} // namespace internal
 
-// main implementation
-// //////////////////////////////////////////////////////////////////////
+    return value<SJValue>(val_ptr, get_value);
+}
 
 /**
- * Evaluate function.
+ * Create evalutation function to convert and store a string into a
+ * `uint64_t`.
  *
- * This function type is ceated by protortype functions like
- * `string_value()` `object()` or `array()` to evaluate a JSON
- * value.
+ * @param val_ptr Pointer to location to store the value.
+ * @param is_null Pointer to location to store `null` status. If
+ *                `(is_null == nullptr)` a `null` is not allowed.
  *
- * @param sj_result Parser result to evaluate.
- * @param err Pointer to error container to store errors.
+ * @return Function to evaluate JSON value.
  */
 template<typename SJValue = simdjson::ondemand::value>
-using eval_fn_type =
-    std::function<
-        void (simdjson::simdjson_result<SJValue> &sj_result, error *err)>;
+inline auto
+string_value(uint64_t *val_ptr, bool *is_null) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(uint64_t*,bool*)");
+    _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
 
-///
-/// @name Evaluate JSON scalar values.
-//  /////////////////////////////////////////////////////////////////////
-/// @{
+    auto get_value =
+        [](auto *sj_result, auto *val_ptr, auto *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE
+        {
+            _SIMDJSON_PEVAL_TRACE("start:get_value");
+            const auto code =
+                sj_result->value().get_uint64_in_string().get(*val_ptr);
+            if (code) {
+                _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                err->add(code);
+            }
+        };
+
+    return value<SJValue>(val_ptr, get_value, is_null);
+}
 
 /**
- * Create evalutation function to store any scalar value by function.
- *
- * The get function get a `simdjson_result` and a pointer to store the
- * value as parameters and a pointer to the error container to report
- * errors.
- *
- *     void
- *     get_fn(simdjson_result<type> *result, Value *val_ptr, error *err);
+ * Create evalutation function to convert and store a string into an
+ * `std::optional<uint64_t>`.
  *
- * @param val_ptr Pointer to location to store the value.
- * @param get_fn Get-function to collect and store value.
+ * @param opt_ptr Pointer to `std::optional` to store the value.
  *
  * @return Function to evaluate JSON value.
  */
-template<typename SJValue = simdjson::ondemand::value,
-         typename ValuePtr,
-         typename GetFn>
+template<typename SJValue = simdjson::ondemand::value>
 inline auto
-value(ValuePtr *val_ptr, GetFn get_fn) {
-    using ResultType = simdjson::simdjson_result<SJValue>;
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("value(ValuePtr,GetFn)");
+string_value(std::optional<uint64_t> *opt_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(std::optional<uint64_t>*)");
     _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(opt_ptr != nullptr);
 
-    return
-        [val_ptr, get_fn]
-        (ResultType &sj_result, error *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
+    auto get_value =
+        [](auto *sj_result, auto *opt_ptr, auto *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE
         {
-            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
-            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+            _SIMDJSON_PEVAL_TRACE("start:get_value");
+            const auto code =
+                sj_result->value().get_uint64_in_string().get(**opt_ptr);
+            if (code) {
+                _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                err->add(code);
+            }
+        };
 
-            get_fn(&sj_result, val_ptr, err);
+    return value<SJValue>(opt_ptr, get_value);
+}
+
+/**
+ * Create evalutation function to convert and store a string into a
+ * `double`.
+ *
+ * @param val_ptr Pointer to location to store the value.
+ *
+ * @return Function to evaluate JSON value.
+ */
+template<typename SJValue = simdjson::ondemand::value>
+inline auto
+string_value(double *val_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(double*)");
+    _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
 
-            _SIMDJSON_PEVAL_TRACE_EVAL_END();
+    auto get_value =
+        [](auto *sj_result, auto *val_ptr, auto *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE
+        {
+            _SIMDJSON_PEVAL_TRACE("start:get_value");
+            const auto code =
+                sj_result->value().get_double_in_string().get(*val_ptr);
+            if (code) {
+                _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                err->add(code);
+            }
         };
+
+    return value<SJValue>(val_ptr, get_value);
 }
 
 /**
- * Create evalutation function to store any scalar value by function.
- *
- * The get function get a `simdjson_result` and a pointer to store the
- * value as parameters and a pointer to the error container to store
- * errors.
- *
- *     void
- *     get_fn(simdjson_result<type> *result, Value *val_ptr, error *err);
+ * Create evalutation function to convert and store a string into a
+ * `double`.
  *
  * @param val_ptr Pointer to location to store the value.
- * @param get_fn Get-function to collect and store value.
  * @param is_null Pointer to location to store `null` status. If
  *                `(is_null == nullptr)` a `null` is not allowed.
  *
  * @return Function to evaluate JSON value.
  */
-template<typename SJValue = simdjson::ondemand::value,
-         typename ValuePtr,
-         typename GetFn>
+template<typename SJValue = simdjson::ondemand::value>
 inline auto
-value(ValuePtr val_ptr, GetFn get_fn, bool *is_null) {
-    using ResultType = simdjson::simdjson_result<SJValue>;
-
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("value(ValuePtr,GetFn,bool*)");
+string_value(double *val_ptr, bool *is_null) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(double*,bool*)");
     _SIMDJSON_PEVAL_TRACE("start");
     _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
 
-    return
-        [val_ptr, is_null, get_fn]
-        (ResultType &sj_result, error *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
+    auto get_value =
+        [](auto *sj_result, auto *val_ptr, auto *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE
         {
-            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
-            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
-
-            if (internal::check_null(sj_result, is_null)) {
-                _SIMDJSON_PEVAL_TRACE("is_null");
-                _SIMDJSON_PEVAL_TRACE_EVAL_END();
-                return;
+            _SIMDJSON_PEVAL_TRACE("start:get_value");
+            const auto code =
+                sj_result->value().get_double_in_string().get(*val_ptr);
+            if (code) {
+                _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                err->add(code);
             }
-
-            get_fn(&sj_result, val_ptr, err);
-
-            _SIMDJSON_PEVAL_TRACE_EVAL_END();
         };
-}
 
+    return value<SJValue>(val_ptr, get_value, is_null);
+}
 
 /**
- * Create evalutation function to store any scalar value as
- * `std::optional` by function.
- *
- * The get function get a `simdjson_result` and a pointer to store the
- * value as parameters and a pointer to the error container to store
- * errors.
- *
- *     void
- *     get_fn(simdjson_result<type> *result, Value *opt_ptr, error *err);
+ * Create evalutation function to convert and store a string into an
+ * `std::optional<double>`.
  *
  * @param opt_ptr Pointer to `std::optional` to store the value.
- * @param get_fn Get-function to collect and store value.
  *
  * @return Function to evaluate JSON value.
  */
-template<typename SJValue = simdjson::ondemand::value,
-         typename Value,
-         typename GetFn>
+template<typename SJValue = simdjson::ondemand::value>
 inline auto
-value(std::optional<Value> *opt_ptr, GetFn get_fn) {
-    using ResultType = simdjson::simdjson_result<SJValue>;
-
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("value(std::optional<Value>*,GetFn)");
+string_value(std::optional<double> *opt_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(std::optional<double>*)");
     _SIMDJSON_PEVAL_TRACE("start");
     _SIMDJSON_PEVAL_ASSERT(opt_ptr != nullptr);
 
-    return
-        [opt_ptr, get_fn]
-        (ResultType &sj_result, error *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
+    auto get_value =
+        [](auto *sj_result, auto *opt_ptr, auto *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE
         {
-            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
-            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
-
-            if (internal::check_null(sj_result, opt_ptr)) {
-                _SIMDJSON_PEVAL_TRACE("is_null");
-                _SIMDJSON_PEVAL_TRACE_EVAL_END();
-                return;
+            _SIMDJSON_PEVAL_TRACE("start:get_value");
+            const auto code =
+                sj_result->value().get_double_in_string().get(**opt_ptr);
+            if (code) {
+                _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                err->add(code);
             }
-
-            opt_ptr->emplace();
-            get_fn(&sj_result, opt_ptr, err);
-
-            _SIMDJSON_PEVAL_TRACE_EVAL_END();
         };
+
+    return value<SJValue>(opt_ptr, get_value);
 }
 
 
+/// @}
+
+///
+/// @name Evaluate JSON number values.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
+
 /**
- * Create evalutation function to execute a generic function.
- *
- * The get function get a `simdjson_result` and a pointer to store the
- * value as parameters and a pointer to the error container to store
- * errors.
- *
- *     void
- *     get_fn(simdjson_result<type> *result, error *err);
+ * Create evalutation function to store a number into an
+ * `int64_t`.
  *
- * @param get_fn Get-function to collect the value.
+ * @param val_ptr Pointer to location to store the value.
  *
  * @return Function to evaluate JSON value.
  */
-template<typename SJValue = simdjson::ondemand::value,
-         typename GetFn>
+template<typename SJValue = simdjson::ondemand::value>
 inline auto
-value(GetFn get_fn) {
-    using ResultType = simdjson::simdjson_result<SJValue>;
-
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("value(GetFn)");
+number_value(int64_t *val_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("number_value(int64_t*)");
     _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
 
-    return
-        [get_fn]
-        (ResultType &sj_result, error *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
+    auto get_value =
+        [](auto *sj_result, auto *val_ptr, auto *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE
         {
-            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
-            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
-
-            get_fn(&sj_result, err);
-
-            _SIMDJSON_PEVAL_TRACE_EVAL_END();
+            _SIMDJSON_PEVAL_TRACE("start:get_value");
+            const auto code = sj_result->value().get_int64().get(*val_ptr);
+            if (code) {
+                _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                err->add(code);
+            }
         };
-}
 
+    return value<SJValue>(val_ptr, get_value);
+}
 
 /**
- * Create evalutation function to store a value into a simdjson value.
- *
- * Only array and object values work with `simdjson::ondemand::document`.
+ * Create evalutation function to store a number into an
+ * `int64_t`.
  *
  * @param val_ptr Pointer to location to store the value.
+ * @param is_null Pointer to location to store `null` status. If
+ *                `(is_null == nullptr)` a `null` is not allowed.
  *
  * @return Function to evaluate JSON value.
  */
 template<typename SJValue = simdjson::ondemand::value>
 inline auto
-value(simdjson::simdjson_result<simdjson::ondemand::value> *val_ptr)
-{
-    _SIMDJSON_PEVAL_TRACE_SET_NAME(
-        "value(simdjson::simdjson_result<simdjson::ondemand::value>*)");
+number_value(int64_t *val_ptr, bool *is_null) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("number_value(int64_t*,bool*)");
     _SIMDJSON_PEVAL_TRACE("start");
     _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
 
@@ -756,34 +2708,49 @@ value(simdjson::simdjson_result<simdjson::ondemand::value> *val_ptr)
         _SIMDJSON_PEVAL_ALWAYS_INLINE
         {
             _SIMDJSON_PEVAL_TRACE("start:get_value");
-            if constexpr(
-                std::is_same_v<
-                    decltype(*sj_result),
-                    simdjson::simdjson_result<simdjson::ondemand::value>&>)
-            {
-                _SIMDJSON_PEVAL_TRACE("type:value");
-                *val_ptr = *sj_result;
-            }
-            else {
-                _SIMDJSON_PEVAL_TRACE("type:other");
-                *val_ptr = sj_result->value().get_value();
+            const auto code = sj_result->value().get_int64().get(*val_ptr);
+            if (code) {
+                _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                err->add(code);
             }
         };
 
-    return value<SJValue>(val_ptr, get_value);
+    return value<SJValue>(val_ptr, get_value, is_null);
 }
 
-/// @}
+/**
+ * Create evalutation function to store a string into an
+ * `std::optional<int64_t>`.
+ *
+ * @param opt_ptr Pointer to `std::optional` to store the value.
+ *
+ * @return Function to evaluate JSON value.
+ */
+template<typename SJValue = simdjson::ondemand::value>
+inline auto
+number_value(std::optional<int64_t> *opt_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("number_value(std::optional<int64_t>*)");
+    _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(opt_ptr != nullptr);
 
-///
-/// @name Evaluate JSON string values.
-//  /////////////////////////////////////////////////////////////////////
-/// @{
+    auto get_value =
+        [](auto *sj_result, auto *opt_ptr, auto *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE
+        {
+            _SIMDJSON_PEVAL_TRACE("start:get_value");
+            const auto code = sj_result->value().get_int64().get(**opt_ptr);
+            if (code) {
+                _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                err->add(code);
+            }
+        };
 
+    return value<SJValue>(opt_ptr, get_value);
+}
 
 /**
- * Create evalutation function to store a string into a
- * `std::string_view`.
+ * Create evalutation function to store a number into a
+ * `uint64_t`.
  *
  * @param val_ptr Pointer to location to store the value.
  *
@@ -791,8 +2758,8 @@ value(simdjson::simdjson_result<simdjson::ondemand::value> *val_ptr)
  */
 template<typename SJValue = simdjson::ondemand::value>
 inline auto
-string_value(std::string_view *val_ptr) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(std::string_view*)");
+number_value(uint64_t *val_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("number_value(uint64_t*)");
     _SIMDJSON_PEVAL_TRACE("start");
     _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
 
@@ -801,7 +2768,7 @@ string_value(std::string_view *val_ptr) {
         _SIMDJSON_PEVAL_ALWAYS_INLINE
         {
             _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code = sj_result->value().get_string().get(*val_ptr);
+            const auto code = sj_result->value().get_uint64().get(*val_ptr);
             if (code) {
                 _SIMDJSON_PEVAL_TRACE_ERROR(code);
                 err->add(code);
@@ -811,10 +2778,9 @@ string_value(std::string_view *val_ptr) {
     return value<SJValue>(val_ptr, get_value);
 }
 
-
 /**
- * Create evalutation function to store a string into a
- * `std::string_view`.
+ * Create evalutation function to store a number into a
+ * `uint64_t`.
  *
  * @param val_ptr Pointer to location to store the value.
  * @param is_null Pointer to location to store `null` status. If
@@ -824,8 +2790,8 @@ string_value(std::string_view *val_ptr) {
  */
 template<typename SJValue = simdjson::ondemand::value>
 inline auto
-string_value(std::string_view *val_ptr, bool *is_null) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(std::string_view*,bool*)");
+number_value(uint64_t *val_ptr, bool *is_null) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("number_value(uint64_t*,bool*)");
     _SIMDJSON_PEVAL_TRACE("start");
     _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
 
@@ -834,7 +2800,7 @@ string_value(std::string_view *val_ptr, bool *is_null) {
         _SIMDJSON_PEVAL_ALWAYS_INLINE
         {
             _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code = sj_result->value().get_string().get(*val_ptr);
+            const auto code = sj_result->value().get_uint64().get(*val_ptr);
             if (code) {
                 _SIMDJSON_PEVAL_TRACE_ERROR(code);
                 err->add(code);
@@ -845,8 +2811,8 @@ string_value(std::string_view *val_ptr, bool *is_null) {
 }
 
 /**
- * Create evalutation function to store a string into an
- * `std::optional<std::string_view>`.
+ * Create evalutation function to store a string into a
+ * `std::optional<uint64_t>`.
  *
  * @param opt_ptr Pointer to `std::optional` to store the value.
  *
@@ -854,9 +2820,8 @@ string_value(std::string_view *val_ptr, bool *is_null) {
  */
 template<typename SJValue = simdjson::ondemand::value>
 inline auto
-string_value(std::optional<std::string_view> *opt_ptr) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME(
-        "string_value(std::optional<std::string_view>*)");
+number_value(std::optional<uint64_t> *opt_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("number_value(std::optional<uint64_t>*)");
     _SIMDJSON_PEVAL_TRACE("start");
     _SIMDJSON_PEVAL_ASSERT(opt_ptr != nullptr);
 
@@ -865,7 +2830,7 @@ string_value(std::optional<std::string_view> *opt_ptr) {
         _SIMDJSON_PEVAL_ALWAYS_INLINE
         {
             _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code = sj_result->value().get_string().get(**opt_ptr);
+            const auto code = sj_result->value().get_uint64().get(**opt_ptr);
             if (code) {
                 _SIMDJSON_PEVAL_TRACE_ERROR(code);
                 err->add(code);
@@ -876,8 +2841,8 @@ string_value(std::optional<std::string_view> *opt_ptr) {
 }
 
 /**
- * Create evalutation function to store a string into a
- * `std::string`.
+ * Create evalutation function to store a number into a
+ * `double`.
  *
  * @param val_ptr Pointer to location to store the value.
  *
@@ -885,8 +2850,8 @@ string_value(std::optional<std::string_view> *opt_ptr) {
  */
 template<typename SJValue = simdjson::ondemand::value>
 inline auto
-string_value(std::string *val_ptr) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(std::string*)");
+number_value(double *val_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("number_value(double*)");
     _SIMDJSON_PEVAL_TRACE("start");
     _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
 
@@ -895,23 +2860,19 @@ string_value(std::string *val_ptr) {
         _SIMDJSON_PEVAL_ALWAYS_INLINE
         {
             _SIMDJSON_PEVAL_TRACE("start:get_value");
-            std::string_view tmp_value;
-            const auto code = sj_result->value().get_string().get(tmp_value);
+            const auto code = sj_result->value().get_double().get(*val_ptr);
             if (code) {
                 _SIMDJSON_PEVAL_TRACE_ERROR(code);
                 err->add(code);
             }
-            else {
-                *val_ptr = tmp_value;
-            }
         };
 
     return value<SJValue>(val_ptr, get_value);
 }
 
 /**
- * Create evalutation function to store a string into a
- * `std::string`.
+ * Create evalutation function to store a number into a
+ * `double`.
  *
  * @param val_ptr Pointer to location to store the value.
  * @param is_null Pointer to location to store `null` status. If
@@ -921,8 +2882,8 @@ string_value(std::string *val_ptr) {
  */
 template<typename SJValue = simdjson::ondemand::value>
 inline auto
-string_value(std::string *val_ptr, bool *is_null) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(std::string*,bool*)");
+number_value(double *val_ptr, bool *is_null) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("number_value(double*,bool*)");
     _SIMDJSON_PEVAL_TRACE("start");
     _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
 
@@ -931,15 +2892,11 @@ string_value(std::string *val_ptr, bool *is_null) {
         _SIMDJSON_PEVAL_ALWAYS_INLINE
         {
             _SIMDJSON_PEVAL_TRACE("start:get_value");
-            std::string_view tmp_value;
-            const auto code = sj_result->value().get_string().get(tmp_value);
+            const auto code = sj_result->value().get_double().get(*val_ptr);
             if (code) {
                 _SIMDJSON_PEVAL_TRACE_ERROR(code);
                 err->add(code);
             }
-            else {
-                *val_ptr = tmp_value;
-            }
         };
 
     return value<SJValue>(val_ptr, get_value, is_null);
@@ -947,7 +2904,7 @@ string_value(std::string *val_ptr, bool *is_null) {
 
 /**
  * Create evalutation function to store a string into an
- * `std::optional<std::string>`.
+ * `std::optional<double>`.
  *
  * @param opt_ptr Pointer to `std::optional` to store the value.
  *
@@ -955,8 +2912,8 @@ string_value(std::string *val_ptr, bool *is_null) {
  */
 template<typename SJValue = simdjson::ondemand::value>
 inline auto
-string_value(std::optional<std::string> *opt_ptr) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(std::optional<std::string>*)");
+number_value(std::optional<double> *opt_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("number_value(std::optional<double>*)");
     _SIMDJSON_PEVAL_TRACE("start");
     _SIMDJSON_PEVAL_ASSERT(opt_ptr != nullptr);
 
@@ -965,24 +2922,26 @@ string_value(std::optional<std::string> *opt_ptr) {
         _SIMDJSON_PEVAL_ALWAYS_INLINE
         {
             _SIMDJSON_PEVAL_TRACE("start:get_value");
-            std::string_view tmp_value;
-            const auto code = sj_result->value().get_string().get(tmp_value);
+            const auto code = sj_result->value().get_double().get(**opt_ptr);
             if (code) {
                 _SIMDJSON_PEVAL_TRACE_ERROR(code);
                 err->add(code);
             }
-            else {
-                **opt_ptr = tmp_value;
-            }
         };
 
     return value<SJValue>(opt_ptr, get_value);
 }
 
+/// @}
+
+///
+/// @name Evaluate JSON bool values.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
 
 /**
- * Create evalutation function to convert and store a string into a
- * `int64_t`.
+ * Create evalutation function to store a number into a
+ * `bool`.
  *
  * @param val_ptr Pointer to location to store the value.
  *
@@ -990,8 +2949,8 @@ string_value(std::optional<std::string> *opt_ptr) {
  */
 template<typename SJValue = simdjson::ondemand::value>
 inline auto
-string_value(int64_t *val_ptr) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(int64_t*)");
+bool_value(bool *val_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("bool_value(bool*)");
     _SIMDJSON_PEVAL_TRACE("start");
     _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
 
@@ -1000,8 +2959,7 @@ string_value(int64_t *val_ptr) {
         _SIMDJSON_PEVAL_ALWAYS_INLINE
         {
             _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code =
-                sj_result->value().get_int64_in_string().get(*val_ptr);
+            const auto code = sj_result->value().get_bool().get(*val_ptr);
             if (code) {
                 _SIMDJSON_PEVAL_TRACE_ERROR(code);
                 err->add(code);
@@ -1012,8 +2970,8 @@ string_value(int64_t *val_ptr) {
 }
 
 /**
- * Create evalutation function to convert and store a string into a
- * `int64_t`.
+ * Create evalutation function to store a number into a
+ * `bool`.
  *
  * @param val_ptr Pointer to location to store the value.
  * @param is_null Pointer to location to store `null` status. If
@@ -1023,8 +2981,8 @@ string_value(int64_t *val_ptr) {
  */
 template<typename SJValue = simdjson::ondemand::value>
 inline auto
-string_value(int64_t *val_ptr, bool *is_null) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(int64_t*,bool*)");
+bool_value(bool *val_ptr, bool *is_null) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("bool_value(bool*,bool*)");
     _SIMDJSON_PEVAL_TRACE("start");
     _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
 
@@ -1033,8 +2991,7 @@ string_value(int64_t *val_ptr, bool *is_null) {
         _SIMDJSON_PEVAL_ALWAYS_INLINE
         {
             _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code =
-                sj_result->value().get_int64_in_string().get(*val_ptr);
+            const auto code = sj_result->value().get_bool().get(*val_ptr);
             if (code) {
                 _SIMDJSON_PEVAL_TRACE_ERROR(code);
                 err->add(code);
@@ -1045,8 +3002,8 @@ string_value(int64_t *val_ptr, bool *is_null) {
 }
 
 /**
- * Create evalutation function to convert and store a string into an
- * `std::optional<int64_t>`.
+ * Create evalutation function to store a string into an
+ * `std::optional<bool>`.
  *
  * @param opt_ptr Pointer to `std::optional` to store the value.
  *
@@ -1054,8 +3011,8 @@ string_value(int64_t *val_ptr, bool *is_null) {
  */
 template<typename SJValue = simdjson::ondemand::value>
 inline auto
-string_value(std::optional<int64_t> *opt_ptr) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(std::optional<int64_t>*)");
+bool_value(std::optional<bool> *opt_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("bool_value(std::optional<bool>*)");
     _SIMDJSON_PEVAL_TRACE("start");
     _SIMDJSON_PEVAL_ASSERT(opt_ptr != nullptr);
 
@@ -1064,644 +3021,995 @@ string_value(std::optional<int64_t> *opt_ptr) {
         _SIMDJSON_PEVAL_ALWAYS_INLINE
         {
             _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code =
-                sj_result->value().get_int64_in_string().get(**opt_ptr);
+            auto code = sj_result->value().get_bool().get(**opt_ptr);
             if (code) {
                 _SIMDJSON_PEVAL_TRACE_ERROR(code);
                 err->add(code);
             }
         };
 
-    return value<SJValue>(opt_ptr, get_value);
+    return value<SJValue>(opt_ptr, get_value);
+}
+
+/// @}
+
+///
+/// @name Reduce JSON number values.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
+///
+/// Inside a record of a function storing records (e.g. `eval_many()`,
+/// `array_to_out_iter()` or `array_for_each()`), the values of reducers
+/// are staged and only added to the accumulators, if the record is
+/// accepted. Values of records with errors or rejected by `where()` are
+/// discarded. Outside of such records values are added at once.
+
+/**
+ * Accumulator counting values.
+ */
+class count_accumulator {
+public:
+
+    /**
+     * Count a value.
+     */
+    void
+    add() {
+        ++count;
+    }
+
+    /**
+     * Add the values of another accumulator.
+     *
+     * @param other Accumulator to merge.
+     */
+    void
+    merge(const count_accumulator &other) {
+        count += other.count;
+    }
+
+    /**
+     * Get the number of values.
+     */
+    size_t
+    get_count() const {
+        return count;
+    }
+
+private:
+
+    /// Number of values.
+    size_t count = 0;
+
+}; // class count_accumulator
+
+/**
+ * Accumulator summing numbers with compensated (Neumaier) summation.
+ *
+ * The rounding errors of the sum are collected separately, which
+ * keeps the error of the sum small for values of different magnitude.
+ * The result may still differ in the last bits with the order of the
+ * values and with the splitting between threads.
+ */
+class sum_accumulator {
+public:
+
+    /**
+     * Add a number.
+     *
+     * @param value Number to add.
+     */
+    void
+    add(double value) {
+        accumulate(value);
+        ++count;
+    }
+
+    /**
+     * Add the numbers of another accumulator.
+     *
+     * @param other Accumulator to merge.
+     */
+    void
+    merge(const sum_accumulator &other) {
+        accumulate(other.sum);
+        accumulate(other.compensation);
+        count += other.count;
+    }
+
+    /**
+     * Get the sum of the numbers.
+     */
+    double
+    get_sum() const {
+        return sum + compensation;
+    }
+
+    /**
+     * Get the number of numbers.
+     */
+    size_t
+    get_count() const {
+        return count;
+    }
+
+private:
+
+    /// Sum of the numbers.
+    double sum = 0.0;
+
+    /// Rounding errors of `sum`.
+    double compensation = 0.0;
+
+    /// Number of numbers.
+    size_t count = 0;
+
+    /**
+     * Add a number to the sum and its rounding error to the
+     * compensation.
+     */
+    void
+    accumulate(double value) {
+        const double new_sum = sum + value;
+        if (std::abs(sum) >= std::abs(value)) {
+            compensation += (sum - new_sum) + value;
+        }
+        else {
+            compensation += (value - new_sum) + sum;
+        }
+        sum = new_sum;
+    }
+
+}; // class sum_accumulator
+
+/**
+ * Accumulator for the minimum and maximum of numbers.
+ */
+class minmax_accumulator {
+public:
+
+    /**
+     * Add a number.
+     *
+     * @param value Number to add.
+     */
+    void
+    add(double value) {
+        min = std::min(min, value);
+        max = std::max(max, value);
+        ++count;
+    }
+
+    /**
+     * Add the numbers of another accumulator.
+     *
+     * @param other Accumulator to merge.
+     */
+    void
+    merge(const minmax_accumulator &other) {
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+        count += other.count;
+    }
+
+    /**
+     * Get the minimum (`+infinity` without numbers).
+     */
+    double
+    get_min() const {
+        return min;
+    }
+
+    /**
+     * Get the maximum (`-infinity` without numbers).
+     */
+    double
+    get_max() const {
+        return max;
+    }
+
+    /**
+     * Get the number of numbers.
+     */
+    size_t
+    get_count() const {
+        return count;
+    }
+
+private:
+
+    /// Minimum of the numbers.
+    double min = std::numeric_limits<double>::infinity();
+
+    /// Maximum of the numbers.
+    double max = -std::numeric_limits<double>::infinity();
+
+    /// Number of numbers.
+    size_t count = 0;
+
+}; // class minmax_accumulator
+
+/**
+ * Accumulator for the mean and variance of numbers.
+ *
+ * The mean is taken from a compensated sum. The variance uses
+ * Welford's running update and the pairwise formula of Chan et al. to
+ * merge, which don't cancel out like a sum of squares.
+ */
+class mean_accumulator {
+public:
+
+    /**
+     * Add a number.
+     *
+     * @param value Number to add.
+     */
+    void
+    add(double value) {
+        sum.add(value);
+
+        const double delta = value - running_mean;
+        running_mean += delta / double(sum.get_count());
+        m2 += delta * (value - running_mean);
+    }
+
+    /**
+     * Add the numbers of another accumulator.
+     *
+     * @param other Accumulator to merge.
+     */
+    void
+    merge(const mean_accumulator &other) {
+        if (other.get_count() == 0) {
+            return;
+        }
+        if (get_count() == 0) {
+            *this = other;
+            return;
+        }
+
+        const double n_this = double(get_count());
+        const double n_other = double(other.get_count());
+        const double n_total = n_this + n_other;
+        const double delta = other.running_mean - running_mean;
+
+        running_mean += delta * n_other / n_total;
+        m2 += other.m2 + delta * delta * n_this * n_other / n_total;
+        sum.merge(other.sum);
+    }
+
+    /**
+     * Get the mean (`0` without numbers).
+     */
+    double
+    get_mean() const {
+        return (get_count() != 0 ? sum.get_sum() / double(get_count()) : 0.0);
+    }
+
+    /**
+     * Get the population variance (`0` without numbers).
+     */
+    double
+    get_variance() const {
+        return (get_count() != 0 ? m2 / double(get_count()) : 0.0);
+    }
+
+    /**
+     * Get the number of numbers.
+     */
+    size_t
+    get_count() const {
+        return sum.get_count();
+    }
+
+private:
+
+    /// Compensated sum and number of the numbers.
+    sum_accumulator sum;
+
+    /// Mean updated by Welford's method (for the variance).
+    double running_mean = 0.0;
+
+    /// Sum of the squared differences from the mean.
+    double m2 = 0.0;
+
+}; // class mean_accumulator
+
+/**
+ * Accumulators of the workers of a parallel evaluation.
+ *
+ * Each evaluation function created for a worker gets its own
+ * accumulator by `add_shard()`, so the workers don't share state. The
+ * pointers stay valid while shards are added. After the evaluation
+ * `merge()` combines the accumulators.
+ */
+template<typename Accumulator>
+class accumulator_shards {
+public:
+
+    /**
+     * Add an accumulator.
+     *
+     * @return Pointer to the new accumulator.
+     */
+    Accumulator *
+    add_shard() {
+        return &shards.emplace_back();
+    }
+
+    /**
+     * Merge all accumulators.
+     *
+     * @return Accumulator with the values of all shards.
+     */
+    Accumulator
+    merge() const {
+        Accumulator result;
+        for (const auto &shard : shards) {
+            result.merge(shard);
+        }
+
+        return result;
+    }
+
+private:
+
+    /// Accumulators with stable addresses.
+    std::deque<Accumulator> shards;
+
+}; // class accumulator_shards
+
+// @name Internal implementations
+// @private
+namespace internal {
+
+/**
+ * Add a number to an accumulator (used by `error::reduce()`).
+ *
+ * @private
+ */
+template<typename Accumulator>
+inline void
+add_to_accumulator(void *acc_ptr, double value) {
+    static_cast<Accumulator *>(acc_ptr)->add(value);
 }
 
 /**
- * Create evalutation function to convert and store a string into a
- * `uint64_t`.
- *
- * @param val_ptr Pointer to location to store the value.
+ * Count a value of a `count_accumulator` (used by `error::reduce()`).
  *
- * @return Function to evaluate JSON value.
+ * @private
  */
-template<typename SJValue = simdjson::ondemand::value>
-inline auto
-string_value(uint64_t *val_ptr) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(uint64_t*)");
-    _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
-
-    auto get_value =
-        [](auto *sj_result, auto *val_ptr, auto *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE
-        {
-            _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code =
-                sj_result->value().get_uint64_in_string().get(*val_ptr);
-            if (code) {
-                _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                err->add(code);
-            }
-        };
-
-    return value<SJValue>(val_ptr, get_value);
+inline void
+add_to_count(void *acc_ptr, double) {
+    static_cast<count_accumulator *>(acc_ptr)->add();
 }
 
 /**
- * Create evalutation function to convert and store a string into a
- * `uint64_t`.
+ * Create evalutation function to add numbers to an accumulator.
  *
- * @param val_ptr Pointer to location to store the value.
- * @param is_null Pointer to location to store `null` status. If
- *                `(is_null == nullptr)` a `null` is not allowed.
+ * @private
+ *
+ * @param acc_ptr Pointer to the accumulator.
  *
  * @return Function to evaluate JSON value.
  */
-template<typename SJValue = simdjson::ondemand::value>
+template<typename SJValue, typename Accumulator>
 inline auto
-string_value(uint64_t *val_ptr, bool *is_null) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(uint64_t*,bool*)");
+reduce_number(Accumulator *acc_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("internal::reduce_number(Accumulator*)");
     _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(acc_ptr != nullptr);
 
     auto get_value =
-        [](auto *sj_result, auto *val_ptr, auto *err)
+        [](auto *sj_result, auto *acc_ptr, auto *err)
         _SIMDJSON_PEVAL_ALWAYS_INLINE
         {
             _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code =
-                sj_result->value().get_uint64_in_string().get(*val_ptr);
+            double number;
+            const auto code = sj_result->value().get_double().get(number);
             if (code) {
                 _SIMDJSON_PEVAL_TRACE_ERROR(code);
                 err->add(code);
             }
+            else {
+                err->reduce(
+                    &add_to_accumulator<Accumulator>, acc_ptr, number);
+            }
         };
 
-    return value<SJValue>(val_ptr, get_value, is_null);
+    return value<SJValue>(acc_ptr, get_value);
 }
 
+} // namespace internal
+
 /**
- * Create evalutation function to convert and store a string into an
- * `std::optional<uint64_t>`.
+ * Create evalutation function to count values.
  *
- * @param opt_ptr Pointer to `std::optional` to store the value.
+ * The value is not evaluated, so it may have any type.
+ *
+ * @param acc_ptr Pointer to the accumulator.
  *
  * @return Function to evaluate JSON value.
  */
 template<typename SJValue = simdjson::ondemand::value>
 inline auto
-string_value(std::optional<uint64_t> *opt_ptr) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(std::optional<uint64_t>*)");
+reduce_count(count_accumulator *acc_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("reduce_count(count_accumulator*)");
     _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(opt_ptr != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(acc_ptr != nullptr);
 
     auto get_value =
-        [](auto *sj_result, auto *opt_ptr, auto *err)
+        [](auto *sj_result, auto *acc_ptr, auto *err)
         _SIMDJSON_PEVAL_ALWAYS_INLINE
         {
             _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code =
-                sj_result->value().get_uint64_in_string().get(**opt_ptr);
+            const auto code = sj_result->error();
             if (code) {
                 _SIMDJSON_PEVAL_TRACE_ERROR(code);
                 err->add(code);
             }
+            else {
+                err->reduce(&internal::add_to_count, acc_ptr, 0.0);
+            }
         };
 
-    return value<SJValue>(opt_ptr, get_value);
+    return value<SJValue>(acc_ptr, get_value);
 }
 
 /**
- * Create evalutation function to convert and store a string into a
- * `double`.
+ * Create evalutation function to add a number to a sum.
  *
- * @param val_ptr Pointer to location to store the value.
+ * Numbers are added as `double`.
+ *
+ * @param acc_ptr Pointer to the accumulator.
  *
  * @return Function to evaluate JSON value.
  */
 template<typename SJValue = simdjson::ondemand::value>
 inline auto
-string_value(double *val_ptr) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(double*)");
+reduce_sum(sum_accumulator *acc_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("reduce_sum(sum_accumulator*)");
     _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
-
-    auto get_value =
-        [](auto *sj_result, auto *val_ptr, auto *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE
-        {
-            _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code =
-                sj_result->value().get_double_in_string().get(*val_ptr);
-            if (code) {
-                _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                err->add(code);
-            }
-        };
 
-    return value<SJValue>(val_ptr, get_value);
+    return internal::reduce_number<SJValue>(acc_ptr);
 }
 
 /**
- * Create evalutation function to convert and store a string into a
- * `double`.
+ * Create evalutation function to add a number to a minimum and
+ * maximum.
  *
- * @param val_ptr Pointer to location to store the value.
- * @param is_null Pointer to location to store `null` status. If
- *                `(is_null == nullptr)` a `null` is not allowed.
+ * Numbers are added as `double`.
+ *
+ * @param acc_ptr Pointer to the accumulator.
  *
  * @return Function to evaluate JSON value.
  */
 template<typename SJValue = simdjson::ondemand::value>
 inline auto
-string_value(double *val_ptr, bool *is_null) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(double*,bool*)");
+reduce_minmax(minmax_accumulator *acc_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("reduce_minmax(minmax_accumulator*)");
     _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
-
-    auto get_value =
-        [](auto *sj_result, auto *val_ptr, auto *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE
-        {
-            _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code =
-                sj_result->value().get_double_in_string().get(*val_ptr);
-            if (code) {
-                _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                err->add(code);
-            }
-        };
 
-    return value<SJValue>(val_ptr, get_value, is_null);
+    return internal::reduce_number<SJValue>(acc_ptr);
 }
 
 /**
- * Create evalutation function to convert and store a string into an
- * `std::optional<double>`.
+ * Create evalutation function to add a number to a mean.
  *
- * @param opt_ptr Pointer to `std::optional` to store the value.
+ * Numbers are added as `double`.
+ *
+ * @param acc_ptr Pointer to the accumulator.
  *
  * @return Function to evaluate JSON value.
  */
 template<typename SJValue = simdjson::ondemand::value>
 inline auto
-string_value(std::optional<double> *opt_ptr) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("string_value(std::optional<double>*)");
+reduce_mean(mean_accumulator *acc_ptr) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("reduce_mean(mean_accumulator*)");
     _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(opt_ptr != nullptr);
-
-    auto get_value =
-        [](auto *sj_result, auto *opt_ptr, auto *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE
-        {
-            _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code =
-                sj_result->value().get_double_in_string().get(**opt_ptr);
-            if (code) {
-                _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                err->add(code);
-            }
-        };
 
-    return value<SJValue>(opt_ptr, get_value);
+    return internal::reduce_number<SJValue>(acc_ptr);
 }
 
-
 /// @}
 
 ///
-/// @name Evaluate JSON number values.
+/// @name Evaluate JSON objects.
 //  /////////////////////////////////////////////////////////////////////
 /// @{
 
-/**
- * Create evalutation function to store a number into an
- * `int64_t`.
- *
- * @param val_ptr Pointer to location to store the value.
- *
- * @return Function to evaluate JSON value.
- */
-template<typename SJValue = simdjson::ondemand::value>
-inline auto
-number_value(int64_t *val_ptr) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("number_value(int64_t*)");
-    _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
-
-    auto get_value =
-        [](auto *sj_result, auto *val_ptr, auto *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE
-        {
-            _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code = sj_result->value().get_int64().get(*val_ptr);
-            if (code) {
-                _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                err->add(code);
-            }
-        };
-
-    return value<SJValue>(val_ptr, get_value);
-}
 
 /**
- * Create evalutation function to store a number into an
- * `int64_t`.
+ * Create evalutation function to call a function for all members.
  *
- * @param val_ptr Pointer to location to store the value.
- * @param is_null Pointer to location to store `null` status. If
- *                `(is_null == nullptr)` a `null` is not allowed.
+ * For each member of the object, the created function calls the
+ * function "out_fn" with the name of the member, a pointer to the
+ * value as "simdjson_result<>" and a pointer to the error container
+ * as parameters.
  *
- * @return Function to evaluate JSON value.
- */
-template<typename SJValue = simdjson::ondemand::value>
-inline auto
-number_value(int64_t *val_ptr, bool *is_null) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("number_value(int64_t*,bool*)");
-    _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
-
-    auto get_value =
-        [](auto *sj_result, auto *val_ptr, auto *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE
-        {
-            _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code = sj_result->value().get_int64().get(*val_ptr);
-            if (code) {
-                _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                err->add(code);
-            }
-        };
-
-    return value<SJValue>(val_ptr, get_value, is_null);
-}
-
-/**
- * Create evalutation function to store a string into an
- * `std::optional<int64_t>`.
+ *     void
+ *     get_fn(
+ *         std::string_view member_name,
+ *         simdjson::simdjson_result<simdjson::ondemand::value> *result,
+ *         error *err);
  *
- * @param opt_ptr Pointer to `std::optional` to store the value.
+ * @param out_fn Function call for each member.
  *
- * @return Function to evaluate JSON value.
+ * @return Function to evaluate JSON object.
  */
-template<typename SJValue = simdjson::ondemand::value>
+template<
+    typename SJValue = simdjson::ondemand::value,
+    typename OutFn>
 inline auto
-number_value(std::optional<int64_t> *opt_ptr) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("number_value(std::optional<int64_t>*)");
+object_to_function(OutFn out_fn)
+{
+    using ResultType = simdjson::simdjson_result<SJValue>;
+
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("object_to_function(OutFn)");
     _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(opt_ptr != nullptr);
 
-    auto get_value =
-        [](auto *sj_result, auto *opt_ptr, auto *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE
+    return
+        [out_fn]
+        (ResultType &sj_result, error *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
         {
-            _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code = sj_result->value().get_int64().get(**opt_ptr);
-            if (code) {
-                _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                err->add(code);
-            }
-        };
+            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
 
-    return value<SJValue>(opt_ptr, get_value);
-}
+            simdjson::simdjson_result<simdjson::ondemand::object> sj_object;
+            if constexpr(std::is_same_v<SJValue, simdjson::ondemand::object>)
+            {
+                _SIMDJSON_PEVAL_TRACE("type:object");
+                sj_object = sj_result;
+            }
+            else {
+                _SIMDJSON_PEVAL_TRACE("type:other");
+                sj_object = sj_result.value().get_object();
+                const auto code = sj_object.error();
+                if (code) {
+                    _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                    err->add(code);
+                    _SIMDJSON_PEVAL_TRACE_EVAL_END();
+                    return;
+                }
+            }
 
-/**
- * Create evalutation function to store a number into a
- * `uint64_t`.
- *
- * @param val_ptr Pointer to location to store the value.
- *
- * @return Function to evaluate JSON value.
- */
-template<typename SJValue = simdjson::ondemand::value>
-inline auto
-number_value(uint64_t *val_ptr) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("number_value(uint64_t*)");
-    _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
+            for (auto field : sj_object) {
+                std::string_view key;
+                const auto code_key = field.unescaped_key().get(key);
+                if (code_key) {
+                    _SIMDJSON_PEVAL_TRACE_ERROR(code_key);
+                    err->add(code_key);
+                }
+                else {
+                    error::path_scope member_error_scope(err, key);
+                    if (err->is_stopped()) {
+                        break;
+                    }
 
-    auto get_value =
-        [](auto *sj_result, auto *val_ptr, auto *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE
-        {
-            _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code = sj_result->value().get_uint64().get(*val_ptr);
-            if (code) {
-                _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                err->add(code);
+                    _SIMDJSON_PEVAL_TRACE("get:" + std::string(key));
+                    const auto code_value = field.value().error();
+                    if (code_value) {
+                        _SIMDJSON_PEVAL_TRACE_ERROR(code_value);
+                        err->add(code_value);
+                    }
+                    else {
+                        auto value = field.value();
+                        out_fn(key, &value, err);
+                    }
+                }
             }
-        };
 
-    return value<SJValue>(val_ptr, get_value);
+            _SIMDJSON_PEVAL_TRACE_EVAL_END();
+        };
 }
 
 /**
- * Create evalutation function to store a number into a
- * `uint64_t`.
+ * Create evalutation function to call a function for all members.
+ *
+ * For each member of the object, the created function calls the
+ * function "out_fn" with the name of the member, a pointer to the
+ * value as "simdjson_result<>" and a pointer to the error container
+ * as parameters.
+ *
+ *     void
+ *     get_fn(
+ *         std::string_view member_name,
+ *         simdjson::simdjson_result<simdjson::ondemand::value> *result,
+ *         error *err);
  *
- * @param val_ptr Pointer to location to store the value.
  * @param is_null Pointer to location to store `null` status. If
  *                `(is_null == nullptr)` a `null` is not allowed.
+ * @param out_fn Function call for each member.
  *
- * @return Function to evaluate JSON value.
+ * @return Function to evaluate JSON object.
  */
-template<typename SJValue = simdjson::ondemand::value>
+template<
+    typename SJValue = simdjson::ondemand::value,
+    typename OutFn>
 inline auto
-number_value(uint64_t *val_ptr, bool *is_null) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("number_value(uint64_t*,bool*)");
+object_to_function(bool *is_null, OutFn out_fn)
+{
+    using ResultType = simdjson::simdjson_result<SJValue>;
+
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("object_to_function(bool*,OutFn)");
     _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
 
-    auto get_value =
-        [](auto *sj_result, auto *val_ptr, auto *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE
+    auto call_fn = object_to_function<SJValue>(out_fn);
+
+    return
+        [is_null, call_fn]
+        (ResultType &sj_result, error *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
         {
-            _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code = sj_result->value().get_uint64().get(*val_ptr);
-            if (code) {
-                _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                err->add(code);
+            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+
+            if (internal::check_null(sj_result, is_null)) {
+                _SIMDJSON_PEVAL_TRACE("is_null");
+            }
+            else {
+                call_fn(sj_result, err);
             }
-        };
 
-    return value<SJValue>(val_ptr, get_value, is_null);
+            _SIMDJSON_PEVAL_TRACE_EVAL_END();
+        };
 }
 
+
 /**
- * Create evalutation function to store a string into a
- * `std::optional<uint64_t>`.
+ * Create evalutation function to store object data by function.
  *
- * @param opt_ptr Pointer to `std::optional` to store the value.
+ * The created function that uses `value_fn` to valuate member of the
+ * object. This function has to store the result into
+ * `temp_value_ptr->second`. Then `out_fn` is called with `temp_pair_ptr`
+ * and a pointer to the error class to store the element.
  *
- * @return Function to evaluate JSON value.
+ *     void
+ *     get_fn(std::pair<StringType, ValueType> *temp_pair_ptr, error *err)
+ *
+ * @param out_fn Function call for each member to store the temporary value.
+ * @param temp_pair_ptr Pointer to a temporary space to store pair elements.
+ * @param value_fn Function to evaluate a single member value and store
+ *                it into `temp_pair_ptr.second`.
+ *
+ * @return Function to evaluate JSON object.
  */
-template<typename SJValue = simdjson::ondemand::value>
+template<
+    typename SJValue = simdjson::ondemand::value,
+    typename OutFn,
+    typename StringType,
+    typename ValueType,
+    typename ValueFn>
 inline auto
-number_value(std::optional<uint64_t> *opt_ptr) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("number_value(std::optional<uint64_t>*)");
+object_to_function(
+    OutFn out_fn,
+    std::pair<StringType, ValueType> *temp_pair_ptr,
+    ValueFn value_fn)
+{
+    using ResultType = simdjson::simdjson_result<SJValue>;
+    using SJValueType = simdjson::simdjson_result<simdjson::ondemand::value>;
+
+    _SIMDJSON_PEVAL_TRACE_SET_NAME(
+        "object_to_function(OutFn,std::pair<StringType,ValueType>*,MemberFn)");
     _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(opt_ptr != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(temp_pair_ptr != nullptr);
 
-    auto get_value =
-        [](auto *sj_result, auto *opt_ptr, auto *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE
-        {
-            _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code = sj_result->value().get_uint64().get(**opt_ptr);
-            if (code) {
-                _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                err->add(code);
-            }
-        };
+    auto gen_out_fn =
+        object_to_function<SJValue>(
+            [out_fn, temp_pair_ptr, value_fn]
+            (std::string_view name, SJValueType *sj_result, error *err)
+            _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
+            {
+                _SIMDJSON_PEVAL_TRACE("start_gen_out_fn");
+                _SIMDJSON_PEVAL_ASSERT(err != nullptr);
 
-    return value<SJValue>(opt_ptr, get_value);
-}
+                temp_pair_ptr->first = name;
+                error::record_scope record(err);
+                const auto num_errors = err->get_count();
+                value_fn(*sj_result, err);
 
-/**
- * Create evalutation function to store a number into a
- * `double`.
- *
- * @param val_ptr Pointer to location to store the value.
- *
- * @return Function to evaluate JSON value.
- */
-template<typename SJValue = simdjson::ondemand::value>
-inline auto
-number_value(double *val_ptr) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("number_value(double*)");
-    _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
+                if (err->is_rejected()) {
+                    _SIMDJSON_PEVAL_TRACE("rejected");
+                    err->set_rejected(false);
+                }
+                else {
+                    if (err->get_count() == num_errors) {
+                        record.commit();
+                    }
+                    out_fn(temp_pair_ptr, err);
+                }
 
-    auto get_value =
-        [](auto *sj_result, auto *val_ptr, auto *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE
+                _SIMDJSON_PEVAL_TRACE("end_gen_out_fn");
+            });
+
+    return
+        [gen_out_fn]
+        (ResultType &sj_result, error *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
         {
-            _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code = sj_result->value().get_double().get(*val_ptr);
-            if (code) {
-                _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                err->add(code);
-            }
-        };
+            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
 
-    return value<SJValue>(val_ptr, get_value);
+            gen_out_fn(sj_result, err);
+
+            _SIMDJSON_PEVAL_TRACE_EVAL_END();
+        };
 }
 
 /**
- * Create evalutation function to store a number into a
- * `double`.
+ * Create evalutation function to store object data by function.
+ *
+ * The created function that uses `value_fn` to valuate member of the
+ * object. This function has to store the result into
+ * `temp_value_ptr->second`. Then `out_fn` is called with `*temp_pair_ptr`
+ * and a pointer to the error class.
+ *
+ *     void
+ *     get_fn(const std::pair<StringType, ValueType> &temp_pair, error *err)
  *
- * @param val_ptr Pointer to location to store the value.
  * @param is_null Pointer to location to store `null` status. If
  *                `(is_null == nullptr)` a `null` is not allowed.
+ * @param out_fn Function call for each member.
+ * @param temp_pair_ptr Pointer to a temporary space to store pair elements.
+ * @param value_fn Function to evaluate a single member value and store
+ *                it into `temp_pair_ptr.second`.
  *
- * @return Function to evaluate JSON value.
+ * @return Function to evaluate JSON object.
  */
-template<typename SJValue = simdjson::ondemand::value>
+template<
+    typename SJValue = simdjson::ondemand::value,
+    typename OutFn,
+    typename StringType,
+    typename ValueType,
+    typename ValueFn>
 inline auto
-number_value(double *val_ptr, bool *is_null) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("number_value(double*,bool*)");
+object_to_function(
+    bool *is_null,
+    OutFn out_fn,
+    std::pair<StringType, ValueType> *temp_pair_ptr,
+    ValueFn value_fn)
+{
+    using ResultType = simdjson::simdjson_result<SJValue>;
+
+    _SIMDJSON_PEVAL_TRACE_SET_NAME(
+        "object_to_function("
+        "bool*,OutFn,std::pair<StringType,ValueType>*,MemberFn)");
     _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(temp_pair_ptr != nullptr);
 
-    auto get_value =
-        [](auto *sj_result, auto *val_ptr, auto *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE
+    auto call_fn =
+        object_to_function<SJValue>(out_fn, temp_pair_ptr, value_fn);
+
+    return
+        [is_null, call_fn]
+        (ResultType &sj_result, error *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
         {
-            _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code = sj_result->value().get_double().get(*val_ptr);
-            if (code) {
-                _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                err->add(code);
+            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+
+            if (internal::check_null(sj_result, is_null)) {
+                _SIMDJSON_PEVAL_TRACE("is_null");
+            }
+            else {
+                call_fn(sj_result, err);
             }
-        };
 
-    return value<SJValue>(val_ptr, get_value, is_null);
+            _SIMDJSON_PEVAL_TRACE_EVAL_END();
+        };
 }
 
 /**
- * Create evalutation function to store a string into an
- * `std::optional<double>`.
+ * Create evalutation function to store object data into an output iterator.
  *
- * @param opt_ptr Pointer to `std::optional` to store the value.
+ * The created function that calls `value_fn` for each member of the
+ * object. This function has to store the result into
+ * `temp_value_ptr->second`. Then the pair is moved into the output
+ * iterator after evaluation of the member.
  *
- * @return Function to evaluate JSON value.
+ * @param out_iter Output iterator to store values.
+ * @param temp_pair_ptr Pointer to a temporary space to store pair elements.
+ * @param value_fn Function to evaluate a single member value and store
+ *                 it into `temp_pair_ptr.second`.
+ *
+ * @return Function to evaluate JSON object.
  */
-template<typename SJValue = simdjson::ondemand::value>
+template<
+    typename SJValue = simdjson::ondemand::value,
+    typename OutIter,
+    typename StringType,
+    typename ValueType,
+    typename ValueFn>
 inline auto
-number_value(std::optional<double> *opt_ptr) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("number_value(std::optional<double>*)");
+object_to_out_iter(
+    OutIter out_iter,
+    std::pair<StringType, ValueType> *temp_pair_ptr,
+    ValueFn value_fn)
+{
+    using ResultType = simdjson::simdjson_result<SJValue>;
+
+    _SIMDJSON_PEVAL_TRACE_SET_NAME(
+        "object_to_out_iter"
+        "(OutIter,std::pair<StringType,ValueType>*,MemberFn)");
     _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(opt_ptr != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(temp_pair_ptr != nullptr);
 
-    auto get_value =
-        [](auto *sj_result, auto *opt_ptr, auto *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE
+    auto out_fn =
+        [out_iter]
+        (auto *pair_ptr, error *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
         {
-            _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code = sj_result->value().get_double().get(**opt_ptr);
-            if (code) {
-                _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                err->add(code);
-            }
+            *out_iter = std::move(*pair_ptr);
+            ++out_iter;
         };
 
-    return value<SJValue>(opt_ptr, get_value);
-}
-
-/// @}
+    auto save_fn =
+        object_to_function<SJValue>(out_fn, temp_pair_ptr, value_fn);
 
-///
-/// @name Evaluate JSON bool values.
-//  /////////////////////////////////////////////////////////////////////
-/// @{
+    return
+        [save_fn]
+        (ResultType &sj_result, error *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
+        {
+            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
 
-/**
- * Create evalutation function to store a number into a
- * `bool`.
- *
- * @param val_ptr Pointer to location to store the value.
- *
- * @return Function to evaluate JSON value.
- */
-template<typename SJValue = simdjson::ondemand::value>
-inline auto
-bool_value(bool *val_ptr) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("bool_value(bool*)");
-    _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
+            save_fn(sj_result, err);
 
-    auto get_value =
-        [](auto *sj_result, auto *val_ptr, auto *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE
-        {
-            _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code = sj_result->value().get_bool().get(*val_ptr);
-            if (code) {
-                _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                err->add(code);
-            }
+            _SIMDJSON_PEVAL_TRACE_EVAL_END();
         };
-
-    return value<SJValue>(val_ptr, get_value);
 }
 
 /**
- * Create evalutation function to store a number into a
- * `bool`.
+ * Create evalutation function to store object data into an output iterator.
+ *
+ * The created function that calls `value_fn` for each member of the
+ * object. This function has to store the result into
+ * `temp_value_ptr->second`. Then the pair is moved into the output
+ * iterator after evaluation of the member.
  *
- * @param val_ptr Pointer to location to store the value.
  * @param is_null Pointer to location to store `null` status. If
  *                `(is_null == nullptr)` a `null` is not allowed.
+ * @param out_iter Output iterator to store values.
+ * @param temp_pair_ptr Pointer to a temporary space to store pair elements.
+ * @param value_fn Function to evaluate a single member value and store
+ *                it into `temp_pair_ptr.second`.
  *
- * @return Function to evaluate JSON value.
+ * @return Function to evaluate JSON object.
  */
-template<typename SJValue = simdjson::ondemand::value>
+template<
+    typename SJValue = simdjson::ondemand::value,
+    typename OutIter,
+    typename StringType,
+    typename ValueType,
+    typename ValueFn>
 inline auto
-bool_value(bool *val_ptr, bool *is_null) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("bool_value(bool*,bool*)");
+object_to_out_iter(
+    bool *is_null,
+    OutIter out_iter,
+    std::pair<StringType, ValueType> *temp_pair_ptr,
+    ValueFn value_fn)
+{
+    using ResultType = simdjson::simdjson_result<SJValue>;
+
+    _SIMDJSON_PEVAL_TRACE_SET_NAME(
+        "object_to_out_iter"
+        "(bool*,OutIter,std::pair<StringType,ValueType>*,MemberFn)");
     _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(temp_pair_ptr != nullptr);
 
-    auto get_value =
-        [](auto *sj_result, auto *val_ptr, auto *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE
+    auto save_fn =
+        object_to_out_iter<SJValue>(out_iter, temp_pair_ptr, value_fn);
+
+    return
+        [is_null, save_fn]
+        (ResultType &sj_result, error *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
         {
-            _SIMDJSON_PEVAL_TRACE("start:get_value");
-            const auto code = sj_result->value().get_bool().get(*val_ptr);
-            if (code) {
-                _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                err->add(code);
+            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+
+            if (internal::check_null(sj_result, is_null)) {
+                _SIMDJSON_PEVAL_TRACE("is_null");
+            }
+            else {
+                save_fn(sj_result, err);
             }
-        };
 
-    return value<SJValue>(val_ptr, get_value, is_null);
+            _SIMDJSON_PEVAL_TRACE_EVAL_END();
+        };
 }
 
+
 /**
- * Create evalutation function to store a string into an
- * `std::optional<bool>`.
+ * Create evalutation function to store object data.
  *
- * @param opt_ptr Pointer to `std::optional` to store the value.
+ * @param member_fn An evalutation function to evaluate a member.
  *
- * @return Function to evaluate JSON value.
+ * @return Function to evaluate JSON object.
  */
-template<typename SJValue = simdjson::ondemand::value>
+template<
+    typename SJValue = simdjson::ondemand::value,
+    typename MemberFn>
 inline auto
-bool_value(std::optional<bool> *opt_ptr) {
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("bool_value(std::optional<bool>*)");
+object(MemberFn member_fn) {
+    using ResultType = simdjson::simdjson_result<SJValue>;
+
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("object(MemberFn)");
     _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(opt_ptr != nullptr);
 
-    auto get_value =
-        [](auto *sj_result, auto *opt_ptr, auto *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE
+    return
+        [member_fn]
+        (ResultType &sj_result, error *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
         {
-            _SIMDJSON_PEVAL_TRACE("start:get_value");
-            auto code = sj_result->value().get_bool().get(**opt_ptr);
-            if (code) {
-                _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                err->add(code);
-            }
-        };
+            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
 
-    return value<SJValue>(opt_ptr, get_value);
-}
+            if constexpr(std::is_same_v<SJValue, simdjson::ondemand::object>)
+            {
+                _SIMDJSON_PEVAL_TRACE("type:object");
+                member_fn(sj_result, err);
+            }
+            else {
+                _SIMDJSON_PEVAL_TRACE("type:other");
 
-/// @}
+                auto sj_object = sj_result.value().get_object();
+                const auto code = sj_object.error();
+                if (code) {
+                    _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                    err->add(code);
+                }
+                else {
+                    member_fn(sj_object, err);
+                }
+            }
 
-///
-/// @name Evaluate JSON objects.
-//  /////////////////////////////////////////////////////////////////////
-/// @{
+            _SIMDJSON_PEVAL_TRACE_EVAL_END();
+        };
+}
 
 
 /**
- * Create evalutation function to call a function for all members.
- *
- * For each member of the object, the created function calls the
- * function "out_fn" with the name of the member, a pointer to the
- * value as "simdjson_result<>" and a pointer to the error container
- * as parameters.
- *
- *     void
- *     get_fn(
- *         std::string_view member_name,
- *         simdjson::simdjson_result<simdjson::ondemand::value> *result,
- *         error *err);
+ * Create evalutation function to store object data.
  *
- * @param out_fn Function call for each member.
+ * @param member_fn An evalutation function to evaluate a member.
+ * @param more_member_fn More function to evaluate members.
  *
  * @return Function to evaluate JSON object.
  */
 template<
     typename SJValue = simdjson::ondemand::value,
-    typename OutFn>
+    typename MemberFn,
+    typename ...MoreMemberFn>
 inline auto
-object_to_function(OutFn out_fn)
-{
+object(MemberFn member_fn,  MoreMemberFn ...more_member_fn) {
     using ResultType = simdjson::simdjson_result<SJValue>;
 
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("object_to_function(OutFn)");
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("object(MemberFn,MoreMemberFn...)");
     _SIMDJSON_PEVAL_TRACE("start");
 
+    auto eval_more_fn =
+        object<simdjson::ondemand::object>(
+            std::forward<MoreMemberFn>(more_member_fn)...);
+
     return
-        [out_fn]
+        [member_fn, eval_more_fn]
         (ResultType &sj_result, error *err)
         _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
         {
             _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
             _SIMDJSON_PEVAL_ASSERT(err != nullptr);
 
-            simdjson::simdjson_result<simdjson::ondemand::object> sj_object;
-            if constexpr(std::is_same_v<SJValue, simdjson::ondemand::object>)
-            {
+            if constexpr(std::is_same_v<SJValue, simdjson::ondemand::object>) {
                 _SIMDJSON_PEVAL_TRACE("type:object");
-                sj_object = sj_result;
+                member_fn(sj_result, err);
+                eval_more_fn(sj_result, err);
             }
             else {
                 _SIMDJSON_PEVAL_TRACE("type:other");
-                sj_object = sj_result.value().get_object();
+                auto sj_object = sj_result.value().get_object();
                 const auto code = sj_object.error();
                 if (code) {
                     _SIMDJSON_PEVAL_TRACE_ERROR(code);
@@ -1709,70 +4017,39 @@ object_to_function(OutFn out_fn)
                     _SIMDJSON_PEVAL_TRACE_EVAL_END();
                     return;
                 }
-            }
-
-            for (auto field : sj_object) {
-                std::string_view key;
-                const auto code_key = field.unescaped_key().get(key);
-                if (code_key) {
-                    _SIMDJSON_PEVAL_TRACE_ERROR(code_key);
-                    err->add(code_key);
-                }
-                else {
-                    error::path_scope member_error_scope(err, key);
 
-                    _SIMDJSON_PEVAL_TRACE("get:" + std::string(key));
-                    const auto code_value = field.value().error();
-                    if (code_value) {
-                        _SIMDJSON_PEVAL_TRACE_ERROR(code_value);
-                        err->add(code_value);
-                    }
-                    else {
-                        auto value = field.value();
-                        out_fn(key, &value, err);
-                    }
-                }
+                member_fn(sj_object, err);
+                eval_more_fn(sj_object, err);
             }
-
             _SIMDJSON_PEVAL_TRACE_EVAL_END();
         };
 }
 
+
 /**
- * Create evalutation function to call a function for all members.
- *
- * For each member of the object, the created function calls the
- * function "out_fn" with the name of the member, a pointer to the
- * value as "simdjson_result<>" and a pointer to the error container
- * as parameters.
- *
- *     void
- *     get_fn(
- *         std::string_view member_name,
- *         simdjson::simdjson_result<simdjson::ondemand::value> *result,
- *         error *err);
+ * Create evalutation function to store object data (`null` allowed).
  *
- * @param is_null Pointer to location to store `null` status. If
- *                `(is_null == nullptr)` a `null` is not allowed.
- * @param out_fn Function call for each member.
+ * @param is_null Pointer to location to store `null` status.
+ * @param all_member_fn Multiple functions to evaluate members.
  *
  * @return Function to evaluate JSON object.
  */
 template<
     typename SJValue = simdjson::ondemand::value,
-    typename OutFn>
+    typename ...AllMemberFn>
 inline auto
-object_to_function(bool *is_null, OutFn out_fn)
-{
+object(bool *is_null, AllMemberFn ...all_member_fn) {
     using ResultType = simdjson::simdjson_result<SJValue>;
 
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("object_to_function(bool*,OutFn)");
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("object(bool*,AllMemberFn...)");
     _SIMDJSON_PEVAL_TRACE("start");
 
-    auto call_fn = object_to_function<SJValue>(out_fn);
+    auto eval_all_fn =
+        object<simdjson::ondemand::object>(
+            std::forward<AllMemberFn>(all_member_fn)...);
 
     return
-        [is_null, call_fn]
+        [is_null, eval_all_fn]
         (ResultType &sj_result, error *err)
         _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
         {
@@ -1781,398 +4058,591 @@ object_to_function(bool *is_null, OutFn out_fn)
 
             if (internal::check_null(sj_result, is_null)) {
                 _SIMDJSON_PEVAL_TRACE("is_null");
+                _SIMDJSON_PEVAL_TRACE_EVAL_END();
+                return;
+            }
+
+            auto sj_object = sj_result.value().get_object();
+            const auto code = sj_object.error();
+            if (code) {
+                _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                err->add(code);
             }
             else {
-                call_fn(sj_result, err);
+                eval_all_fn(sj_object, err);
             }
 
             _SIMDJSON_PEVAL_TRACE_EVAL_END();
         };
 }
 
-
 /**
- * Create evalutation function to store object data by function.
+ * Create evalutation function to store object value.
  *
- * The created function that uses `value_fn` to valuate member of the
- * object. This function has to store the result into
- * `temp_value_ptr->second`. Then `out_fn` is called with `temp_pair_ptr`
- * and a pointer to the error class to store the element.
+ * @param val_ptr Pointer to simdjson obect.
  *
- *     void
- *     get_fn(std::pair<StringType, ValueType> *temp_pair_ptr, error *err)
+ * @return Function to evaluate JSON object.
+ */
+template<typename SJValue = simdjson::ondemand::value>
+inline auto
+object(simdjson::simdjson_result<simdjson::ondemand::object> *val_ptr)
+{
+    using SJObjectType = simdjson::simdjson_result<simdjson::ondemand::object>;
+
+    _SIMDJSON_PEVAL_TRACE_SET_NAME(
+        "object(simdjson::simdjson_result<simdjson::ondemand::object>*)");
+    _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
+
+    auto get_value =
+        [](auto *sj_result, auto *val_ptr, auto *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE
+        {
+            _SIMDJSON_PEVAL_TRACE("start:get_value");
+
+            if constexpr(std::is_same_v<decltype(*sj_result), SJObjectType&>) {
+                _SIMDJSON_PEVAL_TRACE("type:object");
+                *val_ptr = *sj_result;
+            }
+            else {
+                _SIMDJSON_PEVAL_TRACE("type:other");
+                auto sj_object = sj_result->value().get_object();
+                const auto code = sj_object.error();
+                if (code) {
+                    _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                    err->add(code);
+                }
+                else {
+                    *val_ptr = sj_object;
+                }
+            }
+        };
+
+    return value<SJValue>(val_ptr, get_value);
+}
+
+
+/**
+ * Create evalutation function to store object value.
  *
- * @param out_fn Function call for each member to store the temporary value.
- * @param temp_pair_ptr Pointer to a temporary space to store pair elements.
- * @param value_fn Function to evaluate a single member value and store
- *                it into `temp_pair_ptr.second`.
+ * @param val_ptr Pointer to simdjson obect.
+ * @param is_null Pointer to location to store `null` status. If
+ *                `(is_null == nullptr)` a `null` is not allowed.
  *
  * @return Function to evaluate JSON object.
  */
-template<
-    typename SJValue = simdjson::ondemand::value,
-    typename OutFn,
-    typename StringType,
-    typename ValueType,
-    typename ValueFn>
+template<typename SJValue = simdjson::ondemand::value>
 inline auto
-object_to_function(
-    OutFn out_fn,
-    std::pair<StringType, ValueType> *temp_pair_ptr,
-    ValueFn value_fn)
+object(
+    simdjson::simdjson_result<simdjson::ondemand::object> *val_ptr,
+    bool *is_null)
 {
-    using ResultType = simdjson::simdjson_result<SJValue>;
-    using SJValueType = simdjson::simdjson_result<simdjson::ondemand::value>;
+    using SJObjectType = simdjson::simdjson_result<simdjson::ondemand::object>;
 
     _SIMDJSON_PEVAL_TRACE_SET_NAME(
-        "object_to_function(OutFn,std::pair<StringType,ValueType>*,MemberFn)");
+        "object(simdjson::simdjson_result<simdjson::ondemand::object>*,bool*)");
     _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(temp_pair_ptr != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
 
-    auto gen_out_fn =
-        object_to_function<SJValue>(
-            [out_fn, temp_pair_ptr, value_fn]
-            (std::string_view name, SJValueType *sj_result, error *err)
-            _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
-            {
-                _SIMDJSON_PEVAL_TRACE("start_gen_out_fn");
-                _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+    auto get_value =
+        [](auto *sj_result, auto *val_ptr, auto *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE
+        {
+            _SIMDJSON_PEVAL_TRACE("start:get_value");
 
-                temp_pair_ptr->first = name;
-                value_fn(*sj_result, err);
+            if constexpr(std::is_same_v<decltype(*sj_result), SJObjectType&>) {
+                _SIMDJSON_PEVAL_TRACE("type:object");
+                *val_ptr = *sj_result;
+            }
+            else {
+                _SIMDJSON_PEVAL_TRACE("type:other");
+                auto sj_object = sj_result->value().get_object();
+                const auto code = sj_object.error();
+                if (code) {
+                    _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                    err->add(code);
+                }
+                else {
+                    *val_ptr = sj_object;
+                }
+            }
+        };
+
+    return value<SJValue>(val_ptr, get_value, is_null);
+}
+
+
+/**
+ * Create evalutation function to store data of an object member.
+ *
+ * @param name Name of the member.
+ * @param value_fn Function to evaluate member data (any of `value(...)`,
+ *                `object(...)` or `array(...)`).
+ *
+ * @return Function to evaluate JSON object.
+ */
+template<typename ValueFn>
+inline auto
+member(std::string_view name, ValueFn value_fn)
+{
+    using ResultType = simdjson::simdjson_result<simdjson::ondemand::object>;
+
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("member(std::string_view,ValueFn)");
+    _SIMDJSON_PEVAL_TRACE("start");
+
+    return
+        [name, value_fn]
+        (ResultType &sj_result, error *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
+        {
+            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+
+            error::path_scope member_error_scope(err, name);
+            if (err->is_stopped() || err->is_rejected()) {
+                _SIMDJSON_PEVAL_TRACE_EVAL_END();
+                return;
+            }
+
+            auto sj_value = sj_result.value().find_field_unordered(name);
+            const auto code = sj_value.error();
+
+            if (code) {
+                _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                err->add(code);
+            }
+            else {
+                value_fn(sj_value, err);
+            }
+
+            _SIMDJSON_PEVAL_TRACE_EVAL_END();
+        };
+}
 
-                out_fn(temp_pair_ptr, err);
+/**
+ * Create evalutation function to store data of an object member.
+ *
+ * @param name Name of the member.
+ * @param value_fn Function to evaluate member data (any of `value(...)`,
+ *                `object(...)` or `array(...)`).
+ * @param is_undefined Pointer to the location to store, whether the
+ *                     member is defined or not. If `(is_undefined ==
+ *                     nullptr)`, the member must be defined.
+ *
+ * @return Function to evaluate JSON object.
+ */
+template<typename ValueFn>
+inline auto
+member(std::string_view name, ValueFn value_fn, bool *is_undefined)
+{
+    using ResultType = simdjson::simdjson_result<simdjson::ondemand::object>;
 
-                _SIMDJSON_PEVAL_TRACE("end_gen_out_fn");
-            });
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("member(std::string_view,ValueFn,bool*)");
+    _SIMDJSON_PEVAL_TRACE("start");
 
     return
-        [gen_out_fn]
+        [name, value_fn, is_undefined]
         (ResultType &sj_result, error *err)
         _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
         {
             _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
             _SIMDJSON_PEVAL_ASSERT(err != nullptr);
 
-            gen_out_fn(sj_result, err);
+            error::path_scope member_error_scope(err, name);
+            if (err->is_stopped() || err->is_rejected()) {
+                _SIMDJSON_PEVAL_TRACE_EVAL_END();
+                return;
+            }
+
+            auto sj_value = sj_result.value().find_field_unordered(name);
+            const auto code = sj_value.error();
+
+            if (is_undefined) {
+                *is_undefined = false;
+            }
+
+            if (code == simdjson::NO_SUCH_FIELD && is_undefined) {
+                _SIMDJSON_PEVAL_TRACE(
+                    "undefined_member:" + std::string(name));
+                *is_undefined = true;
+            }
+            else if (code) {
+                _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                err->add(code);
+            }
+            else {
+                value_fn(sj_value, err);
+            }
 
             _SIMDJSON_PEVAL_TRACE_EVAL_END();
         };
 }
 
 /**
- * Create evalutation function to store object data by function.
+ * Creates an evalutation function to add object members under a condition.
  *
- * The created function that uses `value_fn` to valuate member of the
- * object. This function has to store the result into
- * `temp_value_ptr->second`. Then `out_fn` is called with `*temp_pair_ptr`
- * and a pointer to the error class.
+ * A function that returns a `bool` is passed as the first parameter.
+ * Subsequent members are evaluated only if this functon returns
+ * `true`:
  *
- *     void
- *     get_fn(const std::pair<StringType, ValueType> &temp_pair, error *err)
+ *     bool
+ *     use_members_fn(
+ *         simdjson::simdjson_result<simdjson::ondemand::object> *result,
+ *         simdjson_peval::error *err)
  *
- * @param is_null Pointer to location to store `null` status. If
- *                `(is_null == nullptr)` a `null` is not allowed.
- * @param out_fn Function call for each member.
- * @param temp_pair_ptr Pointer to a temporary space to store pair elements.
- * @param value_fn Function to evaluate a single member value and store
- *                it into `temp_pair_ptr.second`.
+ * @param use_members_fn Function to evaluate condition.
+ * @param all_member_fn Multiple functions to evaluate members.
  *
- * @return Function to evaluate JSON object.
+ * @return Function for conditionally evaluating the members of a JSON object.
  */
-template<
-    typename SJValue = simdjson::ondemand::value,
-    typename OutFn,
-    typename StringType,
-    typename ValueType,
-    typename ValueFn>
+template<typename UseMembersFn,
+         typename ...AllMemberFn>
 inline auto
-object_to_function(
-    bool *is_null,
-    OutFn out_fn,
-    std::pair<StringType, ValueType> *temp_pair_ptr,
-    ValueFn value_fn)
+discriminator(
+    UseMembersFn use_members_fn,
+    AllMemberFn...all_member_fn)
 {
-    using ResultType = simdjson::simdjson_result<SJValue>;
+    using ResultType = simdjson::simdjson_result<simdjson::ondemand::object>;
 
     _SIMDJSON_PEVAL_TRACE_SET_NAME(
-        "object_to_function("
-        "bool*,OutFn,std::pair<StringType,ValueType>*,MemberFn)");
+        "discriminator(UseMembersFn,MemberFn,MoreMemberFn)");
     _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(temp_pair_ptr != nullptr);
 
-    auto call_fn =
-        object_to_function<SJValue>(out_fn, temp_pair_ptr, value_fn);
+    auto eval_all_fn =
+        object<simdjson::ondemand::object>(
+            std::forward<AllMemberFn>(all_member_fn)...);
 
     return
-        [is_null, call_fn]
+        [use_members_fn, eval_all_fn]
         (ResultType &sj_result, error *err)
         _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
         {
             _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
-            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
-
-            if (internal::check_null(sj_result, is_null)) {
-                _SIMDJSON_PEVAL_TRACE("is_null");
+            if (use_members_fn(&sj_result, err)) {
+                _SIMDJSON_PEVAL_TRACE("use_members");
+                eval_all_fn(sj_result, err);
             }
             else {
-                call_fn(sj_result, err);
+                _SIMDJSON_PEVAL_TRACE("skip_members");
             }
-
             _SIMDJSON_PEVAL_TRACE_EVAL_END();
         };
 }
 
 /**
- * Create evalutation function to store object data into an output iterator.
+ * Creates an evalutation function to filter records by a member.
  *
- * The created function that calls `value_fn` for each member of the
- * object. This function has to store the result into
- * `temp_value_ptr->second`. Then the pair is moved into the output
- * iterator after evaluation of the member.
+ * The function `member_fn` evaluates a member (e.g. by `member()`),
+ * then the predicate decides whether the record is kept:
  *
- * @param out_iter Output iterator to store values.
- * @param temp_pair_ptr Pointer to a temporary space to store pair elements.
- * @param value_fn Function to evaluate a single member value and store
- *                 it into `temp_pair_ptr.second`.
+ *     bool
+ *     predicate_fn();
  *
- * @return Function to evaluate JSON object.
+ * If the predicate returns `false`, the record is rejected: the
+ * remaining members of the object and all enclosing objects of the
+ * record are not evaluated, and functions storing records (e.g.
+ * `array_to_out_iter()`, `array_to_batch()` or `eval_many()`) skip it.
+ * Members used by the predicate should therefore be placed first. The
+ * predicate is not called if `member_fn` added errors.
+ *
+ * @param member_fn Function to evaluate the member used by the predicate.
+ * @param predicate_fn Function to decide whether the record is kept.
+ *
+ * @return Function to evaluate and filter a JSON object.
  */
-template<
-    typename SJValue = simdjson::ondemand::value,
-    typename OutIter,
-    typename StringType,
-    typename ValueType,
-    typename ValueFn>
+template<typename MemberFn,
+         typename PredicateFn>
 inline auto
-object_to_out_iter(
-    OutIter out_iter,
-    std::pair<StringType, ValueType> *temp_pair_ptr,
-    ValueFn value_fn)
+where(MemberFn member_fn, PredicateFn predicate_fn)
 {
-    using ResultType = simdjson::simdjson_result<SJValue>;
+    using ResultType = simdjson::simdjson_result<simdjson::ondemand::object>;
 
-    _SIMDJSON_PEVAL_TRACE_SET_NAME(
-        "object_to_out_iter"
-        "(OutIter,std::pair<StringType,ValueType>*,MemberFn)");
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("where(MemberFn,PredicateFn)");
     _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(temp_pair_ptr != nullptr);
-
-    auto out_fn =
-        [out_iter]
-        (auto *pair_ptr, error *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
-        {
-            *out_iter = std::move(*pair_ptr);
-            ++out_iter;
-        };
-
-    auto save_fn =
-        object_to_function<SJValue>(out_fn, temp_pair_ptr, value_fn);
 
     return
-        [save_fn]
+        [member_fn, predicate_fn]
         (ResultType &sj_result, error *err)
         _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
         {
             _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
             _SIMDJSON_PEVAL_ASSERT(err != nullptr);
 
-            save_fn(sj_result, err);
+            const auto num_errors = err->get_count();
+            member_fn(sj_result, err);
+            if (err->get_count() == num_errors
+                && !err->is_rejected()
+                && !predicate_fn())
+            {
+                _SIMDJSON_PEVAL_TRACE("rejected");
+                err->set_rejected(true);
+            }
 
             _SIMDJSON_PEVAL_TRACE_EVAL_END();
         };
 }
 
+
+/// @}
+
+///
+/// @name Evaluate JSON arrays.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
+
+
 /**
- * Create evalutation function to store object data into an output iterator.
+ * Create evalutation function to call function for all array elements.
  *
- * The created function that calls `value_fn` for each member of the
- * object. This function has to store the result into
- * `temp_value_ptr->second`. Then the pair is moved into the output
- * iterator after evaluation of the member.
+ * For each element of the array, the created function calls the
+ * function "out_fn" with array index, the "simdjson_result<>" of the
+ * element value and a pointer to the error container as parameters.
  *
- * @param is_null Pointer to location to store `null` status. If
- *                `(is_null == nullptr)` a `null` is not allowed.
- * @param out_iter Output iterator to store values.
- * @param temp_pair_ptr Pointer to a temporary space to store pair elements.
- * @param value_fn Function to evaluate a single member value and store
- *                it into `temp_pair_ptr.second`.
+ *     void
+ *     get_fn(
+ *         size_t idx,
+ *         simdjson::simdjson_result<simdjson::ondemand::value> *result,
+ *         error *err);
  *
- * @return Function to evaluate JSON object.
+ * @param out_fn Function call for each element.
+ *
+ * @return Function to evaluate JSON array.
  */
 template<
     typename SJValue = simdjson::ondemand::value,
-    typename OutIter,
-    typename StringType,
-    typename ValueType,
-    typename ValueFn>
+    typename OutFn>
 inline auto
-object_to_out_iter(
-    bool *is_null,
-    OutIter out_iter,
-    std::pair<StringType, ValueType> *temp_pair_ptr,
-    ValueFn value_fn)
+array_to_function(OutFn out_fn)
 {
     using ResultType = simdjson::simdjson_result<SJValue>;
 
-    _SIMDJSON_PEVAL_TRACE_SET_NAME(
-        "object_to_out_iter"
-        "(bool*,OutIter,std::pair<StringType,ValueType>*,MemberFn)");
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("array_to_function(OutFn)");
     _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(temp_pair_ptr != nullptr);
-
-    auto save_fn =
-        object_to_out_iter<SJValue>(out_iter, temp_pair_ptr, value_fn);
 
     return
-        [is_null, save_fn]
+        [out_fn]
         (ResultType &sj_result, error *err)
         _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
         {
             _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
             _SIMDJSON_PEVAL_ASSERT(err != nullptr);
 
-            if (internal::check_null(sj_result, is_null)) {
-                _SIMDJSON_PEVAL_TRACE("is_null");
+            simdjson::simdjson_result<simdjson::ondemand::array> sj_array;
+            if constexpr(std::is_same_v<SJValue, simdjson::ondemand::array>)
+            {
+                _SIMDJSON_PEVAL_TRACE("type:array");
+                sj_array = sj_result;
             }
             else {
-                save_fn(sj_result, err);
+                _SIMDJSON_PEVAL_TRACE("type:other");
+                sj_array = sj_result.value().get_array();
+                const auto code = sj_array.error();
+                if (code) {
+                    _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                    err->add(code);
+                    _SIMDJSON_PEVAL_TRACE_EVAL_END();
+                    return;
+                }
             }
 
+            const auto [first_idx, end_idx] = err->take_slice();
+            size_t idx = 0;
+            for (auto sj_value : sj_array) {
+                if (idx < first_idx) {
+                    // skipped by slice() without evaluation.
+                    ++idx;
+                    continue;
+                }
+                if (idx >= end_idx) {
+                    break;
+                }
+                error::path_scope array_idx_scope(err, idx);
+                if (err->is_stopped()) {
+                    break;
+                }
+                _SIMDJSON_PEVAL_TRACE("get:" + std::to_string(idx));
+
+                out_fn(idx, &sj_value, err);
+
+                ++idx;
+            }
             _SIMDJSON_PEVAL_TRACE_EVAL_END();
         };
 }
 
-
 /**
- * Create evalutation function to store object data.
+ * Create evalutation function to call function for all array elements.
  *
- * @param member_fn An evalutation function to evaluate a member.
+ * For each element of the array, the created function calls the
+ * function "out_fn" with array index, the "simdjson_result<>" of the
+ * element value and a pointer to the error container as parameters.
+ *
+ *     void
+ *     get_fn(
+ *         size_t idx,
+ *         simdjson::simdjson_result<simdjson::ondemand::value> *result,
+ *         error *err);
+ *
+ * @param is_null Pointer to location to store `null` status. If
+ *                `(is_null == nullptr)` a `null` is not allowed.
+ * @param out_fn Function call for each element.
  *
- * @return Function to evaluate JSON object.
+ * @return Function to evaluate JSON array.
  */
 template<
     typename SJValue = simdjson::ondemand::value,
-    typename MemberFn>
+    typename OutFn>
 inline auto
-object(MemberFn member_fn) {
+array_to_function(bool *is_null, OutFn out_fn)
+{
     using ResultType = simdjson::simdjson_result<SJValue>;
 
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("object(MemberFn)");
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("array_to_function(bool*.OutFn)");
     _SIMDJSON_PEVAL_TRACE("start");
 
+    auto call_fn = array_to_function<SJValue>(out_fn);
+
     return
-        [member_fn]
+        [is_null, call_fn]
         (ResultType &sj_result, error *err)
         _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
         {
             _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
             _SIMDJSON_PEVAL_ASSERT(err != nullptr);
 
-            if constexpr(std::is_same_v<SJValue, simdjson::ondemand::object>)
-            {
-                _SIMDJSON_PEVAL_TRACE("type:object");
-                member_fn(sj_result, err);
+            if (internal::check_null(sj_result, is_null)) {
+                _SIMDJSON_PEVAL_TRACE("is_null");
             }
             else {
-                _SIMDJSON_PEVAL_TRACE("type:other");
-
-                auto sj_object = sj_result.value().get_object();
-                const auto code = sj_object.error();
-                if (code) {
-                    _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                    err->add(code);
-                }
-                else {
-                    member_fn(sj_object, err);
-                }
+                call_fn(sj_result, err);
             }
 
             _SIMDJSON_PEVAL_TRACE_EVAL_END();
         };
-}
 
+}
 
 /**
- * Create evalutation function to store object data.
+ * Create evalutation function to store object data by function.
  *
- * @param member_fn An evalutation function to evaluate a member.
- * @param more_member_fn More function to evaluate members.
+ * The created function that calls `value_fn` for each element of the
+ * array which has to store the result into `*temp_value_ptr`. Then
+ * `out_fn` is called with the array index, `temp_pair_ptr` and a
+ * pointer to the error container to store the array element.
  *
- * @return Function to evaluate JSON object.
+ *     void
+ *     get_fn(size_t idx, ValueType *temp_pair, error *err)
+ *
+ * @param out_fn Function call for each member to store the temporary value.
+ * @param temp_value_ptr Pointer to a temporary space to store array elements.
+ * @param value_fn Function to evaluate a single array element and store
+ *                it into `temp_value_ptr`.
+ *
+ * @return Function to evaluate JSON array.
  */
 template<
     typename SJValue = simdjson::ondemand::value,
-    typename MemberFn,
-    typename ...MoreMemberFn>
+    typename OutFn,
+    typename TempValue,
+    typename ValueFn>
 inline auto
-object(MemberFn member_fn,  MoreMemberFn ...more_member_fn) {
+array_to_function(
+    OutFn out_fn,
+    TempValue *temp_value_ptr,
+    ValueFn value_fn)
+{
     using ResultType = simdjson::simdjson_result<SJValue>;
+    using SJValueType = simdjson::simdjson_result<simdjson::ondemand::value>;
 
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("object(MemberFn,MoreMemberFn...)");
+    _SIMDJSON_PEVAL_TRACE_SET_NAME(
+        "array_to_function(OutFn,TempValue*,ValueFn)");
     _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(temp_value_ptr != nullptr);
 
-    auto eval_more_fn =
-        object<simdjson::ondemand::object>(
-            std::forward<MoreMemberFn>(more_member_fn)...);
+    auto gen_out_fn =
+        array_to_function<SJValue>(
+            [out_fn, temp_value_ptr, value_fn]
+            (size_t idx, SJValueType *sj_result, error *err)
+            _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
+            {
+                _SIMDJSON_PEVAL_TRACE("start_gen_out_fn");
+                _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+
+                error::record_scope record(err);
+                const auto num_errors = err->get_count();
+                value_fn(*sj_result, err);
+                if (err->is_rejected()) {
+                    _SIMDJSON_PEVAL_TRACE("rejected");
+                    err->set_rejected(false);
+                }
+                else {
+                    if (err->get_count() == num_errors) {
+                        record.commit();
+                    }
+                    out_fn(idx, temp_value_ptr, err);
+                }
+
+                _SIMDJSON_PEVAL_TRACE("end_gen_out_fn");
+            });
 
     return
-        [member_fn, eval_more_fn]
+        [gen_out_fn]
         (ResultType &sj_result, error *err)
         _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
         {
             _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
             _SIMDJSON_PEVAL_ASSERT(err != nullptr);
 
-            if constexpr(std::is_same_v<SJValue, simdjson::ondemand::object>) {
-                _SIMDJSON_PEVAL_TRACE("type:object");
-                member_fn(sj_result, err);
-                eval_more_fn(sj_result, err);
-            }
-            else {
-                _SIMDJSON_PEVAL_TRACE("type:other");
-                auto sj_object = sj_result.value().get_object();
-                const auto code = sj_object.error();
-                if (code) {
-                    _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                    err->add(code);
-                    _SIMDJSON_PEVAL_TRACE_EVAL_END();
-                    return;
-                }
+            gen_out_fn(sj_result, err);
 
-                member_fn(sj_object, err);
-                eval_more_fn(sj_object, err);
-            }
             _SIMDJSON_PEVAL_TRACE_EVAL_END();
         };
 }
 
-
 /**
- * Create evalutation function to store object data (`null` allowed).
+ * Create evalutation function to store object data by function.
  *
- * @param is_null Pointer to location to store `null` status.
- * @param all_member_fn Multiple functions to evaluate members.
+ * The created function that calls `value_fn` for each element of the
+ * array which has to store the result into `*temp_value_ptr`. Then
+ * `out_fn` is called with `*temp_pair_ptr` and a pointer to the error
+ * class to store the array element.
  *
- * @return Function to evaluate JSON object.
+ *     void
+ *     get_fn(ValueType *temp_pair, error *err)
+ *
+ * @param is_null Pointer to location to store `null` status. If
+ *                `(is_null == nullptr)` a `null` is not allowed.
+ * @param out_fn Function call for each member to store the temporary value.
+ * @param temp_value_ptr Pointer to a temporary space to store array elements.
+ * @param value_fn Function to evaluate a single array element and store
+ *                 it into `temp_value_ptr`.
+ *
+ * @return Function to evaluate JSON array.
  */
 template<
     typename SJValue = simdjson::ondemand::value,
-    typename ...AllMemberFn>
+    typename OutFn,
+    typename TempValue,
+    typename ValueFn>
 inline auto
-object(bool *is_null, AllMemberFn ...all_member_fn) {
+array_to_function(
+    bool *is_null,
+    OutFn out_fn,
+    TempValue *temp_value_ptr,
+    ValueFn value_fn)
+{
     using ResultType = simdjson::simdjson_result<SJValue>;
 
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("object(bool*,AllMemberFn...)");
+    _SIMDJSON_PEVAL_TRACE_SET_NAME(
+        "array_to_function(bool*,OutFn,TempValue*,ValueFn)");
     _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(temp_value_ptr != nullptr);
 
-    auto eval_all_fn =
-        object<simdjson::ondemand::object>(
-            std::forward<AllMemberFn>(all_member_fn)...);
+    auto call_fn =
+        array_to_function<SJValue>(out_fn, temp_value_ptr, value_fn);
 
     return
-        [is_null, eval_all_fn]
+        [is_null, call_fn]
         (ResultType &sj_result, error *err)
         _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
         {
@@ -2181,18 +4651,9 @@ object(bool *is_null, AllMemberFn ...all_member_fn) {
 
             if (internal::check_null(sj_result, is_null)) {
                 _SIMDJSON_PEVAL_TRACE("is_null");
-                _SIMDJSON_PEVAL_TRACE_EVAL_END();
-                return;
-            }
-
-            auto sj_object = sj_result.value().get_object();
-            const auto code = sj_object.error();
-            if (code) {
-                _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                err->add(code);
             }
             else {
-                eval_all_fn(sj_object, err);
+                call_fn(sj_result, err);
             }
 
             _SIMDJSON_PEVAL_TRACE_EVAL_END();
@@ -2200,193 +4661,221 @@ object(bool *is_null, AllMemberFn ...all_member_fn) {
 }
 
 /**
- * Create evalutation function to store object value.
+ * Create evalutation function to store array data into an output
+ * iterator.
  *
- * @param val_ptr Pointer to simdjson obect.
+ * The created function that calls `value_fn` for each element of the
+ * array. This function has to store the result into `*temp_value_ptr`. Then
+ * the value is moved into the output iterator.
  *
- * @return Function to evaluate JSON object.
+ * @param out_iter Output iterator to store values.
+ * @param temp_value_ptr Pointer to a temporary space to store array elements.
+ * @param value_fn Function to evaluate a single array element and store
+ *                 it into `*temp_value_ptr`.
+ *
+ * @return Function to evaluate JSON array.
  */
-template<typename SJValue = simdjson::ondemand::value>
+template<
+    typename SJValue = simdjson::ondemand::value,
+    typename OutIter,
+    typename TempValue,
+    typename ValueFn>
 inline auto
-object(simdjson::simdjson_result<simdjson::ondemand::object> *val_ptr)
+array_to_out_iter(
+    OutIter out_iter,
+    TempValue *temp_value_ptr,
+    ValueFn value_fn)
 {
-    using SJObjectType = simdjson::simdjson_result<simdjson::ondemand::object>;
+    using ResultType = simdjson::simdjson_result<SJValue>;
 
     _SIMDJSON_PEVAL_TRACE_SET_NAME(
-        "object(simdjson::simdjson_result<simdjson::ondemand::object>*)");
+        "array_to_out_iter(OutIter,TempValue*,ValueFn)");
     _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(temp_value_ptr != nullptr);
 
-    auto get_value =
-        [](auto *sj_result, auto *val_ptr, auto *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE
+    auto out_fn =
+        [out_iter]
+        (auto idx, auto *value_ptr, error *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
         {
-            _SIMDJSON_PEVAL_TRACE("start:get_value");
-
-            if constexpr(std::is_same_v<decltype(*sj_result), SJObjectType&>) {
-                _SIMDJSON_PEVAL_TRACE("type:object");
-                *val_ptr = *sj_result;
-            }
-            else {
-                _SIMDJSON_PEVAL_TRACE("type:other");
-                auto sj_object = sj_result->value().get_object();
-                const auto code = sj_object.error();
-                if (code) {
-                    _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                    err->add(code);
-                }
-                else {
-                    *val_ptr = sj_object;
-                }
-            }
+            *out_iter = std::move(*value_ptr);
+            ++out_iter;
         };
 
-    return value<SJValue>(val_ptr, get_value);
-}
+    auto save_fn =
+        array_to_function<SJValue>(out_fn, temp_value_ptr, value_fn);
+
+    return
+        [save_fn]
+        (ResultType &sj_result, error *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
+        {
+            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+
+            save_fn(sj_result, err);
 
+            _SIMDJSON_PEVAL_TRACE_EVAL_END();
+        };
+}
 
 /**
- * Create evalutation function to store object value.
+ * Create evalutation function to store array data into an output
+ * iterator.
+ *
+ * The created function that calls `value_fn` for each element of the
+ * array. This function has to store the result into `*temp_value_ptr`. Then
+ * the value is moved into the output iterator.
  *
- * @param val_ptr Pointer to simdjson obect.
  * @param is_null Pointer to location to store `null` status. If
  *                `(is_null == nullptr)` a `null` is not allowed.
+ * @param out_iter Output iterator to store values.
+ * @param temp_value_ptr Pointer to a temporary space to store array elements.
+ * @param value_fn Function to evaluate a single array element and store
+ *                 it into `*temp_value_ptr`.
  *
- * @return Function to evaluate JSON object.
+ * @return Function to evaluate JSON array.
  */
-template<typename SJValue = simdjson::ondemand::value>
+template<
+    typename SJValue = simdjson::ondemand::value,
+    typename OutIter,
+    typename TempValue,
+    typename ValueFn>
 inline auto
-object(
-    simdjson::simdjson_result<simdjson::ondemand::object> *val_ptr,
-    bool *is_null)
+array_to_out_iter(
+    bool *is_null,
+    OutIter out_iter,
+    TempValue *temp_value_ptr,
+    ValueFn value_fn)
 {
-    using SJObjectType = simdjson::simdjson_result<simdjson::ondemand::object>;
+    using ResultType = simdjson::simdjson_result<SJValue>;
 
     _SIMDJSON_PEVAL_TRACE_SET_NAME(
-        "object(simdjson::simdjson_result<simdjson::ondemand::object>*,bool*)");
+        "array_to_out_iter(bool*,OutIter,TempValue*,ValueFn)");
     _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(temp_value_ptr != nullptr);
 
-    auto get_value =
-        [](auto *sj_result, auto *val_ptr, auto *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE
+    auto save_fn =
+        array_to_out_iter<SJValue>(out_iter, temp_value_ptr, value_fn);
+
+    return
+        [is_null, save_fn]
+        (ResultType &sj_result, error *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
         {
-            _SIMDJSON_PEVAL_TRACE("start:get_value");
+            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
 
-            if constexpr(std::is_same_v<decltype(*sj_result), SJObjectType&>) {
-                _SIMDJSON_PEVAL_TRACE("type:object");
-                *val_ptr = *sj_result;
+            if (internal::check_null(sj_result, is_null)) {
+                _SIMDJSON_PEVAL_TRACE("is_null");
             }
             else {
-                _SIMDJSON_PEVAL_TRACE("type:other");
-                auto sj_object = sj_result->value().get_object();
-                const auto code = sj_object.error();
-                if (code) {
-                    _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                    err->add(code);
-                }
-                else {
-                    *val_ptr = sj_object;
-                }
+                save_fn(sj_result, err);
             }
-        };
 
-    return value<SJValue>(val_ptr, get_value, is_null);
+            _SIMDJSON_PEVAL_TRACE_EVAL_END();
+        };
 }
 
 
 /**
- * Create evalutation function to store data of an object member.
+ * Create evalutation function to store single array values.
  *
- * @param name Name of the member.
- * @param value_fn Function to evaluate member data (any of `value(...)`,
- *                `object(...)` or `array(...)`).
+ * @param all_element_fn Values that should be evaluated in order.
  *
  * @return Function to evaluate JSON object.
  */
-template<typename ValueFn>
+template<
+    typename SJValue = simdjson::ondemand::value,
+    typename ...AllElementFn>
 inline auto
-member(std::string_view name, ValueFn value_fn)
-{
-    using ResultType = simdjson::simdjson_result<simdjson::ondemand::object>;
+array(AllElementFn ...all_element_fn) {
+    using ResultType = simdjson::simdjson_result<SJValue>;
 
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("member(std::string_view,ValueFn)");
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("array(AllElementFn...)");
     _SIMDJSON_PEVAL_TRACE("start");
 
+    auto eval_all_fn =
+        internal::array(std::forward<AllElementFn>(all_element_fn)...);
+
     return
-        [name, value_fn]
+        [eval_all_fn]
         (ResultType &sj_result, error *err)
         _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
         {
             _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
             _SIMDJSON_PEVAL_ASSERT(err != nullptr);
 
-            error::path_scope member_error_scope(err, name);
-
-            auto sj_value = sj_result.value().find_field_unordered(name);
-            const auto code = sj_value.error();
-
-            if (code) {
-                _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                err->add(code);
+            simdjson::simdjson_result<simdjson::ondemand::array> sj_array;
+            if constexpr(std::is_same_v<SJValue, simdjson::ondemand::array>) {
+                _SIMDJSON_PEVAL_TRACE("type:array");
+                sj_array = sj_result;
             }
             else {
-                value_fn(sj_value, err);
+                _SIMDJSON_PEVAL_TRACE("type:other");
+                sj_array = sj_result.value().get_array();
+                const auto code = sj_array.error();
+                if (code) {
+                    _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                    err->add(code);
+                    _SIMDJSON_PEVAL_TRACE_EVAL_END();
+                    return;
+                }
             }
 
+            auto sj_array_iter = sj_array.value().begin();
+            auto sj_array_end  = sj_array.value().end();
+            eval_all_fn(&sj_array_iter, &sj_array_end, 0, err);
+
             _SIMDJSON_PEVAL_TRACE_EVAL_END();
         };
 }
 
 /**
- * Create evalutation function to store data of an object member.
+ * Create evalutation function to store single array values.
  *
- * @param name Name of the member.
- * @param value_fn Function to evaluate member data (any of `value(...)`,
- *                `object(...)` or `array(...)`).
- * @param is_undefined Pointer to the location to store, whether the
- *                     member is defined or not. If `(is_undefined ==
- *                     nullptr)`, the member must be defined.
+ * @param is_null Pointer to location to store `null` status. If
+ *                `(is_null == nullptr)` a `null` is not allowed.
+ * @param all_element_fn Values that should be evaluated in order.
  *
  * @return Function to evaluate JSON object.
  */
-template<typename ValueFn>
+template<
+    typename SJValue = simdjson::ondemand::value,
+    typename ...AllElementFn>
 inline auto
-member(std::string_view name, ValueFn value_fn, bool *is_undefined)
-{
-    using ResultType = simdjson::simdjson_result<simdjson::ondemand::object>;
+array(bool *is_null, AllElementFn ...all_element_fn) {
+    using ResultType = simdjson::simdjson_result<SJValue>;
 
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("member(std::string_view,ValueFn,bool*)");
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("array(bool*,AllElementFn...)");
     _SIMDJSON_PEVAL_TRACE("start");
 
+    auto eval_all_fn =
+        array<simdjson::ondemand::array>(
+            std::forward<AllElementFn>(all_element_fn)...);
+
     return
-        [name, value_fn, is_undefined]
+        [is_null, eval_all_fn]
         (ResultType &sj_result, error *err)
         _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
         {
             _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
             _SIMDJSON_PEVAL_ASSERT(err != nullptr);
 
-            error::path_scope member_error_scope(err, name);
-
-            auto sj_value = sj_result.value().find_field_unordered(name);
-            const auto code = sj_value.error();
-
-            if (is_undefined) {
-                *is_undefined = false;
+            if (internal::check_null(sj_result, is_null)) {
+                _SIMDJSON_PEVAL_TRACE("is_null");
+                _SIMDJSON_PEVAL_TRACE_EVAL_END();
+                return;
             }
 
-            if (code == simdjson::NO_SUCH_FIELD && is_undefined) {
-                _SIMDJSON_PEVAL_TRACE(
-                    "undefined_member:" + std::string(name));
-                *is_undefined = true;
-            }
-            else if (code) {
+            auto sj_array = sj_result.value().get_array();
+            const auto code = sj_array.error();
+            if (code) {
                 _SIMDJSON_PEVAL_TRACE_ERROR(code);
                 err->add(code);
             }
             else {
-                value_fn(sj_value, err);
+                eval_all_fn(sj_array, err);
             }
 
             _SIMDJSON_PEVAL_TRACE_EVAL_END();
@@ -2394,320 +4883,384 @@ member(std::string_view name, ValueFn value_fn, bool *is_undefined)
 }
 
 /**
- * Creates an evalutation function to add object members under a condition.
- *
- * A function that returns a `bool` is passed as the first parameter.
- * Subsequent members are evaluated only if this functon returns
- * `true`:
- *
- *     bool
- *     use_members_fn(
- *         simdjson::simdjson_result<simdjson::ondemand::object> *result,
- *         simdjson_peval::error *err)
+ * Create evalutation function to store array value.
  *
- * @param use_members_fn Function to evaluate condition.
- * @param all_member_fn Multiple functions to evaluate members.
+ * @param val_ptr Pointer to simdjson array.
  *
- * @return Function for conditionally evaluating the members of a JSON object.
+ * @return Function to evaluate JSON object.
  */
-template<typename UseMembersFn,
-         typename ...AllMemberFn>
+template<typename SJValue = simdjson::ondemand::value>
 inline auto
-discriminator(
-    UseMembersFn use_members_fn,
-    AllMemberFn...all_member_fn)
+array(simdjson::simdjson_result<simdjson::ondemand::array> *val_ptr)
 {
-    using ResultType = simdjson::simdjson_result<simdjson::ondemand::object>;
+    using JSArrayValue = simdjson::simdjson_result<simdjson::ondemand::array>;
 
     _SIMDJSON_PEVAL_TRACE_SET_NAME(
-        "discriminator(UseMembersFn,MemberFn,MoreMemberFn)");
+        "array(simdjson::simdjson_result<simdjson::ondemand::array>*)");
     _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
 
-    auto eval_all_fn =
-        object<simdjson::ondemand::object>(
-            std::forward<AllMemberFn>(all_member_fn)...);
-
-    return
-        [use_members_fn, eval_all_fn]
-        (ResultType &sj_result, error *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
+    auto get_value =
+        [](auto *sj_result, auto *val_ptr, auto *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE
         {
-            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
-            if (use_members_fn(&sj_result, err)) {
-                _SIMDJSON_PEVAL_TRACE("use_members");
-                eval_all_fn(sj_result, err);
+            _SIMDJSON_PEVAL_TRACE("start:get_value");
+            if constexpr(std::is_same_v<decltype(*sj_result), JSArrayValue&>) {
+                _SIMDJSON_PEVAL_TRACE("type:array");
+                *val_ptr = *sj_result;
             }
             else {
-                _SIMDJSON_PEVAL_TRACE("skip_members");
+                _SIMDJSON_PEVAL_TRACE("type:other");
+                auto sj_array = sj_result->value().get_array();
+                const auto code = sj_array.error();
+                if (code) {
+                    _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                    err->add(code);
+                }
+                else {
+                    *val_ptr = sj_array;
+                }
             }
-            _SIMDJSON_PEVAL_TRACE_EVAL_END();
         };
-}
 
-
-/// @}
-
-///
-/// @name Evaluate JSON arrays.
-//  /////////////////////////////////////////////////////////////////////
-/// @{
+    return value<SJValue>(val_ptr, get_value);
+}
 
 
 /**
- * Create evalutation function to call function for all array elements.
- *
- * For each element of the array, the created function calls the
- * function "out_fn" with array index, the "simdjson_result<>" of the
- * element value and a pointer to the error container as parameters.
- *
- *     void
- *     get_fn(
- *         size_t idx,
- *         simdjson::simdjson_result<simdjson::ondemand::value> *result,
- *         error *err);
+ * Create evalutation function to store array value.
  *
- * @param out_fn Function call for each element.
+ * @param val_ptr Pointer to simdjson array.
+ * @param is_null Pointer to location to store `null` status. If
+ *                `(is_null == nullptr)` a `null` is not allowed.
  *
- * @return Function to evaluate JSON array.
+ * @return Function to evaluate JSON object.
  */
-template<
-    typename SJValue = simdjson::ondemand::value,
-    typename OutFn>
+template<typename SJValue = simdjson::ondemand::value>
 inline auto
-array_to_function(OutFn out_fn)
+array(
+    simdjson::simdjson_result<simdjson::ondemand::array> *val_ptr,
+    bool *is_null)
 {
-    using ResultType = simdjson::simdjson_result<SJValue>;
+    using JSArrayValue = simdjson::simdjson_result<simdjson::ondemand::array>;
 
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("array_to_function(OutFn)");
+    _SIMDJSON_PEVAL_TRACE_SET_NAME(
+        "array(simdjson::simdjson_result<simdjson::ondemand::array>*,bool*)");
     _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
 
-    return
-        [out_fn]
-        (ResultType &sj_result, error *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
-        {
-            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
-            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
-
-            simdjson::simdjson_result<simdjson::ondemand::array> sj_array;
-            if constexpr(std::is_same_v<SJValue, simdjson::ondemand::array>)
-            {
+    auto get_value =
+        [](auto *sj_result, auto *val_ptr, auto *err)
+        _SIMDJSON_PEVAL_ALWAYS_INLINE
+        {
+            _SIMDJSON_PEVAL_TRACE("start:get_value");
+            if constexpr(std::is_same_v<decltype(*sj_result), JSArrayValue&>) {
                 _SIMDJSON_PEVAL_TRACE("type:array");
-                sj_array = sj_result;
+                *val_ptr = *sj_result;
             }
             else {
                 _SIMDJSON_PEVAL_TRACE("type:other");
-                sj_array = sj_result.value().get_array();
+                auto sj_array = sj_result->value().get_array();
                 const auto code = sj_array.error();
                 if (code) {
                     _SIMDJSON_PEVAL_TRACE_ERROR(code);
                     err->add(code);
-                    _SIMDJSON_PEVAL_TRACE_EVAL_END();
-                    return;
+                }
+                else {
+                    *val_ptr = sj_array;
                 }
             }
-
-            size_t idx = 0;
-            for (auto sj_value : sj_array) {
-                error::path_scope array_idx_scope(err, idx);
-                _SIMDJSON_PEVAL_TRACE("get:" + std::to_string(idx));
-
-                out_fn(idx, &sj_value, err);
-
-                ++idx;
-            }
-            _SIMDJSON_PEVAL_TRACE_EVAL_END();
         };
+
+    return value<SJValue>(val_ptr, get_value, is_null);
 }
 
 /**
- * Create evalutation function to call function for all array elements.
- *
- * For each element of the array, the created function calls the
- * function "out_fn" with array index, the "simdjson_result<>" of the
- * element value and a pointer to the error container as parameters.
+ * Create evalutation function to evaluate a range of array elements.
  *
- *     void
- *     get_fn(
- *         size_t idx,
- *         simdjson::simdjson_result<simdjson::ondemand::value> *result,
- *         error *err);
+ * The created function calls `array_fn`, which should be created by
+ * `array_to_function()`, `array_to_out_iter()` or `array_to_batch()`,
+ * for the elements with the indices `[begin, end)` of the array only:
+ * the elements before `begin` are skipped without evaluation and the
+ * iteration stops at `end`. The following elements are not read, so a
+ * truncated document parsed by `parser::iterate_allow_incomplete_json()`
+ * can be evaluated. Errors are reported with the original array indices.
  *
- * @param is_null Pointer to location to store `null` status. If
- *                `(is_null == nullptr)` a `null` is not allowed.
- * @param out_fn Function call for each element.
+ * @param begin Index of the first element.
+ * @param end Index behind the last element.
+ * @param array_fn Function to evaluate the JSON array.
  *
  * @return Function to evaluate JSON array.
  */
 template<
     typename SJValue = simdjson::ondemand::value,
-    typename OutFn>
+    typename ArrayFn>
 inline auto
-array_to_function(bool *is_null, OutFn out_fn)
+slice(size_t begin, size_t end, ArrayFn array_fn)
 {
     using ResultType = simdjson::simdjson_result<SJValue>;
 
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("array_to_function(bool*.OutFn)");
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("slice(size_t,size_t,ArrayFn)");
     _SIMDJSON_PEVAL_TRACE("start");
 
-    auto call_fn = array_to_function<SJValue>(out_fn);
-
     return
-        [is_null, call_fn]
+        [begin, end, array_fn]
         (ResultType &sj_result, error *err)
         _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
         {
             _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
             _SIMDJSON_PEVAL_ASSERT(err != nullptr);
 
-            if (internal::check_null(sj_result, is_null)) {
-                _SIMDJSON_PEVAL_TRACE("is_null");
-            }
-            else {
-                call_fn(sj_result, err);
-            }
+            err->set_slice(begin, end);
+            array_fn(sj_result, err);
+
+            // not taken for `null` or type errors.
+            err->take_slice();
 
             _SIMDJSON_PEVAL_TRACE_EVAL_END();
         };
-
 }
 
 /**
- * Create evalutation function to store object data by function.
+ * Create evalutation function to evaluate the first array elements.
  *
- * The created function that calls `value_fn` for each element of the
- * array which has to store the result into `*temp_value_ptr`. Then
- * `out_fn` is called with the array index, `temp_pair_ptr` and a
- * pointer to the error container to store the array element.
+ * See `slice(size_t,size_t,ArrayFn)`.
  *
- *     void
- *     get_fn(size_t idx, ValueType *temp_pair, error *err)
+ * @param count Number of elements.
+ * @param array_fn Function to evaluate the JSON array.
  *
- * @param out_fn Function call for each member to store the temporary value.
- * @param temp_value_ptr Pointer to a temporary space to store array elements.
- * @param value_fn Function to evaluate a single array element and store
- *                it into `temp_value_ptr`.
+ * @return Function to evaluate JSON array.
+ */
+template<
+    typename SJValue = simdjson::ondemand::value,
+    typename ArrayFn>
+inline auto
+take(size_t count, ArrayFn array_fn)
+{
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("take(size_t,ArrayFn)");
+    _SIMDJSON_PEVAL_TRACE("start");
+
+    return slice<SJValue>(0, count, std::move(array_fn));
+}
+
+/**
+ * Create evalutation function to evaluate all array elements without
+ * storing them.
+ *
+ * Used with reducers like `reduce_sum()`, which accumulate the values
+ * of the elements themselves.
+ *
+ * @param value_fn Function to evaluate a single array element.
  *
  * @return Function to evaluate JSON array.
  */
 template<
     typename SJValue = simdjson::ondemand::value,
-    typename OutFn,
-    typename TempValue,
     typename ValueFn>
 inline auto
-array_to_function(
-    OutFn out_fn,
-    TempValue *temp_value_ptr,
-    ValueFn value_fn)
+array_for_each(ValueFn value_fn)
 {
-    using ResultType = simdjson::simdjson_result<SJValue>;
     using SJValueType = simdjson::simdjson_result<simdjson::ondemand::value>;
 
-    _SIMDJSON_PEVAL_TRACE_SET_NAME(
-        "array_to_function(OutFn,TempValue*,ValueFn)");
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("array_for_each(ValueFn)");
     _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(temp_value_ptr != nullptr);
 
-    auto gen_out_fn =
+    return
         array_to_function<SJValue>(
-            [out_fn, temp_value_ptr, value_fn]
+            [value_fn]
             (size_t idx, SJValueType *sj_result, error *err)
             _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
             {
-                _SIMDJSON_PEVAL_TRACE("start_gen_out_fn");
-                _SIMDJSON_PEVAL_ASSERT(err != nullptr);
-
+                error::record_scope record(err);
+                const auto num_errors = err->get_count();
                 value_fn(*sj_result, err);
-                out_fn(idx, temp_value_ptr, err);
 
-                _SIMDJSON_PEVAL_TRACE("end_gen_out_fn");
+                // nothing to skip for elements rejected by `where()`.
+                if (!err->is_rejected() && err->get_count() == num_errors) {
+                    record.commit();
+                }
+                err->set_rejected(false);
             });
+}
 
-    return
-        [gen_out_fn]
-        (ResultType &sj_result, error *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
-        {
-            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
-            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
 
-            gen_out_fn(sj_result, err);
+/// @}
 
-            _SIMDJSON_PEVAL_TRACE_EVAL_END();
-        };
-}
+///
+/// @name Batches of records.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
 
 /**
- * Create evalutation function to store object data by function.
- *
- * The created function that calls `value_fn` for each element of the
- * array which has to store the result into `*temp_value_ptr`. Then
- * `out_fn` is called with `*temp_pair_ptr` and a pointer to the error
- * class to store the array element.
+ * Buffer to pass evaluated records to a function in batches.
  *
- *     void
- *     get_fn(ValueType *temp_pair, error *err)
+ * The buffer has a fixed capacity. The memory of the buffer is kept
+ * by `clear()`, so it can be reused for all batches.
  *
- * @param is_null Pointer to location to store `null` status. If
- *                `(is_null == nullptr)` a `null` is not allowed.
- * @param out_fn Function call for each member to store the temporary value.
- * @param temp_value_ptr Pointer to a temporary space to store array elements.
- * @param value_fn Function to evaluate a single array element and store
- *                 it into `temp_value_ptr`.
+ * A batch function gets a pointer to the batch and a pointer to the
+ * error container. The records may be moved out of the batch.
  *
- * @return Function to evaluate JSON array.
+ *     void
+ *     batch_fn(record_batch<Record> *batch, error *err);
  */
-template<
-    typename SJValue = simdjson::ondemand::value,
-    typename OutFn,
-    typename TempValue,
-    typename ValueFn>
-inline auto
-array_to_function(
-    bool *is_null,
-    OutFn out_fn,
-    TempValue *temp_value_ptr,
-    ValueFn value_fn)
-{
-    using ResultType = simdjson::simdjson_result<SJValue>;
+template<typename Record>
+class record_batch {
+public:
+    using value_type = Record;
+    using iterator = typename std::vector<Record>::iterator;
+    using const_iterator = typename std::vector<Record>::const_iterator;
 
-    _SIMDJSON_PEVAL_TRACE_SET_NAME(
-        "array_to_function(bool*,OutFn,TempValue*,ValueFn)");
-    _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(temp_value_ptr != nullptr);
+    /**
+     * Constructor.
+     *
+     * @param capacity Maximum number of records in a batch.
+     */
+    explicit record_batch(size_t capacity)
+        : capacity(capacity > 0 ? capacity : 1)
+    {
+        records.reserve(this->capacity);
+    }
 
-    auto call_fn =
-        array_to_function<SJValue>(out_fn, temp_value_ptr, value_fn);
+    /**
+     * Add a record.
+     *
+     * @param record_ptr Pointer to the record to move into the batch.
+     */
+    void
+    push(Record *record_ptr) {
+        _SIMDJSON_PEVAL_ASSERT(!full());
+        records.push_back(std::move(*record_ptr));
+    }
 
-    return
-        [is_null, call_fn]
-        (ResultType &sj_result, error *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
-        {
-            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
-            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+    /**
+     * Remove all records, but keep the memory.
+     */
+    void
+    clear() {
+        records.clear();
+    }
 
-            if (internal::check_null(sj_result, is_null)) {
-                _SIMDJSON_PEVAL_TRACE("is_null");
-            }
-            else {
-                call_fn(sj_result, err);
-            }
+    /**
+     * Exchange the records with another batch without moving them.
+     *
+     * @param other Batch to exchange records with.
+     */
+    void
+    swap(record_batch &other) {
+        records.swap(other.records);
+        std::swap(capacity, other.capacity);
+    }
 
-            _SIMDJSON_PEVAL_TRACE_EVAL_END();
-        };
-}
+    /**
+     * Get number of records.
+     */
+    size_t
+    size() const {
+        return records.size();
+    }
+
+    /**
+     * Get maximum number of records.
+     */
+    size_t
+    get_capacity() const {
+        return capacity;
+    }
+
+    /**
+     * Checks if there are no records.
+     */
+    bool
+    empty() const {
+        return records.empty();
+    }
+
+    /**
+     * Checks if maximum number of records is reached.
+     */
+    bool
+    full() const {
+        return (records.size() >= capacity);
+    }
+
+    /// Pointer to the first record (e.g. to create a `std::span`).
+    Record *
+    data() {
+        return records.data();
+    }
+
+    /// Pointer to the first record (e.g. to create a `std::span`).
+    const Record *
+    data() const {
+        return records.data();
+    }
+
+    /// Access record by index.
+    Record &
+    operator[](size_t idx) {
+        return records[idx];
+    }
+
+    /// Access record by index.
+    const Record &
+    operator[](size_t idx) const {
+        return records[idx];
+    }
+
+    /// Iterator to first record.
+    iterator begin() { return records.begin(); }
+
+    /// Iterator behind last record.
+    iterator end() { return records.end(); }
+
+    /// Iterator to first record.
+    const_iterator begin() const { return records.begin(); }
+
+    /// Iterator behind last record.
+    const_iterator end() const { return records.end(); }
+
+private:
+
+    /// Records of the batch.
+    std::vector<Record> records;
+
+    /// Maximum number of records.
+    size_t capacity;
+
+}; // class record_batch
+
+#ifdef __cpp_concepts
 
 /**
- * Create evalutation function to store array data into an output
- * iterator.
+ * Function which receives batches of records.
  *
- * The created function that calls `value_fn` for each element of the
- * array. This function has to store the result into `*temp_value_ptr`. Then
- * the value is moved into the output iterator.
+ *     void
+ *     batch_fn(record_batch<Record> *batch, error *err);
+ */
+template<typename BatchFn, typename Record>
+concept batch_sink =
+    std::is_invocable_v<BatchFn &, record_batch<Record> *, error *>;
+
+#endif // __cpp_concepts
+
+/**
+ * Create evalutation function to pass array elements in batches to a
+ * function.
  *
- * @param out_iter Output iterator to store values.
+ * The created function calls `value_fn` for each element of the
+ * array, which has to store the result into `*temp_value_ptr`. If no
+ * error occurred, the value is moved into `*batch_ptr`. Full batches
+ * and the last batch at the end of the array are passed to `batch_fn`
+ * and cleared afterwards:
+ *
+ *     void
+ *     batch_fn(record_batch<TempValue> *batch, error *err);
+ *
+ * The capacity of the batch defines the number of records passed at
+ * once. The memory of the batch is reused for all batches.
+ *
+ * @param batch_fn Function called with batches of values.
+ * @param batch_ptr Pointer to the batch to collect values.
  * @param temp_value_ptr Pointer to a temporary space to store array elements.
  * @param value_fn Function to evaluate a single array element and store
  *                 it into `*temp_value_ptr`.
@@ -2716,59 +5269,112 @@ array_to_function(
  */
 template<
     typename SJValue = simdjson::ondemand::value,
-    typename OutIter,
+    typename BatchFn,
     typename TempValue,
     typename ValueFn>
 inline auto
-array_to_out_iter(
-    OutIter out_iter,
+array_to_batch(
+    BatchFn batch_fn,
+    record_batch<TempValue> *batch_ptr,
     TempValue *temp_value_ptr,
     ValueFn value_fn)
 {
     using ResultType = simdjson::simdjson_result<SJValue>;
 
-    _SIMDJSON_PEVAL_TRACE_SET_NAME(
-        "array_to_out_iter(OutIter,TempValue*,ValueFn)");
-    _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(temp_value_ptr != nullptr);
-
-    auto out_fn =
-        [out_iter]
-        (auto idx, auto *value_ptr, error *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
-        {
-            *out_iter = std::move(*value_ptr);
-            ++out_iter;
-        };
+#ifdef __cpp_concepts
+    static_assert(
+        batch_sink<BatchFn, TempValue>,
+        "batch_fn must be callable with (record_batch<TempValue>*, error*)");
+#endif
 
-    auto save_fn =
-        array_to_function<SJValue>(out_fn, temp_value_ptr, value_fn);
+    _SIMDJSON_PEVAL_TRACE_SET_NAME(
+        "array_to_batch(BatchFn,record_batch*,TempValue*,ValueFn)");
+    _SIMDJSON_PEVAL_TRACE("start");
+    _SIMDJSON_PEVAL_ASSERT(batch_ptr != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(temp_value_ptr != nullptr);
 
     return
-        [save_fn]
+        [batch_fn, batch_ptr, temp_value_ptr, value_fn]
         (ResultType &sj_result, error *err)
         _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
         {
             _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
             _SIMDJSON_PEVAL_ASSERT(err != nullptr);
 
-            save_fn(sj_result, err);
+            simdjson::simdjson_result<simdjson::ondemand::array> sj_array;
+            if constexpr(std::is_same_v<SJValue, simdjson::ondemand::array>)
+            {
+                _SIMDJSON_PEVAL_TRACE("type:array");
+                sj_array = sj_result;
+            }
+            else {
+                _SIMDJSON_PEVAL_TRACE("type:other");
+                sj_array = sj_result.value().get_array();
+                const auto code = sj_array.error();
+                if (code) {
+                    _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                    err->add(code);
+                    _SIMDJSON_PEVAL_TRACE_EVAL_END();
+                    return;
+                }
+            }
+
+            const auto [first_idx, end_idx] = err->take_slice();
+            size_t idx = 0;
+            for (auto sj_value : sj_array) {
+                if (idx < first_idx) {
+                    // skipped by slice() without evaluation.
+                    ++idx;
+                    continue;
+                }
+                if (idx >= end_idx) {
+                    break;
+                }
+                error::path_scope array_idx_scope(err, idx);
+                if (err->is_stopped()) {
+                    break;
+                }
+                ++idx;
+
+                error::record_scope record(err);
+                const auto num_errors = err->get_count();
+                value_fn(sj_value, err);
+                if (err->is_rejected()) {
+                    _SIMDJSON_PEVAL_TRACE("rejected");
+                    err->set_rejected(false);
+                }
+                else if (err->get_count() == num_errors) {
+                    record.commit();
+                    batch_ptr->push(temp_value_ptr);
+                    if (batch_ptr->full()) {
+                        _SIMDJSON_PEVAL_TRACE("batch");
+                        batch_fn(batch_ptr, err);
+                        batch_ptr->clear();
+                    }
+                }
+            }
+
+            // flush last batch at the end of the array.
+            if (!batch_ptr->empty()) {
+                _SIMDJSON_PEVAL_TRACE("batch");
+                batch_fn(batch_ptr, err);
+                batch_ptr->clear();
+            }
 
             _SIMDJSON_PEVAL_TRACE_EVAL_END();
         };
 }
 
 /**
- * Create evalutation function to store array data into an output
- * iterator.
+ * Create evalutation function to pass array elements in batches to a
+ * function.
  *
- * The created function that calls `value_fn` for each element of the
- * array. This function has to store the result into `*temp_value_ptr`. Then
- * the value is moved into the output iterator.
+ * See `array_to_batch(BatchFn,record_batch*,TempValue*,ValueFn)`.
  *
  * @param is_null Pointer to location to store `null` status. If
  *                `(is_null == nullptr)` a `null` is not allowed.
- * @param out_iter Output iterator to store values.
+ * @param batch_fn Function called with batches of values.
+ * @param batch_ptr Pointer to the batch to collect values.
  * @param temp_value_ptr Pointer to a temporary space to store array elements.
  * @param value_fn Function to evaluate a single array element and store
  *                 it into `*temp_value_ptr`.
@@ -2777,25 +5383,25 @@ array_to_out_iter(
  */
 template<
     typename SJValue = simdjson::ondemand::value,
-    typename OutIter,
+    typename BatchFn,
     typename TempValue,
     typename ValueFn>
 inline auto
-array_to_out_iter(
+array_to_batch(
     bool *is_null,
-    OutIter out_iter,
+    BatchFn batch_fn,
+    record_batch<TempValue> *batch_ptr,
     TempValue *temp_value_ptr,
     ValueFn value_fn)
 {
     using ResultType = simdjson::simdjson_result<SJValue>;
 
     _SIMDJSON_PEVAL_TRACE_SET_NAME(
-        "array_to_out_iter(bool*,OutIter,TempValue*,ValueFn)");
+        "array_to_batch(bool*,BatchFn,record_batch*,TempValue*,ValueFn)");
     _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(temp_value_ptr != nullptr);
 
     auto save_fn =
-        array_to_out_iter<SJValue>(out_iter, temp_value_ptr, value_fn);
+        array_to_batch<SJValue>(batch_fn, batch_ptr, temp_value_ptr, value_fn);
 
     return
         [is_null, save_fn]
@@ -2816,224 +5422,529 @@ array_to_out_iter(
         };
 }
 
+/// @}
+
+///
+/// @name Padded buffers.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
+
+// @name Internal implementations
+// @private
+namespace internal {
+
+/// Size of a transparent huge page.
+static constexpr size_t huge_page_size = size_t(2) << 20;
 
 /**
- * Create evalutation function to store single array values.
+ * Deleter of buffers allocated by `allocate_buffer()`.
  *
- * @param all_element_fn Values that should be evaluated in order.
+ * @private
+ */
+struct buffer_deleter {
+    /// Alignment of the buffer (`0`: allocated by `new[]`).
+    size_t alignment = 0;
+
+    void
+    operator()(char *ptr) const {
+        if (alignment != 0) {
+            ::operator delete(ptr, std::align_val_t(alignment));
+        }
+        else {
+            delete[] ptr;
+        }
+    }
+};
+
+/// Buffer allocated by `allocate_buffer()`.
+using buffer_ptr = std::unique_ptr<char[], buffer_deleter>;
+
+/**
+ * Allocate a buffer.
  *
- * @return Function to evaluate JSON object.
+ * Large buffers with `huge_pages` are aligned to huge pages and
+ * advised to be backed by transparent huge pages. If huge pages are
+ * not available, normal pages are used silently.
+ *
+ * @private
+ *
+ * @param size_ptr Pointer to the size to allocate. Updated to the size
+ *                 allocated, if it is rounded up to huge pages.
+ * @param huge_pages Flag: use transparent huge pages.
  */
-template<
-    typename SJValue = simdjson::ondemand::value,
-    typename ...AllElementFn>
-inline auto
-array(AllElementFn ...all_element_fn) {
-    using ResultType = simdjson::simdjson_result<SJValue>;
+inline buffer_ptr
+allocate_buffer(size_t *size_ptr, bool huge_pages) {
+    if (!huge_pages || *size_ptr < huge_page_size) {
+        return buffer_ptr(new char[*size_ptr]);
+    }
 
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("array(AllElementFn...)");
-    _SIMDJSON_PEVAL_TRACE("start");
+    *size_ptr = (*size_ptr + huge_page_size - 1) / huge_page_size
+        * huge_page_size;
+    auto *ptr =
+        static_cast<char *>(
+            ::operator new(*size_ptr, std::align_val_t(huge_page_size)));
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    ::madvise(ptr, *size_ptr, MADV_HUGEPAGE);
+#endif
 
-    auto eval_all_fn =
-        internal::array(std::forward<AllElementFn>(all_element_fn)...);
+    return buffer_ptr(ptr, buffer_deleter{huge_page_size});
+}
 
-    return
-        [eval_all_fn]
-        (ResultType &sj_result, error *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
-        {
-            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
-            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+} // namespace internal
 
-            simdjson::simdjson_result<simdjson::ondemand::array> sj_array;
-            if constexpr(std::is_same_v<SJValue, simdjson::ondemand::array>) {
-                _SIMDJSON_PEVAL_TRACE("type:array");
-                sj_array = sj_result;
-            }
-            else {
-                _SIMDJSON_PEVAL_TRACE("type:other");
-                sj_array = sj_result.value().get_array();
-                const auto code = sj_array.error();
-                if (code) {
-                    _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                    err->add(code);
-                    _SIMDJSON_PEVAL_TRACE_EVAL_END();
-                    return;
-                }
-            }
+/**
+ * Growable buffer for JSON data with `simdjson::SIMDJSON_PADDING`
+ * bytes behind its capacity.
+ *
+ * Unlike `simdjson::padded_string` the buffer can be refilled and
+ * enlarged without new allocations for each document.
+ *
+ * Buffers for large inputs can be backed by transparent huge pages
+ * to reduce TLB misses. Then allocations of at least 2 MiB are
+ * aligned to huge pages and advised by `madvise(MADV_HUGEPAGE)`. If
+ * huge pages are not available, normal pages are used.
+ */
+class padded_buffer {
+public:
 
-            auto sj_array_iter = sj_array.value().begin();
-            auto sj_array_end  = sj_array.value().end();
-            eval_all_fn(&sj_array_iter, &sj_array_end, 0, err);
+    /**
+     * Constructor.
+     *
+     * @param capacity Initial capacity without padding.
+     * @param huge_pages Use transparent huge pages for large
+     *                   allocations.
+     */
+    explicit padded_buffer(size_t capacity = 0, bool huge_pages = false)
+        : huge_pages(huge_pages)
+    {
+        reserve(capacity);
+    }
+
+    /// Pointer to the data.
+    char *
+    data() {
+        return buffer.get();
+    }
+
+    /// Pointer to the data.
+    const char *
+    data() const {
+        return buffer.get();
+    }
+
+    /**
+     * Get number of bytes used.
+     */
+    size_t
+    size() const {
+        return used;
+    }
+
+    /**
+     * Get capacity without padding.
+     */
+    size_t
+    get_capacity() const {
+        return capacity;
+    }
+
+    /**
+     * Set number of bytes used and enlarge capacity if needed.
+     *
+     * The capacity is at least doubled, so that appending data takes
+     * amortized constant time.
+     *
+     * @param new_size Number of bytes used.
+     */
+    void
+    resize(size_t new_size) {
+        if (new_size > capacity) {
+            reserve(std::max(new_size, capacity * 2));
+        }
+        used = new_size;
+    }
+
+    /**
+     * Enlarge capacity and keep the data.
+     *
+     * @param new_capacity Minimum capacity without padding.
+     */
+    void
+    reserve(size_t new_capacity);
+
+    /**
+     * Remove all data, but keep the memory.
+     */
+    void
+    clear() {
+        used = 0;
+    }
+
+    /**
+     * Get padded view of the data used.
+     */
+    simdjson::padded_string_view
+    view() const {
+        return
+            simdjson::padded_string_view(
+                buffer.get(), used, capacity + simdjson::SIMDJSON_PADDING);
+    }
+
+    /**
+     * Checks if transparent huge pages are used for large allocations.
+     */
+    bool
+    is_huge_pages_enabled() const {
+        return huge_pages;
+    }
+
+private:
+
+    /// data with padding.
+    internal::buffer_ptr buffer;
+
+    /// capacity without padding.
+    size_t capacity = 0;
+
+    /// number of bytes used.
+    size_t used = 0;
+
+    /// use transparent huge pages.
+    bool huge_pages = false;
+
+}; // class padded_buffer
+
+/// @}
+
+///
+/// @name Evaluation sessions.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
+
+/**
+ * Session owning all objects needed to evaluate documents.
+ *
+ * A session bundles the parser, a padded buffer for the input, the
+ * error container and a temporary record. Prototypes are created once
+ * with pointers into the record of the session (`get_record()`) and
+ * then evaluate one document after the other. All objects keep their
+ * capacity between evaluations, so once the session has seen the
+ * largest document, an evaluation does no heap allocations besides
+ * the ones of the output containers and of error messages.
+ *
+ * Example:
+ *
+ *     session<my_record> sess;
+ *     auto *rec = sess.get_record();
+ *     auto proto =
+ *         object<simdjson::ondemand::document>(
+ *             member("id", number_value(&rec->id)));
+ *
+ *     if (sess.evaluate(json, proto)) {
+ *         use(*rec);
+ *     }
+ *
+ * @tparam Record Type of the temporary record.
+ */
+template<typename Record = std::monostate>
+class session {
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param path_flag Flag: collect element paths for errors.
+     * @param max_capacity Maximum document size of the parser.
+     * @param huge_pages Use transparent huge pages for large inputs.
+     */
+    explicit session(
+        bool path_flag = false,
+        size_t max_capacity = simdjson::SIMDJSON_MAXSIZE_BYTES,
+        bool huge_pages = false)
+        : parser(max_capacity), buffer(0, huge_pages), errors(path_flag)
+    { /* empty */ }
+
+    session(const session &) = delete;
+    session &operator=(const session &) = delete;
+
+    /**
+     * Evaluate a document.
+     *
+     * The input is copied into the padded buffer of the session and
+     * the errors of the previous evaluation are removed.
+     *
+     * @param input JSON document.
+     * @param proto Evaluation function for `simdjson::ondemand::document`.
+     *
+     * @return `true` if the document was evaluated without errors and
+     *         was not rejected by `where()`. If the parser can't
+     *         iterate the input (e.g. empty input or input larger than
+     *         the maximum capacity), its error is added and `false` is
+     *         returned.
+     */
+    template<typename ProtoFn>
+    bool
+    evaluate(std::string_view input, ProtoFn &&proto) {
+        buffer.resize(input.size());
+        if (!input.empty()) {
+            std::memcpy(buffer.data(), input.data(), input.size());
+        }
+
+        errors.reset();
+        auto sj_doc = parser.iterate(buffer.view());
+        if (sj_doc.error()) {
+            _SIMDJSON_PEVAL_TRACE_SET_NAME("session::evaluate()");
+            _SIMDJSON_PEVAL_TRACE_ERROR(sj_doc.error());
+            errors.add(sj_doc.error());
+            return false;
+        }
+
+        error::record_scope record(&errors);
+        proto(sj_doc, &errors);
+
+        const auto is_accepted = (!errors && !errors.is_rejected());
+        if (is_accepted) {
+            record.commit();
+        }
+
+        return is_accepted;
+    }
+
+    /**
+     * Remove input and errors, but keep the capacity of all objects.
+     *
+     * The record is not changed.
+     */
+    void
+    reset() {
+        buffer.clear();
+        errors.reset();
+    }
+
+    /**
+     * Get the parser.
+     */
+    simdjson::ondemand::parser &
+    get_parser() {
+        return parser;
+    }
+
+    /**
+     * Get the buffer holding the input of the last evaluation.
+     */
+    padded_buffer &
+    get_buffer() {
+        return buffer;
+    }
+
+    /**
+     * Get the error container.
+     *
+     * Guards and limits attached to it apply to all evaluations.
+     */
+    error &
+    get_errors() {
+        return errors;
+    }
+
+    /**
+     * Get the temporary record.
+     */
+    Record *
+    get_record() {
+        return &record;
+    }
+
+private:
+
+    /// Parser keeping its capacity.
+    simdjson::ondemand::parser parser;
+
+    /// Padded copy of the input.
+    padded_buffer buffer;
+
+    /// Errors of the last evaluation.
+    error errors;
+
+    /// Temporary record.
+    Record record;
+
+}; // class session
+
+/// @}
+
+
+// inline implementations of class error_message
+// //////////////////////////////////////////////////////////////////////
+
+inline std::string
+error_message::to_string() const {
+    std::string result;
+
+    if (!path.empty()) {
+        result += "at " + path + ": ";
+    }
 
-            _SIMDJSON_PEVAL_TRACE_EVAL_END();
-        };
-}
+    result += get_text();
 
-/**
- * Create evalutation function to store single array values.
- *
- * @param is_null Pointer to location to store `null` status. If
- *                `(is_null == nullptr)` a `null` is not allowed.
- * @param all_element_fn Values that should be evaluated in order.
- *
- * @return Function to evaluate JSON object.
- */
-template<
-    typename SJValue = simdjson::ondemand::value,
-    typename ...AllElementFn>
-inline auto
-array(bool *is_null, AllElementFn ...all_element_fn) {
-    using ResultType = simdjson::simdjson_result<SJValue>;
+    result += " (" + std::to_string(code) + ')';
 
-    _SIMDJSON_PEVAL_TRACE_SET_NAME("array(bool*,AllElementFn...)");
-    _SIMDJSON_PEVAL_TRACE("start");
+    return result;
+}
 
-    auto eval_all_fn =
-        array<simdjson::ondemand::array>(
-            std::forward<AllElementFn>(all_element_fn)...);
 
-    return
-        [is_null, eval_all_fn]
-        (ResultType &sj_result, error *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE_MUTABLE
-        {
-            _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
-            _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+// inline implementations of class error_histogram
+// //////////////////////////////////////////////////////////////////////
 
-            if (internal::check_null(sj_result, is_null)) {
-                _SIMDJSON_PEVAL_TRACE("is_null");
-                _SIMDJSON_PEVAL_TRACE_EVAL_END();
-                return;
-            }
+inline std::string
+error_histogram::entry::to_string() const {
+    std::string result;
 
-            auto sj_array = sj_result.value().get_array();
-            const auto code = sj_array.error();
-            if (code) {
-                _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                err->add(code);
-            }
-            else {
-                eval_all_fn(sj_array, err);
-            }
+    result += path + ": ";
+    result += get_text();
+    result += " (" + std::to_string(code) + ')';
+    result += " count: " + std::to_string(count);
+    result += ", first at " + first_path;
 
-            _SIMDJSON_PEVAL_TRACE_EVAL_END();
-        };
+    return result;
 }
 
-/**
- * Create evalutation function to store array value.
- *
- * @param val_ptr Pointer to simdjson array.
- *
- * @return Function to evaluate JSON object.
- */
-template<typename SJValue = simdjson::ondemand::value>
-inline auto
-array(simdjson::simdjson_result<simdjson::ondemand::array> *val_ptr)
+inline void
+error_histogram::add(
+    simdjson::error_code code,
+    std::string_view path_template,
+    std::string_view path)
 {
-    using JSArrayValue = simdjson::simdjson_result<simdjson::ondemand::array>;
+    ++total;
 
-    _SIMDJSON_PEVAL_TRACE_SET_NAME(
-        "array(simdjson::simdjson_result<simdjson::ondemand::array>*)");
-    _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
+    auto entry_ptr = get_entry(code, path_template);
+    if (!entry_ptr) {
+        ++dropped;
+        return;
+    }
 
-    auto get_value =
-        [](auto *sj_result, auto *val_ptr, auto *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE
-        {
-            _SIMDJSON_PEVAL_TRACE("start:get_value");
-            if constexpr(std::is_same_v<decltype(*sj_result), JSArrayValue&>) {
-                _SIMDJSON_PEVAL_TRACE("type:array");
-                *val_ptr = *sj_result;
-            }
-            else {
-                _SIMDJSON_PEVAL_TRACE("type:other");
-                auto sj_array = sj_result->value().get_array();
-                const auto code = sj_array.error();
-                if (code) {
-                    _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                    err->add(code);
-                }
-                else {
-                    *val_ptr = sj_array;
-                }
-            }
-        };
+    if (entry_ptr->count == 0) {
+        entry_ptr->first_path = path.substr(0, max_path_length);
+    }
 
-    return value<SJValue>(val_ptr, get_value);
+    ++entry_ptr->count;
+    add_sample(entry_ptr, path);
 }
 
+inline void
+error_histogram::merge(const error_histogram &other, size_t index_offset) {
+    total += other.total;
+    dropped += other.dropped;
+
+    std::string path_buffer;
+    for (const auto &other_entry : other.entries) {
+        auto entry_ptr = get_entry(other_entry.code, other_entry.path);
+        if (!entry_ptr) {
+            dropped += other_entry.count;
+            continue;
+        }
 
-/**
- * Create evalutation function to store array value.
- *
- * @param val_ptr Pointer to simdjson array.
- * @param is_null Pointer to location to store `null` status. If
- *                `(is_null == nullptr)` a `null` is not allowed.
- *
- * @return Function to evaluate JSON object.
- */
-template<typename SJValue = simdjson::ondemand::value>
-inline auto
-array(
-    simdjson::simdjson_result<simdjson::ondemand::array> *val_ptr,
-    bool *is_null)
+        if (entry_ptr->count == 0) {
+            internal::rebase_path(
+                other_entry.first_path, index_offset, &path_buffer);
+            entry_ptr->first_path = path_buffer.substr(0, max_path_length);
+        }
+
+        entry_ptr->count += other_entry.count;
+        for (const auto &sample : other_entry.samples) {
+            internal::rebase_path(sample, index_offset, &path_buffer);
+            add_sample(entry_ptr, path_buffer);
+        }
+    }
+}
+
+inline std::string
+error_histogram::to_string() const {
+    std::string result;
+    for (const auto &elem : entries) {
+        result += elem.to_string() + '\n';
+    }
+
+    if (dropped != 0) {
+        result += "dropped: " + std::to_string(dropped) + '\n';
+    }
+
+    if (!result.empty()) {
+        result.pop_back();
+    }
+
+    return result;
+}
+
+inline error_histogram::entry *
+error_histogram::get_entry(
+    simdjson::error_code code,
+    std::string_view path_template)
 {
-    using JSArrayValue = simdjson::simdjson_result<simdjson::ondemand::array>;
+    path_template = path_template.substr(0, max_path_length);
 
-    _SIMDJSON_PEVAL_TRACE_SET_NAME(
-        "array(simdjson::simdjson_result<simdjson::ondemand::array>*,bool*)");
-    _SIMDJSON_PEVAL_TRACE("start");
-    _SIMDJSON_PEVAL_ASSERT(val_ptr != nullptr);
+    const auto hash =
+        std::hash<std::string_view>{}(path_template) ^ size_t(code);
 
-    auto get_value =
-        [](auto *sj_result, auto *val_ptr, auto *err)
-        _SIMDJSON_PEVAL_ALWAYS_INLINE
+    for (auto &elem : entries) {
+        if (elem.hash == hash
+            && elem.code == code
+            && elem.path == path_template)
         {
-            _SIMDJSON_PEVAL_TRACE("start:get_value");
-            if constexpr(std::is_same_v<decltype(*sj_result), JSArrayValue&>) {
-                _SIMDJSON_PEVAL_TRACE("type:array");
-                *val_ptr = *sj_result;
-            }
-            else {
-                _SIMDJSON_PEVAL_TRACE("type:other");
-                auto sj_array = sj_result->value().get_array();
-                const auto code = sj_array.error();
-                if (code) {
-                    _SIMDJSON_PEVAL_TRACE_ERROR(code);
-                    err->add(code);
-                }
-                else {
-                    *val_ptr = sj_array;
-                }
-            }
-        };
+            return &elem;
+        }
+    }
 
-    return value<SJValue>(val_ptr, get_value, is_null);
+    if (entries.size() >= max_entries) {
+        return nullptr;
+    }
+
+    auto &new_entry = entries.emplace_back();
+    new_entry.hash = hash;
+    new_entry.code = code;
+    new_entry.path = path_template;
+    new_entry.count = 0;
+    new_entry.next_sample = 0;
+    new_entry.samples.reserve(max_samples);
+
+    return &new_entry;
 }
 
+inline void
+error_histogram::add_sample(entry *entry_ptr, std::string_view path) {
+    if (max_samples == 0) {
+        return;
+    }
 
-/// @}
+    path = path.substr(0, max_path_length);
 
+    if (entry_ptr->samples.size() < max_samples) {
+        entry_ptr->samples.emplace_back(path);
+    }
+    else {
+        entry_ptr->samples[entry_ptr->next_sample].assign(path);
+        entry_ptr->next_sample = (entry_ptr->next_sample + 1) % max_samples;
+    }
+}
 
-// inline implementations of class error_message
-// //////////////////////////////////////////////////////////////////////
 
-inline std::string
-error_message::to_string() const {
-    std::string result;
+// inline implementations of class padded_buffer
+// //////////////////////////////////////////////////////////////////////
 
-    if (!path.empty()) {
-        result += "at " + path + ": ";
+inline void
+padded_buffer::reserve(size_t new_capacity) {
+    if (buffer && new_capacity <= capacity) {
+        return;
     }
 
-    result += get_text();
-
-    result += " (" + std::to_string(code) + ')';
+    auto size = new_capacity + simdjson::SIMDJSON_PADDING;
+    auto new_buffer = internal::allocate_buffer(&size, huge_pages);
+    if (used != 0) {
+        std::memcpy(new_buffer.get(), buffer.get(), used);
+    }
 
-    return result;
+    buffer = std::move(new_buffer);
+    capacity = size - simdjson::SIMDJSON_PADDING;
 }
 
 
@@ -3042,13 +5953,53 @@ error_message::to_string() const {
 
 inline void
 error::add(simdjson::error_code code) {
-    if (code != simdjson::SUCCESS) {
+    if (code == simdjson::SUCCESS) {
+        return;
+    }
+
+    ++count;
+
+    if (histogram) {
+        create_path(&template_buffer, true);
+        create_path(&path_buffer, false);
+        histogram->add(code, template_buffer, path_buffer);
+    }
+    else {
         messages.emplace_back(code, create_path());
     }
 }
 
+inline void
+error::append(const error &other, size_t index_offset) {
+    count += other.count;
+
+    if (histogram && other.histogram) {
+        histogram->merge(*other.histogram, index_offset);
+        return;
+    }
+
+    for (const auto &msg : other.messages) {
+        if (histogram) {
+            internal::rebase_path(msg.get_path(), index_offset, &path_buffer);
+            internal::collapse_path(path_buffer, &template_buffer);
+            histogram->add(msg.get_code(), template_buffer, path_buffer);
+        }
+        else if (index_offset != 0 && !msg.get_path().empty()) {
+            internal::rebase_path(msg.get_path(), index_offset, &path_buffer);
+            messages.emplace_back(msg.get_code(), path_buffer);
+        }
+        else {
+            messages.push_back(msg);
+        }
+    }
+}
+
 inline std::string
 error::to_string() const {
+    if (histogram) {
+        return histogram->to_string();
+    }
+
     std::string result;
     for (const auto &msg : messages) {
         result += msg.to_string() + '\n';
@@ -3066,20 +6017,90 @@ error::create_path() {
         return result_path;
     }
 
-    result_path = "<root>";
+    create_path(&result_path, false);
+
+    return result_path;
+}
+
+inline void
+error::create_path(std::string *result, bool collapse_idx) const {
+    result->assign("<root>");
 
     for (const auto &path_elem : path_vector) {
         if (std::holds_alternative<size_t>(path_elem)) {
-            auto idx = std::get<size_t>(path_elem);
-            result_path += '[' + std::to_string(idx) + ']';
+            if (collapse_idx) {
+                result->append("[*]");
+            }
+            else {
+                auto idx = std::get<size_t>(path_elem);
+                result->append(1, '[')
+                    .append(std::to_string(idx))
+                    .append(1, ']');
+            }
         }
         else if (std::holds_alternative<std::string_view>(path_elem)) {
             auto member_name = std::get<std::string_view>(path_elem);
-            result_path.append(1, '.').append(member_name);
+            result->append(1, '.').append(member_name);
         }
     }
+}
 
-    return result_path;
+
+inline bool
+error::check_stop() {
+    if (limits) {
+        if (limit_code) {
+            return true;
+        }
+
+        auto code = simdjson::SUCCESS;
+        if (depth > base_depth && depth - base_depth > limits->max_depth) {
+            code = DEPTH_LIMIT_EXCEEDED;
+        }
+        else if (scope_idx >= limits->max_array_elements) {
+            code = ARRAY_LIMIT_EXCEEDED;
+        }
+        else if (usage.elements > limits->max_elements) {
+            code = ELEMENT_LIMIT_EXCEEDED;
+        }
+
+        if (code) {
+            stop_by_limit(code);
+            return true;
+        }
+    }
+
+    if (guard == nullptr) {
+        return false;
+    }
+
+    if (!guard->get_stop_code()) {
+        const auto code =
+            guard->check(guard_checks++ % guard->get_check_interval() == 0);
+        if (!code) {
+            return false;
+        }
+        guard->stop(code);
+    }
+
+    // each container sharing the guard fails its current record once.
+    if (!guard_stop_seen) {
+        const auto code = guard->get_stop_code();
+        _SIMDJSON_PEVAL_TRACE_SET_NAME("error::check_stop()");
+        _SIMDJSON_PEVAL_TRACE_ERROR(code);
+        guard_stop_seen = true;
+        add(code);
+    }
+
+    return true;
+}
+
+inline void
+error::stop_by_limit(simdjson::error_code code) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("error::stop_by_limit()");
+    _SIMDJSON_PEVAL_TRACE_ERROR(code);
+    limit_code = code;
+    add(code);
 }
 
 
@@ -3092,6 +6113,11 @@ error::path_scope::path_scope(error *err, size_t idx)
 {
     _SIMDJSON_PEVAL_TRACE_SET_NAME(
         "error::path_scope::path_scope(error*,size_t)");
+    if (error_ptr->limits) {
+        ++error_ptr->depth;
+        ++error_ptr->usage.elements;
+        error_ptr->scope_idx = idx;
+    }
     if (error_ptr->is_path_enabled()) {
         _SIMDJSON_PEVAL_ASSERT(error_ptr != nullptr);
         _SIMDJSON_PEVAL_TRACE("add_idx:" + std::to_string(idx));
@@ -3105,6 +6131,11 @@ error::path_scope::path_scope(error *err, std::string_view member)
 {
     _SIMDJSON_PEVAL_TRACE_SET_NAME(
         "error::path_scope::path_scope(error*,std::string_view)");
+    if (error_ptr->limits) {
+        ++error_ptr->depth;
+        ++error_ptr->usage.elements;
+        error_ptr->scope_idx = 0;
+    }
     if (error_ptr->is_path_enabled()) {
         _SIMDJSON_PEVAL_ASSERT(error_ptr != nullptr);
         _SIMDJSON_PEVAL_TRACE("add_member:" + std::string(member));
@@ -3115,6 +6146,9 @@ error::path_scope::path_scope(error *err, std::string_view member)
 inline
 error::path_scope::~path_scope() {
     _SIMDJSON_PEVAL_TRACE_SET_NAME("error::path_scope::~path_scope()");
+    if (error_ptr->limits) {
+        --error_ptr->depth;
+    }
     if (error_ptr->is_path_enabled()) {
         _SIMDJSON_PEVAL_ASSERT(error_ptr != nullptr);
         _SIMDJSON_PEVAL_TRACE("delete");
@@ -3123,6 +6157,42 @@ error::path_scope::~path_scope() {
 }
 
 
+// inline implementations of class error::record_scope
+// //////////////////////////////////////////////////////////////////////
+
+inline
+error::record_scope::record_scope(error *err)
+    : error_ptr(err)
+    , begin(err->pending_values.size())
+{
+    _SIMDJSON_PEVAL_ASSERT(error_ptr != nullptr);
+    ++error_ptr->record_depth;
+}
+
+inline
+error::record_scope::~record_scope() {
+    if (!committed) {
+        error_ptr->pending_values.resize(begin);
+    }
+    --error_ptr->record_depth;
+}
+
+inline void
+error::record_scope::commit() {
+    committed = true;
+    if (error_ptr->record_depth != 1) {
+        // the enclosing record decides.
+        return;
+    }
+
+    auto &values = error_ptr->pending_values;
+    for (auto idx = begin; idx < values.size(); ++idx) {
+        values[idx].add_fn(values[idx].acc_ptr, values[idx].value);
+    }
+    values.resize(begin);
+}
+
+
 } // namespace simdjson_peval
 
 
@@ -0,0 +1,331 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef SIMDJSON_PEVAL_GENERATOR_H
+#define SIMDJSON_PEVAL_GENERATOR_H 1
+
+#include "simdjson_peval.h"
+
+// Generators need C++20 coroutines.
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <ranges>
+
+
+namespace simdjson_peval {
+
+///
+/// @name Generators of evaluated records.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
+
+/**
+ * Lazy sequence of values produced by a coroutine.
+ *
+ * The coroutine yields references to its values (`co_yield value;`)
+ * and is suspended until the next value is requested. No value is
+ * copied and nothing is allocated after the coroutine frame. A yielded
+ * value may be moved out by the consumer. Destroying the generator
+ * before its end stops the coroutine.
+ *
+ * Example:
+ *
+ *     for (auto &value : gen) {
+ *         ...
+ *     }
+ *
+ * @tparam T Type of the values.
+ */
+template<typename T>
+class generator : public std::ranges::view_base {
+public:
+
+    /**
+     * Promise type of the coroutine.
+     */
+    struct promise_type {
+        /// pointer to the last yielded value.
+        T *value_ptr = nullptr;
+
+        generator
+        get_return_object() noexcept {
+            return generator(handle_type::from_promise(*this));
+        }
+
+        std::suspend_always
+        initial_suspend() const noexcept {
+            return {};
+        }
+
+        std::suspend_always
+        final_suspend() const noexcept {
+            return {};
+        }
+
+        std::suspend_always
+        yield_value(T &value) noexcept {
+            value_ptr = &value;
+            return {};
+        }
+
+        void
+        return_void() const noexcept {
+            // empty
+        }
+
+        void
+        unhandled_exception() const noexcept {
+            std::terminate();
+        }
+
+        /// `co_await` is not allowed in generators.
+        void await_transform() = delete;
+    };
+
+    /// Handle of the coroutine.
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    /**
+     * Input iterator over the values.
+     */
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using reference = T &;
+        using pointer = T *;
+
+        iterator() = default;
+
+        explicit iterator(handle_type handle) noexcept
+            : handle(handle)
+        { /* empty */ }
+
+        reference
+        operator*() const noexcept {
+            return *handle.promise().value_ptr;
+        }
+
+        pointer
+        operator->() const noexcept {
+            return handle.promise().value_ptr;
+        }
+
+        iterator &
+        operator++() {
+            handle.resume();
+            return *this;
+        }
+
+        void
+        operator++(int) {
+            ++*this;
+        }
+
+        friend bool
+        operator==(const iterator &iter, std::default_sentinel_t) noexcept {
+            return (!iter.handle || iter.handle.done());
+        }
+
+    private:
+        handle_type handle;
+    };
+
+    /**
+     * Constructor of an empty generator.
+     */
+    generator() = default;
+
+    generator(const generator &) = delete;
+    generator &operator=(const generator &) = delete;
+
+    /**
+     * Move constructor.
+     */
+    generator(generator &&other) noexcept
+        : handle(std::exchange(other.handle, nullptr))
+    { /* empty */ }
+
+    /**
+     * Move assignment.
+     */
+    generator &
+    operator=(generator &&other) noexcept {
+        if (this != &other) {
+            if (handle) {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
+        }
+
+        return *this;
+    }
+
+    /**
+     * Destructor. Stops the coroutine.
+     */
+    ~generator() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    /**
+     * Start the coroutine and get iterator to the first value.
+     *
+     * May only be called once.
+     */
+    iterator
+    begin() {
+        if (handle) {
+            handle.resume();
+        }
+
+        return iterator(handle);
+    }
+
+    /**
+     * Get end of values.
+     */
+    std::default_sentinel_t
+    end() const noexcept {
+        return std::default_sentinel;
+    }
+
+private:
+
+    explicit generator(handle_type handle) noexcept
+        : handle(handle)
+    { /* empty */ }
+
+    /// handle of the coroutine.
+    handle_type handle;
+
+}; // class generator
+
+/**
+ * Evaluate the elements of an array lazily.
+ *
+ * The returned generator evaluates the next element of the array by
+ * `value_fn`, which has to store the result into `*temp_record_ptr`,
+ * and yields a reference to the temporary record. It is suspended
+ * until the consumer requests the next record. So only one record
+ * exists at a time, no matter how large the array is, and the
+ * consumer can stop the evaluation by leaving the loop.
+ *
+ * Elements with errors are skipped. Errors are stored into `*err`
+ * with the index of the element as path level. The JSON value, the
+ * temporary record and the error container must live until the
+ * generator is destroyed.
+ *
+ * Example:
+ *
+ *     for (auto &tweet : records(sj_doc, &tmp_tweet, eval_tweet, &err)) {
+ *         ...
+ *     }
+ *
+ * @param sj_result JSON value of the array.
+ * @param temp_record_ptr Pointer to a temporary space to store a record.
+ * @param value_fn Function to evaluate a single array element and store
+ *                 it into `*temp_record_ptr`.
+ * @param err Pointer to error container to store errors.
+ *
+ * @return Generator of the records.
+ */
+template<
+    typename Record,
+    typename SJValue,
+    typename ValueFn>
+inline generator<Record>
+records(
+    simdjson::simdjson_result<SJValue> &sj_result,
+    Record *temp_record_ptr,
+    ValueFn value_fn,
+    error *err)
+{
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("records(SJValue&,Record*,ValueFn)");
+    _SIMDJSON_PEVAL_ASSERT(temp_record_ptr != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+
+    simdjson::simdjson_result<simdjson::ondemand::array> sj_array;
+    if constexpr(std::is_same_v<SJValue, simdjson::ondemand::array>) {
+        sj_array = sj_result;
+    }
+    else {
+        sj_array = sj_result.get_array();
+    }
+
+    const auto code = sj_array.error();
+    if (code) {
+        _SIMDJSON_PEVAL_TRACE_ERROR(code);
+        err->add(code);
+        co_return;
+    }
+
+    size_t idx = 0;
+    for (auto sj_value : sj_array.value_unsafe()) {
+        const auto num_errors = err->get_count();
+        bool is_accepted = false;
+        {
+            error::path_scope idx_scope(err, idx);
+            if (err->exceeds_array_limit(idx)) {
+                break;
+            }
+            err->reset_usage();
+            if (err->is_stopped()) {
+                break;
+            }
+
+            // the record scope ends before the record is yielded.
+            error::record_scope record(err);
+            value_fn(sj_value, err);
+
+            is_accepted =
+                (err->get_count() == num_errors && !err->is_rejected());
+            err->set_rejected(false);
+            if (is_accepted) {
+                record.commit();
+            }
+        }
+        ++idx;
+
+        if (is_accepted) {
+            co_yield *temp_record_ptr;
+        }
+    }
+}
+
+/// @}
+
+} // namespace simdjson_peval
+
+#endif // __cpp_impl_coroutine
+
+#endif /* SIMDJSON_PEVAL_GENERATOR_H */
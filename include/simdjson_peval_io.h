@@ -0,0 +1,1984 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef SIMDJSON_PEVAL_IO_H
+#define SIMDJSON_PEVAL_IO_H 1
+
+#include "simdjson_peval.h"
+#include "simdjson_peval_ndjson.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Decompressing sources are only available on request, because they
+// need additional libraries (`-lz`, `-lzstd`).
+#ifdef SIMDJSON_PEVAL_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef SIMDJSON_PEVAL_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+// io_uring is used by `async_file_source`, if the kernel headers are
+// available (disable with `SIMDJSON_PEVAL_NO_URING`).
+#if defined(__linux__) && !defined(SIMDJSON_PEVAL_NO_URING)
+#  if __has_include(<linux/io_uring.h>)
+#    define _SIMDJSON_PEVAL_HAS_URING 1
+#    include <linux/io_uring.h>
+#    include <sys/syscall.h>
+#  endif
+#endif
+
+
+namespace simdjson_peval {
+
+///
+/// @name Sources to read JSON data.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
+
+/**
+ * Source reading from a POSIX file descriptor.
+ *
+ * A source is a function reading the next bytes of a stream. It
+ * returns the number of bytes read, which is `0` at the end of the
+ * stream, or an error code:
+ *
+ *     simdjson::simdjson_result<size_t>
+ *     read_fn(char *buffer, size_t capacity);
+ */
+class fd_source {
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param fd File descriptor to read from. It is not closed.
+     */
+    explicit fd_source(int fd) : fd(fd) { /* empty */ }
+
+    /**
+     * Read next bytes.
+     *
+     * @param buffer Buffer to store the bytes.
+     * @param capacity Maximum number of bytes to read.
+     *
+     * @return Number of bytes read or `simdjson::IO_ERROR`.
+     */
+    simdjson::simdjson_result<size_t>
+    operator()(char *buffer, size_t capacity) {
+        for (;;) {
+            const auto result = ::read(fd, buffer, capacity);
+            if (result >= 0) {
+                return size_t(result);
+            }
+
+            if (errno != EINTR) {
+                return simdjson::IO_ERROR;
+            }
+        }
+    }
+
+private:
+
+    /// file descriptor.
+    int fd;
+
+}; // class fd_source
+
+/// @}
+
+#if defined(SIMDJSON_PEVAL_WITH_ZLIB) || defined(SIMDJSON_PEVAL_WITH_ZSTD)
+
+///
+/// @name Decompressing sources.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
+
+#ifdef SIMDJSON_PEVAL_WITH_ZLIB
+
+/**
+ * Source decompressing gzip or zlib data read from another source.
+ *
+ * The compressed data is read in blocks of `input_size` bytes and
+ * decompressed directly into the buffer of the caller, so there is no
+ * copy of the whole decompressed stream. Concatenated gzip members
+ * are decompressed one after another.
+ *
+ * Corrupt or truncated data is reported as `simdjson::IO_ERROR`.
+ *
+ * Needs `SIMDJSON_PEVAL_WITH_ZLIB` and `-lz`.
+ */
+template<typename ReadFn>
+class gzip_source {
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param read_fn Source of the compressed data.
+     * @param input_size Size of blocks of compressed data.
+     */
+    explicit gzip_source(ReadFn read_fn, size_t input_size = 1 << 16);
+
+    /**
+     * Decompress next bytes.
+     *
+     * @param buffer Buffer to store the bytes.
+     * @param capacity Maximum number of bytes to store.
+     *
+     * @return Number of bytes stored, `simdjson::IO_ERROR` or
+     *         `simdjson::MEMALLOC`.
+     */
+    simdjson::simdjson_result<size_t>
+    operator()(char *buffer, size_t capacity);
+
+private:
+
+    /// release zlib stream.
+    struct stream_deleter {
+        void
+        operator()(z_stream *stream) const {
+            inflateEnd(stream);
+            delete stream;
+        }
+    };
+
+    /// source of compressed data.
+    ReadFn read_fn;
+
+    /// zlib stream (on the heap, because zlib keeps its address).
+    std::unique_ptr<z_stream, stream_deleter> stream;
+
+    /// buffer of compressed data.
+    std::unique_ptr<char[]> input;
+
+    /// size of buffer of compressed data.
+    size_t input_size;
+
+    /// end of compressed data reached.
+    bool input_eof = false;
+
+    /// inside a gzip member.
+    bool in_member = false;
+
+}; // class gzip_source
+
+#endif // SIMDJSON_PEVAL_WITH_ZLIB
+
+#ifdef SIMDJSON_PEVAL_WITH_ZSTD
+
+/**
+ * Source decompressing zstd data read from another source.
+ *
+ * The compressed data is read in blocks of `input_size` bytes and
+ * decompressed directly into the buffer of the caller, so there is no
+ * copy of the whole decompressed stream. Concatenated frames are
+ * decompressed one after another.
+ *
+ * Corrupt or truncated data is reported as `simdjson::IO_ERROR`.
+ *
+ * Needs `SIMDJSON_PEVAL_WITH_ZSTD` and `-lzstd`.
+ */
+template<typename ReadFn>
+class zstd_source {
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param read_fn Source of the compressed data.
+     * @param input_size Size of blocks of compressed data.
+     */
+    explicit zstd_source(
+        ReadFn read_fn, size_t input_size = ZSTD_DStreamInSize());
+
+    /**
+     * Decompress next bytes.
+     *
+     * @param buffer Buffer to store the bytes.
+     * @param capacity Maximum number of bytes to store.
+     *
+     * @return Number of bytes stored, `simdjson::IO_ERROR` or
+     *         `simdjson::MEMALLOC`.
+     */
+    simdjson::simdjson_result<size_t>
+    operator()(char *buffer, size_t capacity);
+
+private:
+
+    /// release zstd stream.
+    struct stream_deleter {
+        void
+        operator()(ZSTD_DStream *stream) const {
+            ZSTD_freeDStream(stream);
+        }
+    };
+
+    /// source of compressed data.
+    ReadFn read_fn;
+
+    /// zstd stream.
+    std::unique_ptr<ZSTD_DStream, stream_deleter> stream;
+
+    /// buffer of compressed data.
+    std::unique_ptr<char[]> input;
+
+    /// size of buffer of compressed data.
+    size_t input_size;
+
+    /// compressed data not decompressed yet.
+    ZSTD_inBuffer in_buffer = {nullptr, 0, 0};
+
+    /// end of compressed data reached.
+    bool input_eof = false;
+
+    /// inside a zstd frame.
+    bool in_frame = false;
+
+}; // class zstd_source
+
+#endif // SIMDJSON_PEVAL_WITH_ZSTD
+
+/// @}
+
+#endif // SIMDJSON_PEVAL_WITH_ZLIB || SIMDJSON_PEVAL_WITH_ZSTD
+
+///
+/// @name Asynchronous file sources.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
+
+/**
+ * Options of an asynchronous file source.
+ */
+struct async_file_options {
+    /// Size of the blocks read at once.
+    size_t block_size = size_t(1) << 20;
+
+    /// Number of blocks read ahead.
+    size_t queue_depth = 4;
+
+    /// Use io_uring, if available. Otherwise `pread()` is used.
+    bool use_uring = true;
+};
+
+/**
+ * Statistics of an asynchronous file source.
+ */
+struct async_file_stats {
+    /// Number of files read.
+    size_t files = 0;
+
+    /// Number of reads submitted.
+    size_t reads = 0;
+
+    /// Number of bytes read.
+    size_t bytes = 0;
+
+    /// Number of times the consumer had to wait for a read.
+    size_t waits = 0;
+};
+
+// @name Internal implementations
+// @private
+namespace internal {
+
+#ifdef _SIMDJSON_PEVAL_HAS_URING
+
+/**
+ * Minimal io_uring instance for reads (without liburing).
+ *
+ * @private
+ */
+class uring {
+public:
+
+    uring() = default;
+
+    uring(const uring &) = delete;
+    uring &operator=(const uring &) = delete;
+
+    ~uring() {
+        close();
+    }
+
+    /**
+     * Create the ring.
+     *
+     * @return `false` if io_uring is not available.
+     */
+    bool
+    open(unsigned entries);
+
+    /**
+     * Register buffers for fixed reads.
+     *
+     * @return `false` if the buffers can't be registered.
+     */
+    bool
+    register_buffers(const std::vector<struct iovec> &iovecs);
+
+    /**
+     * Queue a read of a registered buffer or an iovec.
+     */
+    void
+    queue_read(
+        int fd, uint64_t offset, struct iovec *iov, int buf_index,
+        uint64_t user_data);
+
+    /**
+     * Submit queued reads and wait for at least one completion.
+     *
+     * @return `false` on errors.
+     */
+    bool
+    submit_and_wait(bool wait);
+
+    /**
+     * Take the next completion.
+     *
+     * @return `false` if there is no completion.
+     */
+    bool
+    pop_completion(uint64_t *user_data, int *result);
+
+    /**
+     * Destroy the ring.
+     */
+    void
+    close();
+
+private:
+
+    /// file descriptor of the ring.
+    int ring_fd = -1;
+
+    /// number of queued but not submitted entries.
+    unsigned to_submit = 0;
+
+    /// mapping of the submission ring.
+    void *sq_ptr = nullptr;
+    size_t sq_size = 0;
+
+    /// mapping of the completion ring.
+    void *cq_ptr = nullptr;
+    size_t cq_size = 0;
+
+    /// mapping of the submission entries.
+    struct io_uring_sqe *sqes = nullptr;
+    size_t sqes_size = 0;
+
+    /// fields of the submission ring.
+    unsigned *sq_tail = nullptr;
+    unsigned *sq_mask = nullptr;
+    unsigned *sq_array = nullptr;
+
+    /// fields of the completion ring.
+    unsigned *cq_head = nullptr;
+    unsigned *cq_tail = nullptr;
+    unsigned *cq_mask = nullptr;
+    struct io_uring_cqe *cqes = nullptr;
+};
+
+#endif // _SIMDJSON_PEVAL_HAS_URING
+
+} // namespace internal
+
+/**
+ * Source reading a list of files with reads queued ahead.
+ *
+ * The files are read in blocks into `queue_depth` padded buffers,
+ * which are registered with io_uring. While the caller evaluates the
+ * data of one block, the reads of the following blocks and files are
+ * already running. If io_uring is not available (old kernel, seccomp,
+ * `SIMDJSON_PEVAL_NO_URING`), the blocks are read by `pread()` when
+ * they are queued.
+ *
+ * The files are returned as one stream. A line break is inserted
+ * between files, if a file doesn't end with one. So a list of NDJSON
+ * files can be evaluated by `feeder::read_all()` or
+ * `eval_many_pipeline()`, which copy the data into their own buffers.
+ * `next_lines()` returns the complete lines of the blocks in place
+ * instead, which is used by `eval_files_async()`. Only regular files
+ * are supported.
+ *
+ * A file which can't be opened or read is reported as
+ * `simdjson::IO_ERROR`.
+ */
+class async_file_source {
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param paths Paths of the files to read in order.
+     * @param options Options of the source.
+     */
+    explicit async_file_source(
+        std::vector<std::string> paths,
+        const async_file_options &options = async_file_options());
+
+    async_file_source(const async_file_source &) = delete;
+    async_file_source &operator=(const async_file_source &) = delete;
+
+    /**
+     * Move constructor.
+     */
+    async_file_source(async_file_source &&other) noexcept = default;
+
+    async_file_source &operator=(async_file_source &&) = delete;
+
+    /**
+     * Destructor. Waits for running reads.
+     */
+    ~async_file_source();
+
+    /**
+     * Read next bytes.
+     *
+     * @param buffer Buffer to store the bytes.
+     * @param capacity Maximum number of bytes to read.
+     *
+     * @return Number of bytes read or `simdjson::IO_ERROR`.
+     */
+    simdjson::simdjson_result<size_t>
+    operator()(char *buffer, size_t capacity);
+
+    /**
+     * Get the next complete lines without copying them.
+     *
+     * The lines are returned in place in the buffer of a block, and
+     * the rest of the buffer is their padding. Only a line spanning
+     * two blocks is copied into a separate padded buffer. The lines of
+     * a view never span two files, the last line of a file may lack
+     * the line break. The view is valid until the next call, the block
+     * is read again only after it. Calls of `next_lines()` and
+     * `operator()` must not be mixed.
+     *
+     * @param json_ptr Set to the padded view of the lines (empty at the
+     *                 end of the last file).
+     *
+     * @return `simdjson::IO_ERROR` or `simdjson::SUCCESS`.
+     */
+    simdjson::error_code
+    next_lines(simdjson::padded_string_view *json_ptr);
+
+    /**
+     * Checks if the reads are queued by io_uring.
+     */
+    bool
+    is_async() const {
+#ifdef _SIMDJSON_PEVAL_HAS_URING
+        return (ring != nullptr);
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * Get statistics of the source.
+     */
+    const async_file_stats &
+    get_stats() const {
+        return stats;
+    }
+
+private:
+
+    /// Block of a file read into a buffer.
+    struct block {
+        /// buffer of the block.
+        padded_buffer buffer;
+
+        /// index of the file.
+        size_t file = 0;
+
+        /// offset in the file.
+        uint64_t offset = 0;
+
+        /// number of bytes to read.
+        size_t length = 0;
+
+        /// number of bytes read.
+        size_t filled = 0;
+
+        /// number of bytes returned.
+        size_t consumed = 0;
+
+        /// read is running.
+        bool in_flight = false;
+
+        /// iovec for reads into unregistered buffers.
+        struct iovec iov = {nullptr, 0};
+    };
+
+    /**
+     * Queue reads of the next blocks into free buffers.
+     */
+    bool
+    queue_reads();
+
+    /**
+     * Start the read of the rest of a block.
+     */
+    bool
+    start_read(size_t block_idx);
+
+    /**
+     * Wait for completions.
+     */
+    bool
+    wait_reads();
+
+    /**
+     * Wait until the front block is read.
+     */
+    bool
+    wait_front();
+
+    /**
+     * Release the front block and close its file after the last block.
+     */
+    void
+    release_front();
+
+    /**
+     * Append bytes to the line spanning blocks.
+     */
+    void
+    append_carry(std::string_view bytes) {
+        const auto size = carry.size();
+        carry.resize(size + bytes.size());
+        if (!bytes.empty()) {
+            std::memcpy(carry.data() + size, bytes.data(), bytes.size());
+        }
+    }
+
+    /// options of the source.
+    async_file_options options;
+
+    /// paths of all files.
+    std::vector<std::string> paths;
+
+    /// file descriptors of opened files (`-1`: closed).
+    std::vector<int> fds;
+
+    /// sizes of opened files.
+    std::vector<uint64_t> sizes;
+
+    /// ring of blocks.
+    std::vector<block> blocks;
+
+    /// index of the block to return next.
+    size_t front = 0;
+
+    /// number of blocks in use.
+    size_t used = 0;
+
+    /// index of the next file to queue.
+    size_t next_file = 0;
+
+    /// offset of the next block in the next file.
+    uint64_t next_offset = 0;
+
+    /// last byte returned of the current file.
+    char last_byte = '\n';
+
+    /// a line break must be returned before the next file.
+    bool pending_newline = false;
+
+    /// an error occurred.
+    bool failed = false;
+
+    /// line spanning blocks (`next_lines()`).
+    padded_buffer carry;
+
+    /// the front block was returned by `next_lines()`.
+    bool front_returned = false;
+
+    /// the carried line was returned by `next_lines()`.
+    bool carry_returned = false;
+
+#ifdef _SIMDJSON_PEVAL_HAS_URING
+    /// io_uring instance or `nullptr`.
+    std::unique_ptr<internal::uring> ring;
+
+    /// buffers are registered.
+    bool registered = false;
+#endif
+
+    /// statistics.
+    async_file_stats stats;
+
+}; // class async_file_source
+
+/**
+ * Evaluate NDJSON files of an asynchronous file source in place.
+ *
+ * The complete lines of each block are taken by
+ * `async_file_source::next_lines()` and evaluated like by `eval_many()`
+ * in the buffers the data was read into, while the reads of the next
+ * blocks are running. Only lines spanning two blocks are copied. The
+ * records of all blocks are collected in one batch, so `batch_fn` gets
+ * full batches besides the last one.
+ *
+ * The arguments are used like in `eval_many()`. Statistics and error
+ * paths refer to the documents of all files. A read error is added to
+ * `err` and stops the evaluation. Records must not refer to the input
+ * (e.g. by `std::string_view`), since the blocks are reused.
+ *
+ * @param parser Pointer to the parser to use.
+ * @param source Pointer to the source of the files.
+ * @param temp_record_ptr Pointer to a temporary space to store a record.
+ * @param doc_fn Function to evaluate a single document and store it
+ *               into `*temp_record_ptr`.
+ * @param batch_fn Function called with batches of records.
+ * @param err Pointer to error container to store errors.
+ * @param options Options of evaluation.
+ *
+ * @return Statistics of the evaluation.
+ */
+template<
+    typename Record,
+    typename DocFn,
+    typename BatchFn>
+inline eval_many_stats
+eval_files_async(
+    simdjson::ondemand::parser *parser,
+    async_file_source *source,
+    Record *temp_record_ptr,
+    DocFn doc_fn,
+    BatchFn batch_fn,
+    error *err,
+    const eval_many_options &options = eval_many_options())
+{
+#ifdef __cpp_concepts
+    static_assert(
+        batch_sink<BatchFn, Record>,
+        "batch_fn must be callable with (record_batch<Record>*, error*)");
+#endif
+
+    _SIMDJSON_PEVAL_TRACE_SET_NAME(
+        "eval_files_async(parser*,async_file_source*,Record*,DocFn,BatchFn,"
+        "error*)");
+    _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+    _SIMDJSON_PEVAL_ASSERT(parser != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(source != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(temp_record_ptr != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+
+    eval_many_stats stats;
+    stats.batch_size = options.batch_size;
+
+    record_batch<Record> batch(options.records_per_batch);
+    internal::batch_tuning tuning(options);
+    auto part_options = options;
+
+    for (;;) {
+        simdjson::padded_string_view json;
+        const auto code_read = source->next_lines(&json);
+        if (code_read) {
+            _SIMDJSON_PEVAL_TRACE_ERROR(code_read);
+            err->add(code_read);
+            break;
+        }
+
+        if (json.size() == 0) {
+            break;
+        }
+
+        part_options.skip_documents =
+            options.skip_documents
+            - std::min(options.skip_documents, stats.skipped_documents);
+        part_options.first_index =
+            options.first_index + stats.skipped_documents + stats.documents
+            + stats.prefiltered_documents;
+
+        const auto part_stats =
+            internal::eval_many_batch(
+                parser, json, temp_record_ptr, doc_fn, batch_fn, err,
+                part_options, &batch, &tuning);
+
+        stats.documents += part_stats.documents;
+        stats.skipped_documents += part_stats.skipped_documents;
+        stats.records += part_stats.records;
+        stats.failed_documents += part_stats.failed_documents;
+        stats.rejected_documents += part_stats.rejected_documents;
+        stats.prefiltered_documents += part_stats.prefiltered_documents;
+        stats.truncated_bytes += part_stats.truncated_bytes;
+        stats.batch_size = part_stats.batch_size;
+        stats.batch_size_changes += part_stats.batch_size_changes;
+
+        if ((options.stop_on_error && part_stats.failed_documents != 0)
+            || err->is_stopped())
+        {
+            break;
+        }
+    }
+
+    if (!batch.empty()) {
+        stats.records += batch.size();
+        batch_fn(&batch, err);
+        batch.clear();
+    }
+
+    _SIMDJSON_PEVAL_TRACE_EVAL_END();
+    return stats;
+}
+
+/// @}
+
+///
+/// @name Padded input without copies.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
+
+/**
+ * Read-only file mapped into memory with padding.
+ *
+ * The file is mapped over an anonymous mapping, which is
+ * `simdjson::SIMDJSON_PADDING` bytes larger than the file. So the
+ * padding is readable without copying the file or its last page.
+ * Files which can't be mapped (e.g. pipes) are read into a padded
+ * buffer instead.
+ *
+ * The file must not be truncated while it is mapped.
+ */
+class mapped_file {
+public:
+
+    /**
+     * Constructor of an empty file.
+     */
+    mapped_file() = default;
+
+    mapped_file(const mapped_file &) = delete;
+    mapped_file &operator=(const mapped_file &) = delete;
+
+    /**
+     * Move constructor.
+     */
+    mapped_file(mapped_file &&other) noexcept {
+        *this = std::move(other);
+    }
+
+    /**
+     * Move assignment.
+     */
+    mapped_file &
+    operator=(mapped_file &&other) noexcept {
+        if (this != &other) {
+            close();
+            std::swap(mapping, other.mapping);
+            std::swap(mapping_size, other.mapping_size);
+            std::swap(file_size, other.file_size);
+            std::swap(buffer, other.buffer);
+        }
+
+        return *this;
+    }
+
+    /**
+     * Destructor.
+     */
+    ~mapped_file() {
+        close();
+    }
+
+    /**
+     * Map a file into memory.
+     *
+     * @param path Path of the file.
+     *
+     * @return `simdjson::IO_ERROR` if the file can't be read,
+     *         otherwise `simdjson::SUCCESS`.
+     */
+    simdjson::error_code
+    open(const std::string &path);
+
+    /**
+     * Unmap the file.
+     */
+    void
+    close();
+
+    /**
+     * Get padded view of the content of the file.
+     */
+    simdjson::padded_string_view
+    view() const {
+        if (mapping) {
+            return
+                simdjson::padded_string_view(
+                    static_cast<const char *>(mapping), file_size,
+                    mapping_size);
+        }
+
+        return buffer.view();
+    }
+
+    /**
+     * Get size of the file.
+     */
+    size_t
+    size() const {
+        return (mapping ? file_size : buffer.size());
+    }
+
+    /**
+     * Checks if the file is mapped (not read into a buffer).
+     */
+    bool
+    is_mapped() const {
+        return (mapping != nullptr);
+    }
+
+private:
+
+    /// start of mapping or `nullptr`.
+    void *mapping = nullptr;
+
+    /// size of mapping including padding.
+    size_t mapping_size = 0;
+
+    /// size of mapped file.
+    size_t file_size = 0;
+
+    /// content of files which can't be mapped.
+    padded_buffer buffer;
+
+}; // class mapped_file
+
+/**
+ * Create padded view of a string without copying it.
+ *
+ * If the capacity of the string is too small for the padding, the
+ * capacity is enlarged, which copies the string once. The size of the
+ * string is not changed.
+ *
+ * The view is invalid after the string is modified.
+ *
+ * @param str Pointer to the string.
+ *
+ * @return Padded view of the string.
+ */
+inline simdjson::padded_string_view
+padded_view(std::string *str) {
+    _SIMDJSON_PEVAL_ASSERT(str != nullptr);
+
+    if (str->capacity() - str->size() < simdjson::SIMDJSON_PADDING) {
+        str->reserve(str->size() + simdjson::SIMDJSON_PADDING);
+    }
+
+    return
+        simdjson::padded_string_view(
+            str->data(), str->size(), str->capacity());
+}
+
+/**
+ * Create padded view of a character vector without copying it.
+ *
+ * If the capacity of the vector is too small for the padding, the
+ * capacity is enlarged, which copies the data once. The size of the
+ * vector is not changed.
+ *
+ * The view is invalid after the vector is modified.
+ *
+ * @param vec Pointer to the vector.
+ *
+ * @return Padded view of the vector.
+ */
+inline simdjson::padded_string_view
+padded_view(std::vector<char> *vec) {
+    _SIMDJSON_PEVAL_ASSERT(vec != nullptr);
+
+    if (vec->capacity() - vec->size() < simdjson::SIMDJSON_PADDING) {
+        vec->reserve(vec->size() + simdjson::SIMDJSON_PADDING);
+    }
+
+    return
+        simdjson::padded_string_view(
+            vec->data(), vec->size(), vec->capacity());
+}
+
+/**
+ * Read a whole file into a padded buffer.
+ *
+ * Like `simdjson::padded_string::load()`, but the memory of the buffer
+ * is reused and may be backed by transparent huge pages (see
+ * `padded_buffer`).
+ *
+ * @param path Path of the file.
+ * @param buffer_ptr Pointer to the buffer to store the content.
+ *
+ * @return `simdjson::IO_ERROR` if the file can't be read,
+ *         otherwise `simdjson::SUCCESS`.
+ */
+inline simdjson::error_code
+load_file(const std::string &path, padded_buffer *buffer_ptr);
+
+/// @}
+
+///
+/// @name Evaluate huge arrays from a stream.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
+
+/**
+ * Options to evaluate the elements of an array read from a stream.
+ */
+struct eval_array_stream_options {
+    /// Size of the window to read the stream. The window is enlarged,
+    /// if a single element doesn't fit into it.
+    size_t window_size = size_t(1) << 20;
+
+    /// Maximum number of records passed to the batch function at once.
+    size_t records_per_batch = 1024;
+
+    /// Stop evaluation at the first element with errors.
+    bool stop_on_error = false;
+};
+
+/**
+ * Statistics of the evaluation of an array read from a stream.
+ */
+struct eval_array_stream_stats {
+    /// Number of array elements evaluated.
+    size_t elements = 0;
+
+    /// Number of records passed to the batch function.
+    size_t records = 0;
+
+    /// Number of elements with errors.
+    size_t failed_elements = 0;
+
+    /// Number of elements rejected by `where()`.
+    size_t rejected_elements = 0;
+
+    /// Number of times the window was evaluated.
+    size_t windows = 0;
+
+    /// Final size of the window.
+    size_t window_size = 0;
+};
+
+/**
+ * Evaluate the elements of a huge top-level array read from a stream.
+ *
+ * The stream is read into a window of fixed size. The complete
+ * elements of the window are evaluated as an array and the bytes of an
+ * incomplete element are moved to the beginning of the window before
+ * it is refilled. So the memory used is about the window size (or the
+ * size of the largest element) no matter how large the stream is.
+ *
+ * Each element is evaluated by `value_fn`, which has to store the
+ * result into `*temp_record_ptr`. If no error occurred, the record is
+ * moved into a batch. Full batches and the last batch are passed to
+ * `batch_fn` like by `eval_many()`. Errors are reported with the
+ * index of the element in the whole array as first path level.
+ *
+ * Records must not refer to the window (e.g. by `std::string_view`),
+ * since it is overwritten by the next bytes of the stream.
+ *
+ * @param parser Pointer to the parser to use.
+ * @param read_fn Source to read the stream (see `fd_source`).
+ * @param temp_record_ptr Pointer to a temporary space to store a record.
+ * @param value_fn Function to evaluate a single array element and store
+ *                 it into `*temp_record_ptr`.
+ * @param batch_fn Function called with batches of records.
+ * @param err Pointer to error container to store errors.
+ * @param options Options of evaluation.
+ *
+ * @return Statistics of the evaluation.
+ */
+template<
+    typename ReadFn,
+    typename Record,
+    typename ValueFn,
+    typename BatchFn>
+inline eval_array_stream_stats
+eval_array_stream(
+    simdjson::ondemand::parser *parser,
+    ReadFn read_fn,
+    Record *temp_record_ptr,
+    ValueFn value_fn,
+    BatchFn batch_fn,
+    error *err,
+    const eval_array_stream_options &options = eval_array_stream_options())
+{
+#ifdef __cpp_concepts
+    static_assert(
+        batch_sink<BatchFn, Record>,
+        "batch_fn must be callable with (record_batch<Record>*, error*)");
+#endif
+
+    _SIMDJSON_PEVAL_TRACE_SET_NAME(
+        "eval_array_stream(parser*,ReadFn,Record*,ValueFn,BatchFn,error*)");
+    _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+    _SIMDJSON_PEVAL_ASSERT(parser != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(temp_record_ptr != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+
+    eval_array_stream_stats stats;
+    record_batch<Record> batch(options.records_per_batch);
+
+    // The first byte of the window is reserved for the opening
+    // bracket of the elements evaluated.
+    padded_buffer window(std::max(options.window_size, size_t(2)) + 1);
+    window.resize(1);
+
+    internal::array_scanner scanner;
+    size_t elements_begin = 0;   // offset of first element (0: no array)
+    size_t elements_end = 0;     // offset of separator behind last element
+    size_t window_elements = 0;  // complete elements in window
+    bool stop = false;
+    simdjson::error_code code_stream = simdjson::SUCCESS;
+
+    // evaluate all complete elements of the window.
+    auto eval_window =
+        [&]() {
+            ++stats.windows;
+
+            // replace separator behind last element by a closing bracket.
+            window.data()[elements_begin - 1] = '[';
+            window.data()[elements_end] = ']';
+
+            auto sj_doc =
+                parser->iterate(
+                    window.data() + elements_begin - 1,
+                    elements_end - elements_begin + 2,
+                    window.get_capacity() + simdjson::SIMDJSON_PADDING
+                    - (elements_begin - 1));
+            auto sj_array = sj_doc.get_array();
+            if (sj_array.error()) {
+                _SIMDJSON_PEVAL_TRACE_ERROR(sj_array.error());
+                err->add(sj_array.error());
+                stop = true;
+                return;
+            }
+
+            for (auto sj_value : sj_array.value_unsafe()) {
+                error::path_scope idx_scope(err, stats.elements);
+                if (err->exceeds_array_limit(stats.elements)) {
+                    stop = true;
+                    break;
+                }
+                err->reset_usage();
+                if (err->is_stopped()) {
+                    stop = true;
+                    break;
+                }
+                ++stats.elements;
+
+                error::record_scope record(err);
+                const auto num_errors = err->get_count();
+                value_fn(sj_value, err);
+
+                const auto is_rejected = err->is_rejected();
+                err->set_rejected(false);
+
+                if (err->get_count() != num_errors) {
+                    ++stats.failed_elements;
+                    if (options.stop_on_error) {
+                        stop = true;
+                        break;
+                    }
+                }
+                else if (is_rejected) {
+                    ++stats.rejected_elements;
+                }
+                else {
+                    record.commit();
+                    batch.push(temp_record_ptr);
+                    if (batch.full()) {
+                        stats.records += batch.size();
+                        batch_fn(&batch, err);
+                        batch.clear();
+                    }
+                }
+            }
+        };
+
+    bool eof = false;
+    while (!stop && !eof && !scanner.is_finished()) {
+        if (window.size() == window.get_capacity()) {
+            // element larger than window: enlarge window.
+            window.reserve(window.get_capacity() * 2);
+        }
+
+        const auto size = window.size();
+        auto sj_size =
+            read_fn(window.data() + size, window.get_capacity() - size);
+        if (sj_size.error()) {
+            code_stream = sj_size.error();
+            break;
+        }
+
+        const auto read_size = sj_size.value_unsafe();
+        if (read_size == 0) {
+            eof = true;
+        }
+        window.resize(size + read_size);
+
+        code_stream =
+            scanner.scan(
+                std::string_view(window.data() + size, read_size),
+                [&](size_t pos, bool after_element) {
+                    pos += size;
+                    if (elements_begin == 0) {
+                        elements_begin = pos + 1;
+                    }
+                    else if (after_element) {
+                        elements_end = pos;
+                        ++window_elements;
+                    }
+                });
+        if (code_stream) {
+            break;
+        }
+
+        if (window_elements != 0
+            && (eof
+                || scanner.is_finished()
+                || window.size() == window.get_capacity()))
+        {
+            eval_window();
+
+            // move incomplete element to the beginning of the window.
+            const auto rest_begin = elements_end + 1;
+            const auto rest_size = window.size() - rest_begin;
+            std::memmove(window.data() + 1, window.data() + rest_begin,
+                         rest_size);
+            window.resize(1 + rest_size);
+            elements_begin = 1;
+            elements_end = 0;
+            window_elements = 0;
+        }
+    }
+
+    if (!batch.empty()) {
+        stats.records += batch.size();
+        batch_fn(&batch, err);
+        batch.clear();
+    }
+
+    if (code_stream) {
+        _SIMDJSON_PEVAL_TRACE_ERROR(code_stream);
+        err->add(code_stream);
+    }
+    else if (!stop && !scanner.is_finished()) {
+        const auto code = simdjson::INCOMPLETE_ARRAY_OR_OBJECT;
+        _SIMDJSON_PEVAL_TRACE_ERROR(code);
+        err->add(code);
+    }
+
+    stats.window_size = window.get_capacity() - 1;
+
+    _SIMDJSON_PEVAL_TRACE_EVAL_END();
+    return stats;
+}
+
+/// @}
+
+
+
+#ifdef SIMDJSON_PEVAL_WITH_ZLIB
+
+// inline implementations of class gzip_source
+// //////////////////////////////////////////////////////////////////////
+
+template<typename ReadFn>
+inline
+gzip_source<ReadFn>::gzip_source(ReadFn read_fn, size_t input_size)
+    : read_fn(std::move(read_fn))
+    , stream(new z_stream())
+    , input(new char[std::max(input_size, size_t(1))])
+    , input_size(std::max(input_size, size_t(1)))
+{
+    // 15 + 32: maximum window size and automatic gzip/zlib detection.
+    if (inflateInit2(stream.get(), 15 + 32) != Z_OK) {
+        delete stream.release();
+    }
+}
+
+template<typename ReadFn>
+inline simdjson::simdjson_result<size_t>
+gzip_source<ReadFn>::operator()(char *buffer, size_t capacity) {
+    if (!stream) {
+        return simdjson::MEMALLOC;
+    }
+
+    const auto out_size = uInt(std::min(capacity, size_t(UINT_MAX)));
+    stream->next_out = reinterpret_cast<Bytef *>(buffer);
+    stream->avail_out = out_size;
+
+    while (stream->avail_out == out_size && out_size != 0) {
+        if (stream->avail_in == 0) {
+            if (input_eof) {
+                // truncated member is an error.
+                if (in_member) {
+                    return simdjson::IO_ERROR;
+                }
+                break;
+            }
+
+            auto sj_size = read_fn(input.get(), input_size);
+            if (sj_size.error()) {
+                return sj_size.error();
+            }
+
+            input_eof = (sj_size.value_unsafe() == 0);
+            stream->next_in = reinterpret_cast<Bytef *>(input.get());
+            stream->avail_in = uInt(sj_size.value_unsafe());
+            continue;
+        }
+
+        const auto code = inflate(stream.get(), Z_NO_FLUSH);
+        if (code == Z_STREAM_END) {
+            // next gzip member may follow.
+            in_member = false;
+            if (inflateReset(stream.get()) != Z_OK) {
+                return simdjson::IO_ERROR;
+            }
+        }
+        else if (code == Z_OK || code == Z_BUF_ERROR) {
+            in_member = true;
+        }
+        else {
+            return simdjson::IO_ERROR;
+        }
+    }
+
+    return size_t(out_size - stream->avail_out);
+}
+
+#endif // SIMDJSON_PEVAL_WITH_ZLIB
+
+#ifdef SIMDJSON_PEVAL_WITH_ZSTD
+
+// inline implementations of class zstd_source
+// //////////////////////////////////////////////////////////////////////
+
+template<typename ReadFn>
+inline
+zstd_source<ReadFn>::zstd_source(ReadFn read_fn, size_t input_size)
+    : read_fn(std::move(read_fn))
+    , stream(ZSTD_createDStream())
+    , input(new char[std::max(input_size, size_t(1))])
+    , input_size(std::max(input_size, size_t(1)))
+{
+    if (stream && ZSTD_isError(ZSTD_initDStream(stream.get()))) {
+        stream.reset();
+    }
+}
+
+template<typename ReadFn>
+inline simdjson::simdjson_result<size_t>
+zstd_source<ReadFn>::operator()(char *buffer, size_t capacity) {
+    if (!stream) {
+        return simdjson::MEMALLOC;
+    }
+
+    ZSTD_outBuffer out_buffer = {buffer, capacity, 0};
+
+    while (out_buffer.pos == 0 && capacity != 0) {
+        if (in_buffer.pos == in_buffer.size) {
+            if (input_eof) {
+                // truncated frame is an error.
+                if (in_frame) {
+                    return simdjson::IO_ERROR;
+                }
+                break;
+            }
+
+            auto sj_size = read_fn(input.get(), input_size);
+            if (sj_size.error()) {
+                return sj_size.error();
+            }
+
+            input_eof = (sj_size.value_unsafe() == 0);
+            in_buffer = {input.get(), sj_size.value_unsafe(), 0};
+            continue;
+        }
+
+        const auto result =
+            ZSTD_decompressStream(stream.get(), &out_buffer, &in_buffer);
+        if (ZSTD_isError(result)) {
+            return simdjson::IO_ERROR;
+        }
+
+        // 0: frame completed, next frame may follow.
+        in_frame = (result != 0);
+    }
+
+    return size_t(out_buffer.pos);
+}
+
+#endif // SIMDJSON_PEVAL_WITH_ZSTD
+
+#ifdef _SIMDJSON_PEVAL_HAS_URING
+
+// inline implementations of class internal::uring
+// //////////////////////////////////////////////////////////////////////
+
+inline bool
+internal::uring::open(unsigned entries) {
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+
+    const auto fd = int(::syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0) {
+        return false;
+    }
+    ring_fd = fd;
+
+    sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size =
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP);
+    if (single_mmap) {
+        sq_size = cq_size = std::max(sq_size, cq_size);
+    }
+
+    sq_ptr =
+        ::mmap(nullptr, sq_size, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    if (sq_ptr == MAP_FAILED) {
+        sq_ptr = nullptr;
+        close();
+        return false;
+    }
+
+    if (single_mmap) {
+        cq_ptr = sq_ptr;
+    }
+    else {
+        cq_ptr =
+            ::mmap(nullptr, cq_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        if (cq_ptr == MAP_FAILED) {
+            cq_ptr = nullptr;
+            close();
+            return false;
+        }
+    }
+
+    sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes_ptr =
+        ::mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    if (sqes_ptr == MAP_FAILED) {
+        close();
+        return false;
+    }
+    sqes = static_cast<struct io_uring_sqe *>(sqes_ptr);
+
+    auto *sq_base = static_cast<char *>(sq_ptr);
+    sq_tail = reinterpret_cast<unsigned *>(sq_base + params.sq_off.tail);
+    sq_mask = reinterpret_cast<unsigned *>(sq_base + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned *>(sq_base + params.sq_off.array);
+
+    auto *cq_base = static_cast<char *>(cq_ptr);
+    cq_head = reinterpret_cast<unsigned *>(cq_base + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned *>(cq_base + params.cq_off.tail);
+    cq_mask = reinterpret_cast<unsigned *>(cq_base + params.cq_off.ring_mask);
+    cqes =
+        reinterpret_cast<struct io_uring_cqe *>(cq_base + params.cq_off.cqes);
+
+    return true;
+}
+
+inline bool
+internal::uring::register_buffers(const std::vector<struct iovec> &iovecs) {
+    return
+        (::syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_BUFFERS,
+                   iovecs.data(), unsigned(iovecs.size())) == 0);
+}
+
+inline void
+internal::uring::queue_read(
+    int fd, uint64_t offset, struct iovec *iov, int buf_index,
+    uint64_t user_data)
+{
+    const auto tail = *sq_tail;
+    const auto idx = tail & *sq_mask;
+
+    auto *sqe = &sqes[idx];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->fd = fd;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+    if (buf_index >= 0) {
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->addr = uint64_t(uintptr_t(iov->iov_base));
+        sqe->len = unsigned(iov->iov_len);
+        sqe->buf_index = uint16_t(buf_index);
+    }
+    else {
+        sqe->opcode = IORING_OP_READV;
+        sqe->addr = uint64_t(uintptr_t(iov));
+        sqe->len = 1;
+    }
+
+    sq_array[idx] = idx;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ++to_submit;
+}
+
+inline bool
+internal::uring::submit_and_wait(bool wait) {
+    for (;;) {
+        const auto result =
+            ::syscall(__NR_io_uring_enter, ring_fd, to_submit,
+                      (wait ? 1 : 0), (wait ? IORING_ENTER_GETEVENTS : 0),
+                      nullptr, 0);
+        if (result >= 0) {
+            to_submit -= unsigned(result);
+            return true;
+        }
+
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+inline bool
+internal::uring::pop_completion(uint64_t *user_data, int *result) {
+    const auto head = *cq_head;
+    if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+
+    const auto *cqe = &cqes[head & *cq_mask];
+    *user_data = cqe->user_data;
+    *result = cqe->res;
+    __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+inline void
+internal::uring::close() {
+    if (sqes) {
+        ::munmap(sqes, sqes_size);
+        sqes = nullptr;
+    }
+    if (cq_ptr && cq_ptr != sq_ptr) {
+        ::munmap(cq_ptr, cq_size);
+    }
+    cq_ptr = nullptr;
+    if (sq_ptr) {
+        ::munmap(sq_ptr, sq_size);
+        sq_ptr = nullptr;
+    }
+    if (ring_fd >= 0) {
+        ::close(ring_fd);
+        ring_fd = -1;
+    }
+}
+
+#endif // _SIMDJSON_PEVAL_HAS_URING
+
+
+// inline implementations of class async_file_source
+// //////////////////////////////////////////////////////////////////////
+
+inline
+async_file_source::async_file_source(
+    std::vector<std::string> paths,
+    const async_file_options &options)
+    : options(options)
+    , paths(std::move(paths))
+    , fds(this->paths.size(), -1)
+    , sizes(this->paths.size(), 0)
+    , blocks(std::max(options.queue_depth, size_t(1)))
+{
+    this->options.block_size = std::max(options.block_size, size_t(1));
+    for (auto &block : blocks) {
+        block.buffer.reserve(this->options.block_size);
+    }
+
+#ifdef _SIMDJSON_PEVAL_HAS_URING
+    if (options.use_uring) {
+        ring = std::make_unique<internal::uring>();
+        if (!ring->open(unsigned(blocks.size()))) {
+            ring.reset();
+        }
+        else {
+            std::vector<struct iovec> iovecs;
+            for (auto &block : blocks) {
+                iovecs.push_back({block.buffer.data(), this->options.block_size});
+            }
+            registered = ring->register_buffers(iovecs);
+        }
+    }
+#endif
+}
+
+inline
+async_file_source::~async_file_source() {
+#ifdef _SIMDJSON_PEVAL_HAS_URING
+    // the kernel must not write into released buffers.
+    if (ring) {
+        while (std::any_of(
+                   blocks.begin(), blocks.end(),
+                   [](const block &blk) { return blk.in_flight; }))
+        {
+            if (!wait_reads()) {
+                break;
+            }
+        }
+    }
+#endif
+
+    for (auto fd : fds) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+}
+
+inline bool
+async_file_source::start_read(size_t block_idx) {
+    auto &blk = blocks[block_idx];
+    ++stats.reads;
+
+#ifdef _SIMDJSON_PEVAL_HAS_URING
+    if (ring) {
+        blk.iov = {blk.buffer.data() + blk.filled, blk.length - blk.filled};
+        ring->queue_read(
+            fds[blk.file], blk.offset + blk.filled, &blk.iov,
+            (registered ? int(block_idx) : -1), block_idx);
+        blk.in_flight = true;
+        return ring->submit_and_wait(false);
+    }
+#endif
+
+    while (blk.filled < blk.length) {
+        const auto result =
+            ::pread(fds[blk.file], blk.buffer.data() + blk.filled,
+                    blk.length - blk.filled, off_t(blk.offset + blk.filled));
+        if (result <= 0) {
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        blk.filled += size_t(result);
+    }
+
+    return true;
+}
+
+inline bool
+async_file_source::queue_reads() {
+    while (used < blocks.size() && next_file < paths.size()) {
+        if (fds[next_file] < 0) {
+            const auto fd =
+                ::open(paths[next_file].c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                return false;
+            }
+            fds[next_file] = fd;
+
+            struct stat file_stat;
+            if (::fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+                return false;
+            }
+            sizes[next_file] = uint64_t(file_stat.st_size);
+            ++stats.files;
+        }
+
+        const auto block_idx = (front + used) % blocks.size();
+        auto &blk = blocks[block_idx];
+        blk.file = next_file;
+        blk.offset = next_offset;
+        blk.length =
+            size_t(std::min(uint64_t(options.block_size),
+                            sizes[next_file] - next_offset));
+        blk.filled = 0;
+        blk.consumed = 0;
+        ++used;
+
+        next_offset += blk.length;
+        if (next_offset >= sizes[next_file]) {
+            ++next_file;
+            next_offset = 0;
+        }
+
+        if (blk.length != 0 && !start_read(block_idx)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+inline bool
+async_file_source::wait_reads() {
+#ifdef _SIMDJSON_PEVAL_HAS_URING
+    if (!ring->submit_and_wait(true)) {
+        return false;
+    }
+
+    uint64_t block_idx;
+    int result;
+    bool success = true;
+    while (ring->pop_completion(&block_idx, &result)) {
+        auto &blk = blocks[block_idx];
+        blk.in_flight = false;
+        if (result <= 0) {
+            // error or file truncated while reading.
+            success = false;
+            continue;
+        }
+
+        blk.filled += size_t(result);
+        if (blk.filled < blk.length && !start_read(block_idx)) {
+            success = false;
+        }
+    }
+
+    return success;
+#else
+    return false;
+#endif
+}
+
+inline bool
+async_file_source::wait_front() {
+    while (blocks[front].filled < blocks[front].length) {
+        ++stats.waits;
+        if (!wait_reads()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+inline void
+async_file_source::release_front() {
+    auto &blk = blocks[front];
+    front = (front + 1) % blocks.size();
+    --used;
+
+    if (blk.offset + blk.length == sizes[blk.file]) {
+        ::close(fds[blk.file]);
+        fds[blk.file] = -1;
+    }
+}
+
+inline simdjson::error_code
+async_file_source::next_lines(simdjson::padded_string_view *json_ptr) {
+    _SIMDJSON_PEVAL_ASSERT(json_ptr != nullptr);
+
+    *json_ptr = simdjson::padded_string_view();
+
+    // the views of the last call are no longer used.
+    if (front_returned) {
+        front_returned = false;
+        release_front();
+    }
+    if (carry_returned) {
+        carry_returned = false;
+        carry.clear();
+    }
+
+    for (;;) {
+        if (failed || !queue_reads()) {
+            failed = true;
+            return simdjson::IO_ERROR;
+        }
+
+        if (used == 0) {
+            return simdjson::SUCCESS;
+        }
+
+        if (!wait_front()) {
+            failed = true;
+            return simdjson::IO_ERROR;
+        }
+
+        auto &blk = blocks[front];
+        const auto is_last = (blk.offset + blk.length == sizes[blk.file]);
+        const auto rest =
+            std::string_view(blk.buffer.data() + blk.consumed,
+                             blk.length - blk.consumed);
+
+        if (carry.size() != 0) {
+            // complete the line spanning blocks.
+            const auto pos = rest.find('\n');
+            if (pos == std::string_view::npos && !is_last) {
+                append_carry(rest);
+                release_front();
+                continue;
+            }
+
+            const auto size = (pos != std::string_view::npos
+                               ? pos + 1
+                               : rest.size());
+            append_carry(rest.substr(0, size));
+            blk.consumed += size;
+            if (blk.consumed == blk.length) {
+                release_front();
+            }
+
+            stats.bytes += carry.size();
+            carry_returned = true;
+            *json_ptr = carry.view();
+            return simdjson::SUCCESS;
+        }
+
+        // the last block of a file ends with a complete line.
+        const auto pos = rest.rfind('\n');
+        const auto size = (is_last
+                           ? rest.size()
+                           : (pos != std::string_view::npos ? pos + 1 : 0));
+        if (size == 0) {
+            append_carry(rest);
+            release_front();
+            continue;
+        }
+
+        // the incomplete line is carried to the next block.
+        append_carry(rest.substr(size));
+
+        stats.bytes += size;
+        front_returned = true;
+        *json_ptr =
+            simdjson::padded_string_view(
+                rest.data(), size,
+                blk.buffer.get_capacity() + simdjson::SIMDJSON_PADDING
+                - blk.consumed);
+        return simdjson::SUCCESS;
+    }
+}
+
+inline simdjson::simdjson_result<size_t>
+async_file_source::operator()(char *buffer, size_t capacity) {
+    if (capacity == 0) {
+        return size_t(0);
+    }
+
+    for (;;) {
+        if (pending_newline) {
+            // separate files by a line break.
+            pending_newline = false;
+            buffer[0] = '\n';
+            last_byte = '\n';
+            return size_t(1);
+        }
+
+        if (failed || !queue_reads()) {
+            failed = true;
+            return simdjson::IO_ERROR;
+        }
+
+        if (used == 0) {
+            return size_t(0);
+        }
+
+        auto &blk = blocks[front];
+        if (blk.filled < blk.length) {
+            ++stats.waits;
+            if (!wait_reads()) {
+                failed = true;
+                return simdjson::IO_ERROR;
+            }
+            continue;
+        }
+
+        const auto size = std::min(capacity, blk.length - blk.consumed);
+        std::memcpy(buffer, blk.buffer.data() + blk.consumed, size);
+        blk.consumed += size;
+        stats.bytes += size;
+        if (size != 0) {
+            last_byte = buffer[size - 1];
+        }
+
+        if (blk.consumed == blk.length) {
+            const auto file = blk.file;
+            front = (front + 1) % blocks.size();
+            --used;
+
+            if (blk.offset + blk.length == sizes[file]) {
+                ::close(fds[file]);
+                fds[file] = -1;
+                pending_newline = (last_byte != '\n');
+            }
+        }
+
+        if (size != 0) {
+            return size_t(size);
+        }
+    }
+}
+
+// inline implementations of padded input
+// //////////////////////////////////////////////////////////////////////
+
+inline simdjson::error_code
+load_file(const std::string &path, padded_buffer *buffer_ptr) {
+    _SIMDJSON_PEVAL_ASSERT(buffer_ptr != nullptr);
+
+    buffer_ptr->clear();
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return simdjson::IO_ERROR;
+    }
+
+    // one additional byte to detect the end without enlarging.
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) == 0 && S_ISREG(file_stat.st_mode)) {
+        buffer_ptr->reserve(size_t(file_stat.st_size) + 1);
+    }
+
+    fd_source source(fd);
+    for (;;) {
+        const auto size = buffer_ptr->size();
+        if (size == buffer_ptr->get_capacity()) {
+            buffer_ptr->reserve(std::max(size * 2, size_t(1) << 16));
+        }
+        buffer_ptr->resize(buffer_ptr->get_capacity());
+
+        auto sj_size =
+            source(buffer_ptr->data() + size, buffer_ptr->size() - size);
+        if (sj_size.error()) {
+            buffer_ptr->clear();
+            ::close(fd);
+            return sj_size.error();
+        }
+
+        buffer_ptr->resize(size + sj_size.value_unsafe());
+        if (sj_size.value_unsafe() == 0) {
+            break;
+        }
+    }
+
+    ::close(fd);
+    return simdjson::SUCCESS;
+}
+
+
+// inline implementations of class mapped_file
+// //////////////////////////////////////////////////////////////////////
+
+inline simdjson::error_code
+mapped_file::open(const std::string &path) {
+    close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return simdjson::IO_ERROR;
+    }
+
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) == 0
+        && S_ISREG(file_stat.st_mode)
+        && file_stat.st_size > 0)
+    {
+        const auto page_size = size_t(::sysconf(_SC_PAGESIZE));
+        file_size = size_t(file_stat.st_size);
+        mapping_size =
+            (file_size + simdjson::SIMDJSON_PADDING + page_size - 1)
+            / page_size * page_size;
+
+        // reserve memory with padding, then map the file over it.
+        void *reserved =
+            ::mmap(nullptr, mapping_size, PROT_READ,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (reserved != MAP_FAILED) {
+            void *mapped =
+                ::mmap(reserved, file_size, PROT_READ,
+                       MAP_PRIVATE | MAP_FIXED, fd, 0);
+            if (mapped != MAP_FAILED) {
+                ::madvise(mapped, file_size, MADV_SEQUENTIAL);
+                mapping = mapped;
+                ::close(fd);
+                return simdjson::SUCCESS;
+            }
+
+            ::munmap(reserved, mapping_size);
+        }
+
+        mapping_size = 0;
+        file_size = 0;
+    }
+
+    // fallback: read file into buffer.
+    fd_source source(fd);
+    buffer.clear();
+    for (;;) {
+        const auto size = buffer.size();
+        buffer.resize(size + (size_t(1) << 16));
+
+        auto sj_size = source(buffer.data() + size, buffer.size() - size);
+        if (sj_size.error()) {
+            buffer.clear();
+            ::close(fd);
+            return sj_size.error();
+        }
+
+        buffer.resize(size + sj_size.value_unsafe());
+        if (sj_size.value_unsafe() == 0) {
+            break;
+        }
+    }
+
+    ::close(fd);
+    return simdjson::SUCCESS;
+}
+
+inline void
+mapped_file::close() {
+    if (mapping) {
+        ::munmap(mapping, mapping_size);
+        mapping = nullptr;
+        mapping_size = 0;
+        file_size = 0;
+    }
+
+    buffer.clear();
+}
+
+} // namespace simdjson_peval
+
+
+#endif /* SIMDJSON_PEVAL_IO_H */
@@ -0,0 +1,1121 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef SIMDJSON_PEVAL_NDJSON_H
+#define SIMDJSON_PEVAL_NDJSON_H 1
+
+#include "simdjson_peval.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace simdjson_peval {
+
+///
+/// @name Evaluate streams of JSON documents (NDJSON).
+//  /////////////////////////////////////////////////////////////////////
+/// @{
+
+/**
+ * Options to evaluate a stream of documents.
+ */
+struct eval_many_options {
+    /// Initial batch size of `iterate_many()`.
+    size_t batch_size = simdjson::ondemand::DEFAULT_BATCH_SIZE;
+
+    /// The batch size is doubled up to this size, if a document
+    /// doesn't fit into a batch.
+    size_t max_batch_size = simdjson::SIMDJSON_MAXSIZE_BYTES;
+
+    /// Maximum number of records passed to the batch function at once.
+    size_t records_per_batch = 1024;
+
+    /// Number of documents to skip at the beginning of the stream
+    /// (e.g. a header line).
+    size_t skip_documents = 0;
+
+    /// Index of the first document used for error paths.
+    size_t first_index = 0;
+
+    /// Stop evaluation at the first document with errors.
+    bool stop_on_error = false;
+
+    /// Report an incomplete document at the end of the stream as
+    /// error. Otherwise it is only counted by `truncated_bytes`.
+    bool truncated_is_error = false;
+
+    /// Adjust the batch size while evaluating to maximize throughput.
+    bool auto_batch_size = false;
+
+    /// Minimum batch size chosen by `auto_batch_size`.
+    size_t min_auto_batch_size = size_t(1) << 14;
+
+    /// Maximum batch size chosen by `auto_batch_size`.
+    size_t max_auto_batch_size = size_t(1) << 24;
+
+    /// Back large buffers holding copies of the input (e.g. of
+    /// `feeder` and `eval_many_pipeline()`) by transparent huge pages.
+    bool huge_pages = false;
+
+    /// Prefilter: only lines containing all these literals are parsed.
+    /// Requires one document per line; documents are numbered by
+    /// lines. Put the most selective literal first.
+    std::vector<std::string> required_literals;
+};
+
+/**
+ * Statistics of an evaluation of a stream of documents.
+ */
+struct eval_many_stats {
+    /// Number of documents evaluated (without skipped documents).
+    size_t documents = 0;
+
+    /// Number of documents skipped at the beginning of the stream.
+    size_t skipped_documents = 0;
+
+    /// Number of records passed to the batch function.
+    size_t records = 0;
+
+    /// Number of documents with errors.
+    size_t failed_documents = 0;
+
+    /// Number of documents rejected by `where()`.
+    size_t rejected_documents = 0;
+
+    /// Number of lines dropped by the prefilter of `required_literals`.
+    size_t prefiltered_documents = 0;
+
+    /// Size of incomplete document at the end of the stream.
+    size_t truncated_bytes = 0;
+
+    /// Last batch size used by `iterate_many()`.
+    size_t batch_size = 0;
+
+    /// Number of changes of the batch size by `auto_batch_size`.
+    size_t batch_size_changes = 0;
+};
+
+// @name Internal implementations
+// @private
+namespace internal {
+
+/**
+ * Choose the batch size of `iterate_many()` by throughput.
+ *
+ * @private
+ *
+ * The batch size is doubled or halved after each measurement. The
+ * direction is reversed, if the throughput dropped. After three
+ * reversals the batch size with the best throughput is kept, so the
+ * stream is not restarted again and again.
+ */
+class batch_size_tuner {
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param min_size Minimum batch size.
+     * @param max_size Maximum batch size.
+     */
+    batch_size_tuner(size_t min_size, size_t max_size)
+        : min_size(std::max(min_size, size_t(1)))
+        , max_size(std::max(max_size, this->min_size))
+    { /* empty */ }
+
+    /**
+     * Get the batch size for the next measurement.
+     *
+     * @param batch_size Batch size of the last measurement.
+     * @param bytes Bytes evaluated during the last measurement.
+     * @param nanoseconds Duration of the last measurement.
+     * @param max_document_size Size of the largest document seen.
+     *
+     * @return Next batch size.
+     */
+    size_t
+    update(
+        size_t batch_size,
+        size_t bytes,
+        uint64_t nanoseconds,
+        size_t max_document_size)
+    {
+        const auto throughput =
+            double(bytes) / double(std::max(nanoseconds, uint64_t(1)));
+
+        // a batch must hold the largest documents.
+        const auto lower_size =
+            std::min(std::max(min_size, 2 * max_document_size), max_size);
+
+        if (reversals < 3) {
+            if (throughput > best_throughput) {
+                best_throughput = throughput;
+                best_size = batch_size;
+            }
+
+            if (throughput < last_throughput) {
+                grow = !grow;
+                ++reversals;
+            }
+            last_throughput = throughput;
+        }
+
+        if (reversals >= 3) {
+            return std::max(best_size, lower_size);
+        }
+
+        auto result = (grow ? batch_size * 2 : batch_size / 2);
+        if (result >= max_size) {
+            result = max_size;
+            grow = false;
+        }
+        if (result <= lower_size) {
+            result = lower_size;
+            grow = true;
+        }
+
+        return result;
+    }
+
+private:
+
+    /// minimum batch size.
+    size_t min_size;
+
+    /// maximum batch size.
+    size_t max_size;
+
+    /// throughput of the last measurement (bytes per nanosecond).
+    double last_throughput = 0.0;
+
+    /// best throughput measured.
+    double best_throughput = 0.0;
+
+    /// batch size of the best throughput.
+    size_t best_size = 0;
+
+    /// number of reversals of the direction.
+    size_t reversals = 0;
+
+    /// direction of the next change.
+    bool grow = true;
+
+}; // class batch_size_tuner
+
+/**
+ * State of the batch size tuning of a stream evaluated in parts.
+ *
+ * @private
+ *
+ * The caller keeps it for all parts of a stream (like the record
+ * batch), so measurement windows span several calls of
+ * `eval_many_batch()` and only the time spent in these calls is
+ * measured.
+ */
+struct batch_tuning {
+    /**
+     * Constructor.
+     *
+     * @param options Options of the evaluation.
+     */
+    explicit batch_tuning(const eval_many_options &options)
+        : tuner(
+            options.min_auto_batch_size,
+            std::min(options.max_auto_batch_size, options.max_batch_size))
+        , batch_size(options.batch_size)
+    { /* empty */ }
+
+    /// Tuner choosing the next batch size.
+    batch_size_tuner tuner;
+
+    /// Batch size used for the next part.
+    size_t batch_size;
+
+    /// Bytes evaluated in the current window.
+    size_t window_bytes = 0;
+
+    /// Time spent evaluating in the current window.
+    uint64_t window_nanoseconds = 0;
+
+    /// Size of the largest document seen.
+    size_t max_document_size = 0;
+};
+
+/**
+ * Find lines containing all required literals without parsing them.
+ *
+ * @private
+ *
+ * The first literal is searched in the raw input (by `memmem()` on
+ * Linux, otherwise by Boyer-Moore-Horspool), so lines without it are
+ * skipped at memory speed.
+ * The other literals are only searched in the lines found.
+ */
+class line_prefilter {
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param literals Literals each line has to contain.
+     */
+    explicit line_prefilter(const std::vector<std::string> &literals) {
+        for (const auto &literal : literals) {
+            if (!literal.empty()) {
+                others.emplace_back(literal);
+            }
+        }
+
+        if (!others.empty()) {
+            anchor = others.front();
+            others.erase(others.begin());
+
+            std::fill(std::begin(shift), std::end(shift), anchor.size());
+            for (size_t pos = 0; pos + 1 < anchor.size(); ++pos) {
+                shift[static_cast<unsigned char>(anchor[pos])] =
+                    anchor.size() - 1 - pos;
+            }
+        }
+    }
+
+    /**
+     * Find the next line containing all literals.
+     *
+     * @param input Pointer to the remaining input. Updated to the
+     *              input behind the line found.
+     * @param line Pointer to store the line found (without line break).
+     * @param dropped Pointer to store the number of lines skipped
+     *                before the line found (or up to the end).
+     *
+     * @return `true` if a line was found.
+     */
+    bool
+    next(std::string_view *input, std::string_view *line, size_t *dropped)
+        const
+    {
+        const char *pos = input->data();
+        const char *end = pos + input->size();
+        *dropped = 0;
+
+        for (const char *search = pos; pos < end;) {
+            const char *hit = find_anchor(search, end);
+            if (hit == nullptr) {
+                break;
+            }
+
+            const char *line_begin = hit;
+            while (line_begin != pos && line_begin[-1] != '\n') {
+                --line_begin;
+            }
+
+            const char *line_end =
+                static_cast<const char *>(
+                    std::memchr(hit + anchor.size(), '\n',
+                                size_t(end - hit) - anchor.size()));
+            if (line_end == nullptr) {
+                line_end = end;
+            }
+
+            *dropped += count_lines(pos, line_begin);
+            *line = std::string_view(line_begin, size_t(line_end - line_begin));
+            pos = (line_end == end ? end : line_end + 1);
+            search = pos;
+
+            if (!line->empty() && contains_others(*line)) {
+                *input = std::string_view(pos, size_t(end - pos));
+                return true;
+            }
+
+            ++*dropped;
+        }
+
+        // lines up to the end without literals.
+        *dropped += count_lines(pos, end);
+        if (pos != end && end[-1] != '\n') {
+            ++*dropped;
+        }
+        *input = std::string_view(end, 0);
+
+        return false;
+    }
+
+private:
+
+    /// Literal searched in the raw input.
+    std::string anchor;
+
+    /// Literals searched in the lines found.
+    std::vector<std::string> others;
+
+    /// Horspool shifts by the byte aligned with the end of the anchor
+    /// (without `memmem()`).
+    size_t shift[256] = {};
+
+    /**
+     * Count the line breaks in a range.
+     */
+    static size_t
+    count_lines(const char *begin, const char *end) {
+        size_t count = 0;
+        while ((begin = static_cast<const char *>(
+                    std::memchr(begin, '\n', size_t(end - begin)))) != nullptr)
+        {
+            ++count;
+            ++begin;
+        }
+
+        return count;
+    }
+
+    /**
+     * Find the next occurrence of the anchor.
+     *
+     * @return Pointer to the occurrence or `nullptr`.
+     */
+    const char *
+    find_anchor(const char *begin, const char *end) const {
+        if (anchor.empty()) {
+            // no literals: each line is found.
+            return (begin != end ? begin : nullptr);
+        }
+
+#ifdef __linux__
+        return static_cast<const char *>(
+            memmem(begin, size_t(end - begin), anchor.data(), anchor.size()));
+#else
+        const size_t last = anchor.size() - 1;
+        for (const char *hit = begin;
+             size_t(end - hit) > last;
+             hit += shift[static_cast<unsigned char>(hit[last])])
+        {
+            if (hit[last] == anchor[last]
+                && std::memcmp(hit, anchor.data(), last) == 0)
+            {
+                return hit;
+            }
+        }
+
+        return nullptr;
+#endif
+    }
+
+    /**
+     * Checks if a line contains all literals besides the anchor.
+     */
+    bool
+    contains_others(std::string_view line) const {
+        for (const auto &literal : others) {
+            if (line.find(literal) == std::string_view::npos) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+}; // class line_prefilter
+
+/**
+ * Evaluate a stream of JSON documents into a batch of the caller.
+ *
+ * @private
+ *
+ * Like `eval_many()`, but the records are collected in `*batch` and
+ * only full batches are passed to `batch_fn`. The records of a
+ * partial batch stay in `*batch`, so the caller can continue it with
+ * the next part of a stream. The batch size is taken from and stored
+ * into `*tuning` (`options.batch_size` is ignored), which keeps the
+ * measurement of `auto_batch_size` for the next part, too.
+ */
+template<
+    typename Record,
+    typename DocFn,
+    typename BatchFn>
+inline eval_many_stats
+eval_many_batch(
+    simdjson::ondemand::parser *parser,
+    simdjson::padded_string_view json,
+    Record *temp_record_ptr,
+    DocFn &doc_fn,
+    BatchFn &batch_fn,
+    error *err,
+    const eval_many_options &options,
+    record_batch<Record> *batch,
+    batch_tuning *tuning)
+{
+    _SIMDJSON_PEVAL_TRACE_SET_NAME(
+        "eval_many_batch(parser*,padded_string_view,Record*,DocFn&,BatchFn&,"
+        "error*,const eval_many_options&,record_batch<Record>*,"
+        "batch_tuning*)");
+    _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+    _SIMDJSON_PEVAL_ASSERT(parser != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(temp_record_ptr != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(batch != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(tuning != nullptr);
+
+    eval_many_stats stats;
+    stats.batch_size = tuning->batch_size;
+
+    size_t offset = 0;
+    size_t idx = 0;
+    bool stop = false;
+
+    // measurement of throughput for `auto_batch_size` (the window is
+    // continued from the last part).
+    auto window_time = std::chrono::steady_clock::now();
+    size_t last_doc_pos = 0;
+
+    // evaluate a document and store its record (`false`: stop).
+    auto eval_document =
+        [&](auto &sj_doc, simdjson::error_code code_doc) {
+            error::path_scope doc_scope(err, options.first_index + idx);
+            err->reset_usage();
+            if (err->is_stopped()) {
+                return false;
+            }
+            ++idx;
+
+            if (idx <= options.skip_documents) {
+                ++stats.skipped_documents;
+                return true;
+            }
+
+            ++stats.documents;
+
+            error::record_scope record(err);
+            const auto num_errors = err->get_count();
+            if (code_doc) {
+                _SIMDJSON_PEVAL_TRACE_ERROR(code_doc);
+                err->add(code_doc);
+            }
+            else {
+                doc_fn(sj_doc, err);
+            }
+
+            const auto is_rejected = err->is_rejected();
+            err->set_rejected(false);
+
+            if (err->get_count() != num_errors) {
+                ++stats.failed_documents;
+                return !options.stop_on_error;
+            }
+
+            if (is_rejected) {
+                _SIMDJSON_PEVAL_TRACE("rejected");
+                ++stats.rejected_documents;
+            }
+            else {
+                record.commit();
+                batch->push(temp_record_ptr);
+                if (batch->full()) {
+                    stats.records += batch->size();
+                    batch_fn(batch, err);
+                    batch->clear();
+                }
+            }
+
+            return true;
+        };
+
+    if (!options.required_literals.empty()) {
+        // parse only lines containing the literals.
+        internal::line_prefilter prefilter(options.required_literals);
+        auto input = std::string_view(json.data(), json.size());
+        const char *json_end = json.data() + json.capacity();
+
+        for (;;) {
+            std::string_view line;
+            size_t dropped = 0;
+            const auto found = prefilter.next(&input, &line, &dropped);
+
+            const auto skipped =
+                std::min(dropped,
+                         options.skip_documents
+                         - std::min(options.skip_documents, idx));
+            stats.skipped_documents += skipped;
+            stats.prefiltered_documents += dropped - skipped;
+            idx += dropped;
+
+            if (!found) {
+                break;
+            }
+
+            // the input behind the line is its padding.
+            auto sj_document =
+                parser->iterate(
+                    simdjson::padded_string_view(
+                        line.data(), line.size(),
+                        size_t(json_end - line.data())));
+            const auto code_doc = sj_document.error();
+
+            auto sj_doc =
+                simdjson::simdjson_result<
+                    simdjson::ondemand::document_reference>(
+                        simdjson::ondemand::document_reference(
+                            sj_document.value_unsafe()),
+                        code_doc);
+            if (!eval_document(sj_doc, code_doc)) {
+                break;
+            }
+        }
+
+        // all lines are processed: skip `iterate_many()`.
+        stop = true;
+    }
+
+    while (!stop && offset < json.size()) {
+        auto sj_stream =
+            parser->iterate_many(
+                json.data() + offset, json.size() - offset,
+                stats.batch_size);
+        const auto code_stream = sj_stream.error();
+        if (code_stream) {
+            _SIMDJSON_PEVAL_TRACE_ERROR(code_stream);
+            err->add(code_stream);
+            break;
+        }
+
+        bool restart = false;
+        auto sj_iter = sj_stream.value().begin();
+        auto sj_end = sj_stream.value().end();
+        for (; sj_iter != sj_end; ++sj_iter) {
+            auto sj_doc = *sj_iter;
+            const auto code_doc = sj_doc.error();
+
+            if (code_doc == simdjson::CAPACITY
+                && stats.batch_size < options.max_batch_size)
+            {
+                // document is larger than batch: restart with larger batch.
+                _SIMDJSON_PEVAL_TRACE("grow_batch_size");
+                offset += sj_iter.current_index();
+                stats.batch_size =
+                    std::min(stats.batch_size * 2, options.max_batch_size);
+                restart = true;
+                break;
+            }
+
+            if (options.auto_batch_size) {
+                const auto doc_pos = offset + sj_iter.current_index();
+                tuning->max_document_size =
+                    std::max(tuning->max_document_size, doc_pos - last_doc_pos);
+                tuning->window_bytes += doc_pos - last_doc_pos;
+                last_doc_pos = doc_pos;
+
+                if (tuning->window_bytes
+                    >= std::max(4 * stats.batch_size, size_t(1) << 20))
+                {
+                    const auto now = std::chrono::steady_clock::now();
+                    const auto nanoseconds =
+                        tuning->window_nanoseconds
+                        + uint64_t(
+                            std::chrono::duration_cast<
+                                std::chrono::nanoseconds>(
+                                    now - window_time).count());
+                    const auto batch_size =
+                        tuning->tuner.update(
+                            stats.batch_size, tuning->window_bytes,
+                            nanoseconds, tuning->max_document_size);
+                    tuning->window_bytes = 0;
+                    tuning->window_nanoseconds = 0;
+                    window_time = now;
+
+                    if (batch_size != stats.batch_size) {
+                        // continue stream at this document.
+                        _SIMDJSON_PEVAL_TRACE("tune_batch_size");
+                        offset = doc_pos;
+                        stats.batch_size = batch_size;
+                        ++stats.batch_size_changes;
+                        restart = true;
+                        break;
+                    }
+                }
+            }
+
+            if (!eval_document(sj_doc, code_doc)) {
+                stop = true;
+                break;
+            }
+        }
+
+        if (!restart) {
+            if (!stop) {
+                stats.truncated_bytes = sj_stream.value().truncated_bytes();
+                if (stats.truncated_bytes != 0 && options.truncated_is_error) {
+                    error::path_scope doc_scope(
+                        err, options.first_index + idx);
+                    const auto code = simdjson::INCOMPLETE_ARRAY_OR_OBJECT;
+                    _SIMDJSON_PEVAL_TRACE_ERROR(code);
+                    err->add(code);
+                }
+            }
+            break;
+        }
+    }
+
+    if (options.auto_batch_size && !stop) {
+        // the last document of the part ends at the complete input.
+        const auto doc_size =
+            json.size() - std::min(json.size(),
+                                   last_doc_pos + stats.truncated_bytes);
+        tuning->max_document_size =
+            std::max(tuning->max_document_size, doc_size);
+        tuning->window_bytes += doc_size;
+        tuning->window_nanoseconds +=
+            uint64_t(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - window_time).count());
+    }
+
+    tuning->batch_size = stats.batch_size;
+
+    _SIMDJSON_PEVAL_TRACE_EVAL_END();
+    return stats;
+}
+
+/**
+ * Evaluate a stream of JSON documents with the batch size tuning of
+ * the caller.
+ *
+ * @private
+ *
+ * Like `eval_many()`, but `*tuning` is kept for further streams (e.g.
+ * the units of a worker thread).
+ */
+template<
+    typename Record,
+    typename DocFn,
+    typename BatchFn>
+inline eval_many_stats
+eval_many_tuned(
+    simdjson::ondemand::parser *parser,
+    simdjson::padded_string_view json,
+    Record *temp_record_ptr,
+    DocFn &doc_fn,
+    BatchFn &batch_fn,
+    error *err,
+    const eval_many_options &options,
+    batch_tuning *tuning)
+{
+    record_batch<Record> batch(options.records_per_batch);
+    auto stats =
+        eval_many_batch(
+            parser, json, temp_record_ptr, doc_fn, batch_fn, err, options,
+            &batch, tuning);
+
+    if (!batch.empty()) {
+        stats.records += batch.size();
+        batch_fn(&batch, err);
+        batch.clear();
+    }
+
+    return stats;
+}
+
+
+} // namespace internal
+
+/**
+ * Evaluate a stream of JSON documents.
+ *
+ * Each document of the stream is evaluated by `doc_fn`, which has to
+ * store the result into `*temp_record_ptr`. If no error occurred
+ * during the evaluation of a document, the record is moved into a
+ * batch. Full batches and the last batch are passed to `batch_fn`:
+ *
+ *     void
+ *     batch_fn(record_batch<Record> *batch, error *err);
+ *
+ * The evaluation function must evaluate the type
+ * `simdjson::ondemand::document_reference`. Errors are reported with
+ * the index of the document as first path level. Documents with
+ * errors don't stop the evaluation of the following documents, unless
+ * `options.stop_on_error` is set. An `eval_guard` attached to `err` is
+ * checked before each document.
+ *
+ * If a document is larger than the batch size, the batch size is
+ * doubled and the stream is continued at that document.
+ *
+ * With `options.auto_batch_size` the throughput is measured for
+ * windows of four batches (at least 1 MiB). After each window the
+ * batch size is adjusted within `min_auto_batch_size` and
+ * `max_auto_batch_size` and the stream is continued with the new batch
+ * size, until the best batch size is found. The last batch size is
+ * returned in the statistics.
+ *
+ * With `options.required_literals` the raw input is searched for lines
+ * containing all literals, and only these lines are parsed one by one
+ * (prefilter). The prototype has to check the full condition anyway,
+ * e.g. by `where()`. Documents are numbered by lines then.
+ *
+ * @param parser Pointer to the parser to use.
+ * @param json Padded JSON data with all documents.
+ * @param temp_record_ptr Pointer to a temporary space to store a record.
+ * @param doc_fn Function to evaluate a single document and store it
+ *               into `*temp_record_ptr`.
+ * @param batch_fn Function called with batches of records.
+ * @param err Pointer to error container to store errors.
+ * @param options Options of evaluation.
+ *
+ * @return Statistics of the evaluation.
+ */
+template<
+    typename Record,
+    typename DocFn,
+    typename BatchFn>
+inline eval_many_stats
+eval_many(
+    simdjson::ondemand::parser *parser,
+    simdjson::padded_string_view json,
+    Record *temp_record_ptr,
+    DocFn doc_fn,
+    BatchFn batch_fn,
+    error *err,
+    const eval_many_options &options = eval_many_options())
+{
+#ifdef __cpp_concepts
+    static_assert(
+        batch_sink<BatchFn, Record>,
+        "batch_fn must be callable with (record_batch<Record>*, error*)");
+#endif
+
+    internal::batch_tuning tuning(options);
+    return
+        internal::eval_many_tuned(
+            parser, json, temp_record_ptr, doc_fn, batch_fn, err, options,
+            &tuning);
+}
+
+/**
+ * Incremental evaluation of a stream of JSON documents.
+ *
+ * The feeder receives the stream in parts of arbitrary size, e.g. from
+ * a socket. All complete documents (terminated by a line break) are
+ * evaluated like by `eval_many()` as soon as they are available. Only
+ * the bytes of an incomplete document at the end are moved to the
+ * beginning of the reused padded buffer. A document containing line
+ * breaks is kept there until it is complete, but it is parsed again
+ * with each part, so the stream should be NDJSON.
+ *
+ * The feeder keeps one batch of records for the whole stream. Only
+ * full batches are passed to the batch function, a partial batch is
+ * passed by `flush()` and `finish()`.
+ *
+ * The arguments of the constructor are used like in `eval_many()`.
+ * Statistics and error paths refer to the whole stream.
+ */
+template<
+    typename Record,
+    typename DocFn,
+    typename BatchFn>
+class feeder {
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param parser Pointer to the parser to use.
+     * @param temp_record_ptr Pointer to a temporary space to store a
+     *                        record.
+     * @param doc_fn Function to evaluate a single document and store it
+     *               into `*temp_record_ptr`.
+     * @param batch_fn Function called with batches of records.
+     * @param err Pointer to error container to store errors.
+     * @param options Options of evaluation.
+     */
+    feeder(
+        simdjson::ondemand::parser *parser,
+        Record *temp_record_ptr,
+        DocFn doc_fn,
+        BatchFn batch_fn,
+        error *err,
+        const eval_many_options &options = eval_many_options())
+        : parser(parser)
+        , temp_record_ptr(temp_record_ptr)
+        , doc_fn(doc_fn)
+        , batch_fn(batch_fn)
+        , err(err)
+        , options(options)
+        , buffer(0, options.huge_pages)
+        , batch(options.records_per_batch)
+        , tuning(options)
+    {
+#ifdef __cpp_concepts
+        static_assert(
+            batch_sink<BatchFn, Record>,
+            "batch_fn must be callable with (record_batch<Record>*, error*)");
+#endif
+
+        _SIMDJSON_PEVAL_ASSERT(parser != nullptr);
+        _SIMDJSON_PEVAL_ASSERT(temp_record_ptr != nullptr);
+        _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+    }
+
+    /**
+     * Add the next bytes of the stream.
+     *
+     * All documents completed by these bytes are evaluated. Their
+     * records are passed to the batch function when the batch is full,
+     * so call `flush()` to pass them without waiting for further
+     * documents (e.g. if the socket has no further data for now).
+     *
+     * @param bytes Next bytes of the stream.
+     */
+    void
+    push(std::string_view bytes);
+
+    /**
+     * Pass the records of the partial batch to the batch function.
+     */
+    void
+    flush();
+
+    /**
+     * Read the whole stream from a source and finish it.
+     *
+     * The bytes are read directly into the buffer of the feeder. The
+     * source is called like in `eval_many_pipeline()`.
+     *
+     * @param read_fn Function to read the stream.
+     * @param read_size Number of bytes to read at once.
+     */
+    template<typename ReadFn>
+    void
+    read_all(ReadFn read_fn, size_t read_size = size_t(1) << 16);
+
+    /**
+     * Evaluate the last document, if it is not terminated by a line
+     * break, and pass the last batch of records.
+     *
+     * Further bytes must not be added after this call.
+     */
+    void
+    finish();
+
+    /**
+     * Get statistics of all documents evaluated.
+     */
+    const eval_many_stats &
+    get_stats() const {
+        return stats;
+    }
+
+    /**
+     * Get number of bytes of the incomplete document at the end.
+     */
+    size_t
+    get_pending() const {
+        return buffer.size();
+    }
+
+private:
+
+    /// Pointer to parser.
+    simdjson::ondemand::parser *parser;
+
+    /// Pointer to temporary record.
+    Record *temp_record_ptr;
+
+    /// Evaluation function of a document.
+    DocFn doc_fn;
+
+    /// Function to pass batches of records.
+    BatchFn batch_fn;
+
+    /// Pointer to error container.
+    error *err;
+
+    /// Options of evaluation.
+    eval_many_options options;
+
+    /// Bytes of the incomplete document and new bytes.
+    padded_buffer buffer;
+
+    /// Records not yet passed to the batch function.
+    record_batch<Record> batch;
+
+    /// Batch size tuning for all parts of the stream.
+    internal::batch_tuning tuning;
+
+    /// Statistics.
+    eval_many_stats stats;
+
+    /// Flag: stopped by `stop_on_error`.
+    bool stopped = false;
+
+    /**
+     * Evaluate the first `size` bytes of the buffer and move the rest
+     * to the beginning. An incomplete document at the end of these
+     * bytes is kept, unless it is the `last` one of the stream.
+     */
+    void
+    evaluate(size_t size, bool last);
+
+    /**
+     * Evaluate all complete documents after `added` bytes were
+     * appended to the buffer.
+     */
+    void
+    evaluate_complete(size_t added);
+
+}; // class feeder
+
+/// @}
+
+
+// inline implementations of class feeder
+// //////////////////////////////////////////////////////////////////////
+
+template<typename Record, typename DocFn, typename BatchFn>
+inline void
+feeder<Record, DocFn, BatchFn>::push(std::string_view bytes) {
+    if (stopped || bytes.empty()) {
+        return;
+    }
+
+    const auto size = buffer.size();
+    buffer.resize(size + bytes.size());
+    std::memcpy(buffer.data() + size, bytes.data(), bytes.size());
+
+    evaluate_complete(bytes.size());
+}
+
+template<typename Record, typename DocFn, typename BatchFn>
+template<typename ReadFn>
+inline void
+feeder<Record, DocFn, BatchFn>::read_all(ReadFn read_fn, size_t read_size) {
+    _SIMDJSON_PEVAL_TRACE_SET_NAME("feeder::read_all(ReadFn,size_t)");
+
+    while (!stopped) {
+        const auto size = buffer.size();
+        buffer.resize(size + read_size);
+
+        auto sj_size = read_fn(buffer.data() + size, read_size);
+        if (sj_size.error()) {
+            buffer.resize(size);
+            _SIMDJSON_PEVAL_TRACE_ERROR(sj_size.error());
+            err->add(sj_size.error());
+            break;
+        }
+
+        buffer.resize(size + sj_size.value_unsafe());
+        if (sj_size.value_unsafe() == 0) {
+            break;
+        }
+
+        evaluate_complete(sj_size.value_unsafe());
+    }
+
+    finish();
+}
+
+template<typename Record, typename DocFn, typename BatchFn>
+inline void
+feeder<Record, DocFn, BatchFn>::finish() {
+    if (!stopped && buffer.size() != 0) {
+        evaluate(buffer.size(), true);
+    }
+
+    flush();
+}
+
+template<typename Record, typename DocFn, typename BatchFn>
+inline void
+feeder<Record, DocFn, BatchFn>::flush() {
+    if (!batch.empty()) {
+        stats.records += batch.size();
+        batch_fn(&batch, err);
+        batch.clear();
+    }
+}
+
+template<typename Record, typename DocFn, typename BatchFn>
+inline void
+feeder<Record, DocFn, BatchFn>::evaluate_complete(size_t added) {
+    // only the new bytes can contain a new line break.
+    const auto new_bytes =
+        std::string_view(buffer.data() + buffer.size() - added, added);
+    const auto pos = new_bytes.rfind('\n');
+    if (pos != std::string_view::npos) {
+        evaluate(buffer.size() - added + pos + 1, false);
+    }
+}
+
+template<typename Record, typename DocFn, typename BatchFn>
+inline void
+feeder<Record, DocFn, BatchFn>::evaluate(size_t size, bool last) {
+    auto part_options = options;
+    part_options.truncated_is_error = (last && options.truncated_is_error);
+    part_options.skip_documents =
+        options.skip_documents
+        - std::min(options.skip_documents, stats.skipped_documents);
+    part_options.first_index =
+        options.first_index + stats.skipped_documents + stats.documents
+        + stats.prefiltered_documents;
+
+    const auto part_stats =
+        internal::eval_many_batch(
+            parser,
+            simdjson::padded_string_view(
+                buffer.data(), size,
+                buffer.get_capacity() + simdjson::SIMDJSON_PADDING),
+            temp_record_ptr, doc_fn, batch_fn, err, part_options, &batch,
+            &tuning);
+
+    stats.documents += part_stats.documents;
+    stats.skipped_documents += part_stats.skipped_documents;
+    stats.records += part_stats.records;
+    stats.failed_documents += part_stats.failed_documents;
+    stats.rejected_documents += part_stats.rejected_documents;
+    stats.prefiltered_documents += part_stats.prefiltered_documents;
+    stats.batch_size = part_stats.batch_size;
+    stats.batch_size_changes += part_stats.batch_size_changes;
+
+    if (options.stop_on_error && part_stats.failed_documents != 0) {
+        stopped = true;
+    }
+
+    if (last) {
+        stats.truncated_bytes = part_stats.truncated_bytes;
+    }
+    else {
+        // keep the incomplete document for the next part.
+        size -= part_stats.truncated_bytes;
+    }
+
+    // move incomplete document to the beginning.
+    const auto rest_size = buffer.size() - size;
+    std::memmove(buffer.data(), buffer.data() + size, rest_size);
+    buffer.resize(rest_size);
+}
+
+} // namespace simdjson_peval
+
+
+#endif /* SIMDJSON_PEVAL_NDJSON_H */
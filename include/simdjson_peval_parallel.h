@@ -0,0 +1,2296 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef SIMDJSON_PEVAL_PARALLEL_H
+#define SIMDJSON_PEVAL_PARALLEL_H 1
+
+#include "simdjson_peval_ndjson.h"
+
+#include <atomic>
+#include <charconv>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+
+namespace simdjson_peval {
+
+///
+/// @name Placement of worker threads.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
+
+/**
+ * Placement of worker threads on NUMA nodes.
+ *
+ * Pinned workers create their parser, buffers and results in their
+ * own thread, so that the memory is allocated on their local node
+ * (first touch). On machines with a single node (or other systems than
+ * Linux) no thread is pinned.
+ */
+enum class thread_placement {
+    /// Workers are not pinned.
+    none,
+
+    /// Workers are distributed round robin over the nodes.
+    spread,
+
+    /// Consecutive workers are placed on the same node.
+    compact
+};
+
+/**
+ * Statistics of the placement of worker threads.
+ */
+struct placement_stats {
+    /// Number of NUMA nodes with CPUs.
+    size_t nodes = 1;
+
+    /// Number of threads pinned to the CPUs of a node.
+    size_t pinned_threads = 0;
+
+    /// Number of threads assigned to each node.
+    std::vector<size_t> node_threads;
+};
+
+// @name Internal implementations
+// @private
+namespace internal {
+
+/**
+ * Parse a list of CPUs like `0-3,8,10-11`.
+ *
+ * @private
+ *
+ * @param list List of CPUs as in sysfs.
+ *
+ * @return All CPUs of the list.
+ */
+inline std::vector<int>
+parse_cpu_list(std::string_view list) {
+    std::vector<int> result;
+
+    while (!list.empty()) {
+        const auto item = list.substr(0, list.find(','));
+        list.remove_prefix(std::min(item.size() + 1, list.size()));
+
+        int first = -1;
+        int last = -1;
+        const auto dash = item.find('-');
+        const auto first_str = item.substr(0, dash);
+        std::from_chars(
+            first_str.data(), first_str.data() + first_str.size(), first);
+        if (dash == std::string_view::npos) {
+            last = first;
+        }
+        else {
+            std::from_chars(item.data() + dash + 1, item.data() + item.size(),
+                            last);
+        }
+
+        for (int cpu = first; cpu >= 0 && cpu <= last; ++cpu) {
+            result.push_back(cpu);
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Get the CPUs of all NUMA nodes with CPUs.
+ *
+ * The topology is read once from sysfs. Without NUMA information a
+ * single node without CPUs is returned.
+ *
+ * @private
+ */
+inline const std::vector<std::vector<int>> &
+numa_nodes() {
+    static const std::vector<std::vector<int>> nodes =
+        []() {
+            std::vector<std::vector<int>> result;
+
+#ifdef __linux__
+            const std::string sys_path = "/sys/devices/system/node/";
+            std::string list;
+            std::getline(std::ifstream(sys_path + "online"), list);
+            for (auto node : parse_cpu_list(list)) {
+                std::string cpus;
+                std::getline(
+                    std::ifstream(
+                        sys_path + "node" + std::to_string(node) + "/cpulist"),
+                    cpus);
+                auto node_cpus = parse_cpu_list(cpus);
+                if (!node_cpus.empty()) {
+                    result.push_back(std::move(node_cpus));
+                }
+            }
+#endif
+
+            if (result.empty()) {
+                result.emplace_back();
+            }
+            return result;
+        }();
+
+    return nodes;
+}
+
+/**
+ * Assign a worker to a node.
+ *
+ * @private
+ *
+ * @param placement Placement of the workers.
+ * @param worker Index of the worker.
+ * @param workers Number of workers.
+ * @param nodes Number of nodes.
+ *
+ * @return Index of the node.
+ */
+inline size_t
+assign_node(
+    thread_placement placement, size_t worker, size_t workers, size_t nodes)
+{
+    if (placement == thread_placement::compact) {
+        return worker * nodes / std::max(workers, size_t(1));
+    }
+
+    return worker % std::max(nodes, size_t(1));
+}
+
+/**
+ * Placement of the workers of a parallel evaluation.
+ *
+ * @private
+ */
+class worker_placement {
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param placement Placement of the workers.
+     * @param workers Number of workers.
+     */
+    worker_placement(thread_placement placement, size_t workers)
+        : nodes(numa_nodes())
+        , worker_nodes(workers, 0)
+        , pin(placement != thread_placement::none && nodes.size() > 1)
+    {
+        for (size_t idx = 0; idx < workers; ++idx) {
+            worker_nodes[idx] =
+                assign_node(placement, idx, workers, nodes.size());
+        }
+    }
+
+    /**
+     * Pin the calling worker thread to the CPUs of its node.
+     *
+     * Must be called by the worker thread before it allocates memory.
+     *
+     * @param worker Index of the worker.
+     */
+    void
+    enter(size_t worker) {
+#ifdef __linux__
+        if (!pin) {
+            return;
+        }
+
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        for (auto cpu : nodes[worker_nodes[worker]]) {
+            if (cpu < CPU_SETSIZE) {
+                CPU_SET(cpu, &cpu_set);
+            }
+        }
+
+        if (pthread_setaffinity_np(
+                pthread_self(), sizeof(cpu_set), &cpu_set) == 0)
+        {
+            pinned.fetch_add(1, std::memory_order_relaxed);
+        }
+#else
+        (void) worker;
+#endif
+    }
+
+    /**
+     * Get statistics of the placement.
+     */
+    placement_stats
+    get_stats() const {
+        placement_stats result;
+        result.nodes = nodes.size();
+        result.pinned_threads = pinned.load(std::memory_order_relaxed);
+        result.node_threads.resize(nodes.size(), 0);
+        for (auto node : worker_nodes) {
+            ++result.node_threads[node];
+        }
+
+        return result;
+    }
+
+private:
+
+    /// CPUs of all nodes.
+    const std::vector<std::vector<int>> &nodes;
+
+    /// Node of each worker.
+    std::vector<size_t> worker_nodes;
+
+    /// Flag: pin the workers.
+    bool pin;
+
+    /// Number of pinned workers.
+    std::atomic<size_t> pinned{0};
+};
+
+} // namespace internal
+
+/// @}
+
+///
+/// @name Evaluate streams of JSON documents with multiple threads.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
+
+/**
+ * Options to evaluate a stream of documents with multiple threads.
+ */
+struct eval_parallel_options : eval_many_options {
+    /// Number of worker threads (`0`: number of hardware threads).
+    size_t threads = 0;
+
+    /// Approximate size of a chunk of documents evaluated by one
+    /// worker at once (`0`: chosen by input size and threads).
+    size_t chunk_size = 0;
+
+    /// Pass records to the batch function in order of the documents.
+    bool ordered = true;
+
+    /// Maximum number of evaluated chunks per thread waiting for the
+    /// batch function, if `ordered` is set.
+    size_t pending_chunks_per_thread = 2;
+
+    /// Placement of the worker threads on NUMA nodes.
+    thread_placement placement = thread_placement::none;
+};
+
+/**
+ * Statistics of a multi-threaded evaluation of a stream of documents.
+ */
+struct eval_parallel_stats : eval_many_stats {
+    /// Number of worker threads used.
+    size_t threads = 0;
+
+    /// Number of chunks the stream was split into.
+    size_t chunks = 0;
+
+    /// Placement of the worker threads.
+    placement_stats placement;
+};
+
+// @name Internal implementations
+// @private
+namespace internal {
+
+/**
+ * Split a stream of documents into chunks at line breaks.
+ *
+ * @private
+ *
+ * @param json Stream of documents.
+ * @param chunk_size Minimum size of a chunk (except the last one).
+ *
+ * @return Begin and end offset of all chunks.
+ */
+inline std::vector<std::pair<size_t, size_t>>
+split_lines(std::string_view json, size_t chunk_size) {
+    std::vector<std::pair<size_t, size_t>> result;
+
+    size_t begin = 0;
+    while (begin < json.size()) {
+        size_t end = json.size();
+        if (json.size() - begin > chunk_size) {
+            const auto pos = json.find('\n', begin + chunk_size - 1);
+            if (pos != std::string_view::npos) {
+                end = pos + 1;
+            }
+        }
+
+        result.emplace_back(begin, end);
+        begin = end;
+    }
+
+    return result;
+}
+
+/**
+ * Result of the evaluation of a single chunk.
+ *
+ * @private
+ */
+template<typename Record>
+struct parallel_chunk {
+    /// Records waiting for the batch function (ordered mode only).
+    std::vector<Record> records;
+
+    /// Histogram of the chunk, if errors are aggregated.
+    std::optional<error_histogram> histogram;
+
+    /// Errors of the chunk with document indexes of the chunk.
+    error errors;
+
+    /// Statistics of the chunk.
+    eval_many_stats stats;
+
+    /// Flag: chunk is evaluated.
+    bool done = false;
+};
+
+} // namespace internal
+
+/**
+ * Evaluate a stream of JSON documents with multiple threads.
+ *
+ * The stream is split at line breaks into chunks, which are evaluated
+ * by `eval_many()` in a pool of worker threads. Therefore no document
+ * may contain a line break (NDJSON).
+ *
+ * Each worker has its own parser, temporary record and evaluation
+ * function. The evaluation functions are created before the workers
+ * start by calling `make_proto` sequentially in the calling thread:
+ *
+ *     auto
+ *     make_proto(Record *temp_record_ptr);
+ *
+ * If `options.ordered` is set, the records are passed to `batch_fn` by
+ * the calling thread in the order of the documents. Otherwise
+ * `batch_fn` is called by the worker threads (never concurrently) as
+ * soon as a batch is available.
+ *
+ * Errors are reported with the index of the document in the whole
+ * stream as first path level, as `eval_many()` does. If `err` uses a
+ * histogram, each chunk uses a histogram with the same limits, which
+ * is merged afterwards.
+ *
+ * The option `skip_documents` is only applied to the first chunk. If
+ * `stop_on_error` is set, no further chunks are started after a
+ * document with errors. In ordered mode, records and errors of chunks
+ * behind the first failed chunk are discarded.
+ *
+ * If `options.placement` is set on a machine with multiple NUMA nodes,
+ * the workers are pinned to the CPUs of a node. Parsers, copies of
+ * chunk records and batches are allocated by the workers and are so
+ * local to their node.
+ *
+ * @param json Padded JSON data with all documents.
+ * @param make_proto Function creating the evaluation function of a
+ *                   document for a temporary record.
+ * @param batch_fn Function called with batches of records.
+ * @param err Pointer to error container to store errors.
+ * @param options Options of evaluation.
+ *
+ * @return Statistics of the evaluation.
+ */
+template<
+    typename Record,
+    typename MakeProtoFn,
+    typename BatchFn>
+inline eval_parallel_stats
+eval_many_parallel(
+    simdjson::padded_string_view json,
+    MakeProtoFn make_proto,
+    BatchFn batch_fn,
+    error *err,
+    const eval_parallel_options &options = eval_parallel_options())
+{
+    using chunk_type = internal::parallel_chunk<Record>;
+    using proto_type = decltype(make_proto(std::declval<Record *>()));
+
+    _SIMDJSON_PEVAL_TRACE_SET_NAME(
+        "eval_many_parallel(padded_string_view,MakeProtoFn,BatchFn,error*)");
+    _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+    _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+
+    eval_parallel_stats stats;
+    stats.threads = options.threads;
+    if (stats.threads == 0) {
+        stats.threads = std::max(size_t(std::thread::hardware_concurrency()),
+                                 size_t(1));
+    }
+
+    size_t chunk_size = options.chunk_size;
+    if (chunk_size == 0) {
+        // about 8 chunks per thread, but not too small.
+        chunk_size = std::max(json.size() / (stats.threads * 8),
+                              size_t(1) << 20);
+    }
+
+    const auto ranges = internal::split_lines(json, chunk_size);
+    stats.chunks = ranges.size();
+    stats.threads = std::min(stats.threads, stats.chunks);
+
+    // empty histogram with the limits of `err`.
+    std::optional<error_histogram> empty_histogram;
+    if (err->get_histogram()) {
+        empty_histogram.emplace(*err->get_histogram());
+        empty_histogram->clear();
+    }
+
+    std::vector<chunk_type> chunks(ranges.size());
+    std::vector<Record> temp_records(stats.threads);
+    std::vector<proto_type> protos;
+    protos.reserve(stats.threads);
+    for (auto &temp_record : temp_records) {
+        protos.push_back(make_proto(&temp_record));
+    }
+
+    const size_t max_pending =
+        options.ordered
+        ? stats.threads * std::max(options.pending_chunks_per_thread,
+                                   size_t(1))
+        : ranges.size();
+
+    std::mutex mutex;
+    std::condition_variable claim_cond;
+    std::condition_variable done_cond;
+    std::mutex sink_mutex;
+    size_t next_chunk = 0;
+    size_t merged_chunks = 0;
+    bool stop = false;
+
+    internal::worker_placement placement(options.placement, stats.threads);
+
+    auto worker =
+        [&](size_t worker_idx) {
+            placement.enter(worker_idx);
+            simdjson::ondemand::parser parser;
+
+            // the batch size is tuned over all chunks of the worker.
+            internal::batch_tuning tuning(options);
+
+            for (;;) {
+                size_t chunk_idx;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    claim_cond.wait(
+                        lock,
+                        [&]() {
+                            return (stop
+                                    || next_chunk >= ranges.size()
+                                    || next_chunk < merged_chunks + max_pending);
+                        });
+                    if (stop || next_chunk >= ranges.size()) {
+                        break;
+                    }
+                    chunk_idx = next_chunk++;
+                }
+
+                auto &chunk = chunks[chunk_idx];
+                if (empty_histogram) {
+                    chunk.histogram.emplace(*empty_histogram);
+                    chunk.errors = error(&*chunk.histogram);
+                }
+                else {
+                    chunk.errors = error(err->is_path_enabled());
+                }
+                chunk.errors.set_guard(err->get_guard());
+                chunk.errors.set_limits(err->get_limits());
+
+                auto chunk_options = eval_many_options(options);
+                if (chunk_idx != 0) {
+                    chunk_options.skip_documents = 0;
+                }
+
+                const auto [begin, end] = ranges[chunk_idx];
+                simdjson::padded_string_view chunk_json(
+                    json.data() + begin, end - begin, json.capacity() - begin);
+
+                auto chunk_batch_fn =
+                    [&](record_batch<Record> *batch, error *chunk_err) {
+                        if (options.ordered) {
+                            for (auto &record : *batch) {
+                                chunk.records.push_back(std::move(record));
+                            }
+                        }
+                        else {
+                            std::lock_guard<std::mutex> lock(sink_mutex);
+                            batch_fn(batch, chunk_err);
+                        }
+                    };
+                chunk.stats =
+                    internal::eval_many_tuned(
+                        &parser, chunk_json,
+                        &temp_records[worker_idx], protos[worker_idx],
+                        chunk_batch_fn, &chunk.errors, chunk_options,
+                        &tuning);
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    chunk.done = true;
+                    if (options.stop_on_error
+                        && chunk.stats.failed_documents != 0)
+                    {
+                        stop = true;
+                    }
+                }
+                done_cond.notify_all();
+                claim_cond.notify_all();
+            }
+        };
+
+    std::vector<std::thread> threads;
+    threads.reserve(stats.threads);
+    for (size_t idx = 0; idx < stats.threads; ++idx) {
+        threads.emplace_back(worker, idx);
+    }
+
+    // merge chunks in order of the documents.
+    record_batch<Record> batch(options.records_per_batch);
+    size_t doc_offset = 0;
+    for (size_t chunk_idx = 0; chunk_idx < chunks.size(); ++chunk_idx) {
+        auto &chunk = chunks[chunk_idx];
+        if (options.ordered) {
+            std::unique_lock<std::mutex> lock(mutex);
+            done_cond.wait(
+                lock,
+                [&]() {
+                    return chunk.done || (stop && next_chunk <= chunk_idx);
+                });
+        }
+        else if (chunk_idx == 0) {
+            for (auto &thread : threads) {
+                thread.join();
+            }
+            threads.clear();
+        }
+
+        if (!chunk.done) {
+            break;
+        }
+
+        err->append(chunk.errors, doc_offset);
+        doc_offset +=
+            chunk.stats.skipped_documents + chunk.stats.documents
+            + chunk.stats.prefiltered_documents;
+
+        stats.documents += chunk.stats.documents;
+        stats.skipped_documents += chunk.stats.skipped_documents;
+        stats.records += chunk.stats.records;
+        stats.failed_documents += chunk.stats.failed_documents;
+        stats.rejected_documents += chunk.stats.rejected_documents;
+        stats.prefiltered_documents += chunk.stats.prefiltered_documents;
+        stats.truncated_bytes += chunk.stats.truncated_bytes;
+        stats.batch_size = std::max(stats.batch_size, chunk.stats.batch_size);
+        stats.batch_size_changes += chunk.stats.batch_size_changes;
+
+        for (auto &record : chunk.records) {
+            batch.push(&record);
+            if (batch.full()) {
+                batch_fn(&batch, err);
+                batch.clear();
+            }
+        }
+        std::vector<Record>().swap(chunk.records);
+
+        if (options.ordered) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                merged_chunks = chunk_idx + 1;
+            }
+            claim_cond.notify_all();
+        }
+
+        if (options.ordered
+            && options.stop_on_error
+            && chunk.stats.failed_documents != 0)
+        {
+            break;
+        }
+    }
+
+    if (!batch.empty()) {
+        batch_fn(&batch, err);
+        batch.clear();
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    stats.placement = placement.get_stats();
+
+    _SIMDJSON_PEVAL_TRACE_EVAL_END();
+    return stats;
+}
+
+/// @}
+
+///
+/// @name Evaluate streams of JSON documents in a pipeline.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
+
+/**
+ * Lock-free bounded queue for a single producer and a single consumer.
+ *
+ * `try_push()` must only be called by one thread and `try_pop()` only
+ * by another one. The blocking methods `push()` and `pop()` yield the
+ * thread a few times while the queue is full or empty and sleep
+ * afterwards until the other thread changed the queue (by
+ * `std::atomic::wait()` in C++20, otherwise by a condition variable).
+ */
+template<typename T>
+class spsc_queue {
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param capacity Maximum number of elements in the queue.
+     */
+    explicit spsc_queue(size_t capacity)
+        : slots(capacity + 1)
+    { /* empty */ }
+
+    spsc_queue(const spsc_queue &) = delete;
+    spsc_queue &operator=(const spsc_queue &) = delete;
+
+    /**
+     * Add an element, if the queue is not full.
+     *
+     * @param value Element to add. It is only moved on success.
+     *
+     * @return `true` if the element was added.
+     */
+    bool
+    try_push(T &&value) {
+        const auto tail = tail_idx.load(std::memory_order_relaxed);
+        const auto next = next_idx(tail);
+        if (next == head_idx.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        slots[tail] = std::move(value);
+        tail_idx.store(next, std::memory_order_release);
+        notify(&tail_idx);
+        return true;
+    }
+
+    /**
+     * Remove the first element, if the queue is not empty.
+     *
+     * @param value_ptr Pointer to location to move the element to.
+     *
+     * @return `true` if an element was removed.
+     */
+    bool
+    try_pop(T *value_ptr) {
+        const auto head = head_idx.load(std::memory_order_relaxed);
+        if (head == tail_idx.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        *value_ptr = std::move(slots[head]);
+        head_idx.store(next_idx(head), std::memory_order_release);
+        notify(&head_idx);
+        return true;
+    }
+
+    /**
+     * Add an element and wait while the queue is full.
+     */
+    void
+    push(T value) {
+        for (size_t spin = 0; !try_push(std::move(value)); ++spin) {
+            if (spin < spin_count) {
+                std::this_thread::yield();
+            } else {
+                // full: wait until the consumer moves the head.
+                wait_while(
+                    &head_idx,
+                    next_idx(tail_idx.load(std::memory_order_relaxed)));
+            }
+        }
+    }
+
+    /**
+     * Remove the first element and wait while the queue is empty.
+     */
+    T
+    pop() {
+        T value;
+        for (size_t spin = 0; !try_pop(&value); ++spin) {
+            if (spin < spin_count) {
+                std::this_thread::yield();
+            } else {
+                // empty: wait until the producer moves the tail.
+                wait_while(
+                    &tail_idx, head_idx.load(std::memory_order_relaxed));
+            }
+        }
+
+        return value;
+    }
+
+    /**
+     * Get maximum number of elements in the queue.
+     */
+    size_t
+    get_capacity() const {
+        return slots.size() - 1;
+    }
+
+private:
+
+    /// ring buffer with one unused slot.
+    std::vector<T> slots;
+
+    /// index of the first element (written by consumer).
+    alignas(64) std::atomic<size_t> head_idx{0};
+
+    /// index behind the last element (written by producer).
+    alignas(64) std::atomic<size_t> tail_idx{0};
+
+    /// Number of failed attempts of `push()` and `pop()` before they
+    /// sleep.
+    static constexpr size_t spin_count = 64;
+
+#ifdef __cpp_lib_atomic_wait
+
+    /// Sleep while `*idx_ptr` has the value `old_idx`.
+    void
+    wait_while(const std::atomic<size_t> *idx_ptr, size_t old_idx) {
+        idx_ptr->wait(old_idx, std::memory_order_acquire);
+    }
+
+    /// Wake up a thread sleeping on `*idx_ptr`.
+    void
+    notify(std::atomic<size_t> *idx_ptr) {
+        idx_ptr->notify_one();
+    }
+
+#else // __cpp_lib_atomic_wait
+
+    /// mutex and condition variable to sleep in `push()` or `pop()`.
+    std::mutex wait_mutex;
+    std::condition_variable wait_cond;
+
+    /// number of sleeping threads (checked without lock by notify()).
+    std::atomic<size_t> num_waiters{0};
+
+    /// Sleep while `*idx_ptr` has the value `old_idx`.
+    void
+    wait_while(const std::atomic<size_t> *idx_ptr, size_t old_idx) {
+        std::unique_lock<std::mutex> lock(wait_mutex);
+        num_waiters.fetch_add(1, std::memory_order_seq_cst);
+        wait_cond.wait(
+            lock,
+            [idx_ptr, old_idx]() {
+                return idx_ptr->load(std::memory_order_seq_cst) != old_idx;
+            });
+        num_waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /// Wake up a thread sleeping on `*idx_ptr`.
+    void
+    notify(std::atomic<size_t> *) {
+        // pairs with the increment of `num_waiters` before the waiter
+        // checks the index: either it sees the new index or we see it.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (num_waiters.load(std::memory_order_relaxed) != 0) {
+            std::lock_guard<std::mutex> lock(wait_mutex);
+            wait_cond.notify_all();
+        }
+    }
+
+#endif // __cpp_lib_atomic_wait
+
+    /// Get next index in ring buffer.
+    size_t
+    next_idx(size_t idx) const {
+        ++idx;
+        return (idx == slots.size() ? 0 : idx);
+    }
+
+}; // class spsc_queue
+
+/**
+ * Options to evaluate a stream of documents in a pipeline.
+ */
+struct eval_pipeline_options : eval_many_options {
+    /// Size of the blocks read from the source. A block is enlarged,
+    /// if a single document doesn't fit into it.
+    size_t block_size = size_t(1) << 20;
+
+    /// Number of blocks and record batches in flight between the
+    /// stages.
+    size_t queue_depth = 4;
+};
+
+
+/**
+ * Evaluate a stream of JSON documents in a pipeline of three stages.
+ *
+ * Stage 1 reads the stream from a source into padded blocks of
+ * complete lines. A block is passed on, if it is full or if the source
+ * returned less bytes than requested (e.g. a socket without further
+ * data), as soon as it contains a line break. The incomplete line at
+ * its end is written into the next block. Stage 2 evaluates the
+ * documents of the blocks like `eval_many()` and stage 3 passes the
+ * record batches to `batch_fn`.
+ * Stage 1 and 2 run in their own threads, stage 3 runs in the calling
+ * thread. The stages exchange blocks and batches through lock-free
+ * bounded queues, so that a stage waits, if the next one is too slow.
+ * Therefore documents must not contain line breaks (NDJSON).
+ *
+ * The source is a function reading the next bytes of the stream:
+ *
+ *     simdjson::simdjson_result<size_t>
+ *     read_fn(char *buffer, size_t capacity);
+ *
+ * It returns the number of bytes read, which is `0` at the end of the
+ * stream, or an error code, which is added to `err` and stops the
+ * stream.
+ *
+ * `doc_fn` and `batch_fn` are used like in `eval_many()`, but are
+ * called in different threads. Errors added by `batch_fn` are merged
+ * into `err` after the evaluation.
+ *
+ * @param parser Pointer to the parser to use.
+ * @param read_fn Function to read the stream.
+ * @param temp_record_ptr Pointer to a temporary space to store a record.
+ * @param doc_fn Function to evaluate a single document and store it
+ *               into `*temp_record_ptr`.
+ * @param batch_fn Function called with batches of records.
+ * @param err Pointer to error container to store errors.
+ * @param options Options of evaluation.
+ *
+ * @return Statistics of the evaluation.
+ */
+template<
+    typename ReadFn,
+    typename Record,
+    typename DocFn,
+    typename BatchFn>
+inline eval_many_stats
+eval_many_pipeline(
+    simdjson::ondemand::parser *parser,
+    ReadFn read_fn,
+    Record *temp_record_ptr,
+    DocFn doc_fn,
+    BatchFn batch_fn,
+    error *err,
+    const eval_pipeline_options &options = eval_pipeline_options())
+{
+    using block_type = padded_buffer;
+    using batch_type = record_batch<Record>;
+
+    _SIMDJSON_PEVAL_TRACE_SET_NAME(
+        "eval_many_pipeline(parser*,ReadFn,Record*,DocFn,BatchFn,error*)");
+    _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+    _SIMDJSON_PEVAL_ASSERT(parser != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(temp_record_ptr != nullptr);
+    _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+
+    const auto queue_depth = std::max(options.queue_depth, size_t(1));
+    const auto block_size = std::max(options.block_size, size_t(1));
+
+    // one more block than in flight: the read stage fills the next
+    // block with the tail of the current one before passing it.
+    std::vector<block_type> blocks;
+    blocks.reserve(queue_depth + 1);
+    for (size_t idx = 0; idx < queue_depth + 1; ++idx) {
+        blocks.emplace_back(0, options.huge_pages);
+    }
+    std::vector<batch_type> batches(
+        queue_depth, batch_type(options.records_per_batch));
+
+    // `nullptr` marks the end of the stream.
+    spsc_queue<block_type *> free_blocks(queue_depth + 1);
+    spsc_queue<block_type *> full_blocks(queue_depth + 2);
+    spsc_queue<batch_type *> free_batches(queue_depth);
+    spsc_queue<batch_type *> full_batches(queue_depth + 1);
+
+    for (auto &block : blocks) {
+        block.reserve(block_size);
+        free_blocks.push(&block);
+    }
+
+    for (auto &batch : batches) {
+        free_batches.push(&batch);
+    }
+
+    std::atomic<bool> stop{false};
+    simdjson::error_code read_error = simdjson::SUCCESS;
+
+    // stage 1: read blocks of complete lines.
+    auto read_stage =
+        [&]() {
+            auto block_ptr = free_blocks.pop();
+            block_ptr->clear();
+            bool eof = false;
+
+            while (!eof && !stop.load(std::memory_order_relaxed)) {
+                // the tail of the previous block has no line break.
+                size_t line_end = 0;
+                for (;;) {
+                    const auto size = block_ptr->size();
+                    if (size == block_ptr->get_capacity()) {
+                        // no line break found: enlarge block.
+                        block_ptr->reserve(size * 2);
+                    }
+
+                    const auto read_capacity =
+                        block_ptr->get_capacity() - size;
+                    auto sj_size =
+                        read_fn(block_ptr->data() + size, read_capacity);
+                    if (sj_size.error()) {
+                        read_error = sj_size.error();
+                        eof = true;
+                        break;
+                    }
+
+                    const auto read_size = sj_size.value_unsafe();
+                    if (read_size == 0) {
+                        eof = true;
+                        break;
+                    }
+
+                    block_ptr->resize(size + read_size);
+                    const auto pos =
+                        std::string_view(block_ptr->data() + size, read_size)
+                        .rfind('\n');
+                    if (pos != std::string_view::npos) {
+                        line_end = size + pos + 1;
+                    }
+
+                    // pass complete lines after a short read, instead of
+                    // waiting for a full block.
+                    if (line_end != 0 && read_size < read_capacity) {
+                        break;
+                    }
+
+                    if (line_end != 0
+                        && block_ptr->size() == block_ptr->get_capacity())
+                    {
+                        break;
+                    }
+                }
+
+                // write the incomplete line into the next block.
+                block_type *next_ptr = nullptr;
+                if (!eof) {
+                    const auto tail_size = block_ptr->size() - line_end;
+                    next_ptr = free_blocks.pop();
+                    next_ptr->clear();
+                    next_ptr->reserve(tail_size + block_size);
+                    next_ptr->resize(tail_size);
+                    std::memcpy(next_ptr->data(), block_ptr->data() + line_end,
+                                tail_size);
+                    block_ptr->resize(line_end);
+                }
+
+                full_blocks.push(block_ptr);
+                block_ptr = next_ptr;
+            }
+
+            if (block_ptr != nullptr) {
+                free_blocks.push(block_ptr);
+            }
+
+            full_blocks.push(nullptr);
+        };
+
+    // stage 2: evaluate blocks.
+    eval_many_stats stats;
+    stats.batch_size = options.batch_size;
+    auto eval_stage =
+        [&]() {
+            auto block_options = eval_many_options(options);
+
+            // one batch for all blocks: short blocks don't pass small
+            // batches.
+            batch_type stage_batch(options.records_per_batch);
+            internal::batch_tuning tuning(options);
+            auto pass_batch =
+                [&](batch_type *batch, error *) {
+                    auto batch_ptr = free_batches.pop();
+                    batch_ptr->swap(*batch);
+                    full_batches.push(batch_ptr);
+                };
+
+            for (auto block_ptr = full_blocks.pop();
+                 block_ptr != nullptr;
+                 block_ptr = full_blocks.pop())
+            {
+                if (!stop.load(std::memory_order_relaxed)) {
+                    block_options.skip_documents =
+                        options.skip_documents
+                        - std::min(options.skip_documents,
+                                   stats.skipped_documents);
+                    block_options.first_index =
+                        options.first_index
+                        + stats.skipped_documents + stats.documents
+                        + stats.prefiltered_documents;
+
+                    const auto block_stats =
+                        internal::eval_many_batch(
+                            parser, block_ptr->view(), temp_record_ptr,
+                            doc_fn, pass_batch, err, block_options,
+                            &stage_batch, &tuning);
+
+                    stats.documents += block_stats.documents;
+                    stats.skipped_documents += block_stats.skipped_documents;
+                    stats.records += block_stats.records;
+                    stats.failed_documents += block_stats.failed_documents;
+                    stats.rejected_documents +=
+                        block_stats.rejected_documents;
+                    stats.prefiltered_documents +=
+                        block_stats.prefiltered_documents;
+                    stats.truncated_bytes += block_stats.truncated_bytes;
+                    stats.batch_size = block_stats.batch_size;
+                    stats.batch_size_changes +=
+                        block_stats.batch_size_changes;
+
+                    if ((options.stop_on_error
+                         && block_stats.failed_documents != 0)
+                        || err->is_stopped())
+                    {
+                        stop.store(true, std::memory_order_relaxed);
+                    }
+                }
+
+                free_blocks.push(block_ptr);
+            }
+
+            if (!stage_batch.empty()) {
+                stats.records += stage_batch.size();
+                pass_batch(&stage_batch, err);
+            }
+
+            full_batches.push(nullptr);
+        };
+
+    std::thread read_thread(read_stage);
+    std::thread eval_thread(eval_stage);
+
+    // stage 3: pass batches to the batch function.
+    error sink_errors(err->is_path_enabled());
+    for (auto batch_ptr = full_batches.pop();
+         batch_ptr != nullptr;
+         batch_ptr = full_batches.pop())
+    {
+        batch_fn(batch_ptr, &sink_errors);
+        batch_ptr->clear();
+        free_batches.push(batch_ptr);
+    }
+
+    read_thread.join();
+    eval_thread.join();
+
+    err->append(sink_errors);
+    if (read_error) {
+        _SIMDJSON_PEVAL_TRACE_ERROR(read_error);
+        err->add(read_error);
+    }
+
+    _SIMDJSON_PEVAL_TRACE_EVAL_END();
+    return stats;
+}
+
+/// @}
+
+///
+/// @name Evaluate huge arrays with multiple threads.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
+
+/**
+ * Queue of work items with one deque per worker.
+ *
+ * Workers take items from the front of their own deque. If it is
+ * empty, they steal items from the back of the deques of the other
+ * workers. All methods are thread safe.
+ */
+template<typename T>
+class work_stealing_queue {
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param workers Number of workers.
+     */
+    explicit work_stealing_queue(size_t workers)
+        : deques(std::max(workers, size_t(1)))
+    { /* empty */ }
+
+    work_stealing_queue(const work_stealing_queue &) = delete;
+    work_stealing_queue &operator=(const work_stealing_queue &) = delete;
+
+    /**
+     * Add an item to the back of the deque of a worker.
+     *
+     * @param worker Index of the worker.
+     * @param value Item to add.
+     */
+    void
+    push(size_t worker, T value) {
+        auto &deque = deques[worker % deques.size()];
+        std::lock_guard<std::mutex> lock(deque.mutex);
+        deque.items.push_back(std::move(value));
+    }
+
+    /**
+     * Take an item for a worker.
+     *
+     * @param worker Index of the worker.
+     * @param value_ptr Pointer to location to move the item to.
+     *
+     * @return `false` if all deques are empty.
+     */
+    bool
+    pop(size_t worker, T *value_ptr) {
+        {
+            auto &deque = deques[worker % deques.size()];
+            std::lock_guard<std::mutex> lock(deque.mutex);
+            if (!deque.items.empty()) {
+                *value_ptr = std::move(deque.items.front());
+                deque.items.pop_front();
+                return true;
+            }
+        }
+
+        for (size_t idx = 1; idx < deques.size(); ++idx) {
+            auto &deque = deques[(worker + idx) % deques.size()];
+            std::lock_guard<std::mutex> lock(deque.mutex);
+            if (!deque.items.empty()) {
+                *value_ptr = std::move(deque.items.back());
+                deque.items.pop_back();
+                steals.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * Get number of items taken from the deque of another worker.
+     */
+    size_t
+    get_steals() const {
+        return steals.load(std::memory_order_relaxed);
+    }
+
+private:
+
+    /// Deque of a single worker.
+    struct alignas(64) worker_deque {
+        std::mutex mutex;
+        std::deque<T> items;
+    };
+
+    /// Deques of all workers.
+    std::vector<worker_deque> deques;
+
+    /// Number of items stolen.
+    std::atomic<size_t> steals{0};
+
+}; // class work_stealing_queue
+
+/**
+ * Options to evaluate a huge array with multiple threads.
+ */
+struct eval_array_parallel_options {
+    /// Number of worker threads (`0`: number of hardware threads).
+    size_t threads = 0;
+
+    /// Approximate size of a range of elements evaluated at once
+    /// (`0`: chosen by input size and threads).
+    size_t range_size = 0;
+
+    /// Placement of the worker threads on NUMA nodes.
+    thread_placement placement = thread_placement::none;
+};
+
+/**
+ * Statistics of the evaluation of a huge array with multiple threads.
+ */
+struct eval_array_parallel_stats {
+    /// Number of array elements.
+    size_t elements = 0;
+
+    /// Number of ranges the array was split into.
+    size_t ranges = 0;
+
+    /// Number of worker threads used.
+    size_t threads = 0;
+
+    /// Number of ranges stolen from another worker.
+    size_t steals = 0;
+
+    /// Placement of the worker threads.
+    placement_stats placement;
+};
+
+// @name Internal implementations
+// @private
+namespace internal {
+
+/**
+ * Range of array elements.
+ *
+ * @private
+ */
+template<typename Record>
+struct array_range {
+    /// Offset of the first element (behind the separator).
+    size_t begin = 0;
+
+    /// Offset of the separator behind the last element.
+    size_t end = 0;
+
+    /// Array index of the first element.
+    size_t first_index = 0;
+
+    /// Evaluated elements.
+    std::vector<Record> records;
+
+    /// Errors with array indexes of the range.
+    error errors;
+};
+
+} // namespace internal
+
+/**
+ * Evaluate a JSON document holding a huge array with multiple threads.
+ *
+ * A structural pre-scan finds the boundaries of the array elements and
+ * splits the array into ranges. Like stage 1 of simdjson, it computes
+ * bitmasks of strings for blocks of 64 bytes and visits only the
+ * brackets, braces and commas outside of strings. The ranges are evaluated by worker
+ * threads, which take ranges from a work stealing queue. Each worker
+ * has its own parser, temporary record and evaluation function, which
+ * are created before the workers start by calling `make_value_fn`
+ * sequentially in the calling thread:
+ *
+ *     auto
+ *     make_value_fn(Record *temp_record_ptr);
+ *
+ * The function created must evaluate a single array element like the
+ * `value_fn` of `array_to_out_iter()`. After all ranges are evaluated,
+ * the records are moved into `out_iter` in the order of the array and
+ * the errors are added with the same paths as by
+ * `array_to_out_iter()`.
+ *
+ * With `options.placement` the workers are pinned to NUMA nodes (see
+ * `thread_placement`), so that their parsers, padded ranges and
+ * records are allocated on the local node.
+ *
+ * @param json Padded JSON document with an array at the top level.
+ * @param out_iter Output iterator to store records.
+ * @param make_value_fn Function creating the evaluation function of an
+ *                      array element for a temporary record.
+ * @param err Pointer to error container to store errors.
+ * @param options Options of evaluation.
+ *
+ * @return Statistics of the evaluation.
+ */
+template<
+    typename Record,
+    typename OutIter,
+    typename MakeValueFn>
+inline eval_array_parallel_stats
+eval_array_parallel(
+    simdjson::padded_string_view json,
+    OutIter out_iter,
+    MakeValueFn make_value_fn,
+    error *err,
+    const eval_array_parallel_options &options =
+        eval_array_parallel_options())
+{
+    using range_type = internal::array_range<Record>;
+    using value_fn_type = decltype(make_value_fn(std::declval<Record *>()));
+
+    _SIMDJSON_PEVAL_TRACE_SET_NAME(
+        "eval_array_parallel(padded_string_view,OutIter,MakeValueFn,error*)");
+    _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+    _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+
+    eval_array_parallel_stats stats;
+    stats.threads = options.threads;
+    if (stats.threads == 0) {
+        stats.threads = std::max(size_t(std::thread::hardware_concurrency()),
+                                 size_t(1));
+    }
+
+    size_t range_size = options.range_size;
+    if (range_size == 0) {
+        // about 8 ranges per thread, but not too small.
+        range_size = std::max(json.size() / (stats.threads * 8),
+                              size_t(1) << 20);
+    }
+
+    // pre-scan: split array into ranges.
+    std::vector<range_type> ranges;
+    size_t range_begin = 0;
+    size_t range_elements = 0;
+    internal::array_scanner scanner;
+    const auto code_scan =
+        scanner.scan(
+            json,
+            [&](size_t pos, bool after_element) {
+                if (json[pos] == '[') {
+                    range_begin = pos + 1;
+                    return;
+                }
+
+                if (after_element) {
+                    ++range_elements;
+                }
+
+                // ranges behind the first element over the limit.
+                const auto *limits = err->get_limits();
+                if (limits && stats.elements > limits->max_array_elements) {
+                    if (after_element) {
+                        ++stats.elements;
+                    }
+                    range_elements = 0;
+                    return;
+                }
+
+                if (range_elements != 0
+                    && (json[pos] != ',' || pos - range_begin >= range_size))
+                {
+                    auto &range = ranges.emplace_back();
+                    range.begin = range_begin;
+                    range.end = pos;
+                    range.first_index = stats.elements;
+                    range.errors = error(err->is_path_enabled());
+                    range.errors.set_guard(err->get_guard());
+                    range.errors.set_limits(err->get_limits());
+
+                    stats.elements += range_elements;
+                    range_begin = pos + 1;
+                    range_elements = 0;
+                }
+            });
+
+    stats.ranges = ranges.size();
+    stats.threads = std::max(std::min(stats.threads, stats.ranges), size_t(1));
+
+    std::vector<Record> temp_records(stats.threads);
+    std::vector<value_fn_type> value_fns;
+    value_fns.reserve(stats.threads);
+    for (auto &temp_record : temp_records) {
+        value_fns.push_back(make_value_fn(&temp_record));
+    }
+
+    // assign consecutive ranges to each worker.
+    work_stealing_queue<range_type *> queue(stats.threads);
+    for (size_t idx = 0; idx < ranges.size(); ++idx) {
+        queue.push(idx * stats.threads / ranges.size(), &ranges[idx]);
+    }
+
+    internal::worker_placement placement(options.placement, stats.threads);
+
+    auto worker =
+        [&](size_t worker_idx) {
+            placement.enter(worker_idx);
+            simdjson::ondemand::parser parser;
+            std::vector<char> buffer;
+            auto &temp_record = temp_records[worker_idx];
+            auto &value_fn = value_fns[worker_idx];
+
+            range_type *range_ptr;
+            while (queue.pop(worker_idx, &range_ptr)) {
+                auto *range_err = &range_ptr->errors;
+
+                // copy elements of range into a padded array.
+                const auto size = range_ptr->end - range_ptr->begin + 2;
+                buffer.resize(size + simdjson::SIMDJSON_PADDING);
+                buffer[0] = '[';
+                std::memcpy(buffer.data() + 1,
+                            json.data() + range_ptr->begin, size - 2);
+                buffer[size - 1] = ']';
+
+                auto sj_doc =
+                    parser.iterate(buffer.data(), size, buffer.size());
+                auto sj_array = sj_doc.get_array();
+                if (sj_array.error()) {
+                    range_err->add(sj_array.error());
+                    continue;
+                }
+
+                size_t idx = 0;
+                for (auto sj_value : sj_array.value_unsafe()) {
+                    error::path_scope idx_scope(range_err, idx);
+                    if (range_err->exceeds_array_limit(
+                            range_ptr->first_index + idx))
+                    {
+                        break;
+                    }
+                    range_err->reset_usage();
+                    if (range_err->is_stopped()) {
+                        break;
+                    }
+                    error::record_scope record(range_err);
+                    const auto num_errors = range_err->get_count();
+                    value_fn(sj_value, range_err);
+                    if (range_err->is_rejected()) {
+                        range_err->set_rejected(false);
+                    }
+                    else {
+                        if (range_err->get_count() == num_errors) {
+                            record.commit();
+                        }
+                        range_ptr->records.push_back(std::move(temp_record));
+                    }
+                    ++idx;
+                }
+            }
+        };
+
+    std::vector<std::thread> threads;
+    threads.reserve(stats.threads);
+    for (size_t idx = 0; idx < stats.threads; ++idx) {
+        threads.emplace_back(worker, idx);
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    stats.steals = queue.get_steals();
+    stats.placement = placement.get_stats();
+
+    // concatenate results in order of the array.
+    for (auto &range : ranges) {
+        err->append(range.errors, range.first_index);
+        for (auto &record : range.records) {
+            *out_iter = std::move(record);
+            ++out_iter;
+        }
+        std::vector<Record>().swap(range.records);
+    }
+
+    if (code_scan) {
+        _SIMDJSON_PEVAL_TRACE_ERROR(code_scan);
+        err->add(code_scan);
+    }
+    else if (!scanner.is_finished()) {
+        const auto code = simdjson::INCOMPLETE_ARRAY_OR_OBJECT;
+        _SIMDJSON_PEVAL_TRACE_ERROR(code);
+        err->add(code);
+    }
+
+    _SIMDJSON_PEVAL_TRACE_EVAL_END();
+    return stats;
+}
+
+/// @}
+
+///
+/// @name Evaluate many files with multiple threads.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
+
+/**
+ * Options to evaluate many files with multiple threads.
+ */
+struct eval_files_options : eval_many_options {
+    /// Number of worker threads (`0`: number of hardware threads).
+    size_t threads = 0;
+
+    /// Approximate size of a unit of work (`0`: chosen by total size
+    /// and threads). Smaller files are evaluated as a whole.
+    size_t chunk_size = 0;
+
+    /// Split files larger than `chunk_size` at line breaks. This
+    /// requires files without line breaks in documents (NDJSON).
+    bool split_files = true;
+
+    /// Placement of the worker threads on NUMA nodes.
+    thread_placement placement = thread_placement::none;
+};
+
+/**
+ * Statistics of a single worker evaluating files.
+ */
+struct eval_files_worker_stats {
+    /// Number of units evaluated.
+    size_t units = 0;
+
+    /// Number of bytes evaluated.
+    size_t bytes = 0;
+
+    /// Number of documents evaluated.
+    size_t documents = 0;
+
+    /// Time spent reading and evaluating units.
+    std::chrono::nanoseconds busy_time{0};
+
+    /// Share of the elapsed time the worker was busy (0 to 1).
+    double utilization = 0;
+};
+
+/**
+ * Statistics of the evaluation of many files with multiple threads.
+ */
+struct eval_files_stats : eval_many_stats {
+    /// Number of files.
+    size_t files = 0;
+
+    /// Number of files which couldn't be read.
+    size_t failed_files = 0;
+
+    /// Number of units of work (files or chunks of files).
+    size_t units = 0;
+
+    /// Number of units stolen from another worker.
+    size_t steals = 0;
+
+    /// Time from the start to the end of all workers.
+    std::chrono::nanoseconds elapsed_time{0};
+
+    /// Statistics of each worker.
+    std::vector<eval_files_worker_stats> workers;
+
+    /// Placement of the worker threads.
+    placement_stats placement;
+};
+
+// @name Internal implementations
+// @private
+namespace internal {
+
+/**
+ * Unit of work: a whole file or the lines starting in a byte range
+ * of a file.
+ *
+ * @private
+ */
+template<typename Record>
+struct file_unit {
+    /// Index of the file.
+    size_t file = 0;
+
+    /// First byte of the range.
+    size_t begin = 0;
+
+    /// Byte behind the range.
+    size_t end = 0;
+
+    /// Histogram of the unit, if errors are aggregated.
+    std::optional<error_histogram> histogram;
+
+    /// Errors of the unit with document indexes of the unit.
+    error errors;
+
+    /// Statistics of the unit.
+    eval_many_stats stats;
+
+    /// Flag: file couldn't be read.
+    bool failed = false;
+};
+
+/**
+ * Read the lines starting in a byte range of a file.
+ *
+ * A line belongs to the range, if its first byte is inside. So the
+ * range is extended up to the next line break and the rest of the
+ * line starting before the range is skipped.
+ *
+ * @private
+ *
+ * @param path Path of the file.
+ * @param begin First byte of the range.
+ * @param end Byte behind the range.
+ * @param buffer_ptr Pointer to buffer to store the data.
+ * @param first_ptr Pointer to store the offset of the first line in
+ *                  the buffer.
+ *
+ * @return `false` if the file can't be read.
+ */
+inline bool
+read_file_lines(
+    const std::string &path,
+    size_t begin,
+    size_t end,
+    padded_buffer *buffer_ptr,
+    size_t *first_ptr)
+{
+    static constexpr size_t read_ahead = size_t(1) << 16;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    // read one byte before the range to find the start of a line.
+    const size_t read_begin = (begin == 0) ? 0 : begin - 1;
+    file.seekg(std::streamoff(read_begin));
+    if (!file) {
+        return false;
+    }
+
+    auto read =
+        [&](size_t size) {
+            const auto old_size = buffer_ptr->size();
+            buffer_ptr->resize(old_size + size);
+            file.read(buffer_ptr->data() + old_size, std::streamsize(size));
+            buffer_ptr->resize(old_size + size_t(file.gcount()));
+            return (size_t(file.gcount()) == size);
+        };
+
+    buffer_ptr->clear();
+    const auto size = end - read_begin;
+    bool more = read(size);
+    if (buffer_ptr->size() == 0) {
+        *first_ptr = 0;
+        return !file.bad();
+    }
+    std::string_view data(buffer_ptr->data(), buffer_ptr->size());
+
+    size_t first = 0;
+    if (begin != 0) {
+        first = data.find('\n');
+        if (first == std::string_view::npos || first + 1 >= size) {
+            // no line starts inside the range.
+            buffer_ptr->clear();
+            *first_ptr = 0;
+            return !file.bad();
+        }
+        ++first;
+    }
+
+    // complete the last line.
+    size_t search_pos = std::min(size, buffer_ptr->size()) - 1;
+    for (;;) {
+        data = std::string_view(buffer_ptr->data(), buffer_ptr->size());
+        const auto pos = data.find('\n', search_pos);
+        if (pos != std::string_view::npos) {
+            buffer_ptr->resize(pos + 1);
+            break;
+        }
+        if (!more) {
+            break;
+        }
+
+        search_pos = buffer_ptr->size();
+        more = read(read_ahead);
+    }
+
+    *first_ptr = first;
+    return !file.bad();
+}
+
+} // namespace internal
+
+/**
+ * Evaluate many files of JSON documents with multiple threads.
+ *
+ * The files are split into units of work: small files are evaluated as
+ * a whole, files larger than the chunk size are split into chunks of
+ * lines (if `options.split_files` is set). The units are evaluated by
+ * `eval_many()` in worker threads, which take units from a work
+ * stealing queue. So a few huge files don't leave the other workers
+ * idle.
+ *
+ * Each worker has its own parser, buffer, temporary record and
+ * evaluation function. The evaluation functions are created before
+ * the workers start by calling `make_proto` sequentially in the
+ * calling thread:
+ *
+ *     auto
+ *     make_proto(Record *temp_record_ptr);
+ *
+ * `batch_fn` is called by the worker threads (never concurrently) as
+ * soon as a batch is available, so the records are not in the order
+ * of the files.
+ *
+ * Errors are reported with the index of the document in all files as
+ * first path level, as if the files were concatenated. A file which
+ * can't be read is reported as `simdjson::IO_ERROR`. If `err` uses a
+ * histogram, each unit uses a histogram with the same limits, which
+ * is merged afterwards.
+ *
+ * The option `skip_documents` is only applied to the first file. If
+ * `stop_on_error` is set, no further units are started after a
+ * document with errors.
+ *
+ * With `options.placement` the workers are pinned to NUMA nodes (see
+ * `thread_placement`), so that their parsers and read buffers are
+ * allocated on the local node.
+ *
+ * @param paths Paths of the files.
+ * @param make_proto Function creating the evaluation function of a
+ *                   document for a temporary record.
+ * @param batch_fn Function called with batches of records.
+ * @param err Pointer to error container to store errors.
+ * @param options Options of evaluation.
+ *
+ * @return Statistics of the evaluation with the utilization of each
+ *         worker.
+ */
+template<
+    typename Record,
+    typename MakeProtoFn,
+    typename BatchFn>
+inline eval_files_stats
+eval_files_parallel(
+    const std::vector<std::string> &paths,
+    MakeProtoFn make_proto,
+    BatchFn batch_fn,
+    error *err,
+    const eval_files_options &options = eval_files_options())
+{
+    using unit_type = internal::file_unit<Record>;
+    using proto_type = decltype(make_proto(std::declval<Record *>()));
+
+    _SIMDJSON_PEVAL_TRACE_SET_NAME(
+        "eval_files_parallel(vector<string>,MakeProtoFn,BatchFn,error*)");
+    _SIMDJSON_PEVAL_TRACE_EVAL_BEGIN();
+    _SIMDJSON_PEVAL_ASSERT(err != nullptr);
+
+    eval_files_stats stats;
+    stats.files = paths.size();
+    size_t threads = options.threads;
+    if (threads == 0) {
+        threads = std::max(size_t(std::thread::hardware_concurrency()),
+                           size_t(1));
+    }
+
+    // size of all files (`npos`: no regular file).
+    std::vector<size_t> sizes(paths.size(), std::string::npos);
+    size_t total_size = 0;
+    for (size_t idx = 0; idx < paths.size(); ++idx) {
+        std::error_code code;
+        if (std::filesystem::is_regular_file(paths[idx], code)) {
+            const auto size = std::filesystem::file_size(paths[idx], code);
+            if (!code) {
+                sizes[idx] = size_t(size);
+                total_size += sizes[idx];
+            }
+        }
+    }
+
+    size_t chunk_size = options.chunk_size;
+    if (chunk_size == 0) {
+        // about 8 units per thread, but not too small.
+        chunk_size = std::max(total_size / (threads * 8), size_t(1) << 20);
+    }
+
+    std::vector<unit_type> units;
+    for (size_t idx = 0; idx < paths.size(); ++idx) {
+        if (sizes[idx] == std::string::npos) {
+            auto &unit = units.emplace_back();
+            unit.file = idx;
+            unit.failed = true;
+            continue;
+        }
+
+        size_t begin = 0;
+        do {
+            auto &unit = units.emplace_back();
+            unit.file = idx;
+            unit.begin = begin;
+            unit.end =
+                (options.split_files && sizes[idx] - begin > chunk_size)
+                ? begin + chunk_size
+                : sizes[idx];
+            begin = unit.end;
+        } while (begin < sizes[idx]);
+    }
+
+    stats.units = units.size();
+    threads = std::max(std::min(threads, stats.units), size_t(1));
+    stats.workers.resize(threads);
+
+    // empty histogram with the limits of `err`.
+    std::optional<error_histogram> empty_histogram;
+    if (err->get_histogram()) {
+        empty_histogram.emplace(*err->get_histogram());
+        empty_histogram->clear();
+    }
+
+    std::vector<Record> temp_records(threads);
+    std::vector<proto_type> protos;
+    protos.reserve(threads);
+    for (auto &temp_record : temp_records) {
+        protos.push_back(make_proto(&temp_record));
+    }
+
+    // assign consecutive units to each worker.
+    work_stealing_queue<unit_type *> queue(threads);
+    for (size_t idx = 0; idx < units.size(); ++idx) {
+        if (!units[idx].failed) {
+            queue.push(idx * threads / units.size(), &units[idx]);
+        }
+    }
+
+    std::mutex sink_mutex;
+    std::atomic<bool> stop{false};
+
+    internal::worker_placement placement(options.placement, threads);
+
+    auto worker =
+        [&](size_t worker_idx) {
+            placement.enter(worker_idx);
+            simdjson::ondemand::parser parser;
+            padded_buffer buffer(0, options.huge_pages);
+            auto &worker_stats = stats.workers[worker_idx];
+
+            // the batch size is tuned over all units of the worker.
+            internal::batch_tuning tuning(options);
+
+            unit_type *unit_ptr;
+            while (!stop.load(std::memory_order_relaxed)
+                   && queue.pop(worker_idx, &unit_ptr))
+            {
+                const auto start = std::chrono::steady_clock::now();
+
+                if (empty_histogram) {
+                    unit_ptr->histogram.emplace(*empty_histogram);
+                    unit_ptr->errors = error(&*unit_ptr->histogram);
+                }
+                else {
+                    unit_ptr->errors = error(err->is_path_enabled());
+                }
+                unit_ptr->errors.set_guard(err->get_guard());
+                unit_ptr->errors.set_limits(err->get_limits());
+
+                size_t first = 0;
+                if (!internal::read_file_lines(
+                        paths[unit_ptr->file], unit_ptr->begin,
+                        unit_ptr->end, &buffer, &first))
+                {
+                    unit_ptr->failed = true;
+                    continue;
+                }
+
+                auto unit_options = eval_many_options(options);
+                if (unit_ptr->file != 0 || unit_ptr->begin != 0) {
+                    unit_options.skip_documents = 0;
+                }
+
+                simdjson::padded_string_view unit_json(
+                    buffer.data() + first, buffer.size() - first,
+                    buffer.get_capacity() + simdjson::SIMDJSON_PADDING
+                    - first);
+
+                auto unit_batch_fn =
+                    [&](record_batch<Record> *batch, error *unit_err) {
+                        std::lock_guard<std::mutex> lock(sink_mutex);
+                        batch_fn(batch, unit_err);
+                    };
+                unit_ptr->stats =
+                    internal::eval_many_tuned(
+                        &parser, unit_json,
+                        &temp_records[worker_idx], protos[worker_idx],
+                        unit_batch_fn, &unit_ptr->errors, unit_options,
+                        &tuning);
+
+                if (options.stop_on_error
+                    && unit_ptr->stats.failed_documents != 0)
+                {
+                    stop.store(true, std::memory_order_relaxed);
+                }
+
+                ++worker_stats.units;
+                worker_stats.bytes += unit_json.size();
+                worker_stats.documents += unit_ptr->stats.documents;
+                worker_stats.busy_time +=
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start);
+            }
+        };
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (size_t idx = 0; idx < threads; ++idx) {
+        workers.emplace_back(worker, idx);
+    }
+
+    for (auto &thread : workers) {
+        thread.join();
+    }
+
+    stats.elapsed_time =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start);
+    stats.steals = queue.get_steals();
+    stats.placement = placement.get_stats();
+
+    for (auto &worker_stats : stats.workers) {
+        if (stats.elapsed_time.count() != 0) {
+            worker_stats.utilization =
+                double(worker_stats.busy_time.count())
+                / double(stats.elapsed_time.count());
+        }
+    }
+
+    // merge errors in order of the files.
+    size_t doc_offset = 0;
+    size_t failed_file = paths.size();
+    for (auto &unit : units) {
+        if (unit.failed) {
+            if (failed_file != unit.file) {
+                failed_file = unit.file;
+                ++stats.failed_files;
+                _SIMDJSON_PEVAL_TRACE_ERROR(simdjson::IO_ERROR);
+                err->add(simdjson::IO_ERROR);
+            }
+            continue;
+        }
+
+        err->append(unit.errors, doc_offset);
+        doc_offset +=
+            unit.stats.skipped_documents + unit.stats.documents
+            + unit.stats.prefiltered_documents;
+
+        stats.documents += unit.stats.documents;
+        stats.skipped_documents += unit.stats.skipped_documents;
+        stats.records += unit.stats.records;
+        stats.failed_documents += unit.stats.failed_documents;
+        stats.rejected_documents += unit.stats.rejected_documents;
+        stats.prefiltered_documents += unit.stats.prefiltered_documents;
+        stats.truncated_bytes += unit.stats.truncated_bytes;
+        stats.batch_size = std::max(stats.batch_size, unit.stats.batch_size);
+        stats.batch_size_changes += unit.stats.batch_size_changes;
+    }
+
+    _SIMDJSON_PEVAL_TRACE_EVAL_END();
+    return stats;
+}
+
+/// @}
+
+///
+/// @name Pools of parsers.
+//  /////////////////////////////////////////////////////////////////////
+/// @{
+
+/**
+ * Options of a parser pool.
+ */
+struct parser_pool_options {
+    /// Maximum capacity of each parser. Larger documents are rejected
+    /// by the parser with `simdjson::CAPACITY`.
+    size_t max_capacity = simdjson::SIMDJSON_MAXSIZE_BYTES;
+
+    /// Parsers with a larger capacity are shrunk, when they are
+    /// returned to the pool.
+    size_t high_water_mark = size_t(16) << 20;
+
+    /// Maximum number of idle parsers kept (`0`: number of hardware
+    /// threads).
+    size_t max_idle = 0;
+};
+
+/**
+ * Statistics of a parser pool.
+ */
+struct parser_pool_stats {
+    /// Number of parsers handed out.
+    size_t acquired = 0;
+
+    /// Number of parsers created.
+    size_t created = 0;
+
+    /// Number of parsers handed out again.
+    size_t reused = 0;
+
+    /// Number of parsers shrunk because of the high-water mark.
+    size_t shrunk = 0;
+
+    /// Number of parsers released because too many were idle.
+    size_t released = 0;
+
+    /// Number of idle parsers.
+    size_t idle = 0;
+
+    /// Sum of the capacities of idle parsers.
+    size_t idle_capacity = 0;
+};
+
+/**
+ * Thread safe pool of reusable parsers.
+ *
+ * Parsers are handed out by `acquire()` to a thread or a task and are
+ * returned, when the handle is destroyed. So a parser is not
+ * constructed per request and its buffers are reused.
+ *
+ * The buffers of a parser grow to the largest document it has
+ * seen. To keep the memory bounded, each parser is limited to
+ * `max_capacity`, parsers grown beyond `high_water_mark` are shrunk
+ * when they are returned, and at most `max_idle` parsers are kept.
+ *
+ * The pool must live longer than all its handles.
+ */
+class parser_pool {
+public:
+
+    /**
+     * Parser handed out by the pool.
+     *
+     * The parser is returned to the pool by the destructor.
+     */
+    class handle {
+    public:
+
+        /**
+         * Constructor of an empty handle.
+         */
+        handle() = default;
+
+        handle(const handle &) = delete;
+        handle &operator=(const handle &) = delete;
+
+        /**
+         * Move constructor.
+         */
+        handle(handle &&other) noexcept
+            : pool(std::exchange(other.pool, nullptr))
+            , parser(std::move(other.parser))
+        { /* empty */ }
+
+        /**
+         * Move assignment.
+         */
+        handle &
+        operator=(handle &&other) noexcept {
+            if (this != &other) {
+                reset();
+                pool = std::exchange(other.pool, nullptr);
+                parser = std::move(other.parser);
+            }
+
+            return *this;
+        }
+
+        /**
+         * Destructor. Returns the parser to the pool.
+         */
+        ~handle() {
+            reset();
+        }
+
+        /**
+         * Return the parser to the pool.
+         */
+        void
+        reset() {
+            if (parser) {
+                pool->release(std::move(parser));
+            }
+            pool = nullptr;
+        }
+
+        /// Pointer to the parser (e.g. to pass to `eval_many()`).
+        simdjson::ondemand::parser *
+        get() const {
+            return parser.get();
+        }
+
+        /// Access the parser.
+        simdjson::ondemand::parser *
+        operator->() const {
+            return parser.get();
+        }
+
+        /// Access the parser.
+        simdjson::ondemand::parser &
+        operator*() const {
+            return *parser;
+        }
+
+    private:
+        friend class parser_pool;
+
+        handle(
+            parser_pool *pool,
+            std::unique_ptr<simdjson::ondemand::parser> parser)
+            : pool(pool)
+            , parser(std::move(parser))
+        { /* empty */ }
+
+        /// pool to return the parser to.
+        parser_pool *pool = nullptr;
+
+        /// parser handed out.
+        std::unique_ptr<simdjson::ondemand::parser> parser;
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param options Options of the pool.
+     */
+    explicit parser_pool(const parser_pool_options &options = {})
+        : options(options)
+    {
+        if (this->options.max_idle == 0) {
+            this->options.max_idle =
+                std::max(size_t(std::thread::hardware_concurrency()),
+                         size_t(1));
+        }
+    }
+
+    parser_pool(const parser_pool &) = delete;
+    parser_pool &operator=(const parser_pool &) = delete;
+
+    /**
+     * Hand out an idle or a new parser.
+     */
+    handle
+    acquire();
+
+    /**
+     * Release all idle parsers.
+     */
+    void
+    clear();
+
+    /**
+     * Get statistics of the pool.
+     */
+    parser_pool_stats
+    get_stats() const;
+
+private:
+
+    /**
+     * Take back a parser.
+     */
+    void
+    release(std::unique_ptr<simdjson::ondemand::parser> parser);
+
+    /// options of the pool.
+    parser_pool_options options;
+
+    /// protects the idle parsers and the statistics.
+    mutable std::mutex mutex;
+
+    /// idle parsers (last returned at the back).
+    std::vector<std::unique_ptr<simdjson::ondemand::parser>> idle;
+
+    /// statistics without idle parsers.
+    parser_pool_stats stats;
+
+}; // class parser_pool
+
+/// @}
+
+
+
+// inline implementations of class parser_pool
+// //////////////////////////////////////////////////////////////////////
+
+inline parser_pool::handle
+parser_pool::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++stats.acquired;
+        if (!idle.empty()) {
+            // the last returned parser has the warmest buffers.
+            auto parser = std::move(idle.back());
+            idle.pop_back();
+            ++stats.reused;
+            return handle(this, std::move(parser));
+        }
+        ++stats.created;
+    }
+
+    return
+        handle(
+            this,
+            std::make_unique<simdjson::ondemand::parser>(
+                options.max_capacity));
+}
+
+inline void
+parser_pool::release(std::unique_ptr<simdjson::ondemand::parser> parser) {
+    if (parser->capacity() > options.high_water_mark) {
+        // release the buffers by replacing the parser.
+        *parser = simdjson::ondemand::parser(options.max_capacity);
+        std::lock_guard<std::mutex> lock(mutex);
+        ++stats.shrunk;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (idle.size() < options.max_idle) {
+        idle.push_back(std::move(parser));
+    }
+    else {
+        ++stats.released;
+    }
+}
+
+inline void
+parser_pool::clear() {
+    std::vector<std::unique_ptr<simdjson::ondemand::parser>> old_idle;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.released += idle.size();
+        old_idle.swap(idle);
+    }
+}
+
+inline parser_pool_stats
+parser_pool::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto result = stats;
+    result.idle = idle.size();
+    for (const auto &parser : idle) {
+        result.idle_capacity += parser->capacity();
+    }
+
+    return result;
+}
+
+} // namespace simdjson_peval
+
+
+#endif /* SIMDJSON_PEVAL_PARALLEL_H */
@@ -0,0 +1,289 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define _SIMDJSON_PEVAL_DO_TRACE 1
+// test slices of truncated documents.
+#define SIMDJSON_EXPERIMENTAL_ALLOW_INCOMPLETE_JSON 1
+#include "simdjson_peval.h"
+
+#include "gtest/gtest.h"
+
+#include "TestUtils.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+/// Create prototype to store numbers and count evaluated elements.
+auto
+makeNumberProto(int64_t *tmp_value, size_t *num_evals) {
+    using namespace simdjson_peval;
+
+    return
+        value(
+            [tmp_value, num_evals](auto *sj_value, error *err) {
+                ++*num_evals;
+                number_value(tmp_value)(*sj_value, err);
+            });
+}
+
+} // namespace
+
+
+TEST(ArraySlice, ArrayToOutIter) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    auto json = R"([0,1,2,3,4,5,6,7])"_padded;
+    auto doc = parser.iterate(json);
+
+    std::vector<int64_t> values;
+    int64_t tmp_value = 0;
+    size_t num_evals = 0;
+    auto proto =
+        slice<simdjson::ondemand::document>(
+            2, 5,
+            array_to_out_iter<simdjson::ondemand::document>(
+                back_inserter(values), &tmp_value,
+                makeNumberProto(&tmp_value, &num_evals)));
+
+    error errors(true);
+    proto(doc, &errors);
+
+    EXPECT_FALSE(errors);
+    EXPECT_EQ(values, std::vector<int64_t>({2, 3, 4}));
+
+    // elements outside of the slice are not evaluated.
+    EXPECT_EQ(num_evals, 3u);
+}
+
+
+TEST(ArraySlice, TakeArrayToFunction) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    auto json = R"([0,1,2,3])"_padded;
+    auto doc = parser.iterate(json);
+
+    std::vector<size_t> indices;
+    auto proto =
+        take<simdjson::ondemand::document>(
+            2,
+            array_to_function<simdjson::ondemand::document>(
+                [&indices](size_t idx, auto *, error *) {
+                    indices.push_back(idx);
+                }));
+
+    error errors(true);
+    proto(doc, &errors);
+
+    EXPECT_FALSE(errors);
+    EXPECT_EQ(indices, std::vector<size_t>({0, 1}));
+}
+
+
+TEST(ArraySlice, TruncatedDocument) {
+    using namespace simdjson_peval;
+
+    // prefix of a huge array, cut within an element.
+    simdjson::ondemand::parser parser;
+    auto json = R"([{"id":0},{"id":1},{"id":2},{"id":3},{"id":)"_padded;
+
+    std::vector<int64_t> ids;
+    int64_t tmp_id = 0;
+    auto proto =
+        take<simdjson::ondemand::document>(
+            3,
+            array_to_out_iter<simdjson::ondemand::document>(
+                back_inserter(ids), &tmp_id,
+                object(member("id", number_value(&tmp_id)))));
+
+    auto doc = parser.iterate_allow_incomplete_json(json);
+    error errors(true);
+    proto(doc, &errors);
+
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+    EXPECT_EQ(ids, std::vector<int64_t>({0, 1, 2}));
+
+}
+
+
+TEST(ArraySlice, ArrayToBatch) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    auto json = R"([0,1,2,3,4,5,6,7])"_padded;
+    auto doc = parser.iterate(json);
+
+    std::vector<int64_t> values;
+    int64_t tmp_value = 0;
+    size_t num_evals = 0;
+    record_batch<int64_t> batch(2);
+    auto proto =
+        slice<simdjson::ondemand::document>(
+            5, 100,
+            array_to_batch<simdjson::ondemand::document>(
+                [&values](record_batch<int64_t> *batch_ptr, error *) {
+                    for (auto value : *batch_ptr) {
+                        values.push_back(value);
+                    }
+                },
+                &batch, &tmp_value, makeNumberProto(&tmp_value, &num_evals)));
+
+    error errors(true);
+    proto(doc, &errors);
+
+    EXPECT_FALSE(errors);
+    EXPECT_EQ(values, std::vector<int64_t>({5, 6, 7}));
+    EXPECT_EQ(num_evals, 3u);
+}
+
+
+TEST(ArraySlice, StopEarly) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    auto json = R"([0,1,nul,{"x":tru}])"_padded;
+
+    std::vector<int64_t> values;
+    int64_t tmp_value = 0;
+    size_t num_evals = 0;
+    auto proto =
+        take<simdjson::ondemand::document>(
+            2,
+            array_to_out_iter<simdjson::ondemand::document>(
+                back_inserter(values), &tmp_value,
+                makeNumberProto(&tmp_value, &num_evals)));
+
+    auto doc = parser.iterate(json);
+    error errors(true);
+    proto(doc, &errors);
+
+    // the invalid elements behind the slice are not read.
+    EXPECT_FALSE(errors);
+    EXPECT_EQ(values, std::vector<int64_t>({0, 1}));
+
+    // without a slice they are.
+    auto all_proto =
+        array_to_out_iter<simdjson::ondemand::document>(
+            back_inserter(values), &tmp_value,
+            makeNumberProto(&tmp_value, &num_evals));
+
+    doc = parser.iterate(json);
+    errors.reset();
+    all_proto(doc, &errors);
+
+    EXPECT_TRUE(errors);
+}
+
+
+TEST(ArraySlice, Nested) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    auto json =
+        R"({"pages":[[1,2],[3,4,5],[6],[7,8]],"id":7})"_padded;
+    auto doc = parser.iterate(json);
+
+    std::vector<std::vector<int64_t>> pages;
+    std::vector<int64_t> tmp_page;
+    int64_t tmp_value = 0;
+    size_t num_evals = 0;
+    int64_t id = 0;
+    auto proto =
+        object<simdjson::ondemand::document>(
+            member(
+                "pages",
+                slice(
+                    1, 3,
+                    array_to_out_iter(
+                        back_inserter(pages), &tmp_page,
+                        value(
+                            [&](auto *sj_value, error *err) {
+                                tmp_page.clear();
+                                array_to_out_iter(
+                                    back_inserter(tmp_page), &tmp_value,
+                                    makeNumberProto(&tmp_value, &num_evals))(
+                                        *sj_value, err);
+                            })))),
+            member("id", number_value(&id)));
+
+    error errors(true);
+    proto(doc, &errors);
+
+    // the slice is not applied to the inner arrays.
+    EXPECT_FALSE(errors);
+    EXPECT_EQ(
+        pages,
+        std::vector<std::vector<int64_t>>({{3, 4, 5}, {6}}));
+    EXPECT_EQ(num_evals, 4u);
+    EXPECT_EQ(id, 7);
+}
+
+
+TEST(ArraySlice, Errors) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    auto json = R"({"a":[0,1,"x",3],"b":1,"c":[4,5]})"_padded;
+    auto doc = parser.iterate(json);
+
+    std::vector<int64_t> a_values;
+    std::vector<int64_t> c_values;
+    int64_t tmp_value = 0;
+    size_t num_evals = 0;
+    auto proto =
+        object<simdjson::ondemand::document>(
+            member(
+                "a",
+                slice(
+                    2, 4,
+                    array_to_out_iter(
+                        back_inserter(a_values), &tmp_value,
+                        makeNumberProto(&tmp_value, &num_evals)))),
+            member(
+                "b",
+                take(
+                    1,
+                    array_to_out_iter(
+                        back_inserter(a_values), &tmp_value,
+                        makeNumberProto(&tmp_value, &num_evals)))),
+            member(
+                "c",
+                array_to_out_iter(
+                    back_inserter(c_values), &tmp_value,
+                    makeNumberProto(&tmp_value, &num_evals))));
+
+    error errors(true);
+    proto(doc, &errors);
+
+    // errors keep the array indices; the slice of a type error does
+    // not apply to the next array.
+    sp_test::checkErrors(
+        errors,
+        {{simdjson::INCORRECT_TYPE, "<root>.a[2]"},
+         {simdjson::INCORRECT_TYPE, "<root>.b"}});
+    EXPECT_EQ(c_values, std::vector<int64_t>({4, 5}));
+}
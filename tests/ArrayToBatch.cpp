@@ -0,0 +1,186 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define _SIMDJSON_PEVAL_DO_TRACE 1
+#include "simdjson_peval.h"
+
+#include "gtest/gtest.h"
+
+#include "TestUtils.h"
+
+#include <vector>
+
+using namespace simdjson::builtin;
+
+namespace {
+
+struct Item {
+    int64_t id;
+    std::string name;
+
+    bool
+    operator==(const Item &other) const {
+        return (id == other.id && name == other.name);
+    }
+};
+
+} // namespace
+
+
+TEST(ArrayToBatch, Batches) {
+    using namespace simdjson_peval;
+
+    auto json =
+        R"( {"items": [{"id":1,"name":"a"}, {"id":2,"name":"b"},
+                       {"id":"x","name":"c"}, {"id":4,"name":"d"},
+                       {"id":5,"name":"e"}, {"id":6,"name":"f"}]} )"_padded;
+
+    simdjson::ondemand::parser parser;
+    auto sj_doc = parser.iterate(json);
+
+    Item tmp_item;
+    record_batch<Item> batch(2);
+    std::vector<size_t> batch_sizes;
+    std::vector<Item> items;
+
+    auto eval_fn =
+        object<simdjson::ondemand::document>(
+            member("items",
+                   array_to_batch(
+                       [&](record_batch<Item> *batch, error *err) {
+                           batch_sizes.push_back(batch->size());
+                           std::move(
+                               batch->data(), batch->data() + batch->size(),
+                               back_inserter(items));
+                       },
+                       &batch, &tmp_item,
+                       object(
+                           member("id", number_value(&tmp_item.id)),
+                           member("name", string_value(&tmp_item.name))))));
+
+    error errors(true);
+    eval_fn(sj_doc, &errors);
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>.items[2].id"}
+            }));
+    EXPECT_EQ(batch_sizes, std::vector<size_t>({2, 2, 1}));
+    EXPECT_EQ(
+        items,
+        std::vector<Item>(
+            {{1, "a"}, {2, "b"}, {4, "d"}, {5, "e"}, {6, "f"}}));
+    EXPECT_TRUE(batch.empty());
+    EXPECT_EQ(batch.get_capacity(), 2u);
+}
+
+
+TEST(ArrayToBatch, EmptyAndNull) {
+    using namespace simdjson_peval;
+
+    auto json = R"( {"a": [], "b": null, "c": [7]} )"_padded;
+
+    simdjson::ondemand::parser parser;
+    auto sj_doc = parser.iterate(json);
+
+    int64_t tmp_value;
+    record_batch<int64_t> batch(16);
+    size_t num_batches = 0;
+    std::vector<int64_t> values;
+    auto save_values =
+        [&](record_batch<int64_t> *batch, error *err) {
+            ++num_batches;
+            values.insert(values.end(), batch->begin(), batch->end());
+        };
+
+    bool b_is_null = false;
+    auto eval_fn =
+        object<simdjson::ondemand::document>(
+            member("a",
+                   array_to_batch(
+                       save_values, &batch, &tmp_value,
+                       number_value(&tmp_value))),
+            member("b",
+                   array_to_batch(
+                       &b_is_null, save_values, &batch, &tmp_value,
+                       number_value(&tmp_value))),
+            member("c",
+                   array_to_batch(
+                       save_values, &batch, &tmp_value,
+                       number_value(&tmp_value))));
+
+    error errors(true);
+    eval_fn(sj_doc, &errors);
+
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+    EXPECT_TRUE(b_is_null);
+    EXPECT_EQ(num_batches, 1u);
+    EXPECT_EQ(values, std::vector<int64_t>({7}));
+}
+
+
+TEST(ArrayToBatch, NoArray) {
+    using namespace simdjson_peval;
+
+    auto json = R"( {"id":1} )"_padded;
+
+    simdjson::ondemand::parser parser;
+    auto sj_doc = parser.iterate(json);
+
+    int64_t tmp_value;
+    record_batch<int64_t> batch(4);
+    size_t num_batches = 0;
+    auto eval_fn =
+        array_to_batch<simdjson::ondemand::document>(
+            [&](record_batch<int64_t> *batch, error *err) { ++num_batches; },
+            &batch, &tmp_value, number_value(&tmp_value));
+
+    error errors(true);
+    eval_fn(sj_doc, &errors);
+
+    EXPECT_EQ(num_batches, 0u);
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>"}
+            }));
+}
+
+#ifdef __cpp_concepts
+
+TEST(ArrayToBatch, Concept) {
+    using namespace simdjson_peval;
+
+    auto sink = [](record_batch<int64_t> *batch, error *err) {};
+    auto other = [](int64_t value) {};
+
+    static_assert(batch_sink<decltype(sink), int64_t>);
+    static_assert(!batch_sink<decltype(sink), std::string>);
+    static_assert(!batch_sink<decltype(other), int64_t>);
+}
+
+#endif // __cpp_concepts
@@ -0,0 +1,299 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define _SIMDJSON_PEVAL_DO_TRACE 1
+#include "simdjson_peval_io.h"
+#include "simdjson_peval_parallel.h"
+
+#include "gtest/gtest.h"
+
+#include "TestUtils.h"
+
+#include <vector>
+
+namespace {
+
+using sp_test::Item;
+using sp_test::TempFiles;
+using sp_test::createItems;
+using sp_test::makeItemProto;
+using sp_test::makeSaveItems;
+
+/// Evaluate all items of the files.
+std::vector<Item>
+evalFiles(
+    const std::vector<std::string> &paths,
+    const simdjson_peval::async_file_options &options,
+    simdjson_peval::error *errors)
+{
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    Item tmp_item;
+
+    eval_pipeline_options pipeline_options;
+    pipeline_options.block_size = 4096;
+
+    std::vector<Item> items;
+    eval_many_pipeline(
+        &parser, async_file_source(paths, options), &tmp_item,
+        makeItemProto(&tmp_item),
+        makeSaveItems(&items),
+        errors, pipeline_options);
+
+    return items;
+}
+
+/// Evaluate all items of the files in place.
+std::vector<Item>
+evalFilesInPlace(
+    const std::vector<std::string> &paths,
+    const simdjson_peval::async_file_options &options,
+    simdjson_peval::error *errors)
+{
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    Item tmp_item;
+
+    eval_many_options many_options;
+    many_options.records_per_batch = 100;
+
+    std::vector<Item> items;
+    async_file_source source(paths, options);
+    const auto stats =
+        eval_files_async(
+            &parser, &source, &tmp_item, makeItemProto(&tmp_item),
+            makeSaveItems(&items),
+            errors, many_options);
+
+    EXPECT_EQ(stats.records, items.size());
+    return items;
+}
+
+/// Read all bytes of a source.
+std::string
+readAll(simdjson_peval::async_file_source *source, size_t piece_size) {
+    std::string result;
+    std::vector<char> buffer(piece_size);
+    for (;;) {
+        auto size = (*source)(buffer.data(), buffer.size());
+        EXPECT_FALSE(size.error());
+        if (size.error() || size.value_unsafe() == 0) {
+            break;
+        }
+        result.append(buffer.data(), size.value_unsafe());
+    }
+
+    return result;
+}
+
+} // namespace
+
+
+TEST(AsyncFileSource, Files) {
+    using namespace simdjson_peval;
+
+    TempFiles files;
+    files.add(createItems(1000));
+    files.add("");
+    files.add(createItems(10, {}, 1000));
+    files.add(createItems(3000, {}, 1010));
+
+    for (const auto use_uring : {true, false}) {
+        async_file_options options;
+        options.block_size = 1000;
+        options.queue_depth = 3;
+        options.use_uring = use_uring;
+
+        error errors(true);
+        const auto items = evalFiles(files.paths, options, &errors);
+
+        EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+        ASSERT_EQ(items.size(), 4010u);
+        for (size_t idx = 0; idx < items.size(); ++idx) {
+            ASSERT_EQ(items[idx], (Item{int64_t(idx), "item" + std::to_string(idx)}));
+        }
+    }
+}
+
+
+TEST(AsyncFileSource, InPlace) {
+    using namespace simdjson_peval;
+
+    TempFiles files;
+    files.add(createItems(1000));
+    files.add("");
+    files.add(createItems(10, {}, 1000));
+    files.add(createItems(3000, {}, 1010));
+
+    // blocks smaller than a line, too.
+    for (const auto block_size : {size_t(10), size_t(1000)}) {
+        for (const auto use_uring : {true, false}) {
+            async_file_options options;
+            options.block_size = block_size;
+            options.queue_depth = 3;
+            options.use_uring = use_uring;
+
+            error errors(true);
+            const auto items = evalFilesInPlace(files.paths, options, &errors);
+
+            EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+            ASSERT_EQ(items.size(), 4010u);
+            for (size_t idx = 0; idx < items.size(); ++idx) {
+                ASSERT_EQ(items[idx], (Item{int64_t(idx), "item" + std::to_string(idx)}));
+            }
+        }
+    }
+
+    // missing file after a valid one.
+    error errors(true);
+    evalFilesInPlace(
+        {files.paths[0], "/nonexistent/simdjson_peval.json"},
+        async_file_options(), &errors);
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::IO_ERROR, "<root>"}
+            }));
+}
+
+
+TEST(AsyncFileSource, NextLines) {
+    using namespace simdjson_peval;
+
+    TempFiles files;
+    files.add("{\"id\":1}");
+    files.add("{\"id\":2}\n{\"id\":3}\n");
+    files.add("{\"id\":4}");
+
+    for (const auto block_size : {size_t(1), size_t(12), size_t(100)}) {
+        async_file_options options;
+        options.block_size = block_size;
+
+        async_file_source source(files.paths, options);
+        std::vector<std::string> views;
+        for (;;) {
+            simdjson::padded_string_view json;
+            ASSERT_EQ(source.next_lines(&json), simdjson::SUCCESS);
+            if (json.size() == 0) {
+                break;
+            }
+            views.emplace_back(json.data(), json.size());
+        }
+
+        // the views contain complete lines of one file.
+        const auto expected =
+            (block_size == 100
+             ? std::vector<std::string>({
+                     "{\"id\":1}", "{\"id\":2}\n{\"id\":3}\n", "{\"id\":4}"})
+             : std::vector<std::string>({
+                     "{\"id\":1}", "{\"id\":2}\n", "{\"id\":3}\n",
+                     "{\"id\":4}"}));
+        EXPECT_EQ(views, expected);
+        EXPECT_EQ(source.get_stats().files, 3u);
+        EXPECT_EQ(source.get_stats().bytes, 34u);
+    }
+}
+
+
+TEST(AsyncFileSource, LineBreaks) {
+    using namespace simdjson_peval;
+
+    TempFiles files;
+    files.add("{\"id\":1}");
+    files.add("{\"id\":2}\n");
+    files.add("{\"id\":3}");
+
+    for (const auto block_size : {size_t(1), size_t(3), size_t(100)}) {
+        async_file_options options;
+        options.block_size = block_size;
+
+        async_file_source source(files.paths, options);
+        EXPECT_EQ(
+            readAll(&source, 2), "{\"id\":1}\n{\"id\":2}\n{\"id\":3}\n");
+        EXPECT_EQ(source.get_stats().files, 3u);
+        EXPECT_EQ(source.get_stats().bytes, 25u);
+    }
+}
+
+
+TEST(AsyncFileSource, Errors) {
+    using namespace simdjson_peval;
+
+    TempFiles files;
+    files.add(createItems(10));
+
+    for (const auto use_uring : {true, false}) {
+        async_file_options options;
+        options.use_uring = use_uring;
+
+        // missing file after a valid one.
+        error errors(true);
+        auto items =
+            evalFiles(
+                {files.paths[0], "/nonexistent/simdjson_peval.json"},
+                options, &errors);
+        EXPECT_EQ(errors.get_messages().size(), 1u);
+        EXPECT_EQ(errors.get_messages().at(0).get_code(), simdjson::IO_ERROR);
+
+        // directory.
+        errors.clear();
+        items = evalFiles({"/tmp"}, options, &errors);
+        EXPECT_TRUE(items.empty());
+        EXPECT_EQ(errors.get_messages().size(), 1u);
+
+        // no files.
+        errors.clear();
+        items = evalFiles({}, options, &errors);
+        EXPECT_TRUE(items.empty());
+        EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+    }
+}
+
+
+TEST(AsyncFileSource, Stats) {
+    using namespace simdjson_peval;
+
+    TempFiles files;
+    const auto data = createItems(100);
+    files.add(data);
+
+    async_file_options options;
+    options.block_size = 256;
+    options.queue_depth = 2;
+
+    async_file_source source(files.paths, options);
+    const auto result = readAll(&source, 4096);
+    EXPECT_EQ(result, data);
+
+    const auto &stats = source.get_stats();
+    EXPECT_EQ(stats.files, 1u);
+    EXPECT_EQ(stats.bytes, data.size());
+    EXPECT_GE(stats.reads, (data.size() + 255) / 256);
+
+    // a source may be destroyed before all reads are done.
+    async_file_source unread(files.paths, options);
+}
@@ -0,0 +1,394 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define _SIMDJSON_PEVAL_DO_TRACE 1
+#include "simdjson_peval_parallel.h"
+
+#include "gtest/gtest.h"
+
+#include "TestUtils.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// Create an array with the numbers 0 ... num_items-1.
+std::string
+createNumberArray(size_t num_items) {
+    std::string result = "[";
+    for (size_t idx = 0; idx < num_items; ++idx) {
+        if (idx != 0) {
+            result += ',';
+        }
+        result += std::to_string(idx);
+    }
+
+    return result + "]";
+}
+
+/// Create NDJSON input with the given number of documents.
+std::string
+createDocuments(size_t num_docs) {
+    std::string result;
+    for (size_t idx = 0; idx < num_docs; ++idx) {
+        result += R"({"id":)" + std::to_string(idx) + "}\n";
+    }
+
+    return result;
+}
+
+/// Evaluate array of numbers and cancel the token at the given value.
+std::vector<int64_t>
+evalNumbers(
+    std::string_view raw_json,
+    simdjson_peval::cancellation_token *token,
+    int64_t cancel_value,
+    simdjson_peval::error *errors)
+{
+    using namespace simdjson_peval;
+
+    std::vector<int64_t> result;
+    auto proto =
+        object<simdjson::ondemand::document>(
+            member(
+                "values",
+                array_to_function(
+                    [&](size_t, auto *sj_value, error *err) {
+                        int64_t val = 0;
+                        number_value(&val)(*sj_value, err);
+                        result.push_back(val);
+                        if (val == cancel_value) {
+                            token->cancel();
+                        }
+                    })));
+
+    simdjson::ondemand::parser parser;
+    auto json =
+        simdjson::padded_string(
+            "{\"values\":" + std::string(raw_json) + "}");
+    auto doc = parser.iterate(json);
+    proto(doc, errors);
+
+    return result;
+}
+
+/// Wait up to 10 seconds until the condition is true.
+template<typename CondFn>
+void
+waitFor(CondFn cond_fn) {
+    for (int idx = 0; idx < 10000 && !cond_fn(); ++idx) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+} // namespace
+
+
+TEST(Cancellation, Token) {
+    using namespace simdjson_peval;
+
+    cancellation_token token;
+    eval_guard guard(&token);
+
+    error errors(true);
+    errors.set_guard(&guard);
+    EXPECT_EQ(errors.get_guard(), &guard);
+
+    const auto values =
+        evalNumbers(createNumberArray(10), &token, 3, &errors);
+
+    EXPECT_EQ(values, std::vector<int64_t>({0, 1, 2, 3}));
+    EXPECT_TRUE(token.is_cancelled());
+    EXPECT_EQ(guard.get_stop_code(), CANCELLED);
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {CANCELLED, "<root>.values[4]"}
+            }));
+
+    // rearm guard and token for the next evaluation.
+    token.reset();
+    guard.reset();
+    errors.clear();
+    errors.set_guard(&guard);
+
+    const auto all_values =
+        evalNumbers(createNumberArray(10), &token, -1, &errors);
+
+    EXPECT_EQ(all_values.size(), 10u);
+    EXPECT_FALSE(errors);
+    EXPECT_EQ(guard.get_stop_code(), simdjson::SUCCESS);
+}
+
+
+TEST(Cancellation, Deadline) {
+    using namespace simdjson_peval;
+
+    cancellation_token token;
+    eval_guard guard;
+    guard.set_deadline(eval_guard::clock::now());
+
+    error errors(true);
+    errors.set_guard(&guard);
+
+    const auto values =
+        evalNumbers(createNumberArray(10), &token, -1, &errors);
+
+    EXPECT_TRUE(values.empty());
+    EXPECT_EQ(guard.get_stop_code(), DEADLINE_EXCEEDED);
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {DEADLINE_EXCEEDED, "<root>.values"}
+            }));
+
+    // deadline in the future.
+    guard.reset();
+    guard.set_timeout(std::chrono::hours(1));
+    errors.clear();
+    errors.set_guard(&guard);
+
+    EXPECT_EQ(
+        evalNumbers(createNumberArray(10), &token, -1, &errors).size(),
+        10u);
+    EXPECT_FALSE(errors);
+}
+
+
+TEST(Cancellation, CheckInterval) {
+    using namespace simdjson_peval;
+
+    eval_guard guard;
+    EXPECT_EQ(guard.get_check_interval(), 1024u);
+
+    guard.set_check_interval(0);
+    EXPECT_EQ(guard.get_check_interval(), 1u);
+
+    // the clock is checked at the first boundary and every 4th after it.
+    guard.set_check_interval(4);
+    guard.set_timeout(std::chrono::hours(1));
+
+    error errors;
+    errors.set_guard(&guard);
+    EXPECT_FALSE(errors.is_stopped());
+
+    guard.set_deadline(eval_guard::clock::now());
+    EXPECT_FALSE(errors.is_stopped());
+    EXPECT_FALSE(errors.is_stopped());
+    EXPECT_FALSE(errors.is_stopped());
+    EXPECT_TRUE(errors.is_stopped());
+    EXPECT_TRUE(errors.is_stopped());
+    EXPECT_EQ(errors.get_count(), 1u);
+
+    // the token is checked at every boundary.
+    cancellation_token token;
+    eval_guard token_guard(&token);
+    token_guard.set_check_interval(1000);
+
+    error token_errors;
+    token_errors.set_guard(&token_guard);
+    EXPECT_FALSE(token_errors.is_stopped());
+    token.cancel();
+    EXPECT_TRUE(token_errors.is_stopped());
+    EXPECT_EQ(token_guard.get_stop_code(), CANCELLED);
+}
+
+
+TEST(Cancellation, EvalMany) {
+    using namespace simdjson_peval;
+
+    cancellation_token token;
+    eval_guard guard(&token);
+
+    error errors(true);
+    errors.set_guard(&guard);
+
+    simdjson::ondemand::parser parser;
+    auto json = simdjson::padded_string(createDocuments(100));
+
+    int64_t tmp_id = 0;
+    auto proto =
+        object<simdjson::ondemand::document_reference>(
+            member(
+                "id",
+                value(
+                    [&](auto *sj_value, error *err) {
+                        number_value(&tmp_id)(*sj_value, err);
+                        if (tmp_id == 9) {
+                            token.cancel();
+                        }
+                    })));
+
+    std::vector<int64_t> ids;
+    const auto stats =
+        eval_many(
+            &parser, json, &tmp_id, proto,
+            [&](record_batch<int64_t> *batch, error *) {
+                ids.insert(ids.end(), batch->begin(), batch->end());
+            },
+            &errors);
+
+    EXPECT_EQ(stats.documents, 10u);
+    EXPECT_EQ(ids.size(), 10u);
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {CANCELLED, "<root>[10]"}
+            }));
+}
+
+
+TEST(Cancellation, Parallel) {
+    using namespace simdjson_peval;
+
+    cancellation_token token;
+    token.cancel();
+    eval_guard guard(&token);
+
+    error errors(true);
+    errors.set_guard(&guard);
+
+    eval_array_parallel_options options;
+    options.threads = 4;
+    options.range_size = 64;
+
+    std::vector<int64_t> values;
+    auto json = simdjson::padded_string(createNumberArray(1000));
+    eval_array_parallel<int64_t>(
+        json, back_inserter(values),
+        [](int64_t *tmp_value) { return number_value(tmp_value); },
+        &errors, options);
+
+    // each range which saw the stop records it.
+    EXPECT_TRUE(values.empty());
+    ASSERT_GE(errors.get_count(), 1u);
+    for (const auto &message : errors.get_messages()) {
+        EXPECT_EQ(message.get_code(), CANCELLED);
+    }
+}
+
+
+TEST(Cancellation, ParallelInFlight) {
+    using namespace simdjson_peval;
+
+    struct Record {
+        int64_t id = -1;
+        int64_t a = -1;
+        int64_t b = -1;
+    };
+
+    // one document per chunk.
+    auto json =
+        simdjson::padded_string(
+            std::string(
+                "{\"id\":0,\"a\":1,\"b\":2}\n"
+                "{\"id\":1,\"a\":1,\"b\":2}\n"));
+
+    for (bool ordered : {true, false}) {
+        std::atomic<bool> in_record{false};
+        cancellation_token token;
+        eval_guard guard(&token);
+
+        error errors(true);
+        errors.set_guard(&guard);
+
+        eval_parallel_options options;
+        options.threads = 2;
+        options.chunk_size = 8;
+        options.ordered = ordered;
+
+        // the first record cancels when the second one is in evaluation.
+        auto sync_record =
+            [&](const Record *tmp) {
+                if (tmp->id == 0) {
+                    waitFor([&]() { return in_record.load(); });
+                    token.cancel();
+                }
+                else {
+                    in_record = true;
+                    waitFor([&]() { return guard.get_stop_code() != 0; });
+                }
+            };
+
+        std::vector<Record> records;
+        eval_many_parallel<Record>(
+            json,
+            [&](Record *tmp) {
+                return
+                    object<simdjson::ondemand::document_reference>(
+                        member("id", number_value(&tmp->id)),
+                        member(
+                            "a",
+                            value(
+                                [&, tmp](auto *sj_value, error *err) {
+                                    number_value(&tmp->a)(*sj_value, err);
+                                    sync_record(tmp);
+                                })),
+                        member("b", number_value(&tmp->b)));
+            },
+            [&](record_batch<Record> *batch, error *) {
+                for (const auto &record : *batch) {
+                    records.push_back(record);
+                }
+            },
+            &errors, options);
+
+        // both records in evaluation fail.
+        EXPECT_TRUE(records.empty()) << "ordered: " << ordered;
+        EXPECT_TRUE(
+            sp_test::checkErrors(
+                errors,
+                {
+                    {CANCELLED, "<root>[0].b"},
+                    {CANCELLED, "<root>[1].b"}
+                })) << "ordered: " << ordered;
+    }
+}
+
+
+TEST(Cancellation, ErrorText) {
+    using namespace simdjson_peval;
+
+    error errors;
+    errors.add(CANCELLED);
+    errors.add(DEADLINE_EXCEEDED);
+    errors.add(simdjson::INCORRECT_TYPE);
+
+    const auto &messages = errors.get_messages();
+    EXPECT_EQ(
+        messages.at(0).get_text(),
+        std::string_view("The evaluation was cancelled."));
+    EXPECT_EQ(
+        messages.at(1).get_text(),
+        std::string_view("The deadline of the evaluation was exceeded."));
+    EXPECT_EQ(
+        messages.at(2).get_text(),
+        std::string_view(simdjson::error_message(simdjson::INCORRECT_TYPE)));
+}
@@ -0,0 +1,245 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define _SIMDJSON_PEVAL_DO_TRACE 1
+#include "simdjson_peval_io.h"
+#include "simdjson_peval_parallel.h"
+
+#if defined(SIMDJSON_PEVAL_WITH_ZLIB) || defined(SIMDJSON_PEVAL_WITH_ZSTD)
+
+#include "gtest/gtest.h"
+
+#include "TestUtils.h"
+
+#include <vector>
+
+namespace {
+
+using sp_test::Item;
+using sp_test::StringSource;
+using sp_test::createItems;
+using sp_test::makeItemProto;
+using sp_test::makeSaveItems;
+
+/// Evaluate a stream of items in a pipeline.
+template<typename ReadFn>
+std::vector<Item>
+evalPipeline(ReadFn read_fn, simdjson_peval::error *errors) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    Item tmp_item;
+
+    eval_pipeline_options options;
+    options.block_size = 4096;
+
+    std::vector<Item> items;
+    eval_many_pipeline(
+        &parser, std::move(read_fn), &tmp_item, makeItemProto(&tmp_item),
+        makeSaveItems(&items),
+        errors, options);
+
+    return items;
+}
+
+/// Evaluate uncompressed stream of items.
+std::vector<Item>
+evalSequential(const std::string &data, simdjson_peval::error *errors) {
+    return evalPipeline(StringSource{data, data.size()}, errors);
+}
+
+#ifdef SIMDJSON_PEVAL_WITH_ZLIB
+
+/// Compress data with gzip.
+std::string
+gzipCompress(const std::string &data) {
+    z_stream stream = {};
+    // 15 + 16: maximum window size and gzip header.
+    EXPECT_EQ(
+        deflateInit2(
+            &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+            Z_DEFAULT_STRATEGY),
+        Z_OK);
+
+    std::string result(deflateBound(&stream, data.size()), '\0');
+    stream.next_in =
+        reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    stream.avail_in = uInt(data.size());
+    stream.next_out = reinterpret_cast<Bytef *>(result.data());
+    stream.avail_out = uInt(result.size());
+    EXPECT_EQ(deflate(&stream, Z_FINISH), Z_STREAM_END);
+    result.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    return result;
+}
+
+#endif // SIMDJSON_PEVAL_WITH_ZLIB
+
+#ifdef SIMDJSON_PEVAL_WITH_ZSTD
+
+/// Compress data with zstd.
+std::string
+zstdCompress(const std::string &data) {
+    std::string result(ZSTD_compressBound(data.size()), '\0');
+    const auto size =
+        ZSTD_compress(result.data(), result.size(), data.data(), data.size(), 3);
+    EXPECT_FALSE(ZSTD_isError(size));
+    result.resize(size);
+
+    return result;
+}
+
+#endif // SIMDJSON_PEVAL_WITH_ZSTD
+
+} // namespace
+
+
+#ifdef SIMDJSON_PEVAL_WITH_ZLIB
+
+TEST(GzipSource, MatchesUncompressed) {
+    using namespace simdjson_peval;
+
+    const auto data = createItems(2000, {5, 1234});
+    const auto compressed = gzipCompress(data);
+
+    error seq_errors(true);
+    const auto seq_items = evalSequential(data, &seq_errors);
+
+    error errors(true);
+    const auto items =
+        evalPipeline(gzip_source(StringSource{compressed, 100}, 64), &errors);
+
+    EXPECT_EQ(items.size(), 1998u);
+    EXPECT_EQ(items, seq_items);
+    EXPECT_TRUE(sp_test::checkErrors(errors, seq_errors.get_messages()));
+}
+
+
+TEST(GzipSource, Members) {
+    using namespace simdjson_peval;
+
+    const auto data1 = createItems(10, {});
+    const auto data2 = createItems(20, {});
+    const auto compressed = gzipCompress(data1) + gzipCompress(data2);
+
+    error errors(true);
+    const auto items =
+        evalPipeline(gzip_source(StringSource{compressed, 7}), &errors);
+
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+    ASSERT_EQ(items.size(), 30u);
+    EXPECT_EQ(items[10], (Item{0, "item0"}));
+}
+
+
+TEST(GzipSource, Errors) {
+    using namespace simdjson_peval;
+
+    const auto data = createItems(500, {});
+    const auto compressed = gzipCompress(data);
+
+    // truncated stream.
+    error errors(true);
+    auto items =
+        evalPipeline(
+            gzip_source(
+                StringSource{
+                    std::string_view(compressed).substr(
+                        0, compressed.size() / 2),
+                    100}),
+            &errors);
+    EXPECT_EQ(errors.get_messages().size(), 1u);
+    EXPECT_EQ(errors.get_messages().at(0).get_code(), simdjson::IO_ERROR);
+
+    // corrupt stream.
+    auto corrupt = compressed;
+    corrupt[0] = 'x';
+    errors.clear();
+    items = evalPipeline(gzip_source(StringSource{corrupt, 100}), &errors);
+    EXPECT_TRUE(items.empty());
+    EXPECT_TRUE(
+        sp_test::checkErrors(errors, {{simdjson::IO_ERROR, "<root>"}}));
+
+    // empty stream.
+    errors.clear();
+    items = evalPipeline(gzip_source(StringSource{"", 100}), &errors);
+    EXPECT_TRUE(items.empty());
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+}
+
+#endif // SIMDJSON_PEVAL_WITH_ZLIB
+
+#ifdef SIMDJSON_PEVAL_WITH_ZSTD
+
+TEST(ZstdSource, MatchesUncompressed) {
+    using namespace simdjson_peval;
+
+    const auto data = createItems(2000, {7, 1999});
+    const auto compressed = zstdCompress(data) + zstdCompress(data);
+
+    error seq_errors(true);
+    const auto seq_items = evalSequential(data + data, &seq_errors);
+
+    error errors(true);
+    const auto items =
+        evalPipeline(zstd_source(StringSource{compressed, 100}, 64), &errors);
+
+    EXPECT_EQ(items.size(), 3996u);
+    EXPECT_EQ(items, seq_items);
+    EXPECT_TRUE(sp_test::checkErrors(errors, seq_errors.get_messages()));
+}
+
+
+TEST(ZstdSource, Errors) {
+    using namespace simdjson_peval;
+
+    const auto data = createItems(500, {});
+    const auto compressed = zstdCompress(data);
+
+    // truncated stream.
+    error errors(true);
+    evalPipeline(
+        zstd_source(
+            StringSource{
+                std::string_view(compressed).substr(
+                    0, compressed.size() - 10),
+                100}),
+        &errors);
+    EXPECT_EQ(errors.get_messages().size(), 1u);
+    EXPECT_EQ(errors.get_messages().at(0).get_code(), simdjson::IO_ERROR);
+
+    // corrupt stream.
+    auto corrupt = compressed;
+    corrupt[0] = 'x';
+    errors.clear();
+    auto items = evalPipeline(zstd_source(StringSource{corrupt, 100}), &errors);
+    EXPECT_TRUE(items.empty());
+    EXPECT_TRUE(
+        sp_test::checkErrors(errors, {{simdjson::IO_ERROR, "<root>"}}));
+}
+
+#endif // SIMDJSON_PEVAL_WITH_ZSTD
+
+#endif // SIMDJSON_PEVAL_WITH_ZLIB || SIMDJSON_PEVAL_WITH_ZSTD
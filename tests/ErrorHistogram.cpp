@@ -0,0 +1,177 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define _SIMDJSON_PEVAL_DO_TRACE 1
+#include "simdjson_peval.h"
+
+#include "gtest/gtest.h"
+
+#include "TestUtils.h"
+
+#include <vector>
+
+namespace {
+
+struct User {
+    std::string_view name;
+    uint64_t id;
+};
+
+auto
+evalUsers(std::vector<User> *users, User *tmp_user) {
+    using namespace simdjson_peval;
+
+    return
+        object<simdjson::ondemand::document>(
+            member(
+                "statuses",
+                array_to_out_iter(
+                    back_inserter(*users), tmp_user,
+                    object(
+                        member(
+                            "user",
+                            object(
+                                member("name", string_value(&tmp_user->name)),
+                                member("id", number_value(&tmp_user->id))))))));
+}
+
+} // namespace
+
+
+TEST(ErrorHistogram, CountByPathTemplate) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    auto json = R"({"statuses":[
+        {"user":{"name":"a","id":1}},
+        {"user":{"name":1,"id":2}},
+        {"user":{"name":"c","id":"x"}},
+        {"user":{"name":2,"id":4}},
+        {"user":{"name":3,"id":5}}
+    ]})"_padded;
+    auto dataDoc = parser.iterate(json);
+
+    std::vector<User> users;
+    User tmp_user;
+    auto proto = evalUsers(&users, &tmp_user);
+
+    error_histogram histogram;
+    error errors(&histogram);
+    proto(dataDoc, &errors);
+
+    EXPECT_TRUE(errors);
+    EXPECT_EQ(errors.get_count(), 4u);
+    EXPECT_TRUE(errors.get_messages().empty());
+    EXPECT_EQ(errors.get_histogram(), &histogram);
+
+    EXPECT_EQ(histogram.get_total(), 4u);
+    EXPECT_EQ(histogram.get_dropped(), 0u);
+
+    const auto &entries = histogram.get_entries();
+    ASSERT_EQ(entries.size(), 2u);
+
+    EXPECT_EQ(entries[0].get_code(), simdjson::INCORRECT_TYPE);
+    EXPECT_EQ(entries[0].get_path(), "<root>.statuses[*].user.name");
+    EXPECT_EQ(entries[0].get_count(), 3u);
+    EXPECT_EQ(entries[0].get_first_path(), "<root>.statuses[1].user.name");
+    EXPECT_EQ(entries[0].get_samples().size(), 3u);
+
+    EXPECT_EQ(entries[1].get_code(), simdjson::INCORRECT_TYPE);
+    EXPECT_EQ(entries[1].get_path(), "<root>.statuses[*].user.id");
+    EXPECT_EQ(entries[1].get_count(), 1u);
+    EXPECT_EQ(entries[1].get_first_path(), "<root>.statuses[2].user.id");
+
+    EXPECT_EQ(
+        errors.to_string(),
+        entries[0].to_string() + '\n' + entries[1].to_string());
+}
+
+
+TEST(ErrorHistogram, BoundedMemory) {
+    using namespace simdjson_peval;
+
+    std::string raw_json = R"({"statuses":[)";
+    for (size_t i = 0; i < 1000; ++i) {
+        if (i != 0) {
+            raw_json += ',';
+        }
+        raw_json += R"({"user":{"name":)" + std::to_string(i) + R"(,"id":1}})";
+    }
+    raw_json += "]}";
+
+    simdjson::ondemand::parser parser;
+    auto json = simdjson::padded_string(raw_json);
+    auto dataDoc = parser.iterate(json);
+
+    std::vector<User> users;
+    User tmp_user;
+    auto proto = evalUsers(&users, &tmp_user);
+
+    error_histogram histogram(1, 2, 16);
+    error errors(&histogram);
+    proto(dataDoc, &errors);
+
+    EXPECT_EQ(errors.get_count(), 1000u);
+    EXPECT_EQ(histogram.get_total(), 1000u);
+    EXPECT_EQ(histogram.get_dropped(), 0u);
+
+    const auto &entries = histogram.get_entries();
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].get_count(), 1000u);
+    EXPECT_EQ(entries[0].get_path(), "<root>.statuses[");
+    EXPECT_EQ(entries[0].get_first_path(), "<root>.statuses[");
+    EXPECT_EQ(entries[0].get_samples().size(), 2u);
+}
+
+
+TEST(ErrorHistogram, DroppedAndMerge) {
+    using namespace simdjson_peval;
+
+    error_histogram histogram(1, 1);
+    histogram.add(simdjson::INCORRECT_TYPE, "<root>.a[*]", "<root>.a[0]");
+    histogram.add(simdjson::NO_SUCH_FIELD, "<root>.a[*]", "<root>.a[1]");
+
+    EXPECT_EQ(histogram.get_total(), 2u);
+    EXPECT_EQ(histogram.get_dropped(), 1u);
+
+    error_histogram other(4, 1);
+    other.add(simdjson::INCORRECT_TYPE, "<root>.a[*]", "<root>.a[7]");
+    other.add(simdjson::INCORRECT_TYPE, "<root>.b", "<root>.b");
+
+    histogram.merge(other);
+
+    EXPECT_EQ(histogram.get_total(), 4u);
+    EXPECT_EQ(histogram.get_dropped(), 2u);
+
+    const auto &entries = histogram.get_entries();
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].get_count(), 2u);
+    EXPECT_EQ(entries[0].get_first_path(), "<root>.a[0]");
+    ASSERT_EQ(entries[0].get_samples().size(), 1u);
+    EXPECT_EQ(entries[0].get_samples()[0], "<root>.a[7]");
+
+    histogram.clear();
+    EXPECT_EQ(histogram.get_total(), 0u);
+    EXPECT_TRUE(histogram.get_entries().empty());
+}
@@ -0,0 +1,150 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define _SIMDJSON_PEVAL_DO_TRACE 1
+#include "simdjson_peval.h"
+
+#include "gtest/gtest.h"
+
+#include "TestUtils.h"
+
+
+TEST(ErrorMisc, Clear) {
+    using namespace simdjson_peval;
+
+    error errors(true);
+    {
+        error::path_scope scope(&errors, "member");
+        errors.add(simdjson::INCORRECT_TYPE);
+        errors.add(simdjson::NO_SUCH_FIELD);
+
+        EXPECT_TRUE(errors);
+        EXPECT_EQ(errors.get_count(), 2u);
+
+        const auto capacity = errors.get_messages().capacity();
+
+        // clear inside of path scope.
+        errors.clear();
+
+        EXPECT_FALSE(errors);
+        EXPECT_EQ(errors.get_count(), 0u);
+        EXPECT_TRUE(errors.get_messages().empty());
+        EXPECT_EQ(errors.get_messages().capacity(), capacity);
+
+        errors.add(simdjson::NO_SUCH_FIELD);
+    }
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::NO_SUCH_FIELD, "<root>.member"}
+            }));
+}
+
+
+TEST(ErrorMisc, Reset) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+
+    std::string_view value;
+    auto proto =
+        object<simdjson::ondemand::document>(
+            member("value", string_value(&value)));
+
+    error errors(true);
+
+    for (int i = 0; i < 3; ++i) {
+        auto json = R"({"value":10})"_padded;
+        auto dataDoc = parser.iterate(json);
+
+        errors.reset();
+        proto(dataDoc, &errors);
+
+        EXPECT_TRUE(
+            sp_test::checkErrors(
+                errors,
+                {
+                    {simdjson::INCORRECT_TYPE, "<root>.value"}
+                }));
+    }
+}
+
+
+TEST(ErrorMisc, ClearKeepsHistogram) {
+    using namespace simdjson_peval;
+
+    error_histogram histogram;
+    error errors(&histogram);
+
+    errors.add(simdjson::INCORRECT_TYPE);
+    errors.clear();
+    errors.add(simdjson::INCORRECT_TYPE);
+
+    EXPECT_EQ(errors.get_count(), 1u);
+    EXPECT_EQ(histogram.get_total(), 2u);
+}
+
+
+TEST(ErrorMisc, Append) {
+    using namespace simdjson_peval;
+
+    error chunk_errors(true);
+    {
+        error::path_scope idx_scope(&chunk_errors, size_t(2));
+        error::path_scope member_scope(&chunk_errors, "id");
+        chunk_errors.add(simdjson::INCORRECT_TYPE);
+    }
+
+    {
+        error errors(true);
+        errors.add(simdjson::TAPE_ERROR);
+        errors.append(chunk_errors, 10);
+
+        EXPECT_EQ(errors.get_count(), 2u);
+        EXPECT_TRUE(
+            sp_test::checkErrors(
+                errors,
+                {
+                    {simdjson::TAPE_ERROR, "<root>"},
+                    {simdjson::INCORRECT_TYPE, "<root>[12].id"}
+                }));
+    }
+
+    {
+        error_histogram histogram;
+        error errors(&histogram);
+        errors.append(chunk_errors, 10);
+        errors.append(chunk_errors, 20);
+
+        EXPECT_EQ(errors.get_count(), 2u);
+        ASSERT_EQ(histogram.get_entries().size(), 1u);
+
+        const auto &entry = histogram.get_entries()[0];
+        EXPECT_EQ(entry.get_path(), "<root>[*].id");
+        EXPECT_EQ(entry.get_count(), 2u);
+        EXPECT_EQ(entry.get_first_path(), "<root>[12].id");
+    }
+}
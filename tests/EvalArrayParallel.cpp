@@ -0,0 +1,437 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define _SIMDJSON_PEVAL_DO_TRACE 1
+#include "simdjson_peval_parallel.h"
+
+#include "gtest/gtest.h"
+
+#include "TestUtils.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+using sp_test::Item;
+
+/// Create an array of items with invalid ids at the given indexes.
+std::string
+createItemArray(size_t num_items, const std::vector<size_t> &bad_items) {
+    std::string result = "[";
+    for (size_t idx = 0; idx < num_items; ++idx) {
+        const auto is_bad =
+            std::find(bad_items.begin(), bad_items.end(), idx)
+            != bad_items.end();
+
+        if (idx != 0) {
+            result += ",\n ";
+        }
+
+        // names with separators and escapes to test the pre-scan.
+        result +=
+            "{\"id\":"
+            + (is_bad ? std::string("\"x\"") : std::to_string(idx))
+            + ",\"name\":\"i,]}\\\"" + std::to_string(idx) + "\""
+            + ",\"tags\":[1,[2,{\"a\":\"]\"}]]}";
+    }
+
+    return result + "]";
+}
+
+auto
+makeItemProto(Item *tmp_item) {
+    return sp_test::makeItemProto<simdjson::ondemand::value>(tmp_item);
+}
+
+std::vector<Item>
+evalSequential(std::string_view raw_json, simdjson_peval::error *errors) {
+    using namespace simdjson_peval;
+
+    std::vector<Item> items;
+    Item tmp_item;
+    auto proto =
+        array_to_out_iter<simdjson::ondemand::document>(
+            back_inserter(items), &tmp_item, makeItemProto(&tmp_item));
+
+    simdjson::ondemand::parser parser;
+    auto json = simdjson::padded_string(raw_json);
+    auto doc = parser.iterate(json);
+    proto(doc, errors);
+
+    return items;
+}
+
+simdjson_peval::eval_array_parallel_stats
+evalParallel(
+    std::string_view raw_json,
+    std::vector<Item> *items,
+    simdjson_peval::error *errors,
+    const simdjson_peval::eval_array_parallel_options &options)
+{
+    using namespace simdjson_peval;
+
+    auto json = simdjson::padded_string(raw_json);
+
+    return
+        eval_array_parallel<Item>(
+            json, back_inserter(*items),
+            [](Item *tmp_item) { return makeItemProto(tmp_item); },
+            errors, options);
+}
+
+/// Element boundaries found byte by byte.
+std::vector<std::pair<size_t, bool>>
+scanBytewise(std::string_view json) {
+    std::vector<std::pair<size_t, bool>> boundaries;
+    size_t depth = 0;
+    bool in_string = false;
+    bool element = false;
+    for (size_t pos = 0; pos < json.size(); ++pos) {
+        const auto c = json[pos];
+        if (in_string) {
+            if (c == '\\') {
+                ++pos;
+            }
+            else if (c == '"') {
+                in_string = false;
+            }
+            continue;
+        }
+
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            continue;
+        }
+
+        if (depth == 0) {
+            if (c != '[') {
+                break;
+            }
+            boundaries.emplace_back(pos, false);
+            ++depth;
+            continue;
+        }
+
+        if (c == ']' || c == '}') {
+            if (--depth == 0) {
+                boundaries.emplace_back(pos, element);
+                break;
+            }
+        }
+        else if (c == ',' && depth == 1) {
+            boundaries.emplace_back(pos, element);
+            element = false;
+            continue;
+        }
+        else if (c == '[' || c == '{') {
+            ++depth;
+        }
+        else if (c == '"') {
+            in_string = true;
+        }
+
+        element = true;
+    }
+
+    return boundaries;
+}
+
+/// Create a random array with nested values and escaped strings.
+std::string
+createRandomArray(uint32_t *random) {
+    auto next =
+        [random](uint32_t range) {
+            *random = *random * 1103515245 + 12345;
+            return (*random >> 16) % range;
+        };
+
+    std::string result = " [";
+    size_t depth = 1;
+    while (depth != 0) {
+        switch (next(12)) {
+        case 0:
+            result += '"';
+            for (auto num_chars = next(80); num_chars != 0; --num_chars) {
+                const auto kind = next(6);
+                if (kind == 0) {
+                    result.append(next(4) * 2 + 1, '\\');
+                    result += "\"";
+                }
+                else if (kind == 1) {
+                    result.append(next(3) * 2, '\\');
+                }
+                else {
+                    result += ",[]{}a "[next(7)];
+                }
+            }
+            result += '"';
+            break;
+
+        case 1:
+            result += (next(2) == 0 ? '[' : '{');
+            ++depth;
+            break;
+
+        case 2:
+        case 3:
+            // long top-level arrays.
+            if (depth == 1 && next(20) != 0) {
+                break;
+            }
+            result += (next(2) == 0 ? ']' : '}');
+            --depth;
+            break;
+
+        case 4:
+        case 5:
+        case 6:
+            result += ',';
+            break;
+
+        case 7:
+            result.append(next(70), ' ');
+            break;
+
+        default:
+            result += std::to_string(next(100000));
+            break;
+        }
+    }
+
+    return result + " trailing";
+}
+
+} // namespace
+
+
+TEST(ArrayScanner, Random) {
+    using namespace simdjson_peval;
+
+    uint32_t random = 7;
+    for (int run = 0; run < 200; ++run) {
+        const auto json = createRandomArray(&random);
+        const auto expected = scanBytewise(json);
+
+        // data in random parts.
+        std::vector<std::pair<size_t, bool>> boundaries;
+        internal::array_scanner scanner;
+        size_t offset = 0;
+        while (offset < json.size() && !scanner.is_finished()) {
+            random = random * 1103515245 + 12345;
+            const auto size =
+                std::min(size_t(random >> 16) % 150 + 1,
+                         json.size() - offset);
+            EXPECT_EQ(
+                scanner.scan(
+                    std::string_view(json).substr(offset, size),
+                    [&](size_t pos, bool after_element) {
+                        boundaries.emplace_back(offset + pos, after_element);
+                    }),
+                simdjson::SUCCESS);
+            offset += size;
+        }
+
+        ASSERT_TRUE(scanner.is_finished()) << json;
+        ASSERT_EQ(boundaries, expected) << json;
+    }
+}
+
+
+TEST(ArrayScanner, Parts) {
+    using namespace simdjson_peval;
+
+    const std::string json =
+        " [ 1, \"a,\\\"]\", {\"b\":[2,3]}, [4,{}] ,\"\\\\\" ] trailing";
+
+    std::vector<std::pair<size_t, bool>> boundaries;
+    internal::array_scanner scanner;
+    EXPECT_EQ(
+        scanner.scan(
+            json,
+            [&](size_t pos, bool after_element) {
+                boundaries.emplace_back(pos, after_element);
+            }),
+        simdjson::SUCCESS);
+    EXPECT_TRUE(scanner.is_finished());
+
+    ASSERT_EQ(boundaries.size(), 6u);
+    EXPECT_EQ(json[boundaries.front().first], '[');
+    EXPECT_EQ(json[boundaries.back().first], ']');
+    for (size_t idx = 1; idx < boundaries.size(); ++idx) {
+        EXPECT_TRUE(boundaries[idx].second);
+    }
+
+    // same boundaries, if data is passed byte by byte.
+    std::vector<std::pair<size_t, bool>> part_boundaries;
+    internal::array_scanner part_scanner;
+    for (size_t offset = 0; offset < json.size(); ++offset) {
+        EXPECT_EQ(
+            part_scanner.scan(
+                std::string_view(json).substr(offset, 1),
+                [&](size_t pos, bool after_element) {
+                    part_boundaries.emplace_back(offset + pos, after_element);
+                }),
+            simdjson::SUCCESS);
+    }
+    EXPECT_EQ(part_boundaries, boundaries);
+}
+
+
+TEST(ArrayScanner, NoArray) {
+    using namespace simdjson_peval;
+
+    internal::array_scanner scanner;
+    EXPECT_EQ(
+        scanner.scan(" {\"a\":1}", [](size_t, bool) {}),
+        simdjson::INCORRECT_TYPE);
+}
+
+
+TEST(WorkStealingQueue, Steal) {
+    using namespace simdjson_peval;
+
+    work_stealing_queue<int> queue(2);
+    queue.push(0, 1);
+    queue.push(0, 2);
+    queue.push(0, 3);
+
+    int value;
+    ASSERT_TRUE(queue.pop(0, &value));
+    EXPECT_EQ(value, 1);
+    ASSERT_TRUE(queue.pop(1, &value));
+    EXPECT_EQ(value, 3);
+    ASSERT_TRUE(queue.pop(1, &value));
+    EXPECT_EQ(value, 2);
+    EXPECT_FALSE(queue.pop(0, &value));
+    EXPECT_EQ(queue.get_steals(), 2u);
+}
+
+
+TEST(EvalArrayParallel, MatchesSequential) {
+    using namespace simdjson_peval;
+
+    const auto raw_json = createItemArray(2000, {7, 1500});
+
+    error seq_errors(true);
+    auto seq_items = evalSequential(raw_json, &seq_errors);
+    ASSERT_EQ(seq_items.size(), 2000u);
+
+    eval_array_parallel_options options;
+    options.threads = 4;
+    options.range_size = 1000;
+
+    std::vector<Item> items;
+    error errors(true);
+    auto stats = evalParallel(raw_json, &items, &errors, options);
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>[7].id"},
+                {simdjson::INCORRECT_TYPE, "<root>[1500].id"}
+            }));
+    EXPECT_TRUE(sp_test::checkErrors(errors, seq_errors.get_messages()));
+
+    EXPECT_EQ(stats.elements, 2000u);
+    EXPECT_GT(stats.ranges, 4u);
+    EXPECT_EQ(stats.threads, 4u);
+    EXPECT_EQ(items.size(), 2000u);
+    EXPECT_TRUE(items == seq_items);
+}
+
+
+TEST(EvalArrayParallel, SingleRange) {
+    using namespace simdjson_peval;
+
+    const auto raw_json = createItemArray(10, {});
+
+    std::vector<Item> items;
+    error errors(true);
+    auto stats =
+        evalParallel(raw_json, &items, &errors, eval_array_parallel_options());
+
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+    EXPECT_EQ(stats.ranges, 1u);
+    EXPECT_EQ(stats.threads, 1u);
+    EXPECT_EQ(items.size(), 10u);
+    EXPECT_EQ(items[9].name, "i,]}\"9");
+}
+
+
+TEST(EvalArrayParallel, Empty) {
+    using namespace simdjson_peval;
+
+    std::vector<Item> items;
+    error errors(true);
+    auto stats =
+        evalParallel(" [ ] ", &items, &errors, eval_array_parallel_options());
+
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+    EXPECT_EQ(stats.elements, 0u);
+    EXPECT_TRUE(items.empty());
+}
+
+
+TEST(EvalArrayParallel, NoArray) {
+    using namespace simdjson_peval;
+
+    std::vector<Item> items;
+    error errors(true);
+    evalParallel(
+        "{\"id\":1,\"name\":\"a\"}", &items, &errors,
+        eval_array_parallel_options());
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>"}
+            }));
+    EXPECT_TRUE(items.empty());
+}
+
+
+TEST(EvalArrayParallel, Incomplete) {
+    using namespace simdjson_peval;
+
+    eval_array_parallel_options options;
+    options.range_size = 1;
+
+    std::vector<Item> items;
+    error errors(true);
+    auto stats =
+        evalParallel(
+            "[{\"id\":1,\"name\":\"a\"},{\"id\":2,\"name\":\"b\"},{\"id\":3",
+            &items, &errors, options);
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCOMPLETE_ARRAY_OR_OBJECT, "<root>"}
+            }));
+    EXPECT_EQ(stats.elements, 2u);
+    EXPECT_EQ(items, std::vector<Item>({{1, "a"}, {2, "b"}}));
+}
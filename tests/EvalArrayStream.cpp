@@ -0,0 +1,258 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define _SIMDJSON_PEVAL_DO_TRACE 1
+#include "simdjson_peval_io.h"
+
+#include "gtest/gtest.h"
+
+#include "TestUtils.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using sp_test::Item;
+using sp_test::StringSource;
+using sp_test::makeSaveItems;
+
+/// Create an array of items with invalid ids at the given indexes.
+std::string
+createItemArray(size_t num_items, const std::vector<size_t> &bad_items) {
+    std::string result = " [";
+    for (size_t idx = 0; idx < num_items; ++idx) {
+        const auto is_bad =
+            std::find(bad_items.begin(), bad_items.end(), idx)
+            != bad_items.end();
+
+        if (idx != 0) {
+            result += ",\n ";
+        }
+
+        result +=
+            "{\"id\":"
+            + (is_bad ? std::string("\"x\"") : std::to_string(idx))
+            + ",\"name\":\"i,]\\\"" + std::to_string(idx) + "\"}";
+    }
+
+    return result + "]\n";
+}
+
+template<typename ReadFn>
+simdjson_peval::eval_array_stream_stats
+evalStream(
+    ReadFn read_fn,
+    std::vector<Item> *items,
+    simdjson_peval::error *errors,
+    const simdjson_peval::eval_array_stream_options &options)
+{
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    Item tmp_item;
+    auto proto =
+        sp_test::makeItemProto<simdjson::ondemand::value>(&tmp_item);
+
+    return
+        eval_array_stream(
+            &parser, read_fn, &tmp_item, proto,
+            makeSaveItems(items),
+            errors, options);
+}
+
+} // namespace
+
+
+TEST(EvalArrayStream, MatchesSequential) {
+    using namespace simdjson_peval;
+
+    const auto raw_json = createItemArray(500, {3, 321});
+
+    std::vector<Item> seq_items;
+    error seq_errors(true);
+    {
+        Item tmp_item;
+        auto proto =
+            array_to_out_iter<simdjson::ondemand::document>(
+                back_inserter(seq_items), &tmp_item,
+                object(
+                    member("id", number_value(&tmp_item.id)),
+                    member("name", string_value(&tmp_item.name))));
+
+        simdjson::ondemand::parser parser;
+        auto json = simdjson::padded_string(raw_json);
+        auto doc = parser.iterate(json);
+        proto(doc, &seq_errors);
+
+        // records with errors are not passed to the batch function.
+        seq_items.erase(seq_items.begin() + 321);
+        seq_items.erase(seq_items.begin() + 3);
+    }
+
+    eval_array_stream_options options;
+    options.window_size = 128;
+    options.records_per_batch = 7;
+
+    std::vector<Item> items;
+    error errors(true);
+    auto stats =
+        evalStream(StringSource{raw_json, 17}, &items, &errors, options);
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>[3].id"},
+                {simdjson::INCORRECT_TYPE, "<root>[321].id"}
+            }));
+    EXPECT_TRUE(sp_test::checkErrors(errors, seq_errors.get_messages()));
+    EXPECT_EQ(stats.elements, 500u);
+    EXPECT_EQ(stats.records, 498u);
+    EXPECT_EQ(stats.failed_elements, 2u);
+    EXPECT_EQ(stats.window_size, 128u);
+    EXPECT_GT(stats.windows, 100u);
+    EXPECT_TRUE(items == seq_items);
+}
+
+
+TEST(EvalArrayStream, LargeElement) {
+    using namespace simdjson_peval;
+
+    const std::string long_name(1000, 'x');
+    const auto raw_json =
+        "[{\"id\":1,\"name\":\"a\"},"
+        "{\"id\":2,\"name\":\"" + long_name + "\"},"
+        "{\"id\":3,\"name\":\"c\"}]";
+
+    eval_array_stream_options options;
+    options.window_size = 64;
+
+    std::vector<Item> items;
+    error errors(true);
+    auto stats =
+        evalStream(StringSource{raw_json, 1000}, &items, &errors, options);
+
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+    EXPECT_GE(stats.window_size, 1000u);
+    EXPECT_EQ(
+        items,
+        std::vector<Item>({{1, "a"}, {2, long_name}, {3, "c"}}));
+}
+
+
+TEST(EvalArrayStream, FileDescriptor) {
+    using namespace simdjson_peval;
+
+    const auto raw_json = createItemArray(2000, {});
+
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    std::thread writer(
+        [&raw_json, fd = fds[1]]() {
+            std::string_view data(raw_json);
+            while (!data.empty()) {
+                const auto result = write(fd, data.data(), data.size());
+                if (result <= 0) {
+                    break;
+                }
+                data.remove_prefix(size_t(result));
+            }
+            close(fd);
+        });
+
+    eval_array_stream_options options;
+    options.window_size = 4096;
+
+    std::vector<Item> items;
+    error errors(true);
+    auto stats = evalStream(fd_source(fds[0]), &items, &errors, options);
+
+    writer.join();
+    close(fds[0]);
+
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+    EXPECT_EQ(stats.elements, 2000u);
+    EXPECT_EQ(stats.window_size, 4096u);
+    ASSERT_EQ(items.size(), 2000u);
+    EXPECT_EQ(items[1999].name, "i,]\"1999");
+}
+
+
+TEST(EvalArrayStream, Empty) {
+    using namespace simdjson_peval;
+
+    std::vector<Item> items;
+    error errors(true);
+    auto stats =
+        evalStream(
+            StringSource{" [ ] ", 1}, &items, &errors,
+            eval_array_stream_options());
+
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+    EXPECT_EQ(stats.elements, 0u);
+    EXPECT_TRUE(items.empty());
+}
+
+
+TEST(EvalArrayStream, Incomplete) {
+    using namespace simdjson_peval;
+
+    std::vector<Item> items;
+    error errors(true);
+    auto stats =
+        evalStream(
+            StringSource{"[{\"id\":1,\"name\":\"a\"},{\"id\":2", 5},
+            &items, &errors, eval_array_stream_options());
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCOMPLETE_ARRAY_OR_OBJECT, "<root>"}
+            }));
+    EXPECT_EQ(stats.elements, 1u);
+    EXPECT_EQ(items, std::vector<Item>({{1, "a"}}));
+}
+
+
+TEST(EvalArrayStream, NoArray) {
+    using namespace simdjson_peval;
+
+    std::vector<Item> items;
+    error errors(true);
+    evalStream(
+        StringSource{"{\"id\":1}", 100}, &items, &errors,
+        eval_array_stream_options());
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>"}
+            }));
+    EXPECT_TRUE(items.empty());
+}
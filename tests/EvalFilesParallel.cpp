@@ -0,0 +1,206 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define _SIMDJSON_PEVAL_DO_TRACE 1
+#include "simdjson_peval_parallel.h"
+
+#include "gtest/gtest.h"
+
+#include "TestUtils.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+using sp_test::Item;
+using sp_test::TempFiles;
+using sp_test::createItems;
+using sp_test::makeItemProto;
+using sp_test::makeSaveItems;
+
+simdjson_peval::eval_files_stats
+evalFiles(
+    const std::vector<std::string> &paths,
+    std::vector<Item> *items,
+    simdjson_peval::error *errors,
+    const simdjson_peval::eval_files_options &options)
+{
+    using namespace simdjson_peval;
+
+    auto stats =
+        eval_files_parallel<Item>(
+            paths,
+            [](Item *tmp_item) { return makeItemProto(tmp_item); },
+            makeSaveItems(items),
+            errors, options);
+
+    std::sort(items->begin(), items->end());
+    return stats;
+}
+
+} // namespace
+
+
+TEST(EvalFilesParallel, Files) {
+    using namespace simdjson_peval;
+
+    TempFiles files;
+    files.add(createItems(10));
+    files.add(createItems(2000, {15, 1500}, 10));
+    files.add("");
+    files.add(createItems(1, {}, 2010));
+    files.add(createItems(500, {2510}, 2011));
+
+    eval_files_options options;
+    options.threads = 4;
+    options.chunk_size = 1000;
+
+    std::vector<Item> items;
+    error errors(true);
+    const auto stats = evalFiles(files.paths, &items, &errors, options);
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>[15].id"},
+                {simdjson::INCORRECT_TYPE, "<root>[1500].id"},
+                {simdjson::INCORRECT_TYPE, "<root>[2510].id"}
+            }));
+
+    EXPECT_EQ(stats.files, 5u);
+    EXPECT_EQ(stats.failed_files, 0u);
+    EXPECT_GT(stats.units, 40u);
+    EXPECT_EQ(stats.documents, 2511u);
+    EXPECT_EQ(stats.records, 2508u);
+    EXPECT_EQ(stats.failed_documents, 3u);
+
+    ASSERT_EQ(stats.workers.size(), 4u);
+    size_t units = 0;
+    size_t documents = 0;
+    for (const auto &worker : stats.workers) {
+        units += worker.units;
+        documents += worker.documents;
+        EXPECT_GE(worker.utilization, 0.0);
+        EXPECT_LE(worker.utilization, 1.0);
+    }
+    EXPECT_EQ(units, stats.units);
+    EXPECT_EQ(documents, stats.documents);
+
+    ASSERT_EQ(items.size(), 2508u);
+    EXPECT_EQ(items.front(), (Item{0, "item0"}));
+    EXPECT_EQ(items.back(), (Item{2509, "item2509"}));
+}
+
+
+TEST(EvalFilesParallel, ChunkBoundaries) {
+    using namespace simdjson_peval;
+
+    TempFiles files;
+    files.add(createItems(100));
+    // without line break at the end.
+    files.add(createItems(100, {}, 100) + "{\"id\":200,\"name\":\"item200\"}");
+
+    for (const auto chunk_size : {1, 2, 29, 30, 31, 1000, 100000}) {
+        for (const auto threads : {1, 3}) {
+            eval_files_options options;
+            options.threads = threads;
+            options.chunk_size = chunk_size;
+
+            std::vector<Item> items;
+            error errors(true);
+            const auto stats = evalFiles(files.paths, &items, &errors, options);
+
+            EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+            EXPECT_EQ(stats.documents, 201u);
+            ASSERT_EQ(items.size(), 201u);
+            for (size_t idx = 0; idx < items.size(); ++idx) {
+                ASSERT_EQ(items[idx].id, int64_t(idx)) << chunk_size;
+            }
+        }
+    }
+}
+
+
+TEST(EvalFilesParallel, NoSplit) {
+    using namespace simdjson_peval;
+
+    // documents with line breaks.
+    TempFiles files;
+    files.add("{\n  \"id\": 1,\n  \"name\": \"a\"\n}\n{\n  \"id\": 2,\n"
+              "  \"name\": \"b\"\n}\n");
+    files.add("[1, 2]\n");
+
+    eval_files_options options;
+    options.threads = 2;
+    options.chunk_size = 4;
+    options.split_files = false;
+
+    std::vector<Item> items;
+    error errors(true);
+    const auto stats = evalFiles(files.paths, &items, &errors, options);
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(errors, {{simdjson::INCORRECT_TYPE, "<root>[2]"}}));
+    EXPECT_EQ(stats.units, 2u);
+    EXPECT_EQ((std::vector<Item>{{1, "a"}, {2, "b"}}), items);
+}
+
+
+TEST(EvalFilesParallel, Errors) {
+    using namespace simdjson_peval;
+
+    TempFiles files;
+    files.add(createItems(10));
+
+    eval_files_options options;
+    options.threads = 2;
+
+    std::vector<Item> items;
+    error errors(true);
+    auto stats =
+        evalFiles(
+            {"/nonexistent/simdjson_peval.json", files.paths[0], "/tmp"},
+            &items, &errors, options);
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::IO_ERROR, "<root>"},
+                {simdjson::IO_ERROR, "<root>"}
+            }));
+    EXPECT_EQ(stats.files, 3u);
+    EXPECT_EQ(stats.failed_files, 2u);
+    EXPECT_EQ(items.size(), 10u);
+
+    // no files.
+    items.clear();
+    errors.clear();
+    stats = evalFiles({}, &items, &errors, options);
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+    EXPECT_EQ(stats.units, 0u);
+    EXPECT_TRUE(items.empty());
+}
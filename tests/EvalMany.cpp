@@ -0,0 +1,441 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define _SIMDJSON_PEVAL_DO_TRACE 1
+#include "simdjson_peval_ndjson.h"
+
+#include "gtest/gtest.h"
+
+#include "TestUtils.h"
+
+#include <vector>
+
+namespace {
+
+struct Item {
+    int64_t id;
+    std::string name;
+
+    bool
+    operator==(const Item &other) const {
+        return (id == other.id && name == other.name);
+    }
+};
+
+struct ItemCollector {
+    std::vector<Item> items;
+    std::vector<size_t> batch_sizes;
+};
+
+simdjson_peval::eval_many_stats
+evalItems(
+    std::string_view raw_json,
+    ItemCollector *collector,
+    simdjson_peval::error *errors,
+    const simdjson_peval::eval_many_options &options)
+{
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    auto json = simdjson::padded_string(raw_json);
+
+    Item tmp_item;
+    auto proto =
+        object<simdjson::ondemand::document_reference>(
+            member("id", number_value(&tmp_item.id)),
+            member("name", string_value(&tmp_item.name)));
+
+    return
+        eval_many(
+            &parser, json, &tmp_item, proto,
+            [collector](record_batch<Item> *batch, error *err) {
+                collector->batch_sizes.push_back(batch->size());
+                for (auto &item : *batch) {
+                    collector->items.push_back(std::move(item));
+                }
+            },
+            errors, options);
+}
+
+} // namespace
+
+
+TEST(EvalMany, Batches) {
+    using namespace simdjson_peval;
+
+    ItemCollector collector;
+    error errors(true);
+    eval_many_options options;
+    options.records_per_batch = 2;
+
+    auto stats =
+        evalItems(
+            "{\"id\":1,\"name\":\"a\"}\n"
+            "{\"id\":2,\"name\":\"b\"}\n"
+            "{\"id\":3,\"name\":\"c\"}\n"
+            "{\"id\":4,\"name\":\"d\"}\n"
+            "{\"id\":5,\"name\":\"e\"}\n",
+            &collector, &errors, options);
+
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+    EXPECT_EQ(stats.documents, 5u);
+    EXPECT_EQ(stats.records, 5u);
+    EXPECT_EQ(stats.failed_documents, 0u);
+    EXPECT_EQ(stats.truncated_bytes, 0u);
+
+    EXPECT_EQ(collector.batch_sizes, std::vector<size_t>({2, 2, 1}));
+    EXPECT_EQ(
+        collector.items,
+        std::vector<Item>({{1, "a"}, {2, "b"}, {3, "c"}, {4, "d"}, {5, "e"}}));
+}
+
+
+TEST(EvalMany, ErrorIsolation) {
+    using namespace simdjson_peval;
+
+    ItemCollector collector;
+    error errors(true);
+
+    auto stats =
+        evalItems(
+            "{\"id\":1,\"name\":\"a\"}\n"
+            "{\"id\":\"x\",\"name\":\"b\"}\n"
+            "{\"id\":3,\"name\":\"c\"}\n",
+            &collector, &errors, eval_many_options());
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>[1].id"}
+            }));
+    EXPECT_EQ(stats.documents, 3u);
+    EXPECT_EQ(stats.records, 2u);
+    EXPECT_EQ(stats.failed_documents, 1u);
+    EXPECT_EQ(collector.items, std::vector<Item>({{1, "a"}, {3, "c"}}));
+}
+
+
+TEST(EvalMany, StopOnError) {
+    using namespace simdjson_peval;
+
+    ItemCollector collector;
+    error errors(true);
+    eval_many_options options;
+    options.stop_on_error = true;
+
+    auto stats =
+        evalItems(
+            "{\"id\":1,\"name\":\"a\"}\n"
+            "{\"id\":2}\n"
+            "{\"id\":3,\"name\":\"c\"}\n",
+            &collector, &errors, options);
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::NO_SUCH_FIELD, "<root>[1].name"}
+            }));
+    EXPECT_EQ(stats.documents, 2u);
+    EXPECT_EQ(collector.items, std::vector<Item>({{1, "a"}}));
+}
+
+
+TEST(EvalMany, SkipDocuments) {
+    using namespace simdjson_peval;
+
+    ItemCollector collector;
+    error errors(true);
+    eval_many_options options;
+    options.skip_documents = 1;
+
+    auto stats =
+        evalItems(
+            "[\"id\",\"name\"]\n"
+            "{\"id\":1,\"name\":\"a\"}\n",
+            &collector, &errors, options);
+
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+    EXPECT_EQ(stats.documents, 1u);
+    EXPECT_EQ(collector.items, std::vector<Item>({{1, "a"}}));
+}
+
+
+TEST(EvalMany, GrowBatchSize) {
+    using namespace simdjson_peval;
+
+    const std::string long_name(200, 'x');
+
+    ItemCollector collector;
+    error errors(true);
+    eval_many_options options;
+    options.batch_size = 64;
+
+    auto stats =
+        evalItems(
+            "{\"id\":1,\"name\":\"a\"}\n"
+            "{\"id\":2,\"name\":\"" + long_name + "\"}\n"
+            "{\"id\":3,\"name\":\"c\"}\n",
+            &collector, &errors, options);
+
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+    EXPECT_EQ(stats.documents, 3u);
+    EXPECT_GE(stats.batch_size, 256u);
+    EXPECT_EQ(
+        collector.items,
+        std::vector<Item>({{1, "a"}, {2, long_name}, {3, "c"}}));
+}
+
+
+TEST(EvalMany, Truncated) {
+    using namespace simdjson_peval;
+
+    const auto raw_json =
+        "{\"id\":1,\"name\":\"a\"}\n"
+        "{\"id\":2,\"na";
+
+    {
+        ItemCollector collector;
+        error errors(true);
+
+        auto stats =
+            evalItems(raw_json, &collector, &errors, eval_many_options());
+
+        EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+        EXPECT_EQ(stats.documents, 1u);
+        EXPECT_EQ(stats.truncated_bytes, 11u);
+        EXPECT_EQ(collector.items, std::vector<Item>({{1, "a"}}));
+    }
+
+    {
+        ItemCollector collector;
+        error errors(true);
+        eval_many_options options;
+        options.truncated_is_error = true;
+
+        auto stats = evalItems(raw_json, &collector, &errors, options);
+
+        EXPECT_TRUE(
+            sp_test::checkErrors(
+                errors,
+                {
+                    {simdjson::INCOMPLETE_ARRAY_OR_OBJECT, "<root>[1]"}
+                }));
+        EXPECT_EQ(stats.truncated_bytes, 11u);
+    }
+}
+
+
+TEST(EvalMany, BatchSizeTuner) {
+    using namespace simdjson_peval;
+
+    internal::batch_size_tuner tuner(1024, 16384);
+
+    // grow while throughput increases.
+    EXPECT_EQ(tuner.update(2048, 1000, 100, 10), 4096u);
+    EXPECT_EQ(tuner.update(4096, 3000, 100, 10), 8192u);
+
+    // reverse direction, if throughput drops (1).
+    EXPECT_EQ(tuner.update(8192, 2000, 100, 10), 4096u);
+
+    // stay within limits.
+    EXPECT_EQ(tuner.update(4096, 2500, 100, 10), 2048u);
+    EXPECT_EQ(tuner.update(2048, 2600, 100, 10), 1024u);
+    EXPECT_EQ(tuner.update(1024, 2700, 100, 10), 2048u);
+
+    // batch must hold the largest documents.
+    EXPECT_EQ(tuner.update(2048, 2800, 100, 3000), 6000u);
+    EXPECT_EQ(tuner.update(6000, 4000, 100, 3000), 12000u);
+
+    // keep best batch size after three reversals (2, 3).
+    EXPECT_EQ(tuner.update(12000, 2000, 100, 3000), 6000u);
+    EXPECT_EQ(tuner.update(6000, 2500, 100, 3000), 12000u);
+    EXPECT_EQ(tuner.update(12000, 2400, 100, 3000), 6000u);
+    EXPECT_EQ(tuner.update(6000, 9000, 100, 3000), 6000u);
+    EXPECT_EQ(tuner.update(6000, 9000, 100, 5000), 10000u);
+}
+
+
+TEST(EvalMany, AutoBatchSize) {
+    using namespace simdjson_peval;
+
+    std::string data;
+    for (size_t idx = 0; idx < 40000; ++idx) {
+        data +=
+            "{\"id\":" + std::to_string(idx)
+            + ",\"name\":\"" + std::string(idx % 100, 'x') + "\"}\n";
+    }
+    data += "{\"id\":\"x\",\"name\":\"bad\"}\n";
+
+    eval_many_options fixed_options;
+    fixed_options.batch_size = 4096;
+
+    ItemCollector fixed_collector;
+    error fixed_errors(true);
+    const auto fixed_stats =
+        evalItems(data, &fixed_collector, &fixed_errors, fixed_options);
+    EXPECT_EQ(fixed_stats.batch_size_changes, 0u);
+
+    auto auto_options = fixed_options;
+    auto_options.auto_batch_size = true;
+    auto_options.min_auto_batch_size = 2048;
+    auto_options.max_auto_batch_size = 65536;
+
+    ItemCollector auto_collector;
+    error auto_errors(true);
+    const auto auto_stats =
+        evalItems(data, &auto_collector, &auto_errors, auto_options);
+
+    EXPECT_GT(auto_stats.batch_size_changes, 0u);
+    EXPECT_GE(auto_stats.batch_size, auto_options.min_auto_batch_size);
+    EXPECT_LE(auto_stats.batch_size, auto_options.max_auto_batch_size);
+    EXPECT_EQ(auto_stats.documents, 40001u);
+    EXPECT_EQ(auto_stats.records, 40000u);
+    EXPECT_EQ(auto_collector.items, fixed_collector.items);
+    EXPECT_TRUE(
+        sp_test::checkErrors(auto_errors, fixed_errors.get_messages()));
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            auto_errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>[40000].id"}
+            }));
+}
+
+
+TEST(EvalMany, LinePrefilter) {
+    using namespace simdjson_peval;
+
+    internal::line_prefilter prefilter({"\"b\"", "x"});
+
+    auto input = std::string_view("\"a\"x\n\"b\"\n\nx\"b\"\n\"a\"\n\"b\"x");
+    std::string_view line;
+    size_t dropped = 0;
+
+    EXPECT_TRUE(prefilter.next(&input, &line, &dropped));
+    EXPECT_EQ(line, "x\"b\"");
+    EXPECT_EQ(dropped, 3u);
+
+    EXPECT_TRUE(prefilter.next(&input, &line, &dropped));
+    EXPECT_EQ(line, "\"b\"x");
+    EXPECT_EQ(dropped, 1u);
+
+    EXPECT_FALSE(prefilter.next(&input, &line, &dropped));
+    EXPECT_EQ(dropped, 0u);
+    EXPECT_TRUE(input.empty());
+
+    // lines up to the end are dropped.
+    input = std::string_view("\"a\"\n\"b\"\n\"c\"");
+    EXPECT_FALSE(prefilter.next(&input, &line, &dropped));
+    EXPECT_EQ(dropped, 3u);
+}
+
+
+TEST(EvalMany, Prefilter) {
+    using namespace simdjson_peval;
+
+    ItemCollector collector;
+    error errors(true);
+    eval_many_options options;
+    options.records_per_batch = 2;
+    options.required_literals = {"\"name\":\"b\""};
+
+    auto stats =
+        evalItems(
+            "{\"id\":1,\"name\":\"a\"}\n"
+            "{\"id\":2,\"name\":\"b\"}\n"
+            "\n"
+            "{\"id\":\"x\",\"name\":\"b\"}\n"
+            "{\"id\":4,\"name\":\"c\"}\n"
+            "{\"id\":5,\"name\":\"b\"}\n"
+            "{\"id\":6,\"name\":\"b\"}\n",
+            &collector, &errors, options);
+
+    // documents are numbered by lines.
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>[3].id"}
+            }));
+    EXPECT_EQ(stats.documents, 4u);
+    EXPECT_EQ(stats.prefiltered_documents, 3u);
+    EXPECT_EQ(stats.failed_documents, 1u);
+    EXPECT_EQ(stats.records, 3u);
+    EXPECT_EQ(collector.batch_sizes, std::vector<size_t>({2, 1}));
+    EXPECT_EQ(
+        collector.items,
+        std::vector<Item>({{2, "b"}, {5, "b"}, {6, "b"}}));
+}
+
+
+TEST(EvalMany, PrefilterWhere) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    auto json =
+        simdjson::padded_string(
+            std::string(
+                "{\"level\":\"info\",\"msg\":\"header\"}\n"
+                "{\"level\":\"info\",\"msg\":\"a\"}\n"
+                "{\"level\":\"error\",\"msg\":\"b\"}\n"
+                "{\"level\":\"info\",\"msg\":\"\\\"level\\\":\\\"error\\\"\"}\n"
+                "{\"msg\":\"d\",\"level\":\"error\"}"));
+
+    std::pair<std::string, std::string> tmp_record;
+    auto proto =
+        object<simdjson::ondemand::document_reference>(
+            where(
+                member("level", string_value(&tmp_record.first)),
+                [&tmp_record]() { return tmp_record.first == "error"; }),
+            member("msg", string_value(&tmp_record.second)));
+
+    eval_many_options options;
+    options.skip_documents = 1;
+    options.required_literals = {"error", "\"level\":"};
+
+    std::vector<std::string> messages;
+    error errors(true);
+    const auto stats =
+        eval_many(
+            &parser, json, &tmp_record, proto,
+            [&messages](
+                record_batch<std::pair<std::string, std::string>> *batch,
+                error *)
+            {
+                for (const auto &record : *batch) {
+                    messages.push_back(record.second);
+                }
+            },
+            &errors, options);
+
+    // the predicate removes the false positive of the prefilter.
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+    EXPECT_EQ(stats.skipped_documents, 1u);
+    EXPECT_EQ(stats.prefiltered_documents, 1u);
+    EXPECT_EQ(stats.documents, 3u);
+    EXPECT_EQ(stats.rejected_documents, 1u);
+    EXPECT_EQ(messages, std::vector<std::string>({"b", "d"}));
+}
@@ -0,0 +1,224 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define _SIMDJSON_PEVAL_DO_TRACE 1
+#include "simdjson_peval_parallel.h"
+
+#include "gtest/gtest.h"
+
+#include "TestUtils.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+using sp_test::Item;
+using sp_test::createItems;
+using sp_test::makeItemProto;
+using sp_test::makeSaveItems;
+
+simdjson_peval::eval_many_stats
+evalSequential(
+    const simdjson::padded_string &json,
+    std::vector<Item> *items,
+    simdjson_peval::error *errors,
+    const simdjson_peval::eval_many_options &options)
+{
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    Item tmp_item;
+
+    return
+        eval_many(
+            &parser, json, &tmp_item, makeItemProto(&tmp_item),
+            makeSaveItems(items),
+            errors, options);
+}
+
+simdjson_peval::eval_parallel_stats
+evalParallel(
+    const simdjson::padded_string &json,
+    std::vector<Item> *items,
+    simdjson_peval::error *errors,
+    const simdjson_peval::eval_parallel_options &options)
+{
+    using namespace simdjson_peval;
+
+    return
+        eval_many_parallel<Item>(
+            json,
+            [](Item *tmp_item) { return makeItemProto(tmp_item); },
+            makeSaveItems(items),
+            errors, options);
+}
+
+} // namespace
+
+
+TEST(EvalManyParallel, OrderedMatchesSequential) {
+    using namespace simdjson_peval;
+
+    const auto json = simdjson::padded_string(createItems(1000, {10, 777}));
+
+    std::vector<Item> seq_items;
+    error seq_errors(true);
+    auto seq_stats =
+        evalSequential(json, &seq_items, &seq_errors, eval_many_options());
+
+    eval_parallel_options options;
+    options.threads = 4;
+    options.chunk_size = 256;
+    options.records_per_batch = 7;
+
+    std::vector<Item> items;
+    error errors(true);
+    auto stats = evalParallel(json, &items, &errors, options);
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>[10].id"},
+                {simdjson::INCORRECT_TYPE, "<root>[777].id"}
+            }));
+    EXPECT_TRUE(sp_test::checkErrors(errors, seq_errors.get_messages()));
+
+    EXPECT_GT(stats.chunks, 4u);
+    EXPECT_EQ(stats.threads, 4u);
+    EXPECT_EQ(stats.documents, seq_stats.documents);
+    EXPECT_EQ(stats.records, 998u);
+    EXPECT_EQ(stats.failed_documents, 2u);
+    EXPECT_EQ(items, seq_items);
+}
+
+
+TEST(EvalManyParallel, Unordered) {
+    using namespace simdjson_peval;
+
+    const auto json = simdjson::padded_string(createItems(500, {3}));
+
+    std::vector<Item> seq_items;
+    error seq_errors(true);
+    evalSequential(json, &seq_items, &seq_errors, eval_many_options());
+
+    eval_parallel_options options;
+    options.threads = 3;
+    options.chunk_size = 100;
+    options.ordered = false;
+
+    std::vector<Item> items;
+    error errors(true);
+    auto stats = evalParallel(json, &items, &errors, options);
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>[3].id"}
+            }));
+    EXPECT_EQ(stats.records, 499u);
+
+    std::sort(items.begin(), items.end());
+    EXPECT_EQ(items, seq_items);
+}
+
+
+TEST(EvalManyParallel, Histogram) {
+    using namespace simdjson_peval;
+
+    const auto json =
+        simdjson::padded_string(createItems(300, {5, 150, 299}));
+
+    eval_parallel_options options;
+    options.threads = 2;
+    options.chunk_size = 64;
+
+    std::vector<Item> items;
+    error_histogram histogram;
+    error errors(&histogram);
+    evalParallel(json, &items, &errors, options);
+
+    EXPECT_EQ(errors.get_count(), 3u);
+    ASSERT_EQ(histogram.get_entries().size(), 1u);
+
+    const auto &entry = histogram.get_entries()[0];
+    EXPECT_EQ(entry.get_path(), "<root>[*].id");
+    EXPECT_EQ(entry.get_count(), 3u);
+    EXPECT_EQ(entry.get_first_path(), "<root>[5].id");
+}
+
+
+TEST(EvalManyParallel, SkipDocuments) {
+    using namespace simdjson_peval;
+
+    const auto json =
+        simdjson::padded_string(
+            "[\"id\",\"name\"]\n" + createItems(100, {50}));
+
+    eval_parallel_options options;
+    options.threads = 2;
+    options.chunk_size = 64;
+    options.skip_documents = 1;
+
+    std::vector<Item> items;
+    error errors(true);
+    auto stats = evalParallel(json, &items, &errors, options);
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>[51].id"}
+            }));
+    EXPECT_EQ(stats.skipped_documents, 1u);
+    EXPECT_EQ(stats.documents, 100u);
+    EXPECT_EQ(items.size(), 99u);
+}
+
+
+TEST(EvalManyParallel, StopOnError) {
+    using namespace simdjson_peval;
+
+    const auto json = simdjson::padded_string(createItems(200, {120}));
+
+    eval_parallel_options options;
+    options.threads = 4;
+    options.chunk_size = 64;
+    options.stop_on_error = true;
+
+    std::vector<Item> items;
+    error errors(true);
+    evalParallel(json, &items, &errors, options);
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>[120].id"}
+            }));
+    ASSERT_EQ(items.size(), 120u);
+    EXPECT_EQ(items.back().id, 119);
+}
@@ -0,0 +1,313 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define _SIMDJSON_PEVAL_DO_TRACE 1
+#include "simdjson_peval_parallel.h"
+
+#include "gtest/gtest.h"
+
+#include "TestUtils.h"
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using sp_test::Item;
+using sp_test::StringSource;
+using sp_test::createItems;
+using sp_test::makeItemProto;
+using sp_test::makeSaveItems;
+
+simdjson_peval::eval_many_stats
+evalPipeline(
+    StringSource source,
+    std::vector<Item> *items,
+    simdjson_peval::error *errors,
+    const simdjson_peval::eval_pipeline_options &options)
+{
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    Item tmp_item;
+
+    return
+        eval_many_pipeline(
+            &parser, source, &tmp_item, makeItemProto(&tmp_item),
+            makeSaveItems(items),
+            errors, options);
+}
+
+} // namespace
+
+
+TEST(SpscQueue, Order) {
+    using namespace simdjson_peval;
+
+    spsc_queue<size_t> queue(3);
+    EXPECT_EQ(queue.get_capacity(), 3u);
+
+    const size_t num_values = 10000;
+    std::thread producer(
+        [&queue]() {
+            for (size_t idx = 1; idx <= num_values; ++idx) {
+                queue.push(idx);
+            }
+        });
+
+    size_t expected = 1;
+    for (auto value = queue.pop(); ; value = queue.pop()) {
+        ASSERT_EQ(value, expected);
+        if (value == num_values) {
+            break;
+        }
+        ++expected;
+    }
+
+    producer.join();
+
+    size_t value;
+    EXPECT_FALSE(queue.try_pop(&value));
+}
+
+
+TEST(SpscQueue, SleepWhileEmpty) {
+    using namespace simdjson_peval;
+
+    spsc_queue<size_t> queue(1);
+    std::thread producer(
+        [&queue]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+            queue.push(1);
+            queue.push(2);
+            queue.push(3);
+        });
+
+    // the consumer doesn't spin while waiting for the slow producer.
+    const auto start_cpu = std::clock();
+    EXPECT_EQ(queue.pop(), 1u);
+    const auto cpu_ms = (std::clock() - start_cpu) * 1000 / CLOCKS_PER_SEC;
+    EXPECT_LT(cpu_ms, 100);
+
+    // the producer sleeps while the queue is full.
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(queue.pop(), 2u);
+    EXPECT_EQ(queue.pop(), 3u);
+
+    producer.join();
+}
+
+
+TEST(EvalManyPipeline, MatchesSequential) {
+    using namespace simdjson_peval;
+
+    const auto raw_json = createItems(1000, {10, 777});
+
+    std::vector<Item> seq_items;
+    error seq_errors(true);
+    {
+        simdjson::ondemand::parser parser;
+        Item tmp_item;
+        auto proto =
+            object<simdjson::ondemand::document_reference>(
+                member("id", number_value(&tmp_item.id)),
+                member("name", string_value(&tmp_item.name)));
+        eval_many(
+            &parser, simdjson::padded_string(raw_json), &tmp_item, proto,
+            [&seq_items](record_batch<Item> *batch, error *err) {
+                for (auto &item : *batch) {
+                    seq_items.push_back(std::move(item));
+                }
+            },
+            &seq_errors);
+    }
+
+    eval_pipeline_options options;
+    options.block_size = 128;
+    options.queue_depth = 2;
+    options.records_per_batch = 5;
+
+    std::vector<Item> items;
+    error errors(true);
+    auto stats =
+        evalPipeline(StringSource{raw_json, 37}, &items, &errors, options);
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>[10].id"},
+                {simdjson::INCORRECT_TYPE, "<root>[777].id"}
+            }));
+    EXPECT_EQ(stats.documents, 1000u);
+    EXPECT_EQ(stats.records, 998u);
+    EXPECT_EQ(stats.failed_documents, 2u);
+    EXPECT_EQ(stats.truncated_bytes, 0u);
+    EXPECT_EQ(items, seq_items);
+}
+
+
+TEST(EvalManyPipeline, LongDocument) {
+    using namespace simdjson_peval;
+
+    const std::string long_name(200, 'x');
+    const auto raw_json =
+        "{\"id\":1,\"name\":\"a\"}\n"
+        "{\"id\":2,\"name\":\"" + long_name + "\"}\n"
+        "{\"id\":3,\"name\":\"c\"}";
+
+    eval_pipeline_options options;
+    options.block_size = 16;
+    options.skip_documents = 1;
+
+    std::vector<Item> items;
+    error errors(true);
+    auto stats =
+        evalPipeline(StringSource{raw_json, 1000}, &items, &errors, options);
+
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+    EXPECT_EQ(stats.skipped_documents, 1u);
+    EXPECT_EQ(stats.documents, 2u);
+    EXPECT_EQ(items, std::vector<Item>({{2, long_name}, {3, "c"}}));
+}
+
+
+TEST(EvalManyPipeline, ShortRead) {
+    using namespace simdjson_peval;
+
+    eval_pipeline_options options;
+    options.records_per_batch = 1;
+
+    simdjson::ondemand::parser parser;
+    Item tmp_item;
+    auto proto =
+        object<simdjson::ondemand::document_reference>(
+            member("id", number_value(&tmp_item.id)),
+            member("name", string_value(&tmp_item.name)));
+
+    // the source returns the second part only after the first record
+    // was passed.
+    const std::vector<std::string_view> parts({
+            "{\"id\":1,\"name\":\"a\"}\n{\"id",
+            "\":2,\"name\":\"b\"}\n"
+        });
+    std::atomic<size_t> num_records{0};
+    bool passed_early = false;
+    size_t num_reads = 0;
+    auto source =
+        [&](char *buffer, size_t capacity)
+            -> simdjson::simdjson_result<size_t>
+        {
+            if (num_reads == 1) {
+                const auto deadline =
+                    std::chrono::steady_clock::now()
+                    + std::chrono::seconds(10);
+                while (num_records.load() == 0
+                       && std::chrono::steady_clock::now() < deadline)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                passed_early = (num_records.load() != 0);
+            }
+
+            if (num_reads == parts.size()) {
+                return size_t(0);
+            }
+
+            const auto part = parts[num_reads++];
+            std::memcpy(buffer, part.data(), part.size());
+            return part.size();
+        };
+
+    std::vector<Item> items;
+    error errors(true);
+    auto stats =
+        eval_many_pipeline(
+            &parser, source, &tmp_item, proto,
+            [&](record_batch<Item> *batch, error *) {
+                for (auto &item : *batch) {
+                    items.push_back(std::move(item));
+                }
+                num_records.store(items.size());
+            },
+            &errors, options);
+
+    EXPECT_TRUE(passed_early);
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+    EXPECT_EQ(stats.documents, 2u);
+    EXPECT_EQ(items, std::vector<Item>({{1, "a"}, {2, "b"}}));
+}
+
+
+TEST(EvalManyPipeline, ReadError) {
+    using namespace simdjson_peval;
+
+    const auto raw_json = createItems(100, {});
+
+    eval_pipeline_options options;
+    options.block_size = 64;
+
+    std::vector<Item> items;
+    error errors(true);
+    auto stats =
+        evalPipeline(
+            StringSource{raw_json, 10, raw_json.find("item50")},
+            &items, &errors, options);
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::IO_ERROR, "<root>"}
+            }));
+    EXPECT_EQ(stats.records, 50u);
+    EXPECT_GT(stats.truncated_bytes, 0u);
+}
+
+
+TEST(EvalManyPipeline, StopOnError) {
+    using namespace simdjson_peval;
+
+    const auto raw_json = createItems(200, {120});
+
+    eval_pipeline_options options;
+    options.block_size = 64;
+    options.stop_on_error = true;
+
+    std::vector<Item> items;
+    error errors(true);
+    evalPipeline(StringSource{raw_json, 50}, &items, &errors, options);
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>[120].id"}
+            }));
+    ASSERT_EQ(items.size(), 120u);
+    EXPECT_EQ(items.back().id, 119);
+}
@@ -0,0 +1,339 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define _SIMDJSON_PEVAL_DO_TRACE 1
+#include "simdjson_peval_ndjson.h"
+#include "simdjson_peval_io.h"
+
+#include "gtest/gtest.h"
+
+#include "TestUtils.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+
+namespace {
+
+using sp_test::Item;
+using sp_test::createItems;
+using sp_test::makeItemProto;
+using sp_test::makeSaveItems;
+
+} // namespace
+
+
+TEST(Feeder, RandomFragments) {
+    using namespace simdjson_peval;
+
+    const auto raw_json = createItems(500, {4, 250});
+
+    std::vector<Item> seq_items;
+    error seq_errors(true);
+    {
+        simdjson::ondemand::parser parser;
+        Item tmp_item;
+        eval_many(
+            &parser, simdjson::padded_string(raw_json), &tmp_item,
+            makeItemProto(&tmp_item), makeSaveItems(&seq_items),
+            &seq_errors);
+    }
+
+    simdjson::ondemand::parser parser;
+    Item tmp_item;
+    std::vector<Item> items;
+    error errors(true);
+
+    feeder feed(
+        &parser, &tmp_item, makeItemProto(&tmp_item), makeSaveItems(&items),
+        &errors);
+
+    // split stream at pseudo random positions.
+    std::string_view data(raw_json);
+    uint32_t random = 1;
+    while (!data.empty()) {
+        random = random * 1103515245 + 12345;
+        const auto size = std::min(size_t(random >> 16) % 40 + 1, data.size());
+        feed.push(data.substr(0, size));
+        data.remove_prefix(size);
+    }
+
+    EXPECT_EQ(feed.get_pending(), 0u);
+    feed.finish();
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>[4].id"},
+                {simdjson::INCORRECT_TYPE, "<root>[250].id"}
+            }));
+    EXPECT_TRUE(sp_test::checkErrors(errors, seq_errors.get_messages()));
+    EXPECT_EQ(feed.get_stats().documents, 500u);
+    EXPECT_EQ(feed.get_stats().records, 498u);
+    EXPECT_EQ(feed.get_stats().failed_documents, 2u);
+    EXPECT_TRUE(items == seq_items);
+}
+
+
+TEST(Feeder, LastDocument) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    Item tmp_item;
+    std::vector<Item> items;
+    error errors(true);
+    eval_many_options options;
+    options.skip_documents = 1;
+
+    feeder feed(
+        &parser, &tmp_item, makeItemProto(&tmp_item), makeSaveItems(&items),
+        &errors, options);
+
+    feed.push("[\"id\",\"name\"]\n{\"id\":1,\"na");
+    EXPECT_TRUE(items.empty());
+    EXPECT_EQ(feed.get_pending(), 11u);
+
+    // the record stays in the partial batch until finish().
+    feed.push("me\":\"a\"}\n{\"id\":2,\"name\":\"b\"}");
+    EXPECT_TRUE(items.empty());
+    EXPECT_EQ(feed.get_stats().documents, 1u);
+
+    feed.finish();
+    EXPECT_EQ(items, std::vector<Item>({{1, "a"}, {2, "b"}}));
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+    EXPECT_EQ(feed.get_stats().skipped_documents, 1u);
+    EXPECT_EQ(feed.get_stats().documents, 2u);
+}
+
+
+TEST(Feeder, FullBatches) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    Item tmp_item;
+    std::vector<size_t> batch_sizes;
+    error errors(true);
+    eval_many_options options;
+    options.records_per_batch = 3;
+
+    feeder feed(
+        &parser, &tmp_item, makeItemProto(&tmp_item),
+        [&batch_sizes](record_batch<Item> *batch, error *) {
+            batch_sizes.push_back(batch->size());
+        },
+        &errors, options);
+
+    // one document per push: only full batches are passed.
+    const auto raw_json = createItems(7, {});
+    std::string_view data(raw_json);
+    while (!data.empty()) {
+        const auto size = data.find('\n') + 1;
+        feed.push(data.substr(0, size));
+        data.remove_prefix(size);
+    }
+
+    EXPECT_EQ(batch_sizes, std::vector<size_t>({3, 3}));
+    EXPECT_EQ(feed.get_stats().records, 6u);
+
+    feed.finish();
+    EXPECT_EQ(batch_sizes, std::vector<size_t>({3, 3, 1}));
+    EXPECT_EQ(feed.get_stats().records, 7u);
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+}
+
+
+TEST(Feeder, Flush) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    Item tmp_item;
+    std::vector<Item> items;
+    error errors(true);
+
+    feeder feed(
+        &parser, &tmp_item, makeItemProto(&tmp_item), makeSaveItems(&items),
+        &errors);
+
+    feed.push("{\"id\":1,\"name\":\"a\"}\n{\"id\":2,");
+    EXPECT_TRUE(items.empty());
+
+    // the partial batch is passed without further documents.
+    feed.flush();
+    EXPECT_EQ(items, std::vector<Item>({{1, "a"}}));
+    EXPECT_EQ(feed.get_stats().records, 1u);
+
+    feed.flush();
+    EXPECT_EQ(items.size(), 1u);
+
+    feed.push("\"name\":\"b\"}\n");
+    feed.finish();
+    EXPECT_EQ(items, std::vector<Item>({{1, "a"}, {2, "b"}}));
+    EXPECT_EQ(feed.get_stats().records, 2u);
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+}
+
+
+TEST(Feeder, DocumentWithLineBreaks) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    Item tmp_item;
+    std::vector<Item> items;
+    error errors(true);
+    eval_many_options options;
+    options.truncated_is_error = true;
+
+    feeder feed(
+        &parser, &tmp_item, makeItemProto(&tmp_item), makeSaveItems(&items),
+        &errors, options);
+
+    // the incomplete document is kept for the next part.
+    feed.push("{\"id\":1,\"name\":\"a\"}\n{\"id\":2,\n");
+    EXPECT_EQ(feed.get_pending(), 9u);
+    EXPECT_EQ(feed.get_stats().documents, 1u);
+
+    feed.push("\"name\":\"b\"}\n{\"id\":3,\n");
+    EXPECT_EQ(feed.get_stats().documents, 2u);
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+
+    // the incomplete document at the end of the stream is reported.
+    feed.finish();
+    EXPECT_EQ(items, std::vector<Item>({{1, "a"}, {2, "b"}}));
+    EXPECT_EQ(feed.get_stats().truncated_bytes, 9u);
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCOMPLETE_ARRAY_OR_OBJECT, "<root>[2]"}
+            }));
+}
+
+
+TEST(Feeder, AutoBatchSize) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    Item tmp_item;
+    std::vector<Item> items;
+    error errors(true);
+    eval_many_options options;
+    options.batch_size = 4096;
+    options.auto_batch_size = true;
+    options.min_auto_batch_size = 2048;
+    options.max_auto_batch_size = 65536;
+
+    feeder feed(
+        &parser, &tmp_item, makeItemProto(&tmp_item), makeSaveItems(&items),
+        &errors, options);
+
+    // one document per push: the measurement spans the pushes.
+    const size_t num_items = 100000;
+    const auto raw_json = createItems(num_items, {});
+    std::string_view data(raw_json);
+    while (!data.empty()) {
+        const auto size = data.find('\n') + 1;
+        feed.push(data.substr(0, size));
+        data.remove_prefix(size);
+    }
+    feed.finish();
+
+    EXPECT_GT(feed.get_stats().batch_size_changes, 0u);
+    EXPECT_NE(feed.get_stats().batch_size, options.batch_size);
+    EXPECT_EQ(feed.get_stats().records, num_items);
+    EXPECT_EQ(items.size(), num_items);
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+}
+
+
+TEST(Feeder, StopOnError) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    Item tmp_item;
+    std::vector<Item> items;
+    error errors(true);
+    eval_many_options options;
+    options.stop_on_error = true;
+
+    feeder feed(
+        &parser, &tmp_item, makeItemProto(&tmp_item), makeSaveItems(&items),
+        &errors, options);
+
+    feed.push(createItems(3, {1}));
+    feed.push(createItems(3, {}));
+    feed.finish();
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>[1].id"}
+            }));
+    EXPECT_EQ(items, std::vector<Item>({{0, "item0"}}));
+}
+
+
+TEST(Feeder, SocketPair) {
+    using namespace simdjson_peval;
+
+    const auto raw_json = createItems(5000, {});
+
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+    std::thread writer(
+        [&raw_json, fd = fds[1]]() {
+            std::string_view data(raw_json);
+            while (!data.empty()) {
+                const auto size = std::min(data.size(), size_t(999));
+                const auto result = write(fd, data.data(), size);
+                if (result <= 0) {
+                    break;
+                }
+                data.remove_prefix(size_t(result));
+            }
+            close(fd);
+        });
+
+    simdjson::ondemand::parser parser;
+    Item tmp_item;
+    std::vector<Item> items;
+    error errors(true);
+
+    feeder feed(
+        &parser, &tmp_item, makeItemProto(&tmp_item), makeSaveItems(&items),
+        &errors);
+    feed.read_all(fd_source(fds[0]), 4096);
+
+    writer.join();
+    close(fds[0]);
+
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+    EXPECT_EQ(feed.get_stats().documents, 5000u);
+    ASSERT_EQ(items.size(), 5000u);
+    EXPECT_EQ(items[4999], Item({4999, "item4999"}));
+}
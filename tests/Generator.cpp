@@ -0,0 +1,205 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define _SIMDJSON_PEVAL_DO_TRACE 1
+#include "simdjson_peval_generator.h"
+
+// Generators need C++20 coroutines.
+#ifdef __cpp_impl_coroutine
+
+#include "gtest/gtest.h"
+
+#include "TestUtils.h"
+
+#include <vector>
+
+using namespace simdjson::builtin;
+
+namespace {
+
+struct Item {
+    int64_t id;
+    std::string name;
+
+    bool
+    operator==(const Item &other) const {
+        return (id == other.id && name == other.name);
+    }
+};
+
+} // namespace
+
+
+TEST(Generator, Records) {
+    using namespace simdjson_peval;
+
+    auto json =
+        R"( [{"id":1,"name":"a"}, {"id":"x","name":"b"},
+             {"id":3,"name":"c"}] )"_padded;
+
+    simdjson::ondemand::parser parser;
+    auto sj_doc = parser.iterate(json);
+
+    Item tmp_item;
+    auto eval_item =
+        object(
+            member("id", number_value(&tmp_item.id)),
+            member("name", string_value(&tmp_item.name)));
+
+    error errors(true);
+    std::vector<Item> items;
+    for (auto &item : records(sj_doc, &tmp_item, eval_item, &errors)) {
+        items.push_back(std::move(item));
+    }
+
+    EXPECT_EQ(items, std::vector<Item>({{1, "a"}, {3, "c"}}));
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>[1].id"}
+            }));
+}
+
+
+TEST(Generator, EarlyStop) {
+    using namespace simdjson_peval;
+
+    auto json = R"( [1, 2, 3, 4, 5, 6] )"_padded;
+
+    simdjson::ondemand::parser parser;
+    auto sj_doc = parser.iterate(json);
+
+    int64_t tmp_value;
+    size_t num_evaluated = 0;
+    auto eval_value =
+        [&num_evaluated, inner_fn = number_value(&tmp_value)]
+        (simdjson::simdjson_result<simdjson::ondemand::value> &sj_value,
+         error *err) mutable {
+            ++num_evaluated;
+            inner_fn(sj_value, err);
+        };
+
+    error errors(true);
+    std::vector<int64_t> values;
+    for (auto value : records(sj_doc, &tmp_value, eval_value, &errors)) {
+        values.push_back(value);
+        if (values.size() == 2) {
+            break;
+        }
+    }
+
+    EXPECT_EQ(values, std::vector<int64_t>({1, 2}));
+    EXPECT_EQ(num_evaluated, 2u);
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+}
+
+
+TEST(Generator, NoArray) {
+    using namespace simdjson_peval;
+
+    auto json = R"( {"id":1} )"_padded;
+
+    simdjson::ondemand::parser parser;
+    auto sj_doc = parser.iterate(json);
+
+    int64_t tmp_value;
+    error errors(true);
+    size_t num_values = 0;
+    for ([[maybe_unused]] auto value :
+             records(sj_doc, &tmp_value, number_value(&tmp_value), &errors))
+    {
+        ++num_values;
+    }
+
+    EXPECT_EQ(num_values, 0u);
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>"}
+            }));
+}
+
+
+TEST(Generator, ArrayLimit) {
+    using namespace simdjson_peval;
+
+    auto json = R"( [1, 2, 3, 4, 5, 6] )"_padded;
+
+    simdjson::ondemand::parser parser;
+    auto sj_doc = parser.iterate(json);
+
+    eval_limits limits;
+    limits.max_array_elements = 3;
+
+    int64_t tmp_value;
+    error errors(true);
+    errors.set_limits(&limits);
+    std::vector<int64_t> values;
+    for (auto value
+             : records(sj_doc, &tmp_value, number_value(&tmp_value), &errors))
+    {
+        values.push_back(value);
+    }
+
+    EXPECT_EQ(values, std::vector<int64_t>({1, 2, 3}));
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {ARRAY_LIMIT_EXCEEDED, "<root>[3]"}
+            }));
+}
+
+
+TEST(Generator, Ranges) {
+    using namespace simdjson_peval;
+
+    static_assert(std::ranges::input_range<generator<int64_t>>);
+    static_assert(std::ranges::view<generator<int64_t>>);
+
+    auto json = R"( {"values": [1, 2, 3, 4, 5, 6]} )"_padded;
+
+    simdjson::ondemand::parser parser;
+    auto sj_doc = parser.iterate(json);
+    auto sj_values = sj_doc["values"].get_array();
+
+    int64_t tmp_value;
+    error errors(true);
+    auto odd_values =
+        records(sj_values, &tmp_value, number_value(&tmp_value), &errors)
+        | std::views::filter([](int64_t value) { return (value % 2) != 0; })
+        | std::views::take(2);
+
+    std::vector<int64_t> values;
+    for (auto value : odd_values) {
+        values.push_back(value);
+    }
+
+    EXPECT_EQ(values, std::vector<int64_t>({1, 3}));
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+}
+
+#endif // __cpp_impl_coroutine
@@ -0,0 +1,222 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define _SIMDJSON_PEVAL_DO_TRACE 1
+#include "simdjson_peval_io.h"
+#include "simdjson_peval_ndjson.h"
+
+#include "gtest/gtest.h"
+
+#include "TestUtils.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+struct Item {
+    int64_t id;
+    std::string name;
+};
+
+/// Write data into a temporary file.
+std::string
+writeTempFile(const std::string &data) {
+    char path[] = "/tmp/simdjson_peval_XXXXXX";
+    const int fd = mkstemp(path);
+    EXPECT_GE(fd, 0);
+    EXPECT_EQ(write(fd, data.data(), data.size()), ssize_t(data.size()));
+    close(fd);
+
+    return path;
+}
+
+/// Evaluate all items of a stream.
+std::vector<Item>
+evalItems(simdjson::padded_string_view json, simdjson_peval::error *errors) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    Item tmp_item;
+    auto proto =
+        object<simdjson::ondemand::document_reference>(
+            member("id", number_value(&tmp_item.id)),
+            member("name", string_value(&tmp_item.name)));
+
+    std::vector<Item> items;
+    eval_many(
+        &parser, json, &tmp_item, proto,
+        [&items](record_batch<Item> *batch, error *err) {
+            for (auto &item : *batch) {
+                items.push_back(std::move(item));
+            }
+        },
+        errors);
+
+    return items;
+}
+
+} // namespace
+
+
+TEST(InputAdapters, MappedFile) {
+    using namespace simdjson_peval;
+
+    // file size is a multiple of the page size: padding is in the
+    // anonymous mapping behind the file.
+    const size_t page_size = size_t(sysconf(_SC_PAGESIZE));
+    std::string data;
+    for (int64_t idx = 0; data.size() + 64 < page_size; ++idx) {
+        data += "{\"id\":" + std::to_string(idx) + ",\"name\":\"a\"}\n";
+    }
+    data.resize(page_size - 1, ' ');
+    data.push_back('\n');
+
+    const auto path = writeTempFile(data);
+
+    mapped_file file;
+    ASSERT_EQ(file.open(path), simdjson::SUCCESS);
+    EXPECT_TRUE(file.is_mapped());
+    EXPECT_EQ(file.size(), page_size);
+    EXPECT_GE(file.view().capacity(),
+              file.size() + simdjson::SIMDJSON_PADDING);
+    EXPECT_EQ(std::string_view(file.view()), data);
+
+    error errors(true);
+    auto items = evalItems(file.view(), &errors);
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+    EXPECT_GT(items.size(), 10u);
+
+    // moved file stays mapped.
+    mapped_file moved_file(std::move(file));
+    EXPECT_FALSE(file.is_mapped());
+    EXPECT_TRUE(moved_file.is_mapped());
+    EXPECT_EQ(std::string_view(moved_file.view()), data);
+
+    moved_file.close();
+    EXPECT_FALSE(moved_file.is_mapped());
+    std::remove(path.c_str());
+}
+
+
+TEST(InputAdapters, MappedFileErrors) {
+    using namespace simdjson_peval;
+
+    mapped_file file;
+    EXPECT_EQ(file.open("/tmp/simdjson_peval_does_not_exist"),
+              simdjson::IO_ERROR);
+
+    // empty file is read into buffer.
+    const auto path = writeTempFile("");
+    EXPECT_EQ(file.open(path), simdjson::SUCCESS);
+    EXPECT_FALSE(file.is_mapped());
+    EXPECT_EQ(file.size(), 0u);
+    std::remove(path.c_str());
+}
+
+
+TEST(InputAdapters, PaddedViewString) {
+    using namespace simdjson_peval;
+
+    std::string data = "{\"id\":1,\"name\":\"a\"}\n";
+
+    // enlarge capacity once.
+    auto view = padded_view(&data);
+    EXPECT_EQ(view.size(), data.size());
+    EXPECT_GE(view.capacity(), data.size() + simdjson::SIMDJSON_PADDING);
+
+    // no copy, if capacity is large enough.
+    const auto *ptr = data.data();
+    view = padded_view(&data);
+    EXPECT_EQ(view.data(), ptr);
+    EXPECT_EQ(data.size(), 20u);
+
+    error errors(true);
+    auto items = evalItems(view, &errors);
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+    ASSERT_EQ(items.size(), 1u);
+    EXPECT_EQ(items[0].name, "a");
+}
+
+
+TEST(InputAdapters, PaddedViewVector) {
+    using namespace simdjson_peval;
+
+    const std::string_view json = "{\"id\":1,\"name\":\"a\"}\n";
+    std::vector<char> data;
+    data.reserve(json.size() + simdjson::SIMDJSON_PADDING);
+    data.assign(json.begin(), json.end());
+
+    const auto *ptr = data.data();
+    auto view = padded_view(&data);
+    EXPECT_EQ(view.data(), ptr);
+    EXPECT_EQ(view.size(), json.size());
+
+    error errors(true);
+    auto items = evalItems(view, &errors);
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+    EXPECT_EQ(items.size(), 1u);
+}
+
+
+TEST(InputAdapters, LoadFile) {
+    using namespace simdjson_peval;
+
+    std::string data;
+    for (int64_t idx = 0; data.size() < (size_t(3) << 20); ++idx) {
+        data += "{\"id\":" + std::to_string(idx) + ",\"name\":\"a\"}\n";
+    }
+    const auto path = writeTempFile(data);
+
+    for (const auto huge_pages : {false, true}) {
+        padded_buffer buffer(0, huge_pages);
+        EXPECT_EQ(buffer.is_huge_pages_enabled(), huge_pages);
+        ASSERT_EQ(load_file(path, &buffer), simdjson::SUCCESS);
+        EXPECT_EQ(std::string_view(buffer.data(), buffer.size()), data);
+
+        // huge pages: allocation is rounded up to huge pages.
+        const auto allocated =
+            buffer.get_capacity() + simdjson::SIMDJSON_PADDING;
+        EXPECT_EQ(allocated % (size_t(2) << 20) == 0, huge_pages);
+        EXPECT_EQ(
+            reinterpret_cast<uintptr_t>(buffer.data()) % (size_t(2) << 20)
+            == 0,
+            huge_pages);
+
+        error errors(true);
+        auto items = evalItems(buffer.view(), &errors);
+        EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+        EXPECT_EQ(items.size(), size_t(std::count(data.begin(), data.end(), '\n')));
+    }
+    std::remove(path.c_str());
+
+    // small buffers use normal allocations.
+    padded_buffer small_buffer(100, true);
+    EXPECT_EQ(small_buffer.get_capacity(), 100u);
+
+    padded_buffer buffer;
+    EXPECT_EQ(load_file("/tmp/simdjson_peval_does_not_exist", &buffer),
+              simdjson::IO_ERROR);
+    EXPECT_EQ(buffer.size(), 0u);
+}
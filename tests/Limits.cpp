@@ -0,0 +1,374 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define _SIMDJSON_PEVAL_DO_TRACE 1
+#include "simdjson_peval_io.h"
+#include "simdjson_peval_parallel.h"
+
+#include "gtest/gtest.h"
+
+#include "TestUtils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// Evaluate the member "values" with an array of numbers.
+std::vector<int64_t>
+evalNumbers(
+    std::string_view raw_json,
+    const simdjson_peval::eval_limits &limits,
+    simdjson_peval::error *errors)
+{
+    using namespace simdjson_peval;
+
+    std::vector<int64_t> result;
+    int64_t tmp_value = 0;
+    auto proto =
+        object<simdjson::ondemand::document>(
+            member(
+                "values",
+                array_to_out_iter(
+                    back_inserter(result), &tmp_value,
+                    number_value(&tmp_value))));
+
+    simdjson::ondemand::parser parser;
+    auto json = simdjson::padded_string(raw_json);
+    auto doc = parser.iterate(json);
+
+    errors->set_limits(&limits);
+    proto(doc, errors);
+
+    return result;
+}
+
+} // namespace
+
+
+TEST(Limits, Depth) {
+    using namespace simdjson_peval;
+
+    eval_limits limits;
+    limits.max_depth = 2;
+
+    int64_t a_b_c = 0;
+    auto proto =
+        object<simdjson::ondemand::document>(
+            member(
+                "a",
+                object(
+                    member(
+                        "b",
+                        object(member("c", number_value(&a_b_c)))))));
+
+    simdjson::ondemand::parser parser;
+    auto json = R"({"a":{"b":{"c":1}}})"_padded;
+    auto doc = parser.iterate(json);
+
+    error errors(true);
+    errors.set_limits(&limits);
+    EXPECT_EQ(errors.get_limits(), &limits);
+    proto(doc, &errors);
+
+    EXPECT_EQ(a_b_c, 0);
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {DEPTH_LIMIT_EXCEEDED, "<root>.a.b.c"}
+            }));
+
+    // depth within limit.
+    limits.max_depth = 3;
+    errors.reset();
+    doc = parser.iterate(json);
+    proto(doc, &errors);
+
+    EXPECT_EQ(a_b_c, 1);
+    EXPECT_FALSE(errors);
+}
+
+
+TEST(Limits, ArrayElements) {
+    using namespace simdjson_peval;
+
+    eval_limits limits;
+    limits.max_array_elements = 3;
+
+    error errors(true);
+    const auto values =
+        evalNumbers(R"({"values":[0,1,2,3,4,5]})", limits, &errors);
+
+    EXPECT_EQ(values, std::vector<int64_t>({0, 1, 2}));
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {ARRAY_LIMIT_EXCEEDED, "<root>.values[3]"}
+            }));
+
+    errors.reset();
+    EXPECT_EQ(
+        evalNumbers(R"({"values":[0,1,2]})", limits, &errors).size(), 3u);
+    EXPECT_FALSE(errors);
+}
+
+
+TEST(Limits, TopLevelArray) {
+    using namespace simdjson_peval;
+
+    eval_limits limits;
+    limits.max_array_elements = 3;
+
+    const std::string raw_json = "[0,1,2,3,4,5,6,7,8,9]";
+    const std::vector<int64_t> expected({0, 1, 2});
+    const error::message_container expected_errors({
+            {ARRAY_LIMIT_EXCEEDED, "<root>[3]"}
+        });
+
+    // eval_array_stream()
+    {
+        simdjson::ondemand::parser parser;
+        std::string_view data = raw_json;
+
+        error errors(true);
+        errors.set_limits(&limits);
+
+        int64_t tmp_value = 0;
+        std::vector<int64_t> values;
+        eval_array_stream(
+            &parser,
+            [&data](char *buffer, size_t capacity)
+                -> simdjson::simdjson_result<size_t>
+            {
+                auto size = std::min(capacity, data.size());
+                std::memcpy(buffer, data.data(), size);
+                data.remove_prefix(size);
+                return size;
+            },
+            &tmp_value, number_value(&tmp_value),
+            [&values](record_batch<int64_t> *batch, error *) {
+                for (auto value : *batch) {
+                    values.push_back(value);
+                }
+            },
+            &errors);
+
+        EXPECT_EQ(values, expected);
+        EXPECT_TRUE(sp_test::checkErrors(errors, expected_errors));
+    }
+
+    // eval_array_parallel() with ranges of a single element.
+    {
+        auto json = simdjson::padded_string(raw_json);
+
+        error errors(true);
+        errors.set_limits(&limits);
+
+        eval_array_parallel_options options;
+        options.threads = 2;
+        options.range_size = 1;
+
+        std::vector<int64_t> values;
+        eval_array_parallel<int64_t>(
+            json, back_inserter(values),
+            [](int64_t *tmp_value) { return number_value(tmp_value); },
+            &errors, options);
+
+        EXPECT_EQ(values, expected);
+        EXPECT_TRUE(sp_test::checkErrors(errors, expected_errors));
+    }
+}
+
+
+TEST(Limits, Clear) {
+    using namespace simdjson_peval;
+
+    eval_limits limits;
+    limits.max_array_elements = 3;
+
+    error errors(true);
+    evalNumbers(R"({"values":[0,1,2,3]})", limits, &errors);
+    EXPECT_TRUE(errors.is_stopped());
+
+    // the exceeded limit doesn't stop the next record.
+    errors.clear();
+    EXPECT_FALSE(errors.is_stopped());
+    EXPECT_EQ(
+        evalNumbers(R"({"values":[0,1,2]})", limits, &errors),
+        std::vector<int64_t>({0, 1, 2}));
+    EXPECT_FALSE(errors);
+}
+
+
+TEST(Limits, Elements) {
+    using namespace simdjson_peval;
+
+    eval_limits limits;
+    limits.max_elements = 4;
+
+    // the member "values" is counted as element, too.
+    error errors(true);
+    const auto values =
+        evalNumbers(R"({"values":[0,1,2,3,4,5]})", limits, &errors);
+
+    EXPECT_EQ(values, std::vector<int64_t>({0, 1, 2}));
+    EXPECT_EQ(errors.get_usage().elements, 5u);
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {ELEMENT_LIMIT_EXCEEDED, "<root>.values[3]"}
+            }));
+}
+
+
+TEST(Limits, StringBytes) {
+    using namespace simdjson_peval;
+
+    eval_limits limits;
+    limits.max_string_bytes = 10;
+
+    std::vector<std::string> names;
+    std::string tmp_name;
+    auto proto =
+        array_to_out_iter<simdjson::ondemand::document>(
+            back_inserter(names), &tmp_name, string_value(&tmp_name));
+
+    simdjson::ondemand::parser parser;
+    auto json = R"(["abcd","efgh","ijkl","mnop"])"_padded;
+    auto doc = parser.iterate(json);
+
+    error errors(true);
+    errors.set_limits(&limits);
+    proto(doc, &errors);
+
+    // the string exceeding the limit is not copied.
+    EXPECT_EQ(names, std::vector<std::string>({"abcd", "efgh", ""}));
+    EXPECT_EQ(errors.get_usage().string_bytes, 8u);
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {STRING_LIMIT_EXCEEDED, "<root>[2]"}
+            }));
+
+    // string views are not copied and not counted.
+    std::vector<std::string_view> views;
+    std::string_view tmp_view;
+    auto view_proto =
+        array_to_out_iter<simdjson::ondemand::document>(
+            back_inserter(views), &tmp_view, string_value(&tmp_view));
+
+    errors.reset();
+    doc = parser.iterate(json);
+    view_proto(doc, &errors);
+
+    EXPECT_EQ(views.size(), 4u);
+    EXPECT_EQ(errors.get_usage().string_bytes, 0u);
+    EXPECT_FALSE(errors);
+}
+
+
+TEST(Limits, EvalMany) {
+    using namespace simdjson_peval;
+
+    eval_limits limits;
+    limits.max_array_elements = 3;
+
+    error errors(true);
+    errors.set_limits(&limits);
+
+    simdjson::ondemand::parser parser;
+    auto json =
+        simdjson::padded_string(
+            std::string(R"({"values":[1,2]})" "\n"
+                        R"({"values":[1,2,3,4,5]})" "\n"
+                        R"({"values":[1,2,3]})" "\n"));
+
+    std::vector<int64_t> tmp_values;
+    int64_t tmp_value = 0;
+    auto proto =
+        object<simdjson::ondemand::document_reference>(
+            member(
+                "values",
+                array_to_out_iter(
+                    back_inserter(tmp_values), &tmp_value,
+                    number_value(&tmp_value))));
+
+    std::vector<size_t> sizes;
+    const auto stats =
+        eval_many(
+            &parser, json, &tmp_values,
+            [&](auto &sj_doc, error *err) {
+                tmp_values.clear();
+                proto(sj_doc, err);
+            },
+            [&](record_batch<std::vector<int64_t>> *batch, error *) {
+                for (const auto &values : *batch) {
+                    sizes.push_back(values.size());
+                }
+            },
+            &errors);
+
+    // the limits apply to each document.
+    EXPECT_EQ(stats.documents, 3u);
+    EXPECT_EQ(stats.failed_documents, 1u);
+    EXPECT_EQ(sizes, std::vector<size_t>({2, 3}));
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {ARRAY_LIMIT_EXCEEDED, "<root>[1].values[3]"}
+            }));
+}
+
+
+TEST(Limits, ErrorText) {
+    using namespace simdjson_peval;
+
+    error errors;
+    errors.add(DEPTH_LIMIT_EXCEEDED);
+    errors.add(ARRAY_LIMIT_EXCEEDED);
+    errors.add(ELEMENT_LIMIT_EXCEEDED);
+    errors.add(STRING_LIMIT_EXCEEDED);
+
+    const auto &messages = errors.get_messages();
+    EXPECT_EQ(
+        messages.at(0).get_text(),
+        std::string_view("The nesting depth exceeds the limit."));
+    EXPECT_EQ(
+        messages.at(1).get_text(),
+        std::string_view("The number of array elements exceeds the limit."));
+    EXPECT_EQ(
+        messages.at(2).get_text(),
+        std::string_view("The total number of elements exceeds the limit."));
+    EXPECT_EQ(
+        messages.at(3).get_text(),
+        std::string_view(
+            "The total size of output strings exceeds the limit."));
+}
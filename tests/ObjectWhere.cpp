@@ -0,0 +1,318 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define _SIMDJSON_PEVAL_DO_TRACE 1
+#include "simdjson_peval_ndjson.h"
+
+#include "gtest/gtest.h"
+
+#include "TestUtils.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Person {
+    std::string type;
+    std::string name;
+    std::vector<int64_t> ids;
+
+    bool
+    operator==(const Person &other) const {
+        return (type == other.type && name == other.name && ids == other.ids);
+    }
+};
+
+const std::string persons_json =
+    R"([{"type":"teacher","name":"a","ids":[1]},)"
+    R"({"type":"student","name":"b","ids":[2,3]},)"
+    R"({"type":"teacher","name":"c","ids":[]},)"
+    R"({"type":"student","name":"d","ids":[4]}])";
+
+/// Create prototype to evaluate teachers and count evaluated names.
+auto
+makeTeacherProto(Person *tmp_person, size_t *num_names) {
+    using namespace simdjson_peval;
+
+    return
+        object(
+            where(
+                member("type", string_value(&tmp_person->type)),
+                [tmp_person]() { return tmp_person->type == "teacher"; }),
+            member(
+                "name",
+                value(
+                    [tmp_person, num_names](auto *sj_value, error *err) {
+                        ++*num_names;
+                        string_value(&tmp_person->name)(*sj_value, err);
+                    })),
+            member(
+                "ids",
+                array_to_function(
+                    [tmp_person](size_t idx, auto *sj_value, error *err) {
+                        if (idx == 0) {
+                            tmp_person->ids.clear();
+                        }
+                        int64_t id = 0;
+                        number_value(&id)(*sj_value, err);
+                        tmp_person->ids.push_back(id);
+                    })));
+}
+
+} // namespace
+
+
+TEST(ObjectWhere, ArrayToOutIter) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    auto json = simdjson::padded_string(persons_json);
+    auto doc = parser.iterate(json);
+
+    std::vector<Person> persons;
+    Person tmp_person;
+    size_t num_names = 0;
+    auto proto =
+        array_to_out_iter<simdjson::ondemand::document>(
+            back_inserter(persons), &tmp_person,
+            makeTeacherProto(&tmp_person, &num_names));
+
+    error errors(true);
+    proto(doc, &errors);
+
+    EXPECT_FALSE(errors);
+    EXPECT_FALSE(errors.is_rejected());
+    EXPECT_EQ(
+        persons,
+        std::vector<Person>({{"teacher", "a", {1}}, {"teacher", "c", {}}}));
+
+    // members behind a failed predicate are not evaluated.
+    EXPECT_EQ(num_names, 2u);
+}
+
+
+TEST(ObjectWhere, ArrayToBatch) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    auto json = simdjson::padded_string(persons_json);
+    auto doc = parser.iterate(json);
+
+    std::vector<std::string> names;
+    Person tmp_person;
+    size_t num_names = 0;
+    record_batch<Person> batch(3);
+    auto proto =
+        array_to_batch<simdjson::ondemand::document>(
+            [&names](record_batch<Person> *batch_ptr, error *) {
+                for (const auto &person : *batch_ptr) {
+                    names.push_back(person.name);
+                }
+            },
+            &batch, &tmp_person, makeTeacherProto(&tmp_person, &num_names));
+
+    error errors(true);
+    proto(doc, &errors);
+
+    EXPECT_FALSE(errors);
+    EXPECT_EQ(names, std::vector<std::string>({"a", "c"}));
+}
+
+
+TEST(ObjectWhere, Nested) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    auto json =
+        R"({"name":"x","tags":[{"lang":"en","text":"a"},)"
+        R"({"lang":"de","text":"b"},{"lang":"en","text":"c"}],"id":7})"_padded;
+    auto doc = parser.iterate(json);
+
+    std::string name;
+    std::vector<std::string> texts;
+    std::pair<std::string, std::string> tmp_tag;
+    int64_t id = 0;
+    auto proto =
+        object<simdjson::ondemand::document>(
+            member("name", string_value(&name)),
+            member(
+                "tags",
+                array_to_out_iter(
+                    back_inserter(texts), &tmp_tag.second,
+                    object(
+                        where(
+                            member("lang", string_value(&tmp_tag.first)),
+                            [&tmp_tag]() { return tmp_tag.first == "en"; }),
+                        member("text", string_value(&tmp_tag.second))))),
+            member("id", number_value(&id)));
+
+    error errors(true);
+    proto(doc, &errors);
+
+    // rejected elements of the inner array don't reject the document.
+    EXPECT_FALSE(errors);
+    EXPECT_FALSE(errors.is_rejected());
+    EXPECT_EQ(texts, std::vector<std::string>({"a", "c"}));
+    EXPECT_EQ(id, 7);
+}
+
+
+TEST(ObjectWhere, Errors) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    auto json = R"({"type":1,"name":"a"})"_padded;
+    auto doc = parser.iterate(json);
+
+    std::string type;
+    std::string name;
+    size_t num_calls = 0;
+    auto proto =
+        object<simdjson::ondemand::document>(
+            where(
+                member("type", string_value(&type)),
+                [&num_calls]() { ++num_calls; return false; }),
+            member("name", string_value(&name)));
+
+    error errors(true);
+    proto(doc, &errors);
+
+    // the predicate is not called for invalid members.
+    EXPECT_EQ(num_calls, 0u);
+    EXPECT_FALSE(errors.is_rejected());
+    EXPECT_EQ(name, "a");
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>.type"}
+            }));
+}
+
+
+TEST(ObjectWhere, EvalMany) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    auto json =
+        simdjson::padded_string(
+            std::string(R"({"lang":"en","id":1})" "\n"
+                        R"({"lang":"de","id":2})" "\n"
+                        R"({"lang":"en","id":"x"})" "\n"
+                        R"({"lang":"en","id":4})" "\n"));
+
+    std::pair<std::string, int64_t> tmp_record;
+    auto proto =
+        object<simdjson::ondemand::document_reference>(
+            where(
+                member("lang", string_value(&tmp_record.first)),
+                [&tmp_record]() { return tmp_record.first == "en"; }),
+            member("id", number_value(&tmp_record.second)));
+
+    std::vector<int64_t> ids;
+    error errors(true);
+    const auto stats =
+        eval_many(
+            &parser, json, &tmp_record, proto,
+            [&ids](record_batch<std::pair<std::string, int64_t>> *batch,
+                   error *)
+            {
+                for (const auto &record : *batch) {
+                    ids.push_back(record.second);
+                }
+            },
+            &errors);
+
+    EXPECT_EQ(stats.documents, 4u);
+    EXPECT_EQ(stats.rejected_documents, 1u);
+    EXPECT_EQ(stats.failed_documents, 1u);
+    EXPECT_EQ(stats.records, 2u);
+    EXPECT_EQ(ids, std::vector<int64_t>({1, 4}));
+    EXPECT_FALSE(errors.is_rejected());
+}
+
+
+TEST(ObjectWhere, Session) {
+    using namespace simdjson_peval;
+
+    session<std::pair<std::string, int64_t>> sess;
+    auto *record = sess.get_record();
+    auto proto =
+        object<simdjson::ondemand::document>(
+            where(
+                member("lang", string_value(&record->first)),
+                [record]() { return record->first == "en"; }),
+            member("id", number_value(&record->second)));
+
+    EXPECT_TRUE(sess.evaluate(R"({"lang":"en","id":1})", proto));
+    EXPECT_EQ(record->second, 1);
+
+    EXPECT_FALSE(sess.evaluate(R"({"lang":"de","id":2})", proto));
+    EXPECT_FALSE(sess.get_errors());
+    EXPECT_TRUE(sess.get_errors().is_rejected());
+    EXPECT_EQ(record->second, 1);
+
+    EXPECT_TRUE(sess.evaluate(R"({"lang":"en","id":3})", proto));
+    EXPECT_EQ(record->second, 3);
+}
+
+
+TEST(ObjectWhere, Clear) {
+    using namespace simdjson_peval;
+
+    int64_t a = -1;
+    int64_t b = -1;
+    auto proto =
+        object<simdjson::ondemand::document>(
+            where(
+                member("a", number_value(&a)),
+                [&a]() { return a > 0; }),
+            member("b", number_value(&b)));
+
+    simdjson::ondemand::parser parser;
+    error errors(true);
+
+    auto rejected_json = R"({"a":0,"b":1})"_padded;
+    auto doc = parser.iterate(rejected_json);
+    proto(doc, &errors);
+    EXPECT_TRUE(errors.is_rejected());
+    EXPECT_EQ(b, -1);
+
+    // the next document is evaluated after `clear()`.
+    errors.set_slice(1, 2);
+    errors.clear();
+    EXPECT_FALSE(errors.is_rejected());
+    EXPECT_EQ(
+        errors.take_slice(),
+        std::make_pair(size_t(0), std::numeric_limits<size_t>::max()));
+
+    auto json = R"({"a":5,"b":7})"_padded;
+    doc = parser.iterate(json);
+    proto(doc, &errors);
+    EXPECT_FALSE(errors);
+    EXPECT_FALSE(errors.is_rejected());
+    EXPECT_EQ(a, 5);
+    EXPECT_EQ(b, 7);
+}
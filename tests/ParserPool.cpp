@@ -0,0 +1,203 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define _SIMDJSON_PEVAL_DO_TRACE 1
+#include "simdjson_peval_parallel.h"
+
+#include "gtest/gtest.h"
+
+#include "TestUtils.h"
+
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// Create a document of at least the given size.
+simdjson::padded_string
+createDocument(size_t size) {
+    return
+        simdjson::padded_string(
+            "{\"id\":1,\"name\":\"" + std::string(size, 'a') + "\"}");
+}
+
+/// Evaluate the id of a document.
+simdjson::error_code
+evalId(simdjson::ondemand::parser *parser, simdjson::padded_string &json) {
+    using namespace simdjson_peval;
+
+    int64_t id = 0;
+    std::string name;
+    auto sj_doc = parser->iterate(json);
+    if (sj_doc.error()) {
+        return sj_doc.error();
+    }
+
+    error errors;
+    object<simdjson::ondemand::document>(
+        member("id", number_value(&id)),
+        member("name", string_value(&name)))(sj_doc, &errors);
+
+    return (errors ? errors.get_messages().at(0).get_code()
+                   : simdjson::SUCCESS);
+}
+
+} // namespace
+
+
+TEST(ParserPool, Reuse) {
+    using namespace simdjson_peval;
+
+    parser_pool pool;
+    auto json = createDocument(10);
+
+    simdjson::ondemand::parser *first_parser = nullptr;
+    {
+        auto parser = pool.acquire();
+        first_parser = parser.get();
+        EXPECT_EQ(evalId(parser.get(), json), simdjson::SUCCESS);
+    }
+
+    auto parser = pool.acquire();
+    EXPECT_EQ(parser.get(), first_parser);
+    EXPECT_EQ(evalId(parser.get(), json), simdjson::SUCCESS);
+
+    auto stats = pool.get_stats();
+    EXPECT_EQ(stats.acquired, 2u);
+    EXPECT_EQ(stats.created, 1u);
+    EXPECT_EQ(stats.reused, 1u);
+    EXPECT_EQ(stats.idle, 0u);
+
+    parser.reset();
+    stats = pool.get_stats();
+    EXPECT_EQ(stats.idle, 1u);
+    EXPECT_GT(stats.idle_capacity, 0u);
+
+    pool.clear();
+    stats = pool.get_stats();
+    EXPECT_EQ(stats.idle, 0u);
+    EXPECT_EQ(stats.released, 1u);
+}
+
+
+TEST(ParserPool, Capacity) {
+    using namespace simdjson_peval;
+
+    parser_pool_options options;
+    options.max_capacity = 1000;
+    options.high_water_mark = 500;
+    parser_pool pool(options);
+
+    auto small_json = createDocument(100);
+    auto medium_json = createDocument(800);
+    auto large_json = createDocument(2000);
+
+    {
+        auto parser = pool.acquire();
+        EXPECT_EQ(evalId(parser.get(), large_json), simdjson::CAPACITY);
+        EXPECT_EQ(evalId(parser.get(), small_json), simdjson::SUCCESS);
+    }
+    EXPECT_EQ(pool.get_stats().shrunk, 0u);
+
+    {
+        auto parser = pool.acquire();
+        EXPECT_EQ(evalId(parser.get(), medium_json), simdjson::SUCCESS);
+        EXPECT_GT(parser->capacity(), options.high_water_mark);
+    }
+
+    auto stats = pool.get_stats();
+    EXPECT_EQ(stats.shrunk, 1u);
+    EXPECT_EQ(stats.idle, 1u);
+    EXPECT_LE(stats.idle_capacity, options.high_water_mark);
+
+    // shrunk parser keeps maximum capacity.
+    auto parser = pool.acquire();
+    EXPECT_EQ(parser->max_capacity(), options.max_capacity);
+    EXPECT_EQ(evalId(parser.get(), medium_json), simdjson::SUCCESS);
+}
+
+
+TEST(ParserPool, MaxIdle) {
+    using namespace simdjson_peval;
+
+    parser_pool_options options;
+    options.max_idle = 1;
+    parser_pool pool(options);
+
+    {
+        auto parser1 = pool.acquire();
+        auto parser2 = pool.acquire();
+        EXPECT_NE(parser1.get(), parser2.get());
+
+        // moved handle returns parser once.
+        auto parser3 = std::move(parser2);
+        EXPECT_EQ(parser2.get(), nullptr);
+    }
+
+    auto stats = pool.get_stats();
+    EXPECT_EQ(stats.created, 2u);
+    EXPECT_EQ(stats.idle, 1u);
+    EXPECT_EQ(stats.released, 1u);
+}
+
+
+TEST(ParserPool, Threads) {
+    using namespace simdjson_peval;
+
+    const size_t num_threads = 4;
+    const size_t num_requests = 200;
+
+    parser_pool_options options;
+    options.max_idle = num_threads;
+    parser_pool pool(options);
+
+    auto json = createDocument(100);
+
+    std::vector<std::thread> threads;
+    std::vector<size_t> failed(num_threads, 0);
+    for (size_t idx = 0; idx < num_threads; ++idx) {
+        threads.emplace_back(
+            [&, idx]() {
+                // each thread needs its own copy of the input.
+                auto thread_json = simdjson::padded_string(std::string(json));
+                for (size_t req = 0; req < num_requests; ++req) {
+                    auto parser = pool.acquire();
+                    if (evalId(parser.get(), thread_json)) {
+                        ++failed[idx];
+                    }
+                }
+            });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    const auto stats = pool.get_stats();
+    EXPECT_EQ(failed, std::vector<size_t>(num_threads, 0));
+    EXPECT_EQ(stats.acquired, num_threads * num_requests);
+    EXPECT_LE(stats.created, num_threads);
+    EXPECT_EQ(stats.created + stats.reused, stats.acquired);
+    EXPECT_EQ(stats.released, 0u);
+}
@@ -0,0 +1,156 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define _SIMDJSON_PEVAL_DO_TRACE 1
+#include "simdjson_peval_parallel.h"
+
+#include "gtest/gtest.h"
+
+#include "TestUtils.h"
+
+#include <numeric>
+#include <vector>
+
+namespace {
+
+struct Item {
+    int64_t id;
+};
+
+auto
+makeItemProto(Item *tmp_item) {
+    using namespace simdjson_peval;
+
+    return
+        object<simdjson::ondemand::document_reference>(
+            member("id", number_value(&tmp_item->id)));
+}
+
+/// Check statistics of a placement of workers.
+void
+checkPlacement(
+    const simdjson_peval::placement_stats &stats,
+    size_t threads,
+    bool pinned)
+{
+    const auto &nodes = simdjson_peval::internal::numa_nodes();
+
+    EXPECT_EQ(stats.nodes, nodes.size());
+    ASSERT_EQ(stats.node_threads.size(), nodes.size());
+    EXPECT_EQ(
+        std::accumulate(
+            stats.node_threads.begin(), stats.node_threads.end(), size_t(0)),
+        threads);
+
+    // single node: nothing to do.
+    EXPECT_EQ(stats.pinned_threads, (pinned && nodes.size() > 1) ? threads : 0);
+}
+
+} // namespace
+
+
+TEST(Placement, ParseCpuList) {
+    using namespace simdjson_peval;
+
+    EXPECT_EQ(internal::parse_cpu_list(""), (std::vector<int>{}));
+    EXPECT_EQ(internal::parse_cpu_list("0"), (std::vector<int>{0}));
+    EXPECT_EQ(
+        internal::parse_cpu_list("0-3,8,10-11\n"),
+        (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(internal::parse_cpu_list("x,2"), (std::vector<int>{2}));
+}
+
+
+TEST(Placement, AssignNode) {
+    using namespace simdjson_peval;
+
+    std::vector<size_t> spread;
+    std::vector<size_t> compact;
+    for (size_t worker = 0; worker < 6; ++worker) {
+        spread.push_back(
+            internal::assign_node(thread_placement::spread, worker, 6, 2));
+        compact.push_back(
+            internal::assign_node(thread_placement::compact, worker, 6, 2));
+    }
+
+    EXPECT_EQ(spread, (std::vector<size_t>{0, 1, 0, 1, 0, 1}));
+    EXPECT_EQ(compact, (std::vector<size_t>{0, 0, 0, 1, 1, 1}));
+    EXPECT_EQ(internal::assign_node(thread_placement::spread, 3, 4, 1), 0u);
+}
+
+
+TEST(Placement, Stats) {
+    using namespace simdjson_peval;
+
+    EXPECT_FALSE(internal::numa_nodes().empty());
+
+    std::string data;
+    for (size_t idx = 0; idx < 1000; ++idx) {
+        data += "{\"id\":" + std::to_string(idx) + "}\n";
+    }
+    const auto json = simdjson::padded_string(data);
+
+    for (const auto placement :
+             {thread_placement::none, thread_placement::spread,
+              thread_placement::compact})
+    {
+        eval_parallel_options options;
+        options.threads = 3;
+        options.chunk_size = 1000;
+        options.placement = placement;
+
+        size_t records = 0;
+        error errors(true);
+        const auto stats =
+            eval_many_parallel<Item>(
+                json, makeItemProto,
+                [&records](record_batch<Item> *batch, error *err) {
+                    records += batch->size();
+                },
+                &errors, options);
+
+        EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+        EXPECT_EQ(records, 1000u);
+        checkPlacement(
+            stats.placement, 3, placement != thread_placement::none);
+    }
+
+    eval_array_parallel_options array_options;
+    array_options.threads = 2;
+    array_options.range_size = 100;
+    array_options.placement = thread_placement::spread;
+
+    const auto json_array = simdjson::padded_string(std::string("[1,2,3,4]"));
+    std::vector<int64_t> values;
+    error errors(true);
+    const auto array_stats =
+        eval_array_parallel<int64_t>(
+            json_array, back_inserter(values),
+            [](int64_t *tmp_value) { return number_value(tmp_value); },
+            &errors, array_options);
+
+    EXPECT_TRUE(sp_test::checkErrors(errors, {}));
+    EXPECT_EQ(values, (std::vector<int64_t>{1, 2, 3, 4}));
+    checkPlacement(array_stats.placement, array_stats.threads, true);
+}
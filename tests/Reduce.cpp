@@ -0,0 +1,420 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define _SIMDJSON_PEVAL_DO_TRACE 1
+#include "simdjson_peval_parallel.h"
+
+#include "gtest/gtest.h"
+
+#include "TestUtils.h"
+
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace {
+
+/// Batch function ignoring the (empty) records.
+auto
+ignoreBatch() {
+    using namespace simdjson_peval;
+
+    return [](record_batch<std::monostate> *, error *) {};
+}
+
+} // namespace
+
+
+TEST(Reduce, Accumulators) {
+    using namespace simdjson_peval;
+
+    sum_accumulator sum;
+    for (double value : {1e100, 1.0, -1e100}) {
+        sum.add(value);
+    }
+    EXPECT_EQ(sum.get_sum(), 1.0);
+    EXPECT_EQ(sum.get_count(), 3u);
+
+    minmax_accumulator minmax;
+    EXPECT_EQ(minmax.get_min(), std::numeric_limits<double>::infinity());
+    EXPECT_EQ(minmax.get_max(), -std::numeric_limits<double>::infinity());
+
+    mean_accumulator mean;
+    for (int value = 1; value <= 10; ++value) {
+        minmax.add(value);
+        mean.add(value);
+    }
+    EXPECT_EQ(minmax.get_min(), 1.0);
+    EXPECT_EQ(minmax.get_max(), 10.0);
+    EXPECT_EQ(minmax.get_count(), 10u);
+    EXPECT_DOUBLE_EQ(mean.get_mean(), 5.5);
+    EXPECT_DOUBLE_EQ(mean.get_variance(), 8.25);
+    EXPECT_EQ(mean.get_count(), 10u);
+}
+
+
+TEST(Reduce, Merge) {
+    using namespace simdjson_peval;
+
+    accumulator_shards<sum_accumulator> sums;
+    accumulator_shards<mean_accumulator> means;
+    accumulator_shards<minmax_accumulator> minmaxs;
+    accumulator_shards<count_accumulator> counts;
+
+    auto *sum_a = sums.add_shard();
+    auto *sum_b = sums.add_shard();
+    sum_a->add(1e100);
+    sum_a->add(1.0);
+    sum_b->add(-1e100);
+
+    auto *mean_a = means.add_shard();
+    auto *mean_b = means.add_shard();
+    means.add_shard(); // empty shard
+    auto *minmax_a = minmaxs.add_shard();
+    auto *minmax_b = minmaxs.add_shard();
+    auto *count_a = counts.add_shard();
+    auto *count_b = counts.add_shard();
+    for (int value = 1; value <= 10; ++value) {
+        (value <= 3 ? mean_a : mean_b)->add(value);
+        (value % 2 ? minmax_a : minmax_b)->add(value);
+        (value <= 7 ? count_a : count_b)->add();
+    }
+
+    const auto sum = sums.merge();
+    EXPECT_EQ(sum.get_sum(), 1.0);
+    EXPECT_EQ(sum.get_count(), 3u);
+
+    const auto mean = means.merge();
+    EXPECT_DOUBLE_EQ(mean.get_mean(), 5.5);
+    EXPECT_DOUBLE_EQ(mean.get_variance(), 8.25);
+    EXPECT_EQ(mean.get_count(), 10u);
+
+    const auto minmax = minmaxs.merge();
+    EXPECT_EQ(minmax.get_min(), 1.0);
+    EXPECT_EQ(minmax.get_max(), 10.0);
+
+    EXPECT_EQ(counts.merge().get_count(), 10u);
+}
+
+
+TEST(Reduce, ArrayForEach) {
+    using namespace simdjson_peval;
+
+    simdjson::ondemand::parser parser;
+    auto json =
+        R"([{"type":"fruit","price":1.25,"name":"apple"},)"
+        R"({"type":"fruit","price":0.75,"name":"pear"},)"
+        R"({"type":"fruit","price":"x","name":"plum"},)"
+        R"({"type":"other","price":100,"name":"bag"},)"
+        R"({"type":"fruit","price":2,"name":null}])"_padded;
+    auto doc = parser.iterate(json);
+
+    std::string type;
+    sum_accumulator sum;
+    minmax_accumulator minmax;
+    mean_accumulator mean;
+    count_accumulator names;
+    auto proto =
+        array_for_each<simdjson::ondemand::document>(
+            object(
+                where(
+                    member("type", string_value(&type)),
+                    [&type]() { return type == "fruit"; }),
+                member(
+                    "price",
+                    value(
+                        [&](auto *sj_value, error *err) {
+                            // one number for all reducers.
+                            const auto num_errors = err->get_count();
+                            double price;
+                            number_value(&price)(*sj_value, err);
+                            if (err->get_count() == num_errors) {
+                                sum.add(price);
+                                minmax.add(price);
+                            }
+                        })),
+                member("name", reduce_count(&names))));
+
+    error errors(true);
+    proto(doc, &errors);
+
+    sp_test::checkErrors(
+        errors, {{simdjson::INCORRECT_TYPE, "<root>[2].price"}});
+    EXPECT_EQ(sum.get_sum(), 4.0);
+    EXPECT_EQ(sum.get_count(), 3u);
+    EXPECT_EQ(minmax.get_min(), 0.75);
+    EXPECT_EQ(minmax.get_max(), 2.0);
+
+    // the name of the failed element is not counted.
+    EXPECT_EQ(names.get_count(), 3u);
+
+    // reducers used directly.
+    doc = parser.iterate(json);
+    errors.reset();
+    auto mean_proto =
+        array_for_each<simdjson::ondemand::document>(
+            object(member("price", reduce_mean(&mean))));
+    mean_proto(doc, &errors);
+
+    sp_test::checkErrors(
+        errors, {{simdjson::INCORRECT_TYPE, "<root>[2].price"}});
+    EXPECT_DOUBLE_EQ(mean.get_mean(), 26.0);
+    EXPECT_EQ(mean.get_count(), 4u);
+}
+
+
+TEST(Reduce, EvalMany) {
+    using namespace simdjson_peval;
+
+    const auto json =
+        simdjson::padded_string(
+            std::string(
+                "{\"n\":3,\"v\":[1,2]}\n"
+                "{\"n\":-1,\"v\":[]}\n"
+                "{\"n\":true,\"v\":[3]}\n"
+                "{\"n\":5,\"v\":[4,5,6]}\n"));
+
+    sum_accumulator n_sum;
+    minmax_accumulator n_minmax;
+    sum_accumulator v_sum;
+    std::monostate no_record;
+    auto proto =
+        object<simdjson::ondemand::document_reference>(
+            member("n", reduce_sum(&n_sum)),
+            member("n", reduce_minmax(&n_minmax)),
+            member("v", array_for_each(reduce_sum(&v_sum))));
+
+    simdjson::ondemand::parser parser;
+    error errors(true);
+    const auto stats =
+        eval_many(
+            &parser, json, &no_record, proto, ignoreBatch(), &errors);
+
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>[2].n"},
+                {simdjson::INCORRECT_TYPE, "<root>[2].n"}
+            }));
+    EXPECT_EQ(stats.documents, 4u);
+    EXPECT_EQ(n_sum.get_sum(), 7.0);
+    EXPECT_EQ(n_sum.get_count(), 3u);
+    EXPECT_EQ(n_minmax.get_min(), -1.0);
+    EXPECT_EQ(n_minmax.get_max(), 5.0);
+
+    // the elements of the failed document are not accumulated.
+    EXPECT_EQ(v_sum.get_sum(), 18.0);
+    EXPECT_EQ(v_sum.get_count(), 5u);
+}
+
+
+TEST(Reduce, FailedAndRejected) {
+    using namespace simdjson_peval;
+
+    const auto json =
+        simdjson::padded_string(
+            std::string(
+                "{\"v\":1,\"type\":\"a\",\"id\":1}\n"
+                "{\"v\":2,\"type\":\"a\",\"id\":\"x\"}\n"
+                "{\"v\":4,\"type\":\"b\",\"id\":3}\n"));
+
+    sum_accumulator sum;
+    std::string_view type;
+    int64_t id = 0;
+    std::monostate no_record;
+    auto proto =
+        object<simdjson::ondemand::document_reference>(
+            member("v", reduce_sum(&sum)),
+            where(
+                member("type", string_value(&type)),
+                [&type]() { return type == "a"; }),
+            member("id", number_value(&id)));
+
+    simdjson::ondemand::parser parser;
+    error errors(true);
+    const auto stats =
+        eval_many(
+            &parser, json, &no_record, proto, ignoreBatch(), &errors);
+
+    // values of the failed and of the rejected record are discarded.
+    EXPECT_EQ(stats.records, 1u);
+    EXPECT_EQ(stats.failed_documents, 1u);
+    EXPECT_EQ(stats.rejected_documents, 1u);
+    EXPECT_EQ(sum.get_sum(), 1.0);
+    EXPECT_EQ(sum.get_count(), 1u);
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>[1].id"}
+            }));
+}
+
+
+TEST(Reduce, NestedRecords) {
+    using namespace simdjson_peval;
+
+    const auto json =
+        simdjson::padded_string(
+            std::string(
+                "{\"items\":[{\"k\":\"a\",\"v\":1},{\"k\":\"b\",\"v\":2},"
+                "{\"k\":\"a\",\"v\":4}],\"id\":1}\n"
+                "{\"items\":[{\"k\":\"a\",\"v\":8}],\"id\":\"x\"}\n"
+                "{\"items\":[{\"k\":\"a\",\"v\":16},{\"k\":\"a\",\"v\":\"y\"}],"
+                "\"id\":3}\n"));
+
+    sum_accumulator sum;
+    std::string_view key;
+    std::vector<double> values;
+    double tmp_value = 0.0;
+    int64_t id = 0;
+    std::monostate no_record;
+    auto proto =
+        object<simdjson::ondemand::document_reference>(
+            member(
+                "items",
+                array_to_out_iter(
+                    back_inserter(values), &tmp_value,
+                    object(
+                        where(
+                            member("k", string_value(&key)),
+                            [&key]() { return key == "a"; }),
+                        member("v", reduce_sum(&sum)),
+                        member("v", number_value(&tmp_value))))),
+            member("id", number_value(&id)));
+
+    simdjson::ondemand::parser parser;
+    error errors(true);
+    const auto stats =
+        eval_many(
+            &parser, json, &no_record, proto, ignoreBatch(), &errors);
+
+    // rejected elements and all elements of failed documents are
+    // discarded.
+    EXPECT_EQ(stats.records, 1u);
+    EXPECT_EQ(stats.failed_documents, 2u);
+    EXPECT_EQ(sum.get_sum(), 5.0);
+    EXPECT_EQ(sum.get_count(), 2u);
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            errors,
+            {
+                {simdjson::INCORRECT_TYPE, "<root>[1].id"},
+                {simdjson::INCORRECT_TYPE, "<root>[2].items[1].v"},
+                {simdjson::INCORRECT_TYPE, "<root>[2].items[1].v"}
+            }));
+}
+
+
+TEST(Reduce, StopOnError) {
+    using namespace simdjson_peval;
+
+    const auto json =
+        simdjson::padded_string(
+            std::string(
+                "{\"v\":1,\"id\":1}\n"
+                "{\"v\":2,\"id\":\"x\"}\n"
+                "{\"v\":4,\"id\":3}\n"));
+
+    sum_accumulator sum;
+    int64_t id = 0;
+    std::monostate no_record;
+    auto proto =
+        object<simdjson::ondemand::document_reference>(
+            member("v", reduce_sum(&sum)),
+            member("id", number_value(&id)));
+
+    simdjson::ondemand::parser parser;
+    error errors(true);
+    eval_many_options options;
+    options.stop_on_error = true;
+    eval_many(
+        &parser, json, &no_record, proto, ignoreBatch(), &errors, options);
+
+    EXPECT_EQ(sum.get_sum(), 1.0);
+    EXPECT_EQ(sum.get_count(), 1u);
+
+    // a session accumulates accepted documents only.
+    session<std::monostate> sess;
+    auto session_proto =
+        object<simdjson::ondemand::document>(
+            member("v", reduce_sum(&sum)),
+            member("id", number_value(&id)));
+    EXPECT_FALSE(sess.evaluate(R"({"v":2,"id":"x"})", session_proto));
+    EXPECT_TRUE(sess.evaluate(R"({"v":4,"id":3})", session_proto));
+    EXPECT_EQ(sum.get_sum(), 5.0);
+    EXPECT_EQ(sum.get_count(), 2u);
+}
+
+
+TEST(Reduce, EvalManyParallel) {
+    using namespace simdjson_peval;
+
+    std::string raw_json;
+    double expected_sum = 0.0;
+    for (size_t idx = 0; idx < 20000; ++idx) {
+        const auto value = double(idx % 1000) + 0.5;
+        raw_json += "{\"id\":" + std::to_string(idx)
+            + ",\"value\":" + std::to_string(value) + "}\n";
+        expected_sum += value;
+    }
+    const auto json = simdjson::padded_string(raw_json);
+
+    accumulator_shards<sum_accumulator> sums;
+    accumulator_shards<mean_accumulator> means;
+    accumulator_shards<minmax_accumulator> minmaxs;
+
+    eval_parallel_options options;
+    options.threads = 4;
+    options.chunk_size = 1 << 14;
+
+    error errors(true);
+    const auto stats =
+        eval_many_parallel<std::monostate>(
+            json,
+            [&](std::monostate *) {
+                return
+                    object<simdjson::ondemand::document_reference>(
+                        member("value", reduce_sum(sums.add_shard())),
+                        member("value", reduce_mean(means.add_shard())),
+                        member("value", reduce_minmax(minmaxs.add_shard())));
+            },
+            ignoreBatch(), &errors, options);
+
+    EXPECT_FALSE(errors);
+    EXPECT_GT(stats.chunks, 1u);
+
+    const auto sum = sums.merge();
+    EXPECT_EQ(sum.get_sum(), expected_sum);
+    EXPECT_EQ(sum.get_count(), 20000u);
+
+    const auto mean = means.merge();
+    EXPECT_DOUBLE_EQ(mean.get_mean(), expected_sum / 20000);
+    EXPECT_EQ(mean.get_count(), 20000u);
+
+    const auto minmax = minmaxs.merge();
+    EXPECT_EQ(minmax.get_min(), 0.5);
+    EXPECT_EQ(minmax.get_max(), 999.5);
+}
@@ -0,0 +1,242 @@
+//
+// Copyright 2023 kla-sch@gmx.de
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#define _SIMDJSON_PEVAL_DO_TRACE 1
+#include "simdjson_peval.h"
+
+#include "gtest/gtest.h"
+
+#include "TestUtils.h"
+
+#include <cstdlib>
+#include <new>
+#include <string>
+
+namespace {
+
+/// Flag: count allocations of the current thread.
+thread_local bool count_allocations = false;
+
+/// Number of allocations counted.
+thread_local size_t num_allocations = 0;
+
+struct Item {
+    int64_t id = 0;
+    std::string name;
+    std::string_view kind;
+};
+
+/// Create a document with a name of the given size.
+std::string
+createDocument(int64_t id, size_t name_size) {
+    return
+        "{\"id\":" + std::to_string(id)
+        + ",\"name\":\"" + std::string(name_size, 'a' + id % 26)
+        + "\",\"kind\":\"item\"}";
+}
+
+} // namespace
+
+
+// count allocations of all operators without alignment (the address
+// sanitizer replaces the operators itself).
+#if !defined(__SANITIZE_ADDRESS__)
+
+void *
+operator new(size_t size) {
+    if (count_allocations) {
+        ++num_allocations;
+    }
+
+    if (auto *ptr = std::malloc(size != 0 ? size : 1)) {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+void *
+operator new[](size_t size) {
+    return operator new(size);
+}
+
+void
+operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void
+operator delete[](void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void
+operator delete(void *ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void
+operator delete[](void *ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+#endif // !defined(__SANITIZE_ADDRESS__)
+
+
+TEST(Session, Evaluate) {
+    using namespace simdjson_peval;
+
+    session<Item> sess(true);
+    auto *item = sess.get_record();
+    auto proto =
+        object<simdjson::ondemand::document>(
+            member("id", number_value(&item->id)),
+            member("name", string_value(&item->name)),
+            member("kind", string_value(&item->kind)));
+
+    EXPECT_TRUE(sess.evaluate(createDocument(1, 3), proto));
+    EXPECT_EQ(item->id, 1);
+    EXPECT_EQ(item->name, "bbb");
+    EXPECT_EQ(item->kind, "item");
+    EXPECT_FALSE(sess.get_errors());
+
+    EXPECT_FALSE(sess.evaluate(R"({"id":"x","name":"c","kind":"k"})", proto));
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            sess.get_errors(),
+            {
+                {simdjson::INCORRECT_TYPE, "<root>.id"}
+            }));
+
+    // errors of the previous evaluation are removed.
+    EXPECT_TRUE(sess.evaluate(createDocument(2, 3), proto));
+    EXPECT_EQ(item->name, "ccc");
+
+    const auto capacity = sess.get_buffer().get_capacity();
+    sess.reset();
+    EXPECT_EQ(sess.get_buffer().size(), 0u);
+    EXPECT_EQ(sess.get_buffer().get_capacity(), capacity);
+    EXPECT_FALSE(sess.get_errors());
+}
+
+
+TEST(Session, Limits) {
+    using namespace simdjson_peval;
+
+    eval_limits limits;
+    limits.max_string_bytes = 4;
+
+    session<Item> sess(true);
+    sess.get_errors().set_limits(&limits);
+
+    auto *item = sess.get_record();
+    auto proto =
+        object<simdjson::ondemand::document>(
+            member("id", number_value(&item->id)),
+            member("name", string_value(&item->name)),
+            member("kind", string_value(&item->kind)));
+
+    EXPECT_TRUE(sess.evaluate(createDocument(1, 4), proto));
+    EXPECT_FALSE(sess.evaluate(createDocument(1, 5), proto));
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            sess.get_errors(),
+            {
+                {STRING_LIMIT_EXCEEDED, "<root>.name"}
+            }));
+}
+
+
+TEST(Session, IterateError) {
+    using namespace simdjson_peval;
+
+    session<Item> sess(true, 64);
+    auto *item = sess.get_record();
+    auto proto =
+        object<simdjson::ondemand::document>(
+            member("id", number_value(&item->id)));
+
+    // empty input.
+    EXPECT_FALSE(sess.evaluate("", proto));
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            sess.get_errors(),
+            {
+                {simdjson::EMPTY, "<root>"}
+            }));
+
+    // input larger than the maximum capacity of the parser.
+    EXPECT_FALSE(sess.evaluate(createDocument(1, 100), proto));
+    EXPECT_TRUE(
+        sp_test::checkErrors(
+            sess.get_errors(),
+            {
+                {simdjson::CAPACITY, "<root>"}
+            }));
+
+    // the session is still usable.
+    EXPECT_TRUE(sess.evaluate(createDocument(2, 3), proto));
+    EXPECT_EQ(item->id, 2);
+}
+
+
+TEST(Session, NoAllocations) {
+    using namespace simdjson_peval;
+
+#if defined(__SANITIZE_ADDRESS__)
+    GTEST_SKIP() << "allocations are not counted with address sanitizer";
+#endif
+
+    session<Item> sess(true);
+    auto *item = sess.get_record();
+    auto proto =
+        object<simdjson::ondemand::document>(
+            member("id", number_value(&item->id)),
+            member("name", string_value(&item->name)),
+            member("kind", string_value(&item->kind)));
+
+    // the traces of the test build must not allocate either.
+    _trace_buffer.reserve(1000);
+
+    // warm up with the largest document.
+    ASSERT_TRUE(sess.evaluate(createDocument(0, 1000), proto));
+
+    const auto small_doc = createDocument(1, 100);
+    const auto large_doc = createDocument(2, 1000);
+
+    num_allocations = 0;
+    for (int idx = 0; idx < 100; ++idx) {
+        _trace_buffer.clear();
+
+        count_allocations = true;
+        const auto success =
+            sess.evaluate((idx % 2 == 0 ? small_doc : large_doc), proto);
+        count_allocations = false;
+
+        ASSERT_TRUE(success);
+    }
+
+    EXPECT_EQ(num_allocations, 0u);
+    EXPECT_EQ(item->name.size(), 1000u);
+}
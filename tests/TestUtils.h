@@ -27,7 +27,16 @@
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
 
 #ifdef __clang__
 // clang++ evaluates function arguments from right to left.
@@ -125,6 +134,121 @@ paramSetName(const testing::TestParamInfo<ParamStruct> &info) {
     return std::string(info.param.name);
 };
 
+
+/// Record of the tests evaluating streams of documents.
+struct Item {
+    int64_t id;
+    std::string name;
+
+    bool
+    operator==(const Item &other) const {
+        return (id == other.id && name == other.name);
+    }
+
+    bool
+    operator<(const Item &other) const {
+        return (id < other.id);
+    }
+};
+
+/**
+ * Create a stream of items, one document per line.
+ *
+ * @param num_items Number of items.
+ * @param bad_ids Ids of items with an invalid (string) id.
+ * @param first_id Id of the first item.
+ */
+inline std::string
+createItems(
+    size_t num_items,
+    const std::vector<size_t> &bad_ids = {},
+    size_t first_id = 0)
+{
+    std::string result;
+    for (size_t id = first_id; id < first_id + num_items; ++id) {
+        const auto is_bad =
+            std::find(bad_ids.begin(), bad_ids.end(), id) != bad_ids.end();
+
+        result +=
+            "{\"id\":"
+            + (is_bad ? std::string("\"x\"") : std::to_string(id))
+            + ",\"name\":\"item" + std::to_string(id) + "\"}\n";
+    }
+
+    return result;
+}
+
+/// Create prototype to evaluate an item.
+template<typename SJValue = simdjson::ondemand::document_reference>
+inline auto
+makeItemProto(Item *tmp_item) {
+    using namespace simdjson_peval;
+
+    return
+        object<SJValue>(
+            member("id", number_value(&tmp_item->id)),
+            member("name", string_value(&tmp_item->name)));
+}
+
+/// Create batch function appending the items to a vector.
+inline auto
+makeSaveItems(std::vector<Item> *items) {
+    using namespace simdjson_peval;
+
+    return
+        [items](record_batch<Item> *batch, error *) {
+            for (auto &item : *batch) {
+                items->push_back(std::move(item));
+            }
+        };
+}
+
+/// Source reading a string in small pieces.
+struct StringSource {
+    std::string_view data;
+    size_t piece_size;
+
+    /// Position of a read error.
+    size_t error_pos = std::string_view::npos;
+
+    simdjson::simdjson_result<size_t>
+    operator()(char *buffer, size_t capacity) {
+        if (error_pos == 0) {
+            return simdjson::IO_ERROR;
+        }
+
+        auto size = std::min({capacity, piece_size, data.size(), error_pos});
+        std::memcpy(buffer, data.data(), size);
+        data.remove_prefix(size);
+        if (error_pos != std::string_view::npos) {
+            error_pos -= size;
+        }
+
+        return size;
+    }
+};
+
+/// Temporary files removed at the end of the test.
+struct TempFiles {
+    std::vector<std::string> paths;
+
+    ~TempFiles() {
+        for (const auto &path : paths) {
+            std::remove(path.c_str());
+        }
+    }
+
+    void
+    add(const std::string &data) {
+        char path[] = "/tmp/simdjson_peval_XXXXXX";
+        const int fd = mkstemp(path);
+        EXPECT_GE(fd, 0);
+        EXPECT_EQ(write(fd, data.data(), data.size()), ssize_t(data.size()));
+        close(fd);
+        paths.push_back(path);
+    }
+};
+
     
 } // namespace vs_test
 